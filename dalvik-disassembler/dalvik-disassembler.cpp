@@ -1,5 +1,8 @@
 /// Compile clang++ -std=c++20 dalvik-disassembler.cpp -o dalvik-disassembler -lkunai
+#include <charconv>
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
 #include <utility>      // std::pair, std::get
 
 #include <Kunai/DEX/dex.hpp>
@@ -7,12 +10,14 @@
 void show_help(char **argv)
 {
     std::cerr << "[-] USAGE: " << argv[0] << " <dex_file> <class_name> <method_name> [-r]\n";
+    std::cerr << "[-] USAGE: " << argv[0] << " <dex_file> -a [threads]\n";
     std::cerr << "\t<dex_file>: dex file to disassembly\n";
     std::cerr << "\t<class_name>: name of the class to extract\n";
     std::cerr << "\t<method_name>: name of the method to extract\n";
     std::cerr << "\t[-r]: optional argument, use recursive disassembly algorithm\n";
     std::cerr << "\t[-b]: show the instructions as basic blocks\n";
     std::cerr << "\t[-p]: show a plot with the blocks in .dot format\n";
+    std::cerr << "\t-a: write the disassembly of all the classes to stdout\n";
 }
 
 void show_instruction(KUNAI::DEX::Instruction *instr)
@@ -66,6 +71,53 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    // disassembly of the whole dex file
+    if (argc >= 3 && !strcmp("-a", argv[2]))
+    {
+        unsigned threads = 0;
+
+        // the writer never uses more threads than the hardware ones,
+        // but the argument must be a number
+        if (argc > 3)
+        {
+            std::string_view value(argv[3]);
+            auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), threads);
+
+            if (value.empty() || error != std::errc() || end != value.data() + value.size())
+            {
+                std::cerr << "[-] Incorrect number of threads: " << value << "\n";
+                show_help(argv);
+                return 1;
+            }
+        }
+
+        spdlog::set_level(spdlog::level::err);
+
+        auto dex_file = KUNAI::DEX::Dex::parse_dex_file(argv[1]);
+
+        if (!dex_file->get_parsing_correct())
+        {
+            std::cerr << "Error analyzing " << argv[1] << ", maybe DEX file is not correct...\n";
+            return 2;
+        }
+
+        std::cout.flush();
+
+        KUNAI::DEX::DisassemblyWriter writer(dex_file->get_parser(), threads);
+
+        try
+        {
+            writer.write(1);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error writing the disassembly of " << argv[1] << ": " << e.what() << "\n";
+            return 2;
+        }
+
+        return 0;
+    }
+
     // check that 4 arguments were given
     if (argc < 4)
     {
@@ -178,41 +230,34 @@ int main(int argc, char **argv)
     }
     else
     {
-        /// we have to apply the disassembly ourselves since
-        /// the library only applies parsing
-        dex_disassembler->disassembly_dex();
-
-        if (!dex_disassembler->correct_disassembly())
-        {
-            std::cerr << "Error in the disassembly of " << argv[1] << ", maybe some method was incorrect...\n";
-            return 3;
-        }
+        /// we only disassembly the requested method, the
+        /// library decodes it on demand and keeps it cached
+        auto &class_defs = dex_file->get_parser()->get_classes().get_classdefs();
 
-        const auto &dex_instructions = dex_disassembler->get_dex_instructions();
-
-        /// dex instructions contain the next pair:
-        ///     - encoded_method : instructions from method
-        /// we will check for each one if class name and method names
-        /// are correct
-        for (const auto &disassembly : dex_instructions)
+        for (const auto &class_def : class_defs)
         {
-            auto encoded_method = disassembly.first;
-            const auto &instrs = disassembly.second;
+            if (class_def->get_class_idx()->get_name() != class_name)
+                continue;
 
-            auto cls_ = reinterpret_cast<KUNAI::DEX::DVMClass *>(encoded_method->getMethodID()->get_class());
+            for (auto encoded_method : class_def->get_class_data_item().get_methods())
+            {
+                if (encoded_method->getMethodID()->get_name() != method_name)
+                    continue;
 
-            if (cls_ == nullptr)
-                continue;
+                const auto &instrs = dex_disassembler->disassemble_method(encoded_method);
 
-            if (cls_->get_name() != class_name ||
-                encoded_method->getMethodID()->get_name() != method_name)
-                continue;
+                if (!dex_disassembler->correct_disassembly())
+                {
+                    std::cerr << "Error in the disassembly of " << argv[1] << ", maybe some method was incorrect...\n";
+                    return 3;
+                }
 
-            std::cout << encoded_method->getMethodID()->pretty_method() << "\n";
+                std::cout << encoded_method->getMethodID()->pretty_method() << "\n";
 
-            for (const auto &instr : instrs)
-            {
-                show_instruction(instr.get());
+                for (auto instr : instrs)
+                {
+                    show_instruction(instr);
+                }
             }
         }
     }
@@ -93,8 +93,8 @@ void Lifter::gen_instruction(KUNAI::DEX::Instruction22t *instr)
         ///     - current_block: for obtaining the required arguments.
         ///     - true_block: for generating branch to `true` block
         ///     - false_block: for generating fallthrough to `false` block.
-        auto true_block = current_method->get_basic_blocks().get_basic_block_by_idx(true_idx);
-        auto false_block = current_method->get_basic_blocks().get_basic_block_by_idx(false_idx);
+        auto true_block = current_method->get_block_at(true_idx);
+        auto false_block = current_method->get_block_at(false_idx);
         /// create the conditional branch
         builder.create<::mlir::cf::CondBranchOp>(
             location_jcc,
@@ -112,7 +112,7 @@ llvm::SmallVector<mlir::Type> Lifter::gen_prototype(KUNAI::DEX::ProtoID *proto)
 
     auto number_of_registers = encoded_method->get_code_item().get_registers_size();
 
-    auto first_block = M->get_basic_blocks().get_basic_block_by_idx(0);
+    auto first_block = M->get_block_at(0);
 
     for (std::uint32_t Reg = (number_of_registers - number_of_params), /// starting index of the parameter
          Limit = (static_cast<std::uint32_t>(number_of_registers)),    /// limit value for parameters
@@ -140,7 +140,7 @@ mlir::Value Lifter::readLocalVariableRecursive(KUNAI::DEX::DVMBasicBlock *BB,
     /// because block doesn't have it add it to required.
     CurrentDef[BB].required.insert(Reg);
 
-    for (auto pred : BBs.get_predecessors()[BB])
+    for (auto pred : BBs.get_predecessors(BB))
     {
         if (!CurrentDef[pred].Analyzed)
             gen_block(pred);
@@ -255,7 +255,7 @@ void Lifter::gen_terminators(KUNAI::DEX::DVMBasicBlock *bb)
             gen_instruction(last_instr);
         else
         {
-            auto next_block = current_method->get_basic_blocks().get_basic_block_by_idx(
+            auto next_block = current_method->get_block_at(
                 last_instr->get_address() + last_instr->get_instruction_length());
 
             auto loc = mlir::FileLineColLoc::get(&context, module_name, last_instr->get_address(), 1);
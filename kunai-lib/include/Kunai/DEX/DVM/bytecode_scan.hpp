@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file bytecode_scan.hpp
+// @brief Fast pre-scan of the bytecode of a method, it finds the code
+// units that can be the start of control flow instructions or payloads.
+
+#ifndef KUNAI_DEX_DVM_BYTECODE_SCAN_HPP
+#define KUNAI_DEX_DVM_BYTECODE_SCAN_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Pre-scan of the 16-bit code units of a method. For each class
+    /// of opcode a bitmap with one bit per code unit is generated, a bit is
+    /// set if the code unit has an opcode of that class. The scan does not
+    /// know where the instructions start, so the bits are only candidates
+    /// (an operand can look like an opcode) and must be validated with the
+    /// address of a decoded instruction. The scan is vectorized when SSE2
+    /// is available.
+    class BytecodeScan
+    {
+    public:
+        /// @brief classes of opcodes found by the scan
+        enum class bytecode_class_t
+        {
+            /// @brief if-*, goto* and throw
+            BRANCH = 0,
+            /// @brief packed-switch and sparse-switch
+            SWITCH,
+            /// @brief fill-array-data
+            FILL_ARRAY_DATA,
+            /// @brief return*
+            RETURN,
+            /// @brief payload pseudo-opcodes 0x0100, 0x0200 and 0x0300
+            PAYLOAD,
+            /// @brief number of classes
+            CLASSES_NUMBER
+        };
+
+    private:
+        /// @brief number of code units scanned
+        std::size_t units = 0;
+
+        /// @brief number of 64-bit words of each bitmap
+        std::size_t words = 0;
+
+        /// @brief bitmaps of all the classes, one after the other
+        std::vector<std::uint64_t> masks;
+
+        /// @brief Get the bitmap for a class
+        /// @param type class of opcode
+        /// @return pointer to the first word of the bitmap
+        const std::uint64_t *mask(bytecode_class_t type) const
+        {
+            return masks.data() + static_cast<std::size_t>(type) * words;
+        }
+
+    public:
+        /// @brief Create an empty scan
+        BytecodeScan() = default;
+
+        /// @brief Scan the bytecode of a method
+        /// @param bytecode bytecode to scan
+        explicit BytecodeScan(const std::vector<std::uint8_t> &bytecode)
+        {
+            scan(bytecode);
+        }
+
+        /// @brief Scan the bytecode of a method, the previous result is
+        /// replaced and its memory reused
+        /// @param bytecode bytecode to scan
+        void scan(const std::vector<std::uint8_t> &bytecode);
+
+        /// @brief Get the number of code units scanned
+        /// @return number of code units
+        std::size_t get_units() const
+        {
+            return units;
+        }
+
+        /// @brief Check if the code unit in an address is a candidate
+        /// for a class of opcode
+        /// @param type class of opcode
+        /// @param address address in bytes from the start of the method
+        /// @return true if the code unit has an opcode of the class
+        bool is_candidate(bytecode_class_t type, std::uint64_t address) const
+        {
+            auto unit = address >> 1;
+
+            if (unit >= units)
+                return false;
+
+            return (mask(type)[unit >> 6] >> (unit & 63)) & 1;
+        }
+
+        /// @brief Check if the code unit in an address is a candidate for
+        /// any instruction that changes the control flow or points to a
+        /// payload (branches, switches, fill-array-data and returns)
+        /// @param address address in bytes from the start of the method
+        /// @return true if the code unit is a candidate
+        bool is_control_flow_candidate(std::uint64_t address) const
+        {
+            return is_candidate(bytecode_class_t::BRANCH, address) ||
+                   is_candidate(bytecode_class_t::SWITCH, address) ||
+                   is_candidate(bytecode_class_t::FILL_ARRAY_DATA, address) ||
+                   is_candidate(bytecode_class_t::RETURN, address);
+        }
+
+        /// @brief Check if any code unit is a candidate for a class
+        /// @param type class of opcode
+        /// @return true if there is any candidate
+        bool has_candidates(bytecode_class_t type) const;
+
+        /// @brief Get the bitmap of a class, one bit per code unit
+        /// @param type class of opcode
+        /// @return vector with the words of the bitmap
+        std::vector<std::uint64_t> get_mask(bytecode_class_t type) const
+        {
+            auto first = mask(type);
+            return {first, first + words};
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -13,6 +13,7 @@
 #include "Kunai/DEX/parser/parser.hpp"
 #include "Kunai/DEX/DVM/dvm_types.hpp"
 #include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
+#include "Kunai/DEX/DVM/register_list.hpp"
 
 #include <iostream>
 #include <span>
@@ -64,6 +65,19 @@ namespace DEX
         DEX_NONE_OP = 99,
     };
 
+    /// @brief Check the fields of an instruction restricted by its format
+    /// (padding, offsets of the jumps, number of registers) and that its
+    /// references point to items of the DEX file. This is the only copy of
+    /// the checks, the constructors of the instructions throw when it fails
+    /// and Disassembler::is_valid_instruction uses it to not throw.
+    /// @param type format of the instruction
+    /// @param bytecode bytecode of the method, the instruction must fit in it
+    /// @param index index of the instruction
+    /// @param parser parser to check the references, nullptr to skip them
+    /// @return nullptr if the instruction is correct, in other case the error
+    const char *check_instruction(dexinsttype_t type, const std::vector<uint8_t> &bytecode,
+                                  std::size_t index, Parser *parser);
+
     /// @brief Base class for the Instructions of the Dalvik Bytecode
     class Instruction
     {
@@ -1797,8 +1811,8 @@ namespace DEX
         bool is_method = false;
         /// @brief value in string format
         std::string type_str;
-        /// @brief vector with registers (4 bits each)
-        std::vector<std::uint8_t> registers;
+        /// @brief registers (4 bits each), stored in the instruction
+        InlineRegisterList<std::uint8_t> registers;
         /// @brief Parser for the types
         Parser * parser;
     public:
@@ -1811,9 +1825,9 @@ namespace DEX
             return array_size;
         }
 
-        /// @brief Get a constant reference to the vector with the registers
+        /// @brief Get a constant reference to the list with the registers
         /// @return constant reference to registers
-        const std::vector<std::uint8_t>& get_registers() const
+        const InlineRegisterList<std::uint8_t>& get_registers() const
         {
             return registers;
         }
@@ -1825,9 +1839,9 @@ namespace DEX
             return TYPES::Operand::REGISTER;
         }
 
-        /// @brief Get a reference to the vector with the registers
+        /// @brief Get a reference to the list with the registers
         /// @return reference to registers
-        std::vector<std::uint8_t>& get_registers()
+        InlineRegisterList<std::uint8_t>& get_registers()
         {
             return registers;
         }
@@ -1907,9 +1921,9 @@ namespace DEX
         bool is_type = false;
         /// @brief string value of the type
         std::string index_str;
-        /// @brief registers, the registers start by
-        /// one first argument register of 16 bits
-        std::vector<std::uint16_t> registers;
+        /// @brief first register, the registers go from
+        /// vCCCC to vCCCC + array_size - 1
+        std::uint16_t vCCCC;
         /// @brief Parser
         Parser * parser;
     public:
@@ -1930,14 +1944,19 @@ namespace DEX
             return TYPES::Operand::KIND;
         }
 
-        const std::vector<std::uint16_t>& get_registers() const
+        /// @brief Get the first register of the range
+        /// @return vCCCC
+        std::uint16_t get_first_register() const
         {
-            return registers;
+            return vCCCC;
         }
 
-        std::vector<std::uint16_t>& get_registers()
+        /// @brief Get the registers of the instruction, they are
+        /// computed from the first register and the size
+        /// @return range with the registers
+        RegisterRange get_registers() const
         {
-            return registers;
+            return {vCCCC, array_size};
         }
 
         DVMType * get_operand_dvmtype()
@@ -1978,12 +1997,12 @@ namespace DEX
         {
             std::string instruction = DalvikOpcodes::get_instruction_name(op) + " {";
 
-            for(const auto reg : registers)
+            for(const auto reg : get_registers())
             {
                 instruction += "v" + std::to_string(reg) + ", ";
             }
 
-            if (registers.size() > 0)
+            if (array_size > 0)
                 instruction = instruction.substr(0, instruction.size()-2);
             
             instruction += "}, " + index_str;
@@ -2009,8 +2028,8 @@ namespace DEX
     {
         /// @brief number of registers in the operation
         std::uint8_t reg_count;
-        /// @brief registers for the instruction
-        std::vector<std::uint8_t> registers;
+        /// @brief registers for the instruction, stored in the instruction
+        InlineRegisterList<std::uint8_t> registers;
         /// @brief index to the method called
         std::uint16_t method_reference;
         /// @brief possible method
@@ -2027,12 +2046,12 @@ namespace DEX
             return reg_count;
         }
 
-        const std::vector<std::uint8_t>& get_registers() const
+        const InlineRegisterList<std::uint8_t>& get_registers() const
         {
             return registers;
         }
 
-        std::vector<std::uint8_t>& get_registers()
+        InlineRegisterList<std::uint8_t>& get_registers()
         {
             return registers;
         }
@@ -2098,8 +2117,9 @@ namespace DEX
     {
         /// @brief Number of registers
         std::uint8_t reg_count;
-        /// @brief Registers of the instruction
-        std::vector<std::uint16_t> registers;
+        /// @brief First register, the registers go from
+        /// vCCCC to vCCCC + reg_count - 1
+        std::uint16_t vCCCC;
         /// @brief method reference
         std::uint16_t method_reference;
         /// @brief MethodID pointer in case exists
@@ -2116,14 +2136,19 @@ namespace DEX
             return reg_count;
         }
 
-        const std::vector<std::uint16_t>& get_registers() const
+        /// @brief Get the first register of the range
+        /// @return vCCCC
+        std::uint16_t get_first_register() const
         {
-            return registers;
+            return vCCCC;
         }
 
-        std::vector<std::uint16_t>& get_registers()
+        /// @brief Get the registers of the instruction, they are
+        /// computed from the first register and the number of registers
+        /// @return range with the registers
+        RegisterRange get_registers() const
         {
-            return registers;
+            return {vCCCC, reg_count};
         }
         
         std::uint16_t get_method_reference() const
@@ -2152,12 +2177,12 @@ namespace DEX
         {
             std::string instruction = DalvikOpcodes::get_instruction_name(op) + " {";
 
-            for(const auto reg : registers)
+            for(const auto reg : get_registers())
             {
                 instruction += "v" + std::to_string(reg) + ", ";
             }
 
-            if (registers.size() > 0)
+            if (reg_count > 0)
                 instruction = instruction.substr(0, instruction.size()-2);
             
             instruction += "}, ";
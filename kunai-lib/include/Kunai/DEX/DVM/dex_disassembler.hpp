@@ -18,6 +18,9 @@
 #include "Kunai/DEX/DVM/linear_sweep_disassembler.hpp"
 #include "Kunai/DEX/DVM/recursive_traversal_disassembler.hpp"
 
+#include <atomic>
+#include <mutex>
+
 namespace KUNAI
 {
 namespace DEX
@@ -48,13 +51,31 @@ namespace DEX
         /// disassembly to all dex file
         Parser * parser;
 
-        /// @brief Obtain if disassembly was correct
-        bool disassembly_correct = false;
+        /// @brief Obtain if disassembly was correct, it is
+        /// set to false when any method fails in disassembly
+        std::atomic<bool> disassembly_correct = true;
+
+        /// @brief Protects the caches of the methods, it is only held
+        /// while looking up or storing an entry, the bytecode is
+        /// decoded without it
+        std::mutex cache_mutex;
 
         /// @brief An object containing all the instructions from the
         /// dex file
         Disassembler::instructions_t dex_instructions;
 
+        /// @brief Arenas that own the instructions of each method
+        /// from `dex_instructions`
+        std::unordered_map<EncodedMethod *, InstructionArena> method_arenas;
+
+        /// @brief Try blocks and handlers of each method, created
+        /// the first time they are needed
+        std::unordered_map<EncodedMethod *, ExceptionTable> exception_tables;
+
+        /// @brief Arena that owns the instructions returned by
+        /// `disassembly_buffer` when no arena is given
+        InstructionArena buffer_arena;
+
         /// @brief Linear sweep disassembler
         LinearSweepDisassembler linear_sweep;
 
@@ -75,7 +96,8 @@ namespace DEX
         }
 
         /// @brief Set the disassembly algorithm to use in the next calls to
-        /// the different disassembly methods.
+        /// the different disassembly methods. Methods that were already
+        /// disassembled keep the instructions from the previous algorithm.
         /// @param algorithm new algorithm to use
         void set_disassembly_algorithm(disassembly_algorithm algorithm)
         {
@@ -103,25 +125,50 @@ namespace DEX
             return disassembly_correct;
         }
 
-        /// @brief Add the instructions from another disassembler to the
-        /// current one, this invalidate the previous one.
-        /// @param other other dex disassembler
-        void add_disassembly(DexDisassembler& other);
-
         /// @brief This is the most important function from the
         /// disassembler, this function takes the given parser
         /// object and calls one of the internal disassemblers
         /// for retrieving all the instructions from the DEX file
         void disassembly_dex();
 
+        /// @brief Disassembly only one method using the configured
+        /// algorithm. The result is stored in the same cache used by
+        /// `disassembly_dex`, so asking again for the same method does
+        /// not decode its bytecode twice. In case of error an empty
+        /// vector is stored and the disassembly is marked as incorrect.
+        /// The instructions are owned by an arena of the method that lives
+        /// as long as the DexDisassembler. Several threads can disassemble
+        /// methods at the same time once the names of the parser were
+        /// created with Parser::create_pretty_names, if two of them ask for
+        /// the same method the first result stored is kept.
+        /// @param method method to disassembly
+        /// @return reference to the instructions of the method
+        std::vector<Instruction *> &
+            disassemble_method(EncodedMethod *method);
+
+        /// @brief Get the table with the try blocks and handlers of a
+        /// method, the table is created only once and it lives as long
+        /// as the DexDisassembler. It can be called by several threads.
+        /// @param method method of the table
+        /// @return constant reference to the table of the method
+        const ExceptionTable &get_exception_table(EncodedMethod *method);
+
         /// @brief Disassembly a buffer of bytes, take the buffer
-        /// of bytes as dalvik instructions
+        /// of bytes as dalvik instructions. The instructions are owned
+        /// by the DexDisassembler and are valid as long as it lives.
         /// @param buffer buffer with possible bytecode for dalvik
         /// @return vector with disassembled instructions
-        std::vector<std::unique_ptr<Instruction>>
+        std::vector<Instruction *>
             disassembly_buffer(std::vector<std::uint8_t>& buffer);
 
-        DexDisassembler& operator+=(DexDisassembler& other);
+        /// @brief Disassembly a buffer of bytes, take the buffer
+        /// of bytes as dalvik instructions. The instructions are created
+        /// in the given arena, so these are valid as long as the arena lives.
+        /// @param buffer buffer with possible bytecode for dalvik
+        /// @param arena arena that will own the instructions
+        /// @return vector with disassembled instructions
+        std::vector<Instruction *>
+            disassembly_buffer(std::vector<std::uint8_t>& buffer, InstructionArena& arena);
     };
 } // namespace DEX
 } // namespace KUNAI
@@ -11,6 +11,7 @@
 #define KUNAI_DEX_DVM_DISASSEMBLER_HPP
 
 #include "Kunai/DEX/DVM/dalvik_instructions.hpp"
+#include "Kunai/DEX/DVM/instruction_arena.hpp"
 
 #include <memory>
 #include <iostream>
@@ -50,10 +51,10 @@ namespace DEX
         /// @brief For those who just want the full set of instructions
         /// it is possible to retrieve a vector with all the instructions
         /// from the method, it is not needed that these are sorted in any
-        /// way                                         
+        /// way. The instructions are owned by the arena of each method.
         using instructions_t = std::unordered_map
                                 <EncodedMethod*,
-                                std::vector<std::unique_ptr<Instruction>>>;
+                                std::vector<Instruction*>>;
 
     private:
         /// @brief pointer to the parser of the DEX file
@@ -61,8 +62,6 @@ namespace DEX
         /// @brief pointer to the last instruction generated
         /// by the Disassembler
         Instruction * last_instr;
-        /// @brief In case there are no handlers, create a throwable one
-        DVMClass throwable_class{"Ljava/lang/Throwable;"};
         
     public:
 
@@ -76,17 +75,107 @@ namespace DEX
             this->parser = parser;
         }
 
+        /// @brief Get the parser of the disassembler
+        /// @return parser used by the instructions
+        Parser * get_parser()
+        {
+            return parser;
+        }
+
         /// @brief Get an instruction object from the op
         /// @param opcode op code of the instruction to return 
         /// @param bytecode reference to the bytecode for disassembly
         /// @param index index of the current instruction to analyze
-        /// @return unique pointer to the disassembled Instruction
-        std::unique_ptr<Instruction> disassemble_instruction(
+        /// @param arena arena where the instruction is created
+        /// @return pointer to the disassembled Instruction, owned by the arena
+        Instruction * disassemble_instruction(
+            std::uint32_t opcode,
+            std::vector<uint8_t> & bytecode,
+            std::size_t index,
+            InstructionArena & arena
+        );
+
+        /// @brief Get an instruction object from the op, this version
+        /// does not need a Disassembler object so it can be used to
+        /// decode instructions on the fly.
+        /// @param opcode op code of the instruction to return
+        /// @param bytecode reference to the bytecode for disassembly
+        /// @param index index of the current instruction to analyze
+        /// @param parser parser used by some of the instructions
+        /// @param arena arena where the instruction is created
+        /// @return pointer to the disassembled Instruction, owned by the arena
+        static Instruction * disassemble_instruction(
             std::uint32_t opcode,
             std::vector<uint8_t> & bytecode,
+            std::size_t index,
+            Parser * parser,
+            InstructionArena & arena
+        );
+
+        /// @brief Get the size of the instruction in an index without
+        /// decoding it, for the payloads the size is read from their header.
+        /// @param bytecode reference to the bytecode
+        /// @param index index of the instruction
+        /// @return size in bytes of the instruction, 0 if the opcode is not
+        /// recognized. The size can be bigger than the rest of the buffer.
+        static std::uint32_t get_instruction_size(
+            const std::vector<uint8_t> & bytecode,
             std::size_t index
         );
 
+        /// @brief Check if the instruction in an index can be decoded, it
+        /// fits in the buffer and passes check_instruction, the check used
+        /// by the constructors, without creating the instruction or throwing
+        /// exceptions.
+        /// @param bytecode reference to the bytecode
+        /// @param index index of the instruction
+        /// @param parser parser to check the references of the instruction,
+        /// if it is nullptr the references are not checked
+        /// @return true if the instruction fits in the buffer and it is correct
+        static bool is_valid_instruction(
+            const std::vector<uint8_t> & bytecode,
+            std::size_t index,
+            Parser * parser
+        );
+
+        /// @brief Decode the instruction in an index without throwing
+        /// exceptions for incorrect bytes. An unknown opcode, an incorrect
+        /// instruction or an instruction that does not fit before `end` is
+        /// returned as a DalvikIncorrectInstruction.
+        /// @param bytecode reference to the bytecode for disassembly
+        /// @param index index of the current instruction to analyze
+        /// @param end index where the instruction must end at most
+        /// @param arena arena where the instruction is created
+        /// @param size number of bytes used by the instruction, the
+        /// next instruction starts in `index + size`
+        /// @return pointer to the instruction, owned by the arena
+        Instruction * disassemble_checked_instruction(
+            std::vector<uint8_t> & bytecode,
+            std::size_t index,
+            std::size_t end,
+            InstructionArena & arena,
+            std::uint32_t & size
+        );
+
+        /// @brief Same as the other `disassemble_checked_instruction` but
+        /// without a Disassembler object, to decode instructions on the fly
+        /// @param bytecode reference to the bytecode for disassembly
+        /// @param index index of the current instruction to analyze
+        /// @param end index where the instruction must end at most
+        /// @param parser parser used by some of the instructions
+        /// @param arena arena where the instruction is created
+        /// @param size number of bytes used by the instruction, the
+        /// next instruction starts in `index + size`
+        /// @return pointer to the instruction, owned by the arena
+        static Instruction * disassemble_checked_instruction(
+            std::vector<uint8_t> & bytecode,
+            std::size_t index,
+            std::size_t end,
+            Parser * parser,
+            InstructionArena & arena,
+            std::uint32_t & size
+        );
+
         /// @brief Determine given the last instruction the next instruction
         /// to run, the bytecode is retrieved from a :class:EncodedMethod.
         /// The offsets are calculated in number of bytes from the start of the
@@ -122,7 +211,9 @@ namespace DEX
         std::int32_t get_unconditional_jump_target(Instruction * instr);
 
         /// @brief Retrieve information from possible exception code inside
-        /// of a method
+        /// of a method, the try blocks are sorted by start address. This
+        /// creates the data again in each call, use an ExceptionTable (or
+        /// the one cached by the DexDisassembler) to keep it.
         /// @param method method to extract exception data
         /// @return exception data in a vector
         std::vector<exceptions_data> determine_exception(EncodedMethod * method);
@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file disassembly_writer.hpp
+// @brief Writer of the disassembly of a whole DEX file as text, in a
+// format similar to smali. The classes are formatted in parallel and
+// written in order.
+
+#ifndef KUNAI_DEX_DVM_DISASSEMBLY_WRITER_HPP
+#define KUNAI_DEX_DVM_DISASSEMBLY_WRITER_HPP
+
+#include "Kunai/DEX/parser/parser.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <string>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Write the disassembly of all the classes from a DEX file
+    /// as text. Each class is formatted into a memory buffer, the classes
+    /// are split between a pool of threads, and the buffers are written
+    /// to the output in the same order than the classes of the DEX file,
+    /// so the output does not depend on the number of threads:
+    ///
+    ///     DisassemblyWriter writer(dex->get_parser());
+    ///     writer.write("classes.txt");
+    ///
+    /// The instructions are decoded with a linear sweep using an
+    /// InstructionRange, the writer does not use the cache of the
+    /// DexDisassembler so it can be used without disassembling the
+    /// whole file first.
+    class DisassemblyWriter
+    {
+        /// @brief parser of the DEX file
+        Parser *parser;
+
+        /// @brief number of threads to use, 0 for the hardware threads,
+        /// never more than the hardware threads or the classes
+        unsigned threads;
+
+        /// @brief number of buffers of each thread, a class is formatted
+        /// at most this many buffers per thread ahead of the last class
+        /// written, it bounds the memory used
+        static constexpr std::size_t classes_per_thread = 32;
+
+        /// @brief Some names from the parser are created and cached
+        /// the first time they are requested, create all of them
+        /// before the threads access them
+        void prepare_parser();
+
+        /// @brief Format the disassembly of a method
+        /// @param method method to format
+        /// @param out buffer where the text is appended
+        void format_method(EncodedMethod *method, fmt::memory_buffer &out);
+
+    public:
+        /// @brief Constructor of the writer
+        /// @param parser parser of the DEX file
+        /// @param threads number of threads, 0 to use one
+        /// per hardware thread
+        DisassemblyWriter(Parser *parser, unsigned threads = 0)
+            : parser(parser), threads(threads)
+        {
+        }
+
+        /// @brief Change the number of threads used by the writer
+        /// @param threads number of threads, 0 for the hardware threads
+        void set_threads(unsigned threads)
+        {
+            this->threads = threads;
+        }
+
+        /// @brief Format the disassembly of one class, this method only
+        /// reads the parser once it was prepared by a write
+        /// @param class_def class to format
+        /// @param out buffer where the text is appended
+        void format_class(ClassDef *class_def, fmt::memory_buffer &out);
+
+        /// @brief Write the disassembly of all the classes to a file
+        /// descriptor, the descriptor is not closed
+        /// @param fd file descriptor open for writing
+        void write(int fd);
+
+        /// @brief Write the disassembly of all the classes to a file,
+        /// the file is created or truncated
+        /// @param file_path path of the output file
+        void write(const std::string &file_path);
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
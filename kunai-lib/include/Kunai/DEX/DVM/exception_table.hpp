@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file exception_table.hpp
+// @brief Table with the try/catch information of a method, built once
+// from the code item and indexed by address.
+
+#ifndef KUNAI_DEX_DVM_EXCEPTION_TABLE_HPP
+#define KUNAI_DEX_DVM_EXCEPTION_TABLE_HPP
+
+#include "Kunai/DEX/DVM/disassembler.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Try blocks of a method together with their handlers. The
+    /// table is built only once from the TryItems and the
+    /// EncodedCatchHandlers of the method, the try blocks are kept sorted
+    /// by start address. The ranges of the try blocks are split in
+    /// disjoint segments, and each segment stores the try blocks that
+    /// cover it, so the handlers of an address are found with a binary
+    /// search even when the try blocks overlap.
+    ///
+    /// The table stores pointers to its own data, so it can be moved
+    /// but not copied.
+    class ExceptionTable
+    {
+        /// @brief try blocks of the method sorted by start address
+        std::vector<Disassembler::exceptions_data> exceptions;
+
+        /// @brief sorted addresses where a segment starts, the
+        /// segment `i` is [bounds[i], bounds[i+1])
+        std::vector<std::uint64_t> bounds;
+
+        /// @brief position in `covering` of the try blocks of each
+        /// segment, it has one more value than the number of segments
+        std::vector<std::uint32_t> segment_offsets;
+
+        /// @brief try blocks that cover each segment, in the same
+        /// order than `exceptions`
+        std::vector<const Disassembler::exceptions_data *> covering;
+
+        /// @brief Create the index of segments from the try blocks
+        void build_index();
+
+    public:
+        /// @brief Create an empty table, for methods without code
+        ExceptionTable() = default;
+
+        /// @brief Create the table of a method
+        /// @param method method to extract the exception data
+        explicit ExceptionTable(EncodedMethod *method);
+
+        ExceptionTable(const ExceptionTable &) = delete;
+        ExceptionTable &operator=(const ExceptionTable &) = delete;
+
+        ExceptionTable(ExceptionTable &&) = default;
+        ExceptionTable &operator=(ExceptionTable &&) = default;
+
+        /// @brief Get all the try blocks of the method
+        /// @return constant reference to the try blocks, sorted by
+        /// start address
+        const std::vector<Disassembler::exceptions_data> &get_exceptions() const
+        {
+            return exceptions;
+        }
+
+        /// @brief Check if the method has any try block
+        /// @return true if there are no try blocks
+        bool empty() const
+        {
+            return exceptions.empty();
+        }
+
+        /// @brief Get the try blocks that cover an address
+        /// @param address address in bytes from the start of the method
+        /// @return try blocks that contain the address, sorted by start
+        /// address, empty if the address is not inside of any try block
+        std::span<const Disassembler::exceptions_data *const>
+        get_exceptions_at(std::uint64_t address) const;
+
+        /// @brief Check if an address is inside of a try block
+        /// @param address address in bytes from the start of the method
+        /// @return true if any handler covers the address
+        bool is_covered(std::uint64_t address) const
+        {
+            return !get_exceptions_at(address).empty();
+        }
+
+        /// @brief Get the Throwable class used as handler type for the
+        /// catch-all handlers
+        /// @return pointer to a class shared by all the tables
+        static DVMType *get_throwable_class();
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
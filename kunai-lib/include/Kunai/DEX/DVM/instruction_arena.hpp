@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file instruction_arena.hpp
+// @brief Bump allocator for the instructions of the disassembler, all
+// the instructions from a method are created in the same arena and
+// destroyed together with it.
+
+#ifndef KUNAI_DEX_DVM_INSTRUCTION_ARENA_HPP
+#define KUNAI_DEX_DVM_INSTRUCTION_ARENA_HPP
+
+#include "Kunai/DEX/DVM/dalvik_instructions.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Arena that owns the instructions created by the disassembler.
+    /// The instructions are constructed in big chunks of memory instead of
+    /// doing one heap allocation per instruction, and all of them are
+    /// destroyed when the arena is destroyed or cleared. Pointers returned
+    /// by the arena are valid during all its life.
+    class InstructionArena
+    {
+        /// @brief header stored before each instruction, it keeps a list
+        /// of the created instructions in order to call their destructors
+        struct object_header_t
+        {
+            object_header_t *prev;
+            Instruction *object;
+        };
+
+        /// @brief size of the first chunk of memory if no hint is given
+        static constexpr std::size_t default_chunk_size = 1024;
+
+        /// @brief maximum size of an automatically grown chunk
+        static constexpr std::size_t max_chunk_size = 64 * 1024;
+
+        /// @brief chunks of memory used by the arena
+        std::vector<std::unique_ptr<std::byte[]>> chunks;
+
+        /// @brief next free byte of the current chunk
+        std::byte *current = nullptr;
+
+        /// @brief number of free bytes in the current chunk
+        std::size_t remaining = 0;
+
+        /// @brief size of the next chunk to request
+        std::size_t next_chunk_size;
+
+        /// @brief size of the current chunk
+        std::size_t current_chunk_size = 0;
+
+        /// @brief buffer given by the user as first chunk, it is
+        /// not released by the arena
+        std::byte *external = nullptr;
+
+        /// @brief size of the external buffer
+        std::size_t external_size = 0;
+
+        /// @brief last instruction created in the arena
+        object_header_t *last = nullptr;
+
+        /// @brief number of instructions alive in the arena
+        std::size_t objects = 0;
+
+        /// @brief Obtain memory from the current chunk, or from a new
+        /// one in case there is no space
+        /// @param size number of bytes to allocate
+        /// @param alignment alignment of the memory
+        /// @return pointer to the memory
+        void *allocate(std::size_t size, std::size_t alignment);
+
+    public:
+        /// @brief Constructor of the arena
+        /// @param size_hint expected number of bytes to use, the first
+        /// chunk is created with this size
+        explicit InstructionArena(std::size_t size_hint = default_chunk_size)
+            : next_chunk_size(size_hint ? size_hint : default_chunk_size)
+        {
+        }
+
+        /// @brief Constructor of an arena that uses a buffer owned by the
+        /// caller as its first chunk, for example a buffer in the stack. New
+        /// chunks are only requested if the buffer becomes full.
+        /// @param buffer memory to use by the arena
+        /// @param size size of the buffer
+        InstructionArena(std::byte *buffer, std::size_t size)
+            : current(buffer), remaining(size), next_chunk_size(default_chunk_size),
+              external(buffer), external_size(size)
+        {
+        }
+
+        InstructionArena(const InstructionArena &) = delete;
+        InstructionArena &operator=(const InstructionArena &) = delete;
+
+        InstructionArena(InstructionArena &&other) noexcept;
+        InstructionArena &operator=(InstructionArena &&other) noexcept;
+
+        /// @brief Destroy all the instructions from the arena
+        ~InstructionArena()
+        {
+            clear();
+        }
+
+        /// @brief Create an instruction of type T in the arena, in case
+        /// the constructor throws an exception the memory is given back
+        /// to the arena and the exception is propagated.
+        /// @tparam T type of instruction to create
+        /// @tparam ...Args types of the arguments for the constructor
+        /// @param ...args arguments for the constructor
+        /// @return pointer to the new instruction
+        template <typename T, typename... Args>
+        T *make(Args &&...args)
+        {
+            // the header and the instruction are stored together
+            constexpr auto offset = (sizeof(object_header_t) + alignof(T) - 1) & ~(alignof(T) - 1);
+            constexpr auto alignment = alignof(T) > alignof(object_header_t) ? alignof(T) : alignof(object_header_t);
+
+            auto saved_current = current;
+            auto saved_remaining = remaining;
+
+            auto block = static_cast<std::byte *>(allocate(offset + sizeof(T), alignment));
+
+            T *object;
+
+            try
+            {
+                object = ::new (block + offset) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                // give back the memory to the arena
+                current = saved_current;
+                remaining = saved_remaining;
+                throw;
+            }
+
+            auto header = reinterpret_cast<object_header_t *>(block);
+            header->prev = last;
+            header->object = object;
+            last = header;
+            objects++;
+
+            return object;
+        }
+
+        /// @brief Get the number of instructions alive in the arena
+        /// @return number of instructions
+        std::size_t size() const
+        {
+            return objects;
+        }
+
+        /// @brief Destroy all the instructions, the memory of the
+        /// current chunk is kept for reusing it
+        void clear();
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,171 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file instruction_range.hpp
+// @brief Range for iterating over the instructions of a buffer, the
+// instructions are decoded on the fly while the range is iterated.
+
+#ifndef KUNAI_DEX_DVM_INSTRUCTION_RANGE_HPP
+#define KUNAI_DEX_DVM_INSTRUCTION_RANGE_HPP
+
+#include "Kunai/DEX/DVM/disassembler.hpp"
+#include "Kunai/DEX/parser/encoded.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Range over the instructions of a buffer of bytecode. The
+    /// instructions are decoded with a linear sweep while the range is
+    /// traversed, each one in a slot of memory inside of the range that is
+    /// reused by the next one, so no vector of instructions is created and
+    /// the iteration can stop at any moment without decoding the rest.
+    /// It can be used in range-for loops and in std::ranges pipelines:
+    ///
+    ///     InstructionRange range(code_item, parser);
+    ///     for (auto &instr : range | std::views::take(10))
+    ///         ...
+    ///
+    /// As the slot is reused, this is a single pass range: the reference
+    /// obtained from the iterator is valid until the iterator is incremented.
+    /// Calling `begin` again restarts the decoding from the first instruction.
+    class InstructionRange
+    {
+        /// @brief size of the biggest instruction
+        static constexpr std::size_t max_instruction_size = std::max({
+            sizeof(Instruction00x), sizeof(Instruction10x), sizeof(Instruction12x),
+            sizeof(Instruction11n), sizeof(Instruction11x), sizeof(Instruction10t),
+            sizeof(Instruction20t), sizeof(Instruction20bc), sizeof(Instruction22x),
+            sizeof(Instruction21t), sizeof(Instruction21s), sizeof(Instruction21h),
+            sizeof(Instruction21c), sizeof(Instruction23x), sizeof(Instruction22b),
+            sizeof(Instruction22t), sizeof(Instruction22s), sizeof(Instruction22c),
+            sizeof(Instruction22cs), sizeof(Instruction30t), sizeof(Instruction32x),
+            sizeof(Instruction31i), sizeof(Instruction31t), sizeof(Instruction31c),
+            sizeof(Instruction35c), sizeof(Instruction3rc), sizeof(Instruction45cc),
+            sizeof(Instruction4rcc), sizeof(Instruction51l), sizeof(PackedSwitch),
+            sizeof(SparseSwitch), sizeof(FillArrayData), sizeof(DalvikIncorrectInstruction)});
+
+        /// @brief size of the slot, with space for the header
+        /// the arena stores with each instruction
+        static constexpr std::size_t slot_size = max_instruction_size + 4 * alignof(std::max_align_t);
+
+        /// @brief bytecode to decode
+        std::vector<std::uint8_t> &bytecode;
+
+        /// @brief parser used by some of the instructions
+        Parser *parser;
+
+        /// @brief memory where the current instruction is decoded
+        alignas(std::max_align_t) std::byte slot[slot_size];
+
+        /// @brief arena over the slot
+        InstructionArena arena;
+
+        /// @brief current instruction, nullptr once the end is reached
+        Instruction *current = nullptr;
+
+        /// @brief index of the next instruction to decode
+        std::uint64_t next_idx = 0;
+
+        /// @brief Decode the next instruction into the slot, the
+        /// previous instruction is destroyed
+        void decode_next();
+
+    public:
+        /// @brief Iterator over the instructions of the range,
+        /// incrementing it decodes the next instruction.
+        class iterator
+        {
+            /// @brief range that is iterated
+            InstructionRange *range = nullptr;
+
+        public:
+            using iterator_concept = std::input_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Instruction;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Instruction *;
+            using reference = Instruction &;
+
+            iterator() = default;
+
+            explicit iterator(InstructionRange *range) : range(range)
+            {
+            }
+
+            Instruction &operator*() const
+            {
+                return *range->current;
+            }
+
+            Instruction *operator->() const
+            {
+                return range->current;
+            }
+
+            iterator &operator++()
+            {
+                range->decode_next();
+                return *this;
+            }
+
+            void operator++(int)
+            {
+                range->decode_next();
+            }
+
+            bool operator==(std::default_sentinel_t) const
+            {
+                return range == nullptr || range->current == nullptr;
+            }
+        };
+
+        /// @brief Create a range over a buffer of bytecode
+        /// @param bytecode buffer with the instructions
+        /// @param parser parser for the instructions that refer to
+        /// strings, types, fields or methods
+        InstructionRange(std::vector<std::uint8_t> &bytecode, Parser *parser)
+            : bytecode(bytecode), parser(parser), arena(slot, slot_size)
+        {
+        }
+
+        /// @brief Create a range over the bytecode of a method
+        /// @param code_item code of the method
+        /// @param parser parser for the instructions that refer to
+        /// strings, types, fields or methods
+        InstructionRange(CodeItemStruct &code_item, Parser *parser)
+            : InstructionRange(code_item.get_bytecode(), parser)
+        {
+        }
+
+        /// the slot is used by the iterators, the range
+        /// cannot be copied or moved
+        InstructionRange(const InstructionRange &) = delete;
+        InstructionRange &operator=(const InstructionRange &) = delete;
+
+        /// @brief Start decoding from the first instruction
+        /// @return iterator pointing to the first instruction
+        iterator begin()
+        {
+            next_idx = 0;
+            decode_next();
+            return iterator(this);
+        }
+
+        /// @brief Get the end of the range
+        /// @return sentinel for the end of the range
+        std::default_sentinel_t end() const
+        {
+            return std::default_sentinel;
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
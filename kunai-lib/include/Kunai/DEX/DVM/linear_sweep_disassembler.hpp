@@ -18,20 +18,37 @@ namespace DEX
     /// @brief LinearSweepDisassembler is one of the DEX disassembly
     /// algorithms implemented by Kunai, this algorithm will go from
     /// the first byte of a buffer to the last one disassemblying all
-    /// the found instructions.
+    /// the found instructions. The payloads of the switches and the
+    /// fill-array-data are found first and skipped, so their data is
+    /// never decoded as code, and incorrect bytes are returned as
+    /// DalvikIncorrectInstruction without using exceptions.
     class LinearSweepDisassembler
     {
+        /// @brief range [start, end) of a payload in the buffer
+        using payload_range_t = std::pair<std::uint64_t, std::uint64_t>;
+
         /// @brief Internal disassembler
         Disassembler *disassembler;
 
+        /// @brief Find the payloads referenced by the packed-switch,
+        /// sparse-switch and fill-array-data instructions, only the
+        /// sizes of the instructions are read, nothing is decoded.
+        /// @param buffer_bytes bytes to disassembly
+        /// @param payloads vector where the ranges are stored, sorted
+        /// and without overlaps
+        void find_payloads(std::vector<std::uint8_t> &buffer_bytes,
+                           std::vector<payload_range_t> &payloads);
+
         /// @brief If there's any switch in code, we will assign to some instructions
-        /// the PackedSwitch or the SparswSwitch value
+        /// the PackedSwitch or the SparswSwitch value, payloads are searched
+        /// with a binary search as the instructions are sorted by address.
         /// @param instructions all the buffer with the instructions from a method.
-        /// @param cache_instructions cache of instructions for avoiding searching
-        /// always in the vector
+        /// @param first position of the first instruction from the method
+        /// @param switches positions of the switch instructions in `instructions`
         void assign_switch_if_any(
-            std::vector<std::unique_ptr<Instruction>> &instructions,
-            std::unordered_map<std::uint64_t, Instruction *> &cache_instructions);
+            std::vector<Instruction *> &instructions,
+            std::size_t first,
+            const std::vector<std::size_t> &switches);
 
     public:
         LinearSweepDisassembler() = default;
@@ -47,8 +64,10 @@ namespace DEX
         /// byte
         /// @param buffer_bytes bytes to disassembly
         /// @param instructions vector where to store the instructions
+        /// @param arena arena where the instructions are created
         void disassembly(std::vector<std::uint8_t> &buffer_bytes,
-                            std::vector<std::unique_ptr<Instruction>> &instructions);
+                            std::vector<Instruction *> &instructions,
+                            InstructionArena &arena);
     };
 } // DEX
 } // KUNAI
@@ -10,7 +10,7 @@
 #define KUNAI_DEX_DVM_RECURSIVE_TRAVERSAL_DISASSEMBLER_HPP
 
 #include "Kunai/DEX/DVM/disassembler.hpp"
-#include <queue>
+#include "Kunai/DEX/DVM/exception_table.hpp"
 
 namespace KUNAI
 {
@@ -24,19 +24,17 @@ namespace DEX
         /// @brief Internal disassembler
         Disassembler *disassembler;
 
-        /// @brief Queue for keeping track of followed paths
-        std::queue<std::uint64_t> Q;
-
-        /// @brief If there's any switch in code, we will assign to some instructions
-        /// the PackedSwitch or the SparswSwitch value
-        /// @param instructions buffer with all the instructions
-        /// @param cache_instrs cache of the instructions for quickly look for instructions
-        /// by address
+        /// @brief Decode the payload pointed by a `fill-array-data` or
+        /// a switch instruction, in case of a switch assign the PackedSwitch
+        /// or the SparseSwitch to the instruction.
+        /// @param instr31t instruction that points to the payload
         /// @param buffer_bytes buffer with the bytes from the method
-        void analyze_switch(
-            std::vector<std::unique_ptr<Instruction>> &instructions,
-            std::unordered_map<std::uint64_t, Instruction *> &cache_instrs,
-            std::vector<std::uint8_t> &buffer_bytes);
+        /// @param arena arena where the payload is created
+        /// @return number of new instructions decoded (0 or 1)
+        std::size_t analyze_payload(
+            Instruction31t *instr31t,
+            std::vector<std::uint8_t> &buffer_bytes,
+            InstructionArena &arena);
 
     public:
         RecursiveTraversalDisassembler() = default;
@@ -47,15 +45,29 @@ namespace DEX
         }
 
         /// @brief This function implements the algorithm of disassembly
-        /// of linear sweep, the function receives a buffer of bytes and
-        /// the buffer is traversed in a linear way disassembling each
-        /// byte
+        /// of recursive traversal, the function receives a buffer of bytes
+        /// and follows the control flow from the entry point and the
+        /// exception handlers. Visited addresses are kept in a bitmap of
+        /// code units and the instructions are emitted sorted by address.
         /// @param buffer_bytes bytes to disassembly
         /// @param method the method to determine the exceptions
         /// @param instructions vector where to store the instructions
+        /// @param arena arena where the instructions are created
         void disassembly(std::vector<std::uint8_t> &buffer_bytes,
                             EncodedMethod *method,
-                            std::vector<std::unique_ptr<Instruction>> &instructions);
+                            std::vector<Instruction *> &instructions,
+                            InstructionArena &arena);
+
+        /// @brief Same as the other `disassembly` but it takes the
+        /// exception handlers from a table already created for the method
+        /// @param buffer_bytes bytes to disassembly
+        /// @param exception_table try blocks and handlers of the method
+        /// @param instructions vector where to store the instructions
+        /// @param arena arena where the instructions are created
+        void disassembly(std::vector<std::uint8_t> &buffer_bytes,
+                            const ExceptionTable &exception_table,
+                            std::vector<Instruction *> &instructions,
+                            InstructionArena &arena);
     };
 } // namespace DEX
 } // namespace KUNAI
@@ -0,0 +1,263 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file register_list.hpp
+// @brief Lists of registers used by the instructions with a variable
+// number of registers (invoke-*, filled-new-array...), they do not need
+// memory from the heap.
+
+#ifndef KUNAI_DEX_DVM_REGISTER_LIST_HPP
+#define KUNAI_DEX_DVM_REGISTER_LIST_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief List of registers stored inside of the instruction, used
+    /// by the formats that encode each register (35c and 45cc), these
+    /// formats have at most 5 registers.
+    /// @tparam T type of the registers
+    /// @tparam N maximum number of registers
+    template <typename T, std::size_t N = 5>
+    class InlineRegisterList
+    {
+        /// @brief registers of the list
+        std::array<T, N> registers{};
+
+        /// @brief number of registers used
+        std::uint8_t count = 0;
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using const_iterator = const T *;
+        using iterator = const_iterator;
+
+        /// @brief Add a register to the list, the caller must not
+        /// add more than N registers
+        /// @param reg register to add
+        void push_back(T reg)
+        {
+            registers[count++] = reg;
+        }
+
+        /// @brief Get the number of registers
+        /// @return number of registers
+        std::size_t size() const
+        {
+            return count;
+        }
+
+        /// @brief Check if the list has no registers
+        /// @return true if there are no registers
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /// @brief Get a register by its position
+        /// @param pos position of the register
+        /// @return register
+        T operator[](std::size_t pos) const
+        {
+            return registers[pos];
+        }
+
+        /// @brief Get the first register of the list
+        /// @return first register
+        T front() const
+        {
+            return registers[0];
+        }
+
+        /// @brief Get the last register of the list
+        /// @return last register
+        T back() const
+        {
+            return registers[count - 1];
+        }
+
+        const_iterator begin() const
+        {
+            return registers.data();
+        }
+
+        const_iterator end() const
+        {
+            return registers.data() + count;
+        }
+    };
+
+    /// @brief Range of consecutive registers used by the formats
+    /// 3rc and 4rcc, the registers are not stored, they are computed
+    /// from the first register and the number of registers.
+    class RegisterRange
+    {
+        /// @brief first register of the range
+        std::uint32_t first = 0;
+
+        /// @brief number of registers
+        std::uint32_t count = 0;
+
+    public:
+        /// @brief Iterator over the registers of the range
+        class const_iterator
+        {
+            /// @brief current register
+            std::uint32_t reg = 0;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::uint16_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = std::uint16_t;
+
+            const_iterator() = default;
+
+            explicit const_iterator(std::uint32_t reg) : reg(reg)
+            {
+            }
+
+            std::uint16_t operator*() const
+            {
+                return static_cast<std::uint16_t>(reg);
+            }
+
+            std::uint16_t operator[](difference_type n) const
+            {
+                return static_cast<std::uint16_t>(reg + n);
+            }
+
+            const_iterator &operator++()
+            {
+                reg++;
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                auto it = *this;
+                reg++;
+                return it;
+            }
+
+            const_iterator &operator--()
+            {
+                reg--;
+                return *this;
+            }
+
+            const_iterator operator--(int)
+            {
+                auto it = *this;
+                reg--;
+                return it;
+            }
+
+            const_iterator &operator+=(difference_type n)
+            {
+                reg = static_cast<std::uint32_t>(reg + n);
+                return *this;
+            }
+
+            const_iterator &operator-=(difference_type n)
+            {
+                reg = static_cast<std::uint32_t>(reg - n);
+                return *this;
+            }
+
+            friend const_iterator operator+(const_iterator it, difference_type n)
+            {
+                return it += n;
+            }
+
+            friend const_iterator operator+(difference_type n, const_iterator it)
+            {
+                return it += n;
+            }
+
+            friend const_iterator operator-(const_iterator it, difference_type n)
+            {
+                return it -= n;
+            }
+
+            friend difference_type operator-(const_iterator a, const_iterator b)
+            {
+                return static_cast<difference_type>(a.reg) - static_cast<difference_type>(b.reg);
+            }
+
+            friend auto operator<=>(const_iterator a, const_iterator b) = default;
+        };
+
+        using value_type = std::uint16_t;
+        using size_type = std::size_t;
+        using iterator = const_iterator;
+
+        RegisterRange() = default;
+
+        /// @brief Create a range of registers
+        /// @param first first register
+        /// @param count number of registers
+        RegisterRange(std::uint16_t first, std::uint16_t count)
+            : first(first), count(count)
+        {
+        }
+
+        /// @brief Get the number of registers
+        /// @return number of registers
+        std::size_t size() const
+        {
+            return count;
+        }
+
+        /// @brief Check if the range has no registers
+        /// @return true if there are no registers
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /// @brief Get a register by its position
+        /// @param pos position of the register
+        /// @return register
+        std::uint16_t operator[](std::size_t pos) const
+        {
+            return static_cast<std::uint16_t>(first + pos);
+        }
+
+        /// @brief Get the first register of the range
+        /// @return first register
+        std::uint16_t front() const
+        {
+            return static_cast<std::uint16_t>(first);
+        }
+
+        /// @brief Get the last register of the range
+        /// @return last register
+        std::uint16_t back() const
+        {
+            return static_cast<std::uint16_t>(first + count - 1);
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(first);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(first + count);
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -12,11 +12,17 @@
 
 #include "Kunai/DEX/parser/parser.hpp"
 #include "Kunai/DEX/DVM/disassembler.hpp"
+#include "Kunai/DEX/DVM/exception_table.hpp"
 #include "Kunai/DEX/analysis/external_class.hpp"
+#include "Kunai/DEX/analysis/xrefs.hpp"
 #include "Kunai/DEX/DVM/dalvik_instructions.hpp"
 #include "Kunai/Exceptions/analysis_exception.hpp"
 
+#include <deque>
+#include <mutex>
 #include <set>
+#include <span>
+#include <unordered_set>
 #include <variant>
 
 namespace KUNAI
@@ -28,6 +34,7 @@ namespace KUNAI
         class MethodAnalysis;
         class FieldAnalysis;
         class BasicBlocks;
+        class DexDisassembler;
 
         /// @brief Class that contain the instructions of basic block
         /// different DVMBasicBlock exists
@@ -45,7 +52,12 @@ namespace KUNAI
             /// @brief is end block? (empty block)
             bool end_block = false;
             /// @brief Handler type
-            DVMType * handler_type;
+            DVMType * handler_type = nullptr;
+
+            /// @brief id of the block in its graph
+            std::uint32_t id = 0;
+
+            friend class BasicBlocks;
 
             /// @brief name of the block composed by
             /// first and last address
@@ -53,6 +65,14 @@ namespace KUNAI
         public:
             DVMBasicBlock() = default;
 
+            /// @brief Get the id of the block, its position in the
+            /// BasicBlocks that created it
+            /// @return id of the block
+            std::uint32_t get_id() const
+            {
+                return id;
+            }
+
             /// @brief Obtain the number of instructions from the instructions vector
             /// @return number of instructions of DVMBasicBlock
             size_t get_nb_instructions() const
@@ -200,10 +220,24 @@ namespace KUNAI
             }
         };
 
-        /// @brief Class to keep all the Dalvik Basic Blocks from a method
+        /// @brief Class to keep all the Dalvik Basic Blocks from a method.
+        /// The blocks are stored by the graph and identified by a number,
+        /// the position where they were created. The edges are kept in
+        /// the order they were added, and the sucessors and predecessors
+        /// of each block are stored in compressed sparse row form (one
+        /// array with the neighbours of all the blocks, and the offsets
+        /// where the neighbours of each block start), created again
+        /// only after the edges change. The exceptions thrown inside
+        /// a try are kept as a second set of edges, from the blocks
+        /// covered by the try to the blocks of its handlers, so the
+        /// normal edges only follow the jumps and the fallthroughs.
+        /// The pointers to the blocks are stable, the API with pointers
+        /// is a view of the ids.
         class BasicBlocks
         {
         public:
+            /// @brief id of a block, its position in the graph
+            using block_id_t = std::uint32_t;
             /// @brief blocks that are connected with others
             using connected_blocks_t = std::unordered_map<DVMBasicBlock *,
                                                           std::set<DVMBasicBlock *>>;
@@ -218,33 +252,222 @@ namespace KUNAI
                 REGULAR_NODE,  // other cases
             };
 
+            /// @brief View of a list of block ids as pointers to the blocks
+            class block_view_t
+            {
+                /// @brief ids of the blocks
+                std::span<const block_id_t> ids;
+                /// @brief storage of the blocks
+                const std::deque<DVMBasicBlock> *blocks = nullptr;
+
+            public:
+                /// @brief Iterator that gives pointers to the blocks
+                class iterator
+                {
+                    const block_id_t *id = nullptr;
+                    const std::deque<DVMBasicBlock> *blocks = nullptr;
+
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = DVMBasicBlock *;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = void;
+                    using reference = DVMBasicBlock *;
+
+                    iterator() = default;
+
+                    iterator(const block_id_t *id, const std::deque<DVMBasicBlock> *blocks)
+                        : id(id), blocks(blocks)
+                    {
+                    }
+
+                    DVMBasicBlock *operator*() const
+                    {
+                        return const_cast<DVMBasicBlock *>(&(*blocks)[*id]);
+                    }
+
+                    iterator &operator++()
+                    {
+                        id++;
+                        return *this;
+                    }
+
+                    iterator operator++(int)
+                    {
+                        auto it = *this;
+                        id++;
+                        return it;
+                    }
+
+                    bool operator==(const iterator &other) const
+                    {
+                        return id == other.id;
+                    }
+                };
+
+                block_view_t() = default;
+
+                block_view_t(std::span<const block_id_t> ids, const std::deque<DVMBasicBlock> *blocks)
+                    : ids(ids), blocks(blocks)
+                {
+                }
+
+                /// @brief Get the number of blocks in the view
+                /// @return number of blocks
+                std::size_t size() const
+                {
+                    return ids.size();
+                }
+
+                /// @brief Check if there are no blocks in the view
+                /// @return true if the view is empty
+                bool empty() const
+                {
+                    return ids.empty();
+                }
+
+                /// @brief Get a block by its position in the view
+                /// @param pos position in the view
+                /// @return pointer to the block
+                DVMBasicBlock *operator[](std::size_t pos) const
+                {
+                    return const_cast<DVMBasicBlock *>(&(*blocks)[ids[pos]]);
+                }
+
+                /// @brief Get the ids of the blocks of the view
+                /// @return ids of the blocks
+                std::span<const block_id_t> get_ids() const
+                {
+                    return ids;
+                }
+
+                iterator begin() const
+                {
+                    return iterator(ids.data(), blocks);
+                }
+
+                iterator end() const
+                {
+                    return iterator(ids.data() + ids.size(), blocks);
+                }
+            };
+
         private:
-            /// @brief all the basic blocks from a method
-            std::vector<DVMBasicBlock *> nodes;
+            /// @brief storage of all the blocks created in the graph,
+            /// the id of a block is its position, a deque does not move
+            /// the blocks when it grows
+            std::deque<DVMBasicBlock> blocks;
 
-            /// @brief set of nodes that are predecessors of a node
-            connected_blocks_t predecessors;
+            /// @brief is the block with that id in the graph? the
+            /// removed blocks are kept in the storage
+            std::vector<std::uint8_t> in_graph;
 
-            /// @brief set of nodes that are sucessors of a node
-            connected_blocks_t sucessors;
+            /// @brief all the basic blocks from a method, in the
+            /// order they were added
+            std::vector<DVMBasicBlock *> nodes;
 
             /// @brief edges in the graph, this is a directed graph
             edges_t edges;
 
-        public:
-            BasicBlocks() = default;
+            /// @brief edges in the graph as a pair of ids packed in
+            /// one value, to check in O(1) if an edge already exists
+            std::unordered_set<std::uint64_t> edge_set;
+
+            /// @brief start of the sucessors of each block in
+            /// `sucessor_ids`, one more value than blocks
+            mutable std::vector<std::uint32_t> sucessor_offsets;
+
+            /// @brief sucessors of all the blocks
+            mutable std::vector<block_id_t> sucessor_ids;
+
+            /// @brief start of the predecessors of each block in
+            /// `predecessor_ids`, one more value than blocks
+            mutable std::vector<std::uint32_t> predecessor_offsets;
+
+            /// @brief predecessors of all the blocks
+            mutable std::vector<block_id_t> predecessor_ids;
+
+            /// @brief edges from the blocks covered by a try to the
+            /// blocks of its handlers, kept apart from the normal edges
+            edges_t exception_edges;
+
+            /// @brief exceptional edges as a pair of ids packed in one value
+            std::unordered_set<std::uint64_t> exception_edge_set;
+
+            /// @brief start of the exceptional sucessors of each block
+            /// in `exception_sucessor_ids`, one more value than blocks
+            mutable std::vector<std::uint32_t> exception_sucessor_offsets;
+
+            /// @brief handlers of all the blocks
+            mutable std::vector<block_id_t> exception_sucessor_ids;
+
+            /// @brief start of the exceptional predecessors of each
+            /// block in `exception_predecessor_ids`, one more value than blocks
+            mutable std::vector<std::uint32_t> exception_predecessor_offsets;
+
+            /// @brief blocks that can throw to each handler
+            mutable std::vector<block_id_t> exception_predecessor_ids;
+
+            /// @brief are the sucessors and predecessors updated?
+            mutable bool adjacency_valid = false;
+
+            /// @brief sets of predecessors created from the adjacency
+            /// for the API with maps
+            mutable connected_blocks_t predecessors;
+
+            /// @brief sets of sucessors created from the adjacency
+            /// for the API with maps
+            mutable connected_blocks_t sucessors;
+
+            /// @brief are the maps of predecessors and sucessors updated?
+            mutable bool connected_valid = false;
 
-            /// @brief Destructor of the BasicBlocks, we need
-            /// to free the memory
-            ~BasicBlocks()
+            /// @brief first address of the blocks with instructions,
+            /// sorted, used to find a block by address
+            std::vector<std::uint64_t> block_starts;
+
+            /// @brief blocks in the same order than `block_starts`
+            std::vector<DVMBasicBlock *> blocks_by_address;
+
+            /// @brief is the index of blocks by address updated?
+            bool block_index_valid = false;
+
+            /// @brief Create the index of blocks by address, it is
+            /// created again only after the nodes have changed
+            void build_block_index();
+
+            /// @brief Create the sucessors and predecessors of each
+            /// block from the edges and the exceptional edges
+            void build_adjacency() const;
+
+            /// @brief Create the maps of sucessors and predecessors
+            void build_connected() const;
+
+            /// @brief The edges have changed, the adjacency must
+            /// be created again
+            void invalidate_edges()
             {
-                // free memory
-                for (auto p : nodes)
-                    delete p;
-                // clear de vector of nodes
-                nodes.clear();
+                adjacency_valid = false;
+                connected_valid = false;
             }
 
+            /// @brief Check if a block was created by this graph
+            /// @param node block to check
+            /// @return true if the block is stored in this graph
+            bool owns(const DVMBasicBlock *node) const
+            {
+                return node && node->get_id() < blocks.size() &&
+                       &blocks[node->get_id()] == node;
+            }
+
+        public:
+            BasicBlocks() = default;
+
+            /// @brief The nodes keep pointers to the storage, so
+            /// a graph cannot be copied
+            BasicBlocks(const BasicBlocks &) = delete;
+            BasicBlocks &operator=(const BasicBlocks &) = delete;
+
             /// @brief Return the number of basic blocks in the graph
             /// @return number of basic blocks
             size_t get_number_of_basic_blocks() const
@@ -252,109 +475,176 @@ namespace KUNAI
                 return nodes.size();
             }
 
-            /// @brief Get all predecessors from all the blocks
-            /// @return constant reference to predecessors
-            const connected_blocks_t& get_predecessors() const
+            /// @brief Get the number of ids given to the blocks, the
+            /// removed blocks keep their id, useful to create arrays
+            /// indexed by the id of the blocks
+            /// @return number of ids
+            size_t get_number_of_block_ids() const
             {
-                return predecessors;
+                return blocks.size();
             }
 
-            /// @brief Get all predecessors from all the blocks
-            /// @return reference to predecessors
-            connected_blocks_t& get_predecessors()
+            /// @brief Get a block by its id
+            /// @param id id of the block
+            /// @return pointer to the block
+            DVMBasicBlock *get_block(block_id_t id)
             {
-                return predecessors;
+                return &blocks[id];
             }
 
-            /// @brief Add a node to the list of predecessors of another
-            /// @param node node to add predecessor
-            /// @param pred predecessor node
-            void add_predecessor(DVMBasicBlock *node, DVMBasicBlock *pred)
+            /// @brief Get a block by its id
+            /// @param id id of the block
+            /// @return constant pointer to the block
+            const DVMBasicBlock *get_block(block_id_t id) const
             {
-                predecessors[node].insert(pred);
+                return &blocks[id];
             }
 
-            /// @brief Get all sucessors from all the blocks
-            /// @return constant reference to sucessors
-            const connected_blocks_t& get_sucessors() const
+            /// @brief Check if the block with an id is in the graph
+            /// @param id id of the block
+            /// @return false if the block was removed
+            bool contains(block_id_t id) const
             {
-                return sucessors;
+                return id < in_graph.size() && in_graph[id];
             }
 
-            /// @brief Get all sucessors from all the blocks
-            /// @return reference to sucessors
-            connected_blocks_t& get_sucessors()
+            /// @brief Create a new empty block in the graph, the block
+            /// is owned by the graph
+            /// @return pointer to the new block
+            DVMBasicBlock *create_block();
+
+            /// @brief Get the ids of the sucessors of a block, in the
+            /// order the edges were added
+            /// @param id id of the block
+            /// @return ids of the sucessors
+            std::span<const block_id_t> get_sucessor_ids(block_id_t id) const;
+
+            /// @brief Get the ids of the predecessors of a block, in the
+            /// order the edges were added
+            /// @param id id of the block
+            /// @return ids of the predecessors
+            std::span<const block_id_t> get_predecessor_ids(block_id_t id) const;
+
+            /// @brief Get the ids of the handlers where a block can
+            /// throw, they are not in `get_sucessor_ids`
+            /// @param id id of the block
+            /// @return ids of the blocks of the handlers
+            std::span<const block_id_t> get_exception_sucessor_ids(block_id_t id) const;
+
+            /// @brief Get the ids of the blocks that can throw to a
+            /// handler, they are not in `get_predecessor_ids`
+            /// @param id id of the block of the handler
+            /// @return ids of the blocks covered by the try
+            std::span<const block_id_t> get_exception_predecessor_ids(block_id_t id) const;
+
+            /// @brief Check if a block is only reached by the exceptions,
+            /// the handlers that nothing jumps to are connected with the
+            /// start block, that edge must be skipped when the exceptional
+            /// edges are followed
+            /// @param id id of the block
+            /// @return true if the only predecessor of the block is the
+            /// start block and it has exceptional predecessors
+            bool is_reached_by_exceptions_only(block_id_t id) const;
+
+            /// @brief Get the sucessors of a block
+            /// @param node block to retrieve its sucessors
+            /// @return view with the sucessors of the block
+            block_view_t get_sucessors(const DVMBasicBlock *node) const
             {
-                return sucessors;
+                return {get_sucessor_ids(node->get_id()), &blocks};
             }
 
-            /// @brief Add a node to the list of sucessors of another
-            /// @param node node to add sucessor
-            /// @param suc sucessor node
-            void add_sucessor(DVMBasicBlock *node, DVMBasicBlock *suc)
+            /// @brief Get the predecessors of a block
+            /// @param node block to retrieve its predecessors
+            /// @return view with the predecessors of the block
+            block_view_t get_predecessors(const DVMBasicBlock *node) const
             {
-                sucessors[node].insert(suc);
+                return {get_predecessor_ids(node->get_id()), &blocks};
             }
 
-            /// @brief Add a node to the vector of nodes, we will transfer the
-            /// ownership
-            /// @param node node to push into our vector
-            void add_node(DVMBasicBlock *node)
+            /// @brief Get all predecessors from all the blocks, the map
+            /// is created from the adjacency the first time it is requested
+            /// after a change, prefer `get_predecessors(node)`
+            /// @return constant reference to predecessors
+            const connected_blocks_t &get_predecessors() const
             {
-                if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
-                    nodes.push_back(node);
+                if (!connected_valid)
+                    build_connected();
+                return predecessors;
             }
 
-            /// @brief Add an edge to the basic blocks
-            /// @param src source node
-            /// @param dst edge node
-            void add_edge(DVMBasicBlock *src, DVMBasicBlock *dst)
+            /// @brief Get all sucessors from all the blocks, the map is
+            /// created from the adjacency the first time it is requested
+            /// after a change, prefer `get_sucessors(node)`
+            /// @return constant reference to sucessors
+            const connected_blocks_t &get_sucessors() const
             {
-                add_node(src);
-                add_node(dst);
-                // now insert the edge
-                auto edge_pair = std::make_pair(src, dst);
-                if (std::find(edges.begin(), edges.end(), edge_pair) == edges.end())
-                    edges.push_back(edge_pair);
-                /// now add the sucessors and predecessors
-                add_sucessor(src, dst);
-                add_predecessor(dst, src);
+                if (!connected_valid)
+                    build_connected();
+                return sucessors;
             }
 
+            /// @brief Add a node to the vector of nodes, the node must
+            /// be created by `create_block`, it is only added again in
+            /// case it was removed
+            /// @param node node to push into our vector
+            void add_node(DVMBasicBlock *node);
+
+            /// @brief Add an edge to the basic blocks, in case the edge
+            /// already exists nothing is done
+            /// @param src source node
+            /// @param dst edge node
+            void add_edge(DVMBasicBlock *src, DVMBasicBlock *dst);
+
             /// @brief Get a constant reference to the edges of the graph
             /// @return constant reference to the edges
-            const edges_t& get_edges() const
+            const edges_t &get_edges() const
             {
                 return edges;
             }
 
-            /// @brief Get a reference to the edges of the graph
-            /// @return reference to the edges
-            edges_t& get_edges()
+            /// @brief Add an exceptional edge, from a block with an
+            /// instruction covered by a try to the block of one of its
+            /// handlers, in case the edge already exists nothing is done
+            /// @param src block covered by the try
+            /// @param dst block of the handler
+            void add_exception_edge(DVMBasicBlock *src, DVMBasicBlock *dst);
+
+            /// @brief Get a constant reference to the exceptional edges
+            /// of the graph, the blocks of the handlers are also connected
+            /// with normal edges (from the start block when nothing else
+            /// jumps to them)
+            /// @return constant reference to the exceptional edges
+            const edges_t &get_exception_edges() const
             {
-                return edges;
+                return exception_edges;
             }
 
             /// @brief Get the node type between JOIN_NODE, BRANCH_NODE or REGULAR_NODE
             /// @param node node to check
             /// @return type of node
-            node_type_t get_node_type(DVMBasicBlock *node)
+            node_type_t get_node_type(DVMBasicBlock *node) const
             {
-                if (predecessors[node].size() > 1)
+                if (get_predecessor_ids(node->get_id()).size() > 1)
                     return JOIN_NODE;
-                else if (sucessors[node].size() > 1)
+                else if (get_sucessor_ids(node->get_id()).size() > 1)
                     return BRANCH_NODE;
                 else
                     return REGULAR_NODE;
             }
 
-            /// @brief Remove a node from the graph, this operation can
-            /// be expensive on time
+            /// @brief Remove a node from the graph, the predecessors of
+            /// the node are connected with its sucessors, its exceptional
+            /// edges are removed. The block is kept in the storage of the
+            /// graph until the graph is destroyed.
             /// @param node node to remove
             void remove_node(DVMBasicBlock *node);
 
             /// @brief Get a basic block given an idx, the idx can be one
-            /// address from the first to the last address of the block
+            /// address from the first to the last address of the block.
+            /// The block is found with a binary search over the first
+            /// addresses of the blocks, the instructions of the blocks
+            /// must not change once the blocks are searched.
             /// @param idx address of the block to retrieve
             /// @return block that contains an instruction in that address
             DVMBasicBlock *get_basic_block_by_idx(std::uint64_t idx);
@@ -365,13 +655,6 @@ namespace KUNAI
             {
                 return nodes;
             }
-
-            /// @brief Get a reference to the nodes of the graph
-            /// @return reference to basic blocks
-            std::vector<DVMBasicBlock *>& get_nodes()
-            {
-                return nodes;
-            }
         };
 
         /// @brief specification of a field analysis
@@ -381,10 +664,10 @@ namespace KUNAI
             EncodedField *field;
             /// @brief name of the field
             std::string &name;
-            /// @brief xrefs where field is read
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> xrefread;
-            /// @brief xrefs where field is written
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> xrefwrite;
+            /// @brief table with the xrefs of the analysis
+            const XrefTable *xref_table = nullptr;
+            /// @brief id of the field in the xref table
+            XrefTable::symbol_id_t id = XrefTable::symbol_id_t(SymbolTable::no_symbol);
 
         public:
             FieldAnalysis(EncodedField *field)
@@ -402,46 +685,27 @@ namespace KUNAI
                 return name;
             }
 
-            const std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefread() const
+            /// @brief Set the table where the xrefs of the field are
+            /// @param table xref table of the analysis
+            /// @param field_id id of the field in the symbol table
+            void set_xref_table(const XrefTable *table, XrefTable::symbol_id_t field_id)
             {
-                return xrefread;
+                xref_table = table;
+                id = field_id;
             }
 
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefread()
+            /// @brief Get the xrefs where the field is read
+            /// @return view of (class, method, offset)
+            auto get_xrefread() const
             {
-                return xrefread;
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::FIELD_READ, id, XrefTable::caller);
             }
 
-            const std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefwrite() const
+            /// @brief Get the xrefs where the field is written
+            /// @return view of (class, method, offset)
+            auto get_xrefwrite() const
             {
-                return xrefwrite;
-            }
-
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefwrite()
-            {
-                return xrefwrite;
-            }
-
-            /// @brief Add a cross reference where the field is read in code
-            /// @param c class where is read
-            /// @param m method where is read
-            /// @param offset idx where is read
-            void add_xrefread(ClassAnalysis *c, MethodAnalysis *m, std::uint64_t offset)
-            {
-                xrefread.push_back(std::make_tuple(c, m, offset));
-            }
-
-            /// @brief Add a cross reference where the field is written in code
-            /// @param c class where is written
-            /// @param m method where is written
-            /// @param offset idx where is written
-            void add_xrefwrite(ClassAnalysis *c, MethodAnalysis *m, std::uint64_t offset)
-            {
-                xrefwrite.push_back(std::make_tuple(c, m, offset));
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::FIELD_WRITE, id, XrefTable::caller);
             }
         };
 
@@ -450,8 +714,10 @@ namespace KUNAI
         {
             /// @brief Value of the string
             std::string &value;
-            /// @brief xref where the string is used
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> xreffrom;
+            /// @brief table with the xrefs of the analysis
+            const XrefTable *xref_table = nullptr;
+            /// @brief id of the string in the xref table
+            XrefTable::symbol_id_t id = XrefTable::symbol_id_t(SymbolTable::no_symbol);
 
         public:
             StringAnalysis(std::string &value) : value(value)
@@ -463,25 +729,20 @@ namespace KUNAI
                 return value;
             }
 
-            const std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xreffrom() const
-            {
-                return xreffrom;
-            }
-
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xreffrom()
+            /// @brief Set the table where the xrefs of the string are
+            /// @param table xref table of the analysis
+            /// @param string_id id of the string in the symbol table
+            void set_xref_table(const XrefTable *table, XrefTable::symbol_id_t string_id)
             {
-                return xreffrom;
+                xref_table = table;
+                id = string_id;
             }
 
-            /// @brief Add a cross reference where the string is read
-            /// @param c class where is read
-            /// @param m method where is read
-            /// @param offset offset where is read
-            void add_xreffrom(ClassAnalysis *c, MethodAnalysis *m, std::uint64_t offset)
+            /// @brief Get the xrefs where the string is used
+            /// @return view of (class, method, offset)
+            auto get_xreffrom() const
             {
-                xreffrom.push_back(std::make_tuple(c, m, offset));
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::STRING, id, XrefTable::caller);
             }
         };
 
@@ -528,29 +789,42 @@ namespace KUNAI
             /// @brief number of parameters
             std::uint16_t num_of_params;
 
-            /// @brief Instructions of the current method
-            std::vector<std::unique_ptr<Instruction>> instructions;
+            /// @brief Disassembler used to retrieve the instructions
+            /// of the method the first time they are requested
+            DexDisassembler *disassembler;
+
+            /// @brief Instructions of the current method, these are
+            /// owned by the arena of the method in the disassembler
+            /// and retrieved on demand
+            std::vector<Instruction *> *instructions = nullptr;
+
+            /// @brief External methods do not have instructions, use
+            /// an empty vector for them
+            std::vector<Instruction *> no_instructions;
+
+            /// @brief Address of each instruction from `instructions`,
+            /// in the same order, created on the first search of an
+            /// instruction by address
+            std::vector<std::uint64_t> instruction_addresses;
 
             /// @brief BasicBlocks from the method
             BasicBlocks basic_blocks;
 
-            /// @brief exceptions from the method
-            std::vector<Disassembler::exceptions_data> exceptions;
+            /// @brief were the basic blocks already created?
+            bool basic_blocks_created = false;
 
-            /// @brief methods where current method is read
-            std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> xrefread;
-            /// @brief methods where method is written to
-            std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> xrefwrite;
+            /// @brief Try blocks and handlers of the method, the table
+            /// is owned by the disassembler and retrieved on demand
+            const ExceptionTable *exception_table = nullptr;
 
-            /// @brief methods called from current method
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> xrefto;
-            /// @brief methods where this method is called
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> xreffrom;
+            /// @brief External methods do not have try blocks, use
+            /// an empty table for them
+            ExceptionTable no_exceptions;
 
-            /// @brief new instance of the method
-            std::vector<std::pair<ClassAnalysis *, std::uint64_t>> xrefnewinstance;
-            /// @brief use of const class
-            std::vector<std::pair<ClassAnalysis *, std::uint64_t>> xrefconstclass;
+            /// @brief table with the xrefs of the analysis
+            const XrefTable *xref_table = nullptr;
+            /// @brief id of the method in the xref table
+            XrefTable::symbol_id_t id = XrefTable::symbol_id_t(SymbolTable::no_symbol);
 
             /// @brief Pretty print an instruction and its opcodes in a dot format to an output dot file
             /// @param dot_file file where to dump the instruction
@@ -567,15 +841,16 @@ namespace KUNAI
             /// @param name name of the dot file
             void dump_method_dot(std::ofstream& dot_file);
 
-            /// @brief Some kind of magic function that will take all
-            /// the instructions from the method, and after some wololo
-            /// will generate the basic blocks.
-            void create_basic_blocks();
-
         public:
+            /// @brief Constructor of the MethodAnalysis, the instructions
+            /// and the basic blocks are not created here, these are
+            /// retrieved the first time they are requested.
+            /// @param method_encoded encoded method or external method
+            /// @param disassembler disassembler to obtain the instructions
+            /// of the method, it can be nullptr for external methods
             MethodAnalysis(
                 std::variant<EncodedMethod *, ExternalMethod *> method_encoded,
-                std::vector<std::unique_ptr<Instruction>> &instructions) : method_encoded(method_encoded), instructions(std::move(instructions))
+                DexDisassembler *disassembler) : method_encoded(method_encoded), disassembler(disassembler)
             {
                 is_external = method_encoded.index() == 0 ? false : true;
 
@@ -587,11 +862,14 @@ namespace KUNAI
 
                     num_of_params = em->getMethodID()->get_proto()->get_parameters().size();
                 }
-
-                if (this->instructions.size() > 0)
-                    create_basic_blocks();
             }
 
+            /// @brief Some kind of magic function that will take all
+            /// the instructions from the method, and after some wololo
+            /// will generate the basic blocks. The blocks are created
+            /// only once, next calls do nothing.
+            void create_basic_blocks();
+
             /// @brief Dump the method as a dot file into
             /// the current path
             /// @param file_path reference to a path where
@@ -612,13 +890,22 @@ namespace KUNAI
                 return is_external;
             }
 
+            /// @brief Get the basic blocks of the method, the blocks are
+            /// not created here, these are empty until `create_basic_blocks`
+            /// or the non constant version of this method is called
+            /// @return constant reference to the basic blocks
             const BasicBlocks& get_basic_blocks() const
             {
                 return basic_blocks;
             }
 
+            /// @brief Get the basic blocks of the method, these
+            /// are created in case they do not exist yet
+            /// @return reference to the basic blocks
             BasicBlocks& get_basic_blocks()
             {
+                if (!basic_blocks_created)
+                    create_basic_blocks();
                 return basic_blocks;
             }
 
@@ -646,116 +933,96 @@ namespace KUNAI
 
             const std::string &get_full_name() const;
 
-            std::vector<std::unique_ptr<Instruction>>& get_instructions()
-            {
-                return instructions;
-            }
-
-            std::variant<EncodedMethod *, ExternalMethod *> get_encoded_method() const
-            {
-                return method_encoded;
-            }
-
-            const std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> &
-            get_xrefread() const
-            {
-                return xrefread;
-            }
-
-            std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> &
-            get_xrefread()
-            {
-                return xrefread;
-            }
-
-            const std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> &
-            get_xrefwrite() const
-            {
-                return xrefwrite;
-            }
-
-            std::vector<std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t>> &
-            get_xrefwrite()
-            {
-                return xrefwrite;
-            }
-
-            const std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefto() const
-            {
-                return xrefto;
-            }
-
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xrefto()
-            {
-                return xrefto;
-            }
+            /// @brief Get the instructions of the method, the method
+            /// is disassembled the first time the instructions are
+            /// requested
+            /// @return reference to the instructions of the method
+            std::vector<Instruction *>& get_instructions();
 
-            const std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xreffrom() const
-            {
-                return xreffrom;
-            }
+            /// @brief Get the instruction that starts in an address, both
+            /// disassembly algorithms give the instructions sorted by
+            /// address so a binary search is used
+            /// @param address address in bytes from the start of the method
+            /// @return instruction in the address, nullptr if no instruction
+            /// starts there
+            Instruction *get_instruction_at(std::uint64_t address);
 
-            std::vector<std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t>> &
-            get_xreffrom()
+            /// @brief Get the basic block that contains an address, the
+            /// basic blocks are created in case they do not exist yet
+            /// @param address address in bytes from the start of the method
+            /// @return block with an instruction in the address, nullptr if
+            /// there is no block there
+            DVMBasicBlock *get_block_at(std::uint64_t address)
             {
-                return xreffrom;
+                return get_basic_blocks().get_basic_block_by_idx(address);
             }
 
-            const std::vector<std::pair<ClassAnalysis *, std::uint64_t>> &
-            get_xrefnewinstance() const
-            {
-                return xrefnewinstance;
-            }
+            /// @brief Get the try blocks and handlers of the method, the
+            /// table is created the first time it is requested
+            /// @return constant reference to the exception table
+            const ExceptionTable& get_exception_table();
 
-            std::vector<std::pair<ClassAnalysis *, std::uint64_t>> &
-            get_xrefnewinstance()
+            std::variant<EncodedMethod *, ExternalMethod *> get_encoded_method() const
             {
-                return xrefnewinstance;
+                return method_encoded;
             }
 
-            const std::vector<std::pair<ClassAnalysis *, std::uint64_t>> &
-            get_xrefconstclass() const
+            /// @brief Set the table where the xrefs of the method are
+            /// @param table xref table of the analysis
+            /// @param method_id id of the method in the symbol table
+            void set_xref_table(const XrefTable *table, XrefTable::symbol_id_t method_id)
             {
-                return xrefconstclass;
+                xref_table = table;
+                id = method_id;
             }
 
-            std::vector<std::pair<ClassAnalysis *, std::uint64_t>> &
-            get_xrefconstclass()
+            /// @brief Get the id of the method in the symbol table
+            /// @return id, no_symbol if the method is not in the analysis
+            XrefTable::symbol_id_t get_symbol_id() const
             {
-                return xrefconstclass;
+                return id;
             }
 
-            void add_xrefread(ClassAnalysis *c, FieldAnalysis *f, std::uint64_t offset)
+            /// @brief Get the fields read by the method
+            /// @return view of (class of the method, field, offset)
+            auto get_xrefread() const
             {
-                xrefread.push_back(std::make_tuple(c, f, offset));
+                return XrefTable::from(xref_table, id, XrefTable::xref_kind_t::FIELD_READ, XrefTable::field);
             }
 
-            void add_xrefwrite(ClassAnalysis *c, FieldAnalysis *f, std::uint64_t offset)
+            /// @brief Get the fields written by the method
+            /// @return view of (class of the method, field, offset)
+            auto get_xrefwrite() const
             {
-                xrefwrite.push_back(std::make_tuple(c, f, offset));
+                return XrefTable::from(xref_table, id, XrefTable::xref_kind_t::FIELD_WRITE, XrefTable::field);
             }
 
-            void add_xrefto(ClassAnalysis *c, MethodAnalysis *m, std::uint64_t offset)
+            /// @brief Get the methods called from the method
+            /// @return view of (class of the callee, callee, offset)
+            auto get_xrefto() const
             {
-                xrefto.push_back(std::make_tuple(c, m, offset));
+                return XrefTable::from(xref_table, id, XrefTable::xref_kind_t::CALL, XrefTable::callee);
             }
 
-            void add_xreffrom(ClassAnalysis *c, MethodAnalysis *m, std::uint64_t offset)
+            /// @brief Get the methods that call the method
+            /// @return view of (class of the caller, caller, offset)
+            auto get_xreffrom() const
             {
-                xreffrom.push_back(std::make_tuple(c, m, offset));
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::CALL, id, XrefTable::caller);
             }
 
-            void add_xrefnewinstance(ClassAnalysis *c, std::uint64_t offset)
+            /// @brief Get the classes instantiated by the method
+            /// @return view of (class, offset)
+            auto get_xrefnewinstance() const
             {
-                xrefnewinstance.push_back(std::make_pair(c, offset));
+                return XrefTable::from(xref_table, id, XrefTable::xref_kind_t::NEW_INSTANCE, XrefTable::class_used);
             }
 
-            void add_xrefconstclass(ClassAnalysis *c, std::uint64_t offset)
+            /// @brief Get the classes used with const-class by the method
+            /// @return view of (class, offset)
+            auto get_xrefconstclass() const
             {
-                xrefconstclass.push_back(std::make_pair(c, offset));
+                return XrefTable::from(xref_table, id, XrefTable::xref_kind_t::CONST_CLASS, XrefTable::class_used);
             }
         };
 
@@ -786,16 +1053,20 @@ namespace KUNAI
             /// @brief map for mapping EncodedField and FieldAnalysis
             std::unordered_map<EncodedField *, std::unique_ptr<FieldAnalysis>> fields;
 
-            /// @brief Classes that this class calls
-            classxref xrefto;
-            /// @brief Classes that call this class
-            classxref xreffrom;
-
-            /// @brief New instances of this class
-            std::vector<std::pair<MethodAnalysis *, std::uint64_t>> xrefnewinstance;
-
-            /// @brief use of const class of this class
-            std::vector<std::pair<MethodAnalysis *, std::uint64_t>> xrefconstclass;
+            /// @brief table with the xrefs of the analysis
+            const XrefTable *xref_table = nullptr;
+            /// @brief id of the class in the xref table
+            XrefTable::symbol_id_t id = XrefTable::symbol_id_t(SymbolTable::no_symbol);
+
+            /// @brief maps returned by get_xrefto and get_xreffrom, these
+            /// are built once for each generation of the xref table
+            mutable std::mutex xrefs_mutex;
+            mutable classxref xrefto;
+            mutable classxref xreffrom;
+            /// @brief generation of the table used by each map, 0 if
+            /// the map must be built again
+            mutable std::uint32_t xrefto_generation = 0;
+            mutable std::uint32_t xreffrom_generation = 0;
 
         public:
             ClassAnalysis(std::variant<ClassDef *, ExternalClass *> class_def) : class_def(class_def)
@@ -878,122 +1149,54 @@ namespace KUNAI
             /// @return FieldAnalysis pointer
             FieldAnalysis *get_field_analysis(EncodedField *field);
 
-            void add_field_xref_read(MethodAnalysis *method,
-                                     ClassAnalysis *classobj,
-                                     EncodedField *field,
-                                     std::uint64_t off)
-            {
-                if (fields.find(field) == fields.end())
-                    fields[field] = std::make_unique<FieldAnalysis>(field);
-                fields[field]->add_xrefread(classobj, method, off);
-            }
-
-            void add_field_xref_write(MethodAnalysis *method,
-                                      ClassAnalysis *classobj,
-                                      EncodedField *field,
-                                      std::uint64_t off)
-            {
-                if (fields.find(field) == fields.end())
-                    fields[field] = std::make_unique<FieldAnalysis>(field);
-                fields[field]->add_xrefwrite(classobj, method, off);
-            }
-
-            void add_method_xref_to(MethodAnalysis *method1,
-                                    ClassAnalysis *classobj,
-                                    MethodAnalysis *method2,
-                                    std::uint64_t off)
-            {
-                auto method_key = method1->get_full_name();
-
-                if (methods.find(method_key) == methods.end())
-                    add_method(method1);
-                methods[method_key]->add_xrefto(classobj, method2, off);
-            }
-
-            void add_method_xref_from(MethodAnalysis *method1,
-                                      ClassAnalysis *classobj,
-                                      MethodAnalysis *method2,
-                                      std::uint64_t off)
-            {
-                auto method_key = method1->get_full_name();
-
-                if (methods.find(method_key) == methods.end())
-                    add_method(method1);
-                methods[method_key]->add_xreffrom(classobj, method2, off);
-            }
-
-            void add_xref_to(TYPES::REF_TYPE ref_kind,
-                             ClassAnalysis *classobj,
-                             MethodAnalysis *methodobj,
-                             std::uint64_t offset)
-            {
-                xrefto[classobj].insert(std::make_tuple(ref_kind, methodobj, offset));
-            }
-
-            void add_xref_from(TYPES::REF_TYPE ref_kind,
-                               ClassAnalysis *classobj,
-                               MethodAnalysis *methodobj,
-                               std::uint64_t offset)
-            {
-                xreffrom[classobj].insert(std::make_tuple(ref_kind, methodobj, offset));
-            }
-
-            void add_xref_new_instance(MethodAnalysis *methodobj, std::uint64_t offset)
-            {
-                xrefnewinstance.push_back(std::make_pair(methodobj, offset));
-            }
-
-            void add_xref_const_class(MethodAnalysis *methodobj, std::uint64_t offset)
-            {
-                xrefconstclass.push_back(std::make_pair(methodobj, offset));
-            }
-
-            const classxref &
-            get_xrefto() const
-            {
-                return xrefto;
-            }
-
-            classxref &
-            get_xrefto()
-            {
-                return xrefto;
-            }
-
-            const classxref &
-            get_xreffrom() const
+            /// @brief Get the FieldAnalysis of a field, it is created
+            /// the first time
+            /// @param field field to look for
+            /// @return FieldAnalysis pointer
+            FieldAnalysis *add_field(EncodedField *field)
             {
-                return xreffrom;
+                auto &field_analysis = fields[field];
+                if (!field_analysis)
+                    field_analysis = std::make_unique<FieldAnalysis>(field);
+                return field_analysis.get();
             }
 
-            classxref &
-            get_xreffrom()
+            /// @brief Set the table where the xrefs of the class are
+            /// @param table xref table of the analysis
+            /// @param class_id id of the class in the symbol table
+            void set_xref_table(const XrefTable *table, XrefTable::symbol_id_t class_id)
             {
-                return xreffrom;
+                xref_table = table;
+                id = class_id;
             }
 
-            const std::vector<std::pair<MethodAnalysis *, std::uint64_t>>
-            get_xrefnewinstance() const
-            {
-                return xrefnewinstance;
-            }
+            /// @brief Get the classes used by the methods of this class,
+            /// the map is built from the xref table in the first call and
+            /// kept until the table or the methods of the class change
+            /// @return classes used with the kind of reference, the method
+            /// called (or the method of this class for classes instantiated
+            /// or used with const-class) and the offset
+            const classxref &get_xrefto() const;
 
-            std::vector<std::pair<MethodAnalysis *, std::uint64_t>>
-            get_xrefnewinstance()
-            {
-                return xrefnewinstance;
-            }
+            /// @brief Get the classes that use this class, the map is built
+            /// from the xref table in the first call and kept until the
+            /// table or the methods of the class change
+            /// @return classes with the kind of reference, the method of that
+            /// class and the offset
+            const classxref &get_xreffrom() const;
 
-            const std::vector<std::pair<MethodAnalysis *, std::uint64_t>>
-            get_xrefconstclass() const
+            /// @brief Get the new instances of this class
+            /// @return view of (method, offset)
+            auto get_xrefnewinstance() const
             {
-                return xrefconstclass;
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::NEW_INSTANCE, id, XrefTable::user);
             }
 
-            std::vector<std::pair<MethodAnalysis *, std::uint64_t>>
-            get_xrefconstclass()
+            /// @brief Get the uses of this class with const-class
+            /// @return view of (method, offset)
+            auto get_xrefconstclass() const
             {
-                return xrefconstclass;
+                return XrefTable::to(xref_table, XrefTable::xref_kind_t::CONST_CLASS, id, XrefTable::user);
             }
         };
     } // namespace DEX
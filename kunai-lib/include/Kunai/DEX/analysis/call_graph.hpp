@@ -0,0 +1,242 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file call_graph.hpp
+// @brief Call graph of all the methods of an analysis, with the queries
+// for knowing which methods can be reached from others.
+
+#ifndef KUNAI_DEX_ANALYSIS_CALL_GRAPH_HPP
+#define KUNAI_DEX_ANALYSIS_CALL_GRAPH_HPP
+
+#include "Kunai/DEX/analysis/class_hierarchy.hpp"
+#include "Kunai/DEX/analysis/xrefs.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    class CallGraph;
+
+    /// @brief Which methods of a group (the sinks) can be reached from
+    /// each method of the call graph. One bit per sink is stored for each
+    /// strongly connected component, so asking for a method is just
+    /// reading its bits.
+    class SinkReachability
+    {
+    public:
+        using node_t = SymbolTable::symbol_id_t;
+
+    private:
+        /// @brief graph of the query
+        const CallGraph *graph;
+
+        /// @brief words of 64 bits used by each component
+        std::size_t words;
+
+        /// @brief bits of the sinks reached by each component
+        std::vector<std::uint64_t> bits;
+
+        friend class CallGraph;
+
+        SinkReachability(const CallGraph *graph, std::size_t sinks);
+
+        const std::uint64_t *get_bits(node_t method) const;
+
+    public:
+        /// @brief Can a method reach one of the sinks?
+        /// @param method id of the method
+        /// @param sink position of the sink in the group
+        /// @return true if there is a path of calls to the sink
+        bool reaches(node_t method, std::size_t sink) const;
+
+        /// @brief Can a method reach any of the sinks?
+        /// @param method id of the method
+        /// @return true if there is a path of calls to any sink
+        bool reaches_any(node_t method) const;
+
+        /// @brief Get the sinks that a method can reach
+        /// @param method id of the method
+        /// @return positions of the sinks in the group
+        std::vector<std::size_t> get_sinks(node_t method) const;
+    };
+
+    /// @brief Immutable call graph whose nodes are the method ids of the
+    /// symbol table (internal and external methods). The callees and the
+    /// callers of every method are stored in compressed sparse rows, each
+    /// call appears once even if the method is called several times.
+    ///
+    /// The strongly connected components are computed with the algorithm
+    /// of Tarjan when the graph is created. These are numbered in reverse
+    /// topological order, so every component calls only components with
+    /// a lower number.
+    class CallGraph
+    {
+    public:
+        using node_t = SymbolTable::symbol_id_t;
+        using component_t = std::uint32_t;
+
+    private:
+        /// @brief first callee of each method
+        std::vector<std::uint32_t> callee_offsets;
+
+        /// @brief callees, sorted for each method
+        std::vector<node_t> callees;
+
+        /// @brief first caller of each method
+        std::vector<std::uint32_t> caller_offsets;
+
+        /// @brief callers, sorted for each method
+        std::vector<node_t> callers;
+
+        /// @brief component of each method
+        std::vector<component_t> components;
+
+        /// @brief number of methods of each component
+        std::vector<std::uint32_t> component_sizes;
+
+        /// @brief first successor of each component
+        std::vector<std::uint32_t> successor_offsets;
+
+        /// @brief components called from each component
+        std::vector<component_t> successors;
+
+        void compute_components();
+
+        /// @brief Do a breadth first search from some methods
+        /// @param sources methods where the search starts
+        /// @param target method to stop at, no_symbol to visit all
+        /// @param parents if not empty, the method from which each
+        /// method was found
+        /// @return methods found, in the order of the search
+        std::vector<node_t> breadth_first(std::span<const node_t> sources,
+                                          node_t target,
+                                          std::vector<node_t> *parents) const;
+
+    public:
+        /// @brief Create the call graph with the calls of an xref table
+        /// @param xrefs table of a finished analysis
+        /// @param number_of_methods number of method ids
+        /// @param hierarchy if given, every call goes to all the methods
+        /// it can execute according to the hierarchy, otherwise only to
+        /// the method of the instruction
+        /// @param mode how the hierarchy resolves the virtual calls
+        CallGraph(const XrefTable &xrefs, std::size_t number_of_methods,
+                  const ClassHierarchy *hierarchy = nullptr,
+                  ClassHierarchy::dispatch_t mode = ClassHierarchy::dispatch_t::CHA);
+
+        /// @brief Get the number of methods of the graph
+        std::size_t get_number_of_nodes() const
+        {
+            return callee_offsets.size() - 1;
+        }
+
+        /// @brief Get the number of different calls between methods
+        std::size_t get_number_of_edges() const
+        {
+            return callees.size();
+        }
+
+        /// @brief Get the methods called from a method
+        /// @param method id of the method
+        /// @return sorted ids of the callees
+        std::span<const node_t> get_callees(node_t method) const
+        {
+            return std::span<const node_t>(callees).subspan(callee_offsets[method],
+                                                            callee_offsets[method + 1] - callee_offsets[method]);
+        }
+
+        /// @brief Get the methods that call a method
+        /// @param method id of the method
+        /// @return sorted ids of the callers
+        std::span<const node_t> get_callers(node_t method) const
+        {
+            return std::span<const node_t>(callers).subspan(caller_offsets[method],
+                                                            caller_offsets[method + 1] - caller_offsets[method]);
+        }
+
+        /// @brief Get all the methods reachable from a group of methods
+        /// following the calls, breadth first
+        /// @param sources methods where the search starts
+        /// @return the sources and the methods reachable from them, in
+        /// breadth first order
+        std::vector<node_t> reachable_from(std::span<const node_t> sources) const
+        {
+            return breadth_first(sources, SymbolTable::no_symbol, nullptr);
+        }
+
+        /// @brief Get all the methods reachable from a method, depth first
+        /// @param method method where the search starts
+        /// @return the method and the methods reachable from it, in
+        /// depth first preorder
+        std::vector<node_t> depth_first(node_t method) const;
+
+        /// @brief Can a method reach another following the calls?
+        /// @param from id of the first method
+        /// @param to id of the method to reach
+        /// @return true if there is a path of calls, a method
+        /// always reaches itself
+        bool reaches(node_t from, node_t to) const
+        {
+            // the calls only go to components with a lower number
+            if (components[from] == components[to])
+                return true;
+            if (components[from] < components[to])
+                return false;
+            return !breadth_first(std::span<const node_t>(&from, 1), to, nullptr).empty();
+        }
+
+        /// @brief Get one of the shortest paths of calls between two methods
+        /// @param from id of the first method
+        /// @param to id of the method to reach
+        /// @return methods of the path, from `from` to `to`, empty if
+        /// there is no path
+        std::vector<node_t> get_path(node_t from, node_t to) const;
+
+        /// @brief Get the number of strongly connected components
+        std::size_t get_number_of_components() const
+        {
+            return component_sizes.size();
+        }
+
+        /// @brief Get the strongly connected component of a method
+        /// @param method id of the method
+        /// @return component, in reverse topological order
+        component_t get_component(node_t method) const
+        {
+            return components[method];
+        }
+
+        /// @brief Get the number of methods of a component, more
+        /// than one means that the methods are mutually recursive
+        std::uint32_t get_component_size(component_t component) const
+        {
+            return component_sizes[component];
+        }
+
+        /// @brief Get the components called from a component in the
+        /// condensation of the graph (the graph of the components)
+        /// @param component component to query
+        /// @return sorted components, all of them lower than `component`
+        std::span<const component_t> get_successors(component_t component) const
+        {
+            return std::span<const component_t>(successors).subspan(successor_offsets[component],
+                                                                    successor_offsets[component + 1] - successor_offsets[component]);
+        }
+
+        /// @brief Compute which of a group of methods can be reached
+        /// from every method of the graph, the bits of each component
+        /// are computed once walking the condensation
+        /// @param sinks methods to reach
+        /// @return object for asking which sinks each method reaches
+        SinkReachability reach_sinks(std::span<const node_t> sinks) const;
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
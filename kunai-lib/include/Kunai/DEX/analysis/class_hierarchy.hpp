@@ -0,0 +1,243 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file class_hierarchy.hpp
+// @brief Class hierarchy of an analysis, used for the subtype checks and
+// for knowing which methods a virtual call can execute.
+
+#ifndef KUNAI_DEX_ANALYSIS_CLASS_HIERARCHY_HPP
+#define KUNAI_DEX_ANALYSIS_CLASS_HIERARCHY_HPP
+
+#include "Kunai/DEX/analysis/xrefs.hpp"
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Hierarchy of all the classes of the symbol table. The tree
+    /// of the superclasses is numbered with a depth first search, so the
+    /// subclasses of a class are a range of numbers and checking if a
+    /// class extends another is a comparison of integers. The interfaces
+    /// that every class implements (directly, by its superclasses or by
+    /// other interfaces) are stored sorted.
+    ///
+    /// The methods with the same name and descriptor share a selector.
+    /// Each selector has a dispatch table with the classes that declare
+    /// it sorted by their number, so the declarations in the subclasses
+    /// of a class are found with a binary search.
+    ///
+    /// The classes without a definition (external ones) have no
+    /// superclass and only declare the methods called on them. So when a
+    /// class of the dex extends an external class that extends another
+    /// one (e.g. a framework class), the class is not in the cone of the
+    /// upper superclass, and the methods it overrides are not targets of
+    /// the calls made through that superclass. An external class is an
+    /// interface when a class of the dex implements it or when it is
+    /// the class of the method of an invoke-interface.
+    class ClassHierarchy
+    {
+    public:
+        using class_t = SymbolTable::symbol_id_t;
+        using method_t = SymbolTable::symbol_id_t;
+        using selector_t = std::uint32_t;
+
+        /// @brief how the targets of a virtual call are computed
+        enum class dispatch_t
+        {
+            CHA, //! Class Hierarchy Analysis, any subclass of the receiver
+            RTA  //! Rapid Type Analysis, only the subclasses instantiated with new-instance
+        };
+
+        /// @brief declaration of a method in a dispatch table
+        struct declaration_t
+        {
+            /// @brief number of the class in the depth first search
+            std::uint32_t pre;
+            /// @brief class that declares the method
+            class_t cls;
+            /// @brief method declared
+            method_t method;
+        };
+
+    private:
+        /// @brief superclass of each class, no_symbol for the roots
+        std::vector<class_t> superclasses;
+
+        /// @brief is each class an interface?
+        std::vector<std::uint8_t> interface;
+
+        /// @brief number of each class in the depth first search
+        std::vector<std::uint32_t> pre;
+
+        /// @brief first number after the subclasses of each class
+        std::vector<std::uint32_t> end;
+
+        /// @brief first class of the chain of each class
+        std::vector<std::uint32_t> chain_offsets;
+
+        /// @brief the class and its superclasses up to the root
+        std::vector<class_t> chains;
+
+        /// @brief first interface of each class
+        std::vector<std::uint32_t> interface_offsets;
+
+        /// @brief interfaces implemented by each class, sorted
+        std::vector<class_t> interfaces;
+
+        /// @brief first implementor of each interface
+        std::vector<std::uint32_t> implementor_offsets;
+
+        /// @brief classes that implement each interface, sorted by
+        /// their number
+        std::vector<class_t> implementors;
+
+        /// @brief selector of each method
+        std::vector<selector_t> method_selectors;
+
+        /// @brief class of each method, no_symbol for the
+        /// methods of the arrays
+        std::vector<class_t> method_classes;
+
+        /// @brief can each method be executed? false for the
+        /// abstract methods
+        std::vector<std::uint8_t> concrete;
+
+        /// @brief number of selectors
+        std::size_t number_of_selectors = 0;
+
+        /// @brief method declared by a class for a selector,
+        /// the key is (class << 32) | selector
+        std::unordered_map<std::uint64_t, method_t> declarations;
+
+        /// @brief first declaration of each selector
+        std::vector<std::uint32_t> dispatch_offsets;
+
+        /// @brief declarations of each selector, sorted by number
+        std::vector<declaration_t> dispatch;
+
+        /// @brief classes instantiated with new-instance, sorted by number
+        std::vector<class_t> instantiated;
+
+        std::span<const declaration_t> get_declarations(selector_t selector,
+                                                        std::uint32_t first,
+                                                        std::uint32_t last) const;
+
+        void add_target(method_t method, std::vector<method_t> &targets) const;
+
+    public:
+        /// @brief Create the hierarchy of the classes of an analysis
+        /// @param symbols ids of the analysis
+        /// @param classes ClassAnalysis of each class id
+        /// @param methods MethodAnalysis of each method id
+        /// @param xrefs xrefs of the analysis, used for knowing the
+        /// instantiated classes
+        ClassHierarchy(const SymbolTable &symbols,
+                       const std::vector<ClassAnalysis *> &classes,
+                       const std::vector<MethodAnalysis *> &methods,
+                       const XrefTable &xrefs);
+
+        /// @brief Get the number of classes of the hierarchy
+        std::size_t get_number_of_classes() const
+        {
+            return superclasses.size();
+        }
+
+        /// @brief Get the superclass of a class
+        /// @return class, no_symbol if unknown or root
+        class_t get_superclass(class_t cls) const
+        {
+            return superclasses[cls];
+        }
+
+        /// @brief Get the class and all its superclasses
+        /// @return the class first and the root last
+        std::span<const class_t> get_superclass_chain(class_t cls) const
+        {
+            return std::span<const class_t>(chains).subspan(chain_offsets[cls], chain_offsets[cls + 1] - chain_offsets[cls]);
+        }
+
+        /// @brief Get all the interfaces implemented by a class
+        /// @return sorted interfaces
+        std::span<const class_t> get_interfaces(class_t cls) const
+        {
+            return std::span<const class_t>(interfaces).subspan(interface_offsets[cls], interface_offsets[cls + 1] - interface_offsets[cls]);
+        }
+
+        /// @brief Get the classes that implement an interface,
+        /// interfaces that extend it are not included
+        /// @return classes sorted by their number
+        std::span<const class_t> get_implementors(class_t interface_cls) const
+        {
+            return std::span<const class_t>(implementors).subspan(implementor_offsets[interface_cls], implementor_offsets[interface_cls + 1] - implementor_offsets[interface_cls]);
+        }
+
+        /// @brief Is a class an interface?
+        bool is_interface(class_t cls) const
+        {
+            return interface[cls];
+        }
+
+        /// @brief Is a class instantiated by some new-instance?
+        bool is_instantiated(class_t cls) const;
+
+        /// @brief Does a class extend another? A class extends itself
+        /// @param cls class to check
+        /// @param superclass possible superclass
+        /// @return true if `superclass` is in the chain of `cls`
+        bool is_subclass(class_t cls, class_t superclass) const
+        {
+            return pre[superclass] <= pre[cls] && pre[cls] < end[superclass];
+        }
+
+        /// @brief Can a value of a class be used as another type?
+        /// @param cls class to check
+        /// @param type class or interface
+        /// @return true if `cls` extends or implements `type`
+        bool is_subtype(class_t cls, class_t type) const;
+
+        /// @brief Get the selector of a method, the selector is the same
+        /// for the methods with the same name and descriptor
+        selector_t get_selector(method_t method) const
+        {
+            return method_selectors[method];
+        }
+
+        /// @brief Get the dispatch table of a selector
+        /// @return declarations sorted by the number of their class
+        std::span<const declaration_t> get_dispatch_table(selector_t selector) const
+        {
+            return std::span<const declaration_t>(dispatch).subspan(dispatch_offsets[selector], dispatch_offsets[selector + 1] - dispatch_offsets[selector]);
+        }
+
+        /// @brief Get the method executed when a selector is called
+        /// on an object of a class, searching in its superclasses
+        /// @param cls class of the object
+        /// @param selector selector called
+        /// @return method, no_symbol if no class of the chain declares it
+        method_t resolve(class_t cls, selector_t selector) const;
+
+        /// @brief Get the methods that an invoke instruction can execute.
+        /// The static, direct and super calls have one target, the virtual
+        /// and interface calls can execute the method of any subclass of
+        /// the receiver (or only of the instantiated ones with RTA). When
+        /// nothing is found the method of the instruction is returned.
+        /// The method of an external interface is kept with the
+        /// implementors, external classes can implement it too.
+        /// @param method method of the invoke instruction
+        /// @param opcode opcode of the instruction
+        /// @param mode how the virtual calls are resolved
+        /// @return sorted methods
+        std::vector<method_t> get_targets(method_t method, std::uint32_t opcode,
+                                          dispatch_t mode = dispatch_t::CHA) const;
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,625 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file dataflow.hpp
+// @brief Bit-vector dataflow framework over the basic blocks of a method,
+// with the analyses of liveness, reaching definitions and def-use chains
+// of the Dalvik registers.
+
+#ifndef KUNAI_DEX_ANALYSIS_DATAFLOW_HPP
+#define KUNAI_DEX_ANALYSIS_DATAFLOW_HPP
+
+#include "Kunai/DEX/analysis/analysis.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Set of bits with a fixed size, stored in words of 64 bits
+    /// so the operations of the dataflow work on a whole word at a time
+    class BitVector
+    {
+        /// @brief words with the bits
+        std::vector<std::uint64_t> words;
+
+        /// @brief number of bits
+        std::size_t bits = 0;
+
+    public:
+        BitVector() = default;
+
+        /// @brief Create a set with all the bits to 0
+        /// @param size number of bits
+        explicit BitVector(std::size_t size) : words((size + 63) / 64, 0), bits(size)
+        {
+        }
+
+        /// @brief Get the number of bits of the set
+        /// @return number of bits
+        std::size_t size() const
+        {
+            return bits;
+        }
+
+        /// @brief Set a bit to 1
+        /// @param bit position of the bit
+        void set(std::size_t bit)
+        {
+            words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+
+        /// @brief Set a bit to 0
+        /// @param bit position of the bit
+        void reset(std::size_t bit)
+        {
+            words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+        }
+
+        /// @brief Check the value of a bit
+        /// @param bit position of the bit
+        /// @return true if the bit is 1
+        bool test(std::size_t bit) const
+        {
+            return (words[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        /// @brief Set all the bits to 0
+        void clear()
+        {
+            std::fill(words.begin(), words.end(), 0);
+        }
+
+        /// @brief Set all the bits to 1
+        void fill();
+
+        /// @brief Check if there is any bit set
+        /// @return true if all the bits are 0
+        bool none() const;
+
+        /// @brief Count the bits set
+        /// @return number of bits to 1
+        std::size_t count() const;
+
+        /// @brief Add the bits of other set, both must have the same size
+        /// @param other set to add
+        /// @return true if the set changed
+        bool union_with(const BitVector &other);
+
+        /// @brief Keep only the bits that are also in other set
+        /// @param other set to intersect with
+        /// @return true if the set changed
+        bool intersect_with(const BitVector &other);
+
+        /// @brief Remove the bits of other set
+        /// @param other set with the bits to remove
+        void subtract(const BitVector &other);
+
+        bool operator==(const BitVector &other) const = default;
+
+        /// @brief Call a function with the position of every bit set,
+        /// from the lowest to the highest
+        /// @param fn function that receives the position of a bit
+        template <typename F>
+        void for_each(F fn) const
+        {
+            for (std::size_t i = 0; i < words.size(); i++)
+            {
+                for (auto word = words[i]; word; word &= word - 1)
+                    fn(i * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+            }
+        }
+    };
+
+    /// @brief Registers written and read by every instruction of a method,
+    /// stored in compressed sparse row form and indexed by the position of
+    /// the instruction in the method. The wide values (long and double)
+    /// live in a pair of consecutive registers, both registers of the pair
+    /// are given. The registers out of the frame of the method are ignored.
+    class RegisterAccesses
+    {
+        /// @brief instructions of the method, sorted by address
+        const std::vector<Instruction *> &instructions;
+
+        /// @brief number of registers of the method
+        std::uint32_t number_of_registers;
+
+        /// @brief first register of the parameters
+        std::uint32_t first_parameter;
+
+        /// @brief start of the definitions of each instruction
+        std::vector<std::uint32_t> def_offsets;
+
+        /// @brief registers written by all the instructions
+        std::vector<std::uint16_t> defs;
+
+        /// @brief start of the uses of each instruction
+        std::vector<std::uint32_t> use_offsets;
+
+        /// @brief registers read by all the instructions
+        std::vector<std::uint16_t> uses;
+
+    public:
+        /// @brief Compute the registers of all the instructions of a method
+        /// @param method internal method to analyze
+        RegisterAccesses(MethodAnalysis *method);
+
+        /// @brief Append the registers written and read by an instruction
+        /// @param instr instruction to check
+        /// @param written registers written by the instruction
+        /// @param read registers read by the instruction
+        static void get_registers(Instruction *instr,
+                                  std::vector<std::uint16_t> &written,
+                                  std::vector<std::uint16_t> &read);
+
+        /// @brief Get the number of instructions
+        /// @return number of instructions of the method
+        std::size_t size() const
+        {
+            return instructions.size();
+        }
+
+        /// @brief Get the number of registers of the method
+        /// @return registers of the frame
+        std::uint32_t get_number_of_registers() const
+        {
+            return number_of_registers;
+        }
+
+        /// @brief Get the first register of the parameters, the parameters
+        /// use the last registers of the frame
+        /// @return first parameter register
+        std::uint32_t get_first_parameter() const
+        {
+            return first_parameter;
+        }
+
+        /// @brief Get the instructions of the method
+        /// @return instructions sorted by address
+        const std::vector<Instruction *> &get_instructions() const
+        {
+            return instructions;
+        }
+
+        /// @brief Get the position of an instruction of the method
+        /// @param instr instruction of the method
+        /// @return position of the instruction
+        std::uint32_t get_index(const Instruction *instr) const;
+
+        /// @brief Get the total number of registers written
+        /// @return number of definitions of the instructions
+        std::size_t get_number_of_defs() const
+        {
+            return defs.size();
+        }
+
+        /// @brief Get the total number of registers read
+        /// @return number of uses of the instructions
+        std::size_t get_number_of_uses() const
+        {
+            return uses.size();
+        }
+
+        /// @brief Get the position of the first register written by
+        /// an instruction among the registers written by all of them
+        /// @param index position of the instruction
+        /// @return position of the first definition
+        std::uint32_t get_first_def(std::uint32_t index) const
+        {
+            return def_offsets[index];
+        }
+
+        /// @brief Get the position of the first register read by an
+        /// instruction among the registers read by all of them
+        /// @param index position of the instruction
+        /// @return position of the first use
+        std::uint32_t get_first_use(std::uint32_t index) const
+        {
+            return use_offsets[index];
+        }
+
+        /// @brief Get the instruction that writes a definition
+        /// @param def position of the definition among the registers
+        /// written by all the instructions
+        /// @return position of the instruction
+        std::uint32_t get_def_instruction(std::uint32_t def) const
+        {
+            auto it = std::upper_bound(def_offsets.begin(), def_offsets.end(), def);
+            return static_cast<std::uint32_t>(it - def_offsets.begin() - 1);
+        }
+
+        /// @brief Get the registers written by an instruction
+        /// @param index position of the instruction
+        /// @return registers written
+        std::span<const std::uint16_t> get_defs(std::uint32_t index) const
+        {
+            return std::span<const std::uint16_t>(defs.data() + def_offsets[index],
+                                                  def_offsets[index + 1] - def_offsets[index]);
+        }
+
+        /// @brief Get the registers read by an instruction
+        /// @param index position of the instruction
+        /// @return registers read
+        std::span<const std::uint16_t> get_uses(std::uint32_t index) const
+        {
+            return std::span<const std::uint16_t>(uses.data() + use_offsets[index],
+                                                  use_offsets[index + 1] - use_offsets[index]);
+        }
+    };
+
+    /// @brief Generic solver of bit-vector dataflow problems over a
+    /// BasicBlocks graph. A problem gives the `gen` and `kill` sets of
+    /// every block and the solver computes the `in` and `out` sets:
+    ///
+    ///     forward:  in = meet(out of predecessors), out = gen | (in - kill)
+    ///     backward: out = meet(in of sucessors),   in = gen | (out - kill)
+    ///
+    /// The exceptional edges of the graph are also followed, any
+    /// instruction of a block covered by a try can throw, so the handler
+    /// receives what holds at some point of the block:
+    ///
+    ///     forward:  union: in | out | exception_gen, intersection: in & out
+    ///     backward: in of the block also meets the in of its handlers
+    ///
+    /// The edge from the start block to a handler that nothing jumps to
+    /// is ignored when the handler has exceptional predecessors.
+    ///
+    /// The blocks are visited in reverse postorder from the start block
+    /// (postorder for the backward problems), and a block is only visited
+    /// again when one of its inputs changed. The blocks that cannot be
+    /// reached from the start block keep empty sets.
+    class DataFlowAnalysis
+    {
+    public:
+        using block_id_t = BasicBlocks::block_id_t;
+
+        /// @brief direction of the analysis
+        enum class direction_t
+        {
+            FORWARD,
+            BACKWARD
+        };
+
+        /// @brief operation to join the values of different paths
+        enum class meet_t
+        {
+            UNION,
+            INTERSECTION
+        };
+
+    protected:
+        /// @brief graph analyzed
+        const BasicBlocks &blocks;
+
+        /// @brief direction of the analysis
+        direction_t direction;
+
+        /// @brief join of the values
+        meet_t meet;
+
+        /// @brief bits of the sets
+        std::size_t number_of_bits;
+
+        /// @brief value at the start block for forward problems, or at
+        /// the end block for backward problems, empty by default
+        BitVector boundary;
+
+        /// @brief sets of each block, indexed by id
+        std::vector<BitVector> gen, kill, in, out;
+
+        /// @brief bits generated at any point of each block, they
+        /// reach the handlers of the block even if the block kills
+        /// them later, empty by default
+        std::vector<BitVector> exception_gen;
+
+        /// @brief blocks reachable from the start block in reverse postorder
+        std::vector<block_id_t> order;
+
+        /// @brief number of visits to the blocks in the last solve
+        std::size_t iterations = 0;
+
+    public:
+        /// @brief Create a problem with empty gen and kill sets
+        /// @param blocks graph to analyze
+        /// @param direction direction of the analysis
+        /// @param meet join of the values
+        /// @param number_of_bits size of the sets
+        DataFlowAnalysis(const BasicBlocks &blocks, direction_t direction,
+                         meet_t meet, std::size_t number_of_bits);
+
+        virtual ~DataFlowAnalysis() = default;
+
+        /// @brief Compute the in and out sets of all the blocks
+        void solve();
+
+        /// @brief Get the size of the sets
+        /// @return number of bits
+        std::size_t get_number_of_bits() const
+        {
+            return number_of_bits;
+        }
+
+        /// @brief Get the blocks visited by the solver
+        /// @return reachable blocks in reverse postorder
+        const std::vector<block_id_t> &get_order() const
+        {
+            return order;
+        }
+
+        /// @brief Get the number of times a block was visited by
+        /// the last solve, useful to measure the convergence
+        /// @return visits to the blocks
+        std::size_t get_iterations() const
+        {
+            return iterations;
+        }
+
+        /// @brief Get the value used at the start (or the end) block
+        /// @return reference to modify it before solving
+        BitVector &get_boundary()
+        {
+            return boundary;
+        }
+
+        /// @brief Get the bits generated by a block
+        /// @param id id of the block
+        /// @return reference to modify it before solving
+        BitVector &get_gen(block_id_t id)
+        {
+            return gen[id];
+        }
+
+        /// @brief Get the bits removed by a block
+        /// @param id id of the block
+        /// @return reference to modify it before solving
+        BitVector &get_kill(block_id_t id)
+        {
+            return kill[id];
+        }
+
+        /// @brief Get the bits generated at any point of a block,
+        /// given to the handlers of the block in the forward problems
+        /// with union
+        /// @param id id of the block
+        /// @return reference to modify it before solving
+        BitVector &get_exception_gen(block_id_t id)
+        {
+            return exception_gen[id];
+        }
+
+        /// @brief Get the value at the start of a block
+        /// @param id id of the block
+        /// @return set of bits
+        const BitVector &get_in(block_id_t id) const
+        {
+            return in[id];
+        }
+
+        /// @brief Get the value at the end of a block
+        /// @param id id of the block
+        /// @return set of bits
+        const BitVector &get_out(block_id_t id) const
+        {
+            return out[id];
+        }
+    };
+
+    /// @brief Live registers at the start and at the end of every block,
+    /// a register is live if its value can be read before being written.
+    /// The registers live at a handler are live in all the blocks that
+    /// can throw to it.
+    class LivenessAnalysis : public DataFlowAnalysis
+    {
+    public:
+        /// @brief Compute the live registers of a method
+        /// @param method internal method to analyze
+        /// @param accesses registers of the instructions of the method
+        LivenessAnalysis(MethodAnalysis *method, const RegisterAccesses &accesses);
+
+        /// @brief Check if a register is live at the start of a block
+        bool is_live_in(block_id_t id, std::uint16_t reg) const
+        {
+            return reg < number_of_bits && in[id].test(reg);
+        }
+
+        /// @brief Check if a register is live at the end of a block
+        bool is_live_out(block_id_t id, std::uint16_t reg) const
+        {
+            return reg < number_of_bits && out[id].test(reg);
+        }
+    };
+
+    /// @brief Definitions of registers that reach every block. Each
+    /// definition is a register written by an instruction, the
+    /// parameters are defined at the start of the method by no
+    /// instruction. All the definitions of a block covered by a try
+    /// reach its handlers.
+    class ReachingDefinitions : public DataFlowAnalysis
+    {
+    public:
+        using def_id_t = std::uint32_t;
+
+        /// @brief instruction index of the definitions of the parameters
+        static constexpr std::uint32_t parameter = std::numeric_limits<std::uint32_t>::max();
+
+        /// @brief A register written by an instruction
+        struct definition_t
+        {
+            /// @brief position of the instruction, `parameter`
+            /// for the parameters
+            std::uint32_t instruction;
+            /// @brief register written
+            std::uint16_t reg;
+        };
+
+    private:
+        /// @brief registers of the instructions
+        const RegisterAccesses &accesses;
+
+        /// @brief all the definitions
+        std::vector<definition_t> definitions;
+
+        /// @brief start of the definitions of each register
+        std::vector<std::uint32_t> register_offsets;
+
+        /// @brief definitions of all the registers
+        std::vector<def_id_t> register_defs;
+
+        /// @brief number of definitions of the parameters, they
+        /// come before the definitions of the instructions
+        std::uint32_t number_of_parameters = 0;
+
+    public:
+        /// @brief Compute the definitions that reach every block of a method
+        /// @param method internal method to analyze
+        /// @param accesses registers of the instructions of the method
+        ReachingDefinitions(MethodAnalysis *method, const RegisterAccesses &accesses);
+
+        /// @brief Get all the definitions of the method
+        /// @return definitions, the id is the position
+        const std::vector<definition_t> &get_definitions() const
+        {
+            return definitions;
+        }
+
+        /// @brief Get the definitions of a register
+        /// @param reg register
+        /// @return ids of the definitions
+        std::span<const def_id_t> get_definitions_of(std::uint16_t reg) const
+        {
+            if (reg >= accesses.get_number_of_registers())
+                return {};
+            return std::span<const def_id_t>(register_defs.data() + register_offsets[reg],
+                                             register_offsets[reg + 1] - register_offsets[reg]);
+        }
+
+        /// @brief Get the id of the definitions of an instruction, one per
+        /// register written in the same order than `RegisterAccesses::get_defs`
+        /// @param index position of the instruction
+        /// @return id of the first definition of the instruction
+        def_id_t get_first_definition(std::uint32_t index) const
+        {
+            return number_of_parameters + accesses.get_first_def(index);
+        }
+
+        /// @brief Apply the effect of an instruction to a set of
+        /// definitions, used to walk the instructions of a block
+        /// @param index position of the instruction
+        /// @param reaching definitions before the instruction, after
+        /// the call the definitions after the instruction
+        void transfer(std::uint32_t index, BitVector &reaching) const;
+    };
+
+    /// @brief Def-use chains of the registers of a method: for every
+    /// register read by an instruction (a use) the definitions that can
+    /// give its value, and for every definition the uses of its value.
+    class DefUseChains
+    {
+    public:
+        using def_id_t = ReachingDefinitions::def_id_t;
+        using use_id_t = std::uint32_t;
+
+        /// @brief A register read by an instruction
+        struct use_t
+        {
+            /// @brief position of the instruction
+            std::uint32_t instruction;
+            /// @brief register read
+            std::uint16_t reg;
+        };
+
+    private:
+        /// @brief registers of the instructions
+        RegisterAccesses accesses;
+
+        /// @brief reaching definitions used to create the chains
+        ReachingDefinitions reaching;
+
+        /// @brief all the uses, in the order of the instructions, the
+        /// same order than `RegisterAccesses::get_uses`
+        std::vector<use_t> uses;
+
+        /// @brief start of the definitions of each use
+        std::vector<std::uint32_t> use_offsets;
+
+        /// @brief definitions of all the uses
+        std::vector<def_id_t> use_defs;
+
+        /// @brief start of the uses of each definition
+        std::vector<std::uint32_t> def_offsets;
+
+        /// @brief uses of all the definitions
+        std::vector<use_id_t> def_uses;
+
+    public:
+        /// @brief Create the def-use chains of a method
+        /// @param method internal method to analyze
+        DefUseChains(MethodAnalysis *method);
+
+        /// the reaching definitions keep a reference to the accesses
+        DefUseChains(const DefUseChains &) = delete;
+        DefUseChains &operator=(const DefUseChains &) = delete;
+
+        /// @brief Get the registers of the instructions
+        const RegisterAccesses &get_register_accesses() const
+        {
+            return accesses;
+        }
+
+        /// @brief Get the reaching definitions of the method
+        const ReachingDefinitions &get_reaching_definitions() const
+        {
+            return reaching;
+        }
+
+        /// @brief Get all the definitions of the method
+        const std::vector<ReachingDefinitions::definition_t> &get_definitions() const
+        {
+            return reaching.get_definitions();
+        }
+
+        /// @brief Get all the uses of the method
+        /// @return uses, the id is the position
+        const std::vector<use_t> &get_uses() const
+        {
+            return uses;
+        }
+
+        /// @brief Get the definitions that can give the value of a use
+        /// @param use id of the use
+        /// @return ids of the definitions
+        std::span<const def_id_t> get_definitions_of(use_id_t use) const
+        {
+            return std::span<const def_id_t>(use_defs.data() + use_offsets[use],
+                                             use_offsets[use + 1] - use_offsets[use]);
+        }
+
+        /// @brief Get the uses that can read the value of a definition
+        /// @param def id of the definition
+        /// @return ids of the uses
+        std::span<const use_id_t> get_uses_of(def_id_t def) const
+        {
+            return std::span<const use_id_t>(def_uses.data() + def_offsets[def],
+                                             def_offsets[def + 1] - def_offsets[def]);
+        }
+
+        /// @brief Get the definitions that can give the value of a
+        /// register read by an instruction
+        /// @param instr instruction that reads the register
+        /// @param reg register read
+        /// @return ids of the definitions, empty if the instruction
+        /// does not read the register
+        std::span<const def_id_t> get_definitions_of(const Instruction *instr, std::uint16_t reg) const;
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
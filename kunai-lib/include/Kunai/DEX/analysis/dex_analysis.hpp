@@ -11,8 +11,17 @@
 #define KUNAI_DEX_ANALYSIS_DEX_ANALYSIS_HPP
 
 #include "Kunai/DEX/analysis/analysis.hpp"
+#include "Kunai/DEX/analysis/call_graph.hpp"
+#include "Kunai/DEX/analysis/class_hierarchy.hpp"
+#include "Kunai/DEX/analysis/method_metrics.hpp"
+#include "Kunai/DEX/analysis/search.hpp"
+#include "Kunai/DEX/analysis/string_scanner.hpp"
+#include "Kunai/DEX/analysis/symbols.hpp"
+#include "Kunai/DEX/analysis/xrefs.hpp"
 #include "Kunai/DEX/DVM/dex_disassembler.hpp"
 
+#include <mutex>
+
 namespace KUNAI
 {
 namespace DEX
@@ -48,12 +57,29 @@ namespace DEX
         std::unordered_map<std::string,
             std::unique_ptr<ExternalMethod>> external_methods;
 
-        /// @brief MethodAnalysis stored by a hash
-        std::unordered_map<std::string, MethodAnalysis*> methods_hashes;
-        
-        /// @brief map hash for quickly getting the methods (maybe will be deleted)
-        std::unordered_map<std::string,
-            MethodAnalysis*> method_hashes;
+        /// @brief ids of the classes, methods, fields and strings
+        /// of all the dex files
+        SymbolTable symbols;
+
+        /// @brief ClassAnalysis of each class id, nullptr until
+        /// the class is added or found as external
+        std::vector<ClassAnalysis*> class_analyses;
+
+        /// @brief MethodAnalysis of each method id, nullptr until
+        /// the method is added or called as external
+        std::vector<MethodAnalysis*> method_analyses;
+
+        /// @brief StringAnalysis of each string id, nullptr until
+        /// the string is used by a const-string
+        std::vector<StringAnalysis*> string_analyses;
+
+        /// @brief FieldAnalysis of each field id, nullptr until
+        /// the field is read or written
+        std::vector<FieldAnalysis*> field_analyses;
+
+        /// @brief cross references of all the methods, the analysis
+        /// objects read their xrefs from here
+        XrefTable xref_table{symbols, class_analyses, method_analyses, field_analyses};
 
         std::vector<FieldAnalysis*> all_fields;
         
@@ -63,27 +89,138 @@ namespace DEX
         /// @brief are the xrefs already created?
         bool created_xrefs = false;
 
-        /// @brief Internal method for creating the xref for `current_class`
-        /// There are four steps involved in getting the xrefs:
+        /// @brief Indexes for the find_* methods, each table has
+        /// the objects of one of the maps in the order of the map and
+        /// one NameIndex for every column that can be queried
+        struct search_index_t
+        {
+            /// @brief held by the find_* methods while the indexes are
+            /// updated and queried, so these can be called from different
+            /// threads, but not while the dex files or the xrefs are added
+            std::mutex mutex;
+
+            /// @brief must the indexes be created again?
+            bool outdated = true;
+
+            std::vector<ClassAnalysis *> classes;
+            NameIndex class_names;
+
+            std::vector<MethodAnalysis *> methods;
+            NameIndex method_class_names;
+            NameIndex method_names;
+            NameIndex method_access_flags;
+
+            std::vector<StringAnalysis *> strings;
+            NameIndex string_values;
+
+            std::vector<FieldAnalysis *> fields;
+            NameIndex field_class_names;
+            NameIndex field_names;
+            NameIndex field_types;
+            NameIndex field_access_flags;
+            /// @brief access flags of each field as a string,
+            /// computed once for all the queries
+            std::vector<std::string> field_access_flags_str;
+        } search_index;
+
+        /// @brief Create the indexes of the find_* methods if the
+        /// classes, methods, strings or fields changed, the mutex of
+        /// the indexes must be held by the caller
+        void _update_search_index();
+
+        /// @brief Cross reference found by `_scan_xrefs`, the classes,
+        /// methods and strings are given by their id in `symbols`, these
+        /// are resolved (or created as external) when the cross reference
+        /// is applied
+        struct pending_xref_t
+        {
+            /// @brief type of cross reference
+            enum kind_t : std::uint8_t
+            {
+                CLASS,      //! const-class and new-instance
+                METHOD,     //! invoke-* and invoke-*/range
+                STRING,     //! const-string
+                FIELD_READ, //! iget-* and sget-*
+                FIELD_WRITE //! iput-* and sput-*
+            } kind;
+
+            /// @brief opcode of the instruction
+            std::uint32_t op_value;
+
+            /// @brief offset of the instruction
+            std::uint64_t off;
+
+            /// @brief id of the class, method, string or field referenced
+            SymbolTable::symbol_id_t id = SymbolTable::no_symbol;
+
+            /// @brief operand of the const-string, used as value
+            /// of the StringAnalysis
+            std::string *string = nullptr;
+
+            /// @brief field read or written
+            EncodedField *field = nullptr;
+        };
+
+        /// @brief Internal method for finding the xrefs of a method, the
+        /// analysis is not modified so it can be called from different
+        /// threads at the same time. There are four types of xrefs:
         ///     * xrefs for class instantiation and static class usage.
         ///     * xrefs for method calls
         ///     * xrefs for string usage
         ///     * xrefs field manipuation
-        /// All the information is stored in the Analysis objects.
-        /// It might be quite slow as all instructions are parsed.
-        /// @param current_class class to create the xrefs.
-        void _create_xrefs(ClassDef * current_class);
-
-        /// @brief Get a method by its hash, return the MethodAnalysis object
+        /// The method is disassembled if it was not, the names of its
+        /// parser must be created before (Parser::create_pretty_names).
+        /// @param parser_symbols ids of the dex file of the method
+        /// @param current_class id of the class of the method
+        /// @param current_method method to analyze
+        /// @param xrefs vector where the xrefs are stored in the order
+        /// of the instructions
+        void _scan_xrefs(const SymbolTable::parser_symbols_t &parser_symbols,
+                         SymbolTable::symbol_id_t current_class,
+                         MethodAnalysis *current_method,
+                         std::vector<pending_xref_t> &xrefs) const;
+
+        /// @brief Internal method for storing one xref found by
+        /// `_scan_xrefs` in the Analysis objects, creating the
+        /// external classes, methods and the strings if necessary.
+        /// @param current_class class of the method with the xref
+        /// @param current_method method with the xref
+        /// @param xref cross reference to store
+        void _apply_xref(ClassAnalysis *current_class,
+                         MethodAnalysis *current_method,
+                         const pending_xref_t &xref);
+
+        /// @brief Get a class by its id, in case it doesn't exists,
+        /// create an ExternalClass
+        /// @param class_id id of the class
+        /// @return a ClassAnalysis pointer
+        ClassAnalysis* _resolve_class(SymbolTable::symbol_id_t class_id);
+
+        /// @brief Get a method by its id, return the MethodAnalysis object
         /// in case it doesn't exists, create an ExternalMethod
-        /// @param class_name name of method's class
-        /// @param method_name name of the method
-        /// @param method_descriptor prototype of the method
+        /// @param method_id id of the method
         /// @return a MethodAnalysis pointer
-        MethodAnalysis* _resolve_method(std::string & class_name, 
-            std::string & method_name, std::string & method_descriptor);
+        MethodAnalysis* _resolve_method(SymbolTable::symbol_id_t method_id);
 
     public:
+        /// @brief occurrence of a pattern found by `scan_strings`
+        struct string_match_t
+        {
+            /// @brief id of the string in the symbol table
+            SymbolTable::symbol_id_t string;
+
+            /// @brief position of the pattern in the PatternSet
+            PatternSet::pattern_t pattern;
+
+            /// @brief offset of the pattern in the string
+            std::uint32_t offset;
+
+            /// @brief positions in the xref table of the const-string
+            /// instructions that use the string, empty if the xrefs
+            /// were not created or the string is not used
+            std::span<const std::uint32_t> sites;
+        };
+
         Analysis(Parser * parser, DexDisassembler * disassembler, bool create_xrefs) : 
             created_xrefs(!create_xrefs), disassembler(disassembler)
         {
@@ -91,10 +228,19 @@ namespace DEX
                 add(parser);
         }
 
+        /// @brief the analysis objects keep pointers to the
+        /// xref table, so the analysis cannot be copied
+        Analysis(const Analysis &) = delete;
+        Analysis &operator=(const Analysis &) = delete;
+
         /// @brief Add all the classes and methods from a parser
-        /// to the analysis class.
+        /// to the analysis class. The methods are not disassembled
+        /// here, each MethodAnalysis retrieves its instructions the
+        /// first time these are requested.
         /// @param parser parser to extract the information
-        void add(Parser * parser);
+        /// @param parser_disassembler disassembler of the given parser,
+        /// if nullptr the disassembler of the analysis is used
+        void add(Parser * parser, DexDisassembler * parser_disassembler = nullptr);
 
         /// @brief Create class, method, string and field cross references
         /// if you are using multiple DEX files, this function must
@@ -102,7 +248,109 @@ namespace DEX
         /// If you call the function after every DEX file, it will only
         /// work for the first time.
         /// ADD ALL DEX FIRST
-        void create_xrefs();
+        /// The methods are disassembled and scanned by a pool of
+        /// threads, then the xrefs are stored in the order of the
+        /// classes and methods, so the result is the same for any
+        /// number of threads.
+        /// @param threads number of threads, 0 to use one per
+        /// hardware thread
+        void create_xrefs(unsigned threads = 0);
+
+        /// @brief Create the basic blocks of all the internal methods
+        /// using a pool of threads, each thread disassembles the methods
+        /// it takes. The methods are given to the threads from the biggest
+        /// bytecode to the smallest, so a huge method starts early and does
+        /// not keep the rest of the threads waiting at the end.
+        /// @param threads number of threads, 0 to use one per
+        /// hardware thread
+        void create_all_basic_blocks(unsigned threads = 0);
+
+        /// @brief Compute the metrics of all the internal methods: size
+        /// of the control flow graph, cyclomatic complexity, loops and
+        /// the number of instructions of each kind. The basic blocks are
+        /// created first with `create_all_basic_blocks`, then every
+        /// method is measured by one of the threads.
+        /// @param threads number of threads, 0 to use one per
+        /// hardware thread
+        /// @return table with one row per internal method, in the
+        /// order of `get_methods`
+        MethodMetrics compute_method_metrics(unsigned threads = 0);
+
+        /// @brief Create the call graph of all the methods, internal and
+        /// external, from the cross references. The nodes are the method
+        /// ids of `get_symbols`, so `get_method_analysis` gives the
+        /// MethodAnalysis of a node.
+        /// `create_xrefs` must be called first, otherwise the graph
+        /// has no calls.
+        /// @param hierarchy if given, the virtual and interface calls go
+        /// to every method they can execute, see `build_class_hierarchy`
+        /// @param mode how the hierarchy resolves the virtual calls
+        /// @return call graph of the analysis
+        CallGraph build_call_graph(const ClassHierarchy *hierarchy = nullptr,
+                                   ClassHierarchy::dispatch_t mode = ClassHierarchy::dispatch_t::CHA) const;
+
+        /// @brief Create the hierarchy of all the classes, with the
+        /// dispatch tables for resolving the virtual calls. The class
+        /// ids are those of `get_symbols`.
+        /// `create_xrefs` must be called first, the instantiated classes
+        /// and the methods of the external classes come from the xrefs.
+        /// @return class hierarchy of the analysis
+        ClassHierarchy build_class_hierarchy() const;
+
+        /// @brief Look for a set of patterns in all the strings of the
+        /// dex files with one pass over every string, the strings are
+        /// scanned in blocks by a pool of threads. Each match has the
+        /// const-string instructions that use the string, the method and
+        /// offset of each one are in `get_xref_table`.
+        /// @param patterns compiled patterns to look for
+        /// @param only_used scan only the strings used by some
+        /// const-string instruction, needs `create_xrefs`
+        /// @param threads number of threads, 0 to use one per
+        /// hardware thread
+        /// @return matches sorted by string id, then by the end of
+        /// the occurrence in the string
+        std::vector<string_match_t> scan_strings(const PatternSet &patterns,
+                                                 bool only_used = false,
+                                                 unsigned threads = 0) const;
+
+        /// @brief Get the ids of the classes, methods, fields and strings
+        /// @return constant reference to the symbol table
+        const SymbolTable& get_symbols() const
+        {
+            return symbols;
+        }
+
+        /// @brief Get the cross references of all the methods, the
+        /// table is empty until `create_xrefs` is called
+        /// @return constant reference to the xref table
+        const XrefTable& get_xref_table() const
+        {
+            return xref_table;
+        }
+
+        /// @brief Get the ClassAnalysis of a class id
+        /// @param id id of the class in the symbol table
+        /// @return pointer to ClassAnalysis, nullptr if it does not exist
+        ClassAnalysis* get_class_analysis(SymbolTable::symbol_id_t id) const
+        {
+            return id < class_analyses.size() ? class_analyses[id] : nullptr;
+        }
+
+        /// @brief Get the MethodAnalysis of a method id
+        /// @param id id of the method in the symbol table
+        /// @return pointer to MethodAnalysis, nullptr if it does not exist
+        MethodAnalysis* get_method_analysis(SymbolTable::symbol_id_t id) const
+        {
+            return id < method_analyses.size() ? method_analyses[id] : nullptr;
+        }
+
+        /// @brief Get the StringAnalysis of a string id
+        /// @param id id of the string in the symbol table
+        /// @return pointer to StringAnalysis, nullptr if it is not used
+        StringAnalysis* get_string_analysis(SymbolTable::symbol_id_t id) const
+        {
+            return id < string_analyses.size() ? string_analyses[id] : nullptr;
+        }
 
         /// @brief Get a ClassAnalysis object by the class name
         /// @param class_name name of the class to retrieve
@@ -172,20 +420,19 @@ namespace DEX
         /// @brief Obtain a method anaylsis by different values
         /// @param class_name class name of the method
         /// @param method_name name of the method
-        /// @param method_descriptor prototype descriptor of the method
+        /// @param method_descriptor full prototype descriptor of the
+        /// method, for example (ILjava/lang/String;)V
         /// @return pointer to MethodAnalysis or nullptr
         MethodAnalysis* get_method_analysis_by_name(std::string &class_name, 
             std::string &method_name, 
             std::string &method_descriptor)
         {
-            std::string m_hash = class_name+method_name+method_descriptor;
-
-            auto it = method_hashes.find(m_hash);
+            auto id = symbols.find_method(class_name + "->" + method_name + method_descriptor);
 
-            if (it == method_hashes.end())
+            if (id == SymbolTable::no_symbol)
                 return nullptr;
 
-            return it->second;
+            return method_analyses[id];
         }
 
         /// @brief Obtain a MethodID by different values
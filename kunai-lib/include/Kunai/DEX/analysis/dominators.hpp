@@ -0,0 +1,265 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file dominators.hpp
+// @brief Dominator and post-dominator trees of the basic blocks of a
+// method, together with the dominance frontiers.
+
+#ifndef KUNAI_DEX_ANALYSIS_DOMINATORS_HPP
+#define KUNAI_DEX_ANALYSIS_DOMINATORS_HPP
+
+#include "Kunai/DEX/analysis/analysis.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Dominator tree of a BasicBlocks graph. The tree is computed
+    /// with the iterative algorithm from Cooper, Harvey and Kennedy over a
+    /// reverse postorder numbering of the blocks. With `post_dominators`
+    /// the edges are followed backwards from the end block, and the tree
+    /// obtained is the post-dominator tree.
+    ///
+    /// Everything is stored in arrays indexed by the id of the blocks.
+    /// The children of each node and the dominance frontiers are kept in
+    /// compressed sparse row form, and every node of the tree stores the
+    /// interval of its preorder numbering, so `dominates` is answered in
+    /// constant time.
+    ///
+    /// With `exceptions` the exceptional edges are also followed, and the
+    /// handlers that nothing jumps to are only reached from the blocks
+    /// that throw to them, not from the start block.
+    ///
+    /// The blocks that cannot be reached from the root (for example the
+    /// blocks of an infinite loop in a post-dominator tree) are not part
+    /// of the tree, they do not dominate and are not dominated by any block.
+    class DominatorTree
+    {
+    public:
+        using block_id_t = BasicBlocks::block_id_t;
+
+        /// @brief value used for the blocks without immediate dominator
+        static constexpr block_id_t no_block = std::numeric_limits<block_id_t>::max();
+
+    private:
+        /// @brief is it a post-dominator tree?
+        bool post_dominators;
+
+        /// @brief are the exceptional edges followed?
+        bool exceptions;
+
+        /// @brief start of the sucessors of each block with the
+        /// exceptional edges, only used when they are followed
+        std::vector<std::uint32_t> sucessor_offsets;
+
+        /// @brief sucessors of all the blocks with the exceptional edges
+        std::vector<block_id_t> sucessor_ids;
+
+        /// @brief start of the predecessors of each block with the
+        /// exceptional edges, only used when they are followed
+        std::vector<std::uint32_t> predecessor_offsets;
+
+        /// @brief predecessors of all the blocks with the exceptional edges
+        std::vector<block_id_t> predecessor_ids;
+
+        /// @brief root of the tree, the start block or the end block
+        block_id_t root = no_block;
+
+        /// @brief blocks reachable from the root in reverse postorder
+        std::vector<block_id_t> reverse_postorder;
+
+        /// @brief position of each block in `reverse_postorder`,
+        /// no_block for the unreachable blocks
+        std::vector<std::uint32_t> rpo_number;
+
+        /// @brief immediate dominator of each block
+        std::vector<block_id_t> idom;
+
+        /// @brief start of the children of each block in `children`
+        std::vector<std::uint32_t> children_offsets;
+
+        /// @brief children of all the blocks in the tree
+        std::vector<block_id_t> children;
+
+        /// @brief preorder number of each block in the tree
+        std::vector<std::uint32_t> preorder;
+
+        /// @brief last preorder number of the subtree of each block
+        std::vector<std::uint32_t> last_preorder;
+
+        /// @brief start of the frontier of each block in `frontiers`
+        std::vector<std::uint32_t> frontier_offsets;
+
+        /// @brief dominance frontiers of all the blocks
+        std::vector<block_id_t> frontiers;
+
+        /// @brief Get the sucessors of a block in the graph of the tree
+        std::span<const block_id_t> sucessors(const BasicBlocks &blocks, block_id_t id) const
+        {
+            if (!exceptions)
+                return blocks.get_sucessor_ids(id);
+            return std::span<const block_id_t>(sucessor_ids.data() + sucessor_offsets[id],
+                                               sucessor_offsets[id + 1] - sucessor_offsets[id]);
+        }
+
+        /// @brief Get the predecessors of a block in the graph of the tree
+        std::span<const block_id_t> predecessors(const BasicBlocks &blocks, block_id_t id) const
+        {
+            if (!exceptions)
+                return blocks.get_predecessor_ids(id);
+            return std::span<const block_id_t>(predecessor_ids.data() + predecessor_offsets[id],
+                                               predecessor_offsets[id + 1] - predecessor_offsets[id]);
+        }
+
+        /// @brief Get the blocks that follow a block in the direction
+        /// of the analysis, sucessors or predecessors
+        std::span<const block_id_t> forward(const BasicBlocks &blocks, block_id_t id) const
+        {
+            return post_dominators ? predecessors(blocks, id) : sucessors(blocks, id);
+        }
+
+        /// @brief Get the blocks that come before a block in the
+        /// direction of the analysis, predecessors or sucessors
+        std::span<const block_id_t> backward(const BasicBlocks &blocks, block_id_t id) const
+        {
+            return post_dominators ? sucessors(blocks, id) : predecessors(blocks, id);
+        }
+
+        /// @brief Join the normal and the exceptional edges of the graph
+        void compute_exception_graph(const BasicBlocks &blocks);
+
+        /// @brief Number the blocks in reverse postorder from the root
+        void compute_reverse_postorder(const BasicBlocks &blocks);
+
+        /// @brief Compute the immediate dominators
+        void compute_immediate_dominators(const BasicBlocks &blocks);
+
+        /// @brief Create the children of each block and the preorder
+        /// intervals of the tree
+        void compute_tree();
+
+        /// @brief Compute the dominance frontiers of all the blocks
+        void compute_frontiers(const BasicBlocks &blocks);
+
+    public:
+        /// @brief Compute the dominator tree of a graph
+        /// @param blocks basic blocks of a method, with its start and end blocks
+        /// @param post_dominators compute the post-dominator tree instead
+        /// @param exceptions follow also the exceptional edges
+        DominatorTree(const BasicBlocks &blocks, bool post_dominators = false, bool exceptions = false);
+
+        /// @brief Is this a post-dominator tree?
+        /// @return true for a post-dominator tree
+        bool is_post_dominator_tree() const
+        {
+            return post_dominators;
+        }
+
+        /// @brief Are the exceptional edges followed?
+        /// @return true if the handlers are reached from the blocks that throw
+        bool follows_exceptions() const
+        {
+            return exceptions;
+        }
+
+        /// @brief Get the root of the tree
+        /// @return id of the start block (or the end block for the
+        /// post-dominators), no_block for an empty graph
+        block_id_t get_root() const
+        {
+            return root;
+        }
+
+        /// @brief Get the blocks reachable from the root in reverse postorder,
+        /// the order in which the forward analyses visit the blocks
+        /// @return ids of the blocks
+        const std::vector<block_id_t> &get_reverse_postorder() const
+        {
+            return reverse_postorder;
+        }
+
+        /// @brief Check if a block is part of the tree
+        /// @param id id of the block
+        /// @return true if the block is reachable from the root
+        bool is_reachable(block_id_t id) const
+        {
+            return id < rpo_number.size() && rpo_number[id] != no_block;
+        }
+
+        /// @brief Get the position of a block in the reverse postorder
+        /// @param id id of the block
+        /// @return position, no_block for unreachable blocks
+        std::uint32_t get_rpo_number(block_id_t id) const
+        {
+            return rpo_number[id];
+        }
+
+        /// @brief Get the immediate dominator of a block
+        /// @param id id of the block
+        /// @return id of the immediate dominator, no_block for the
+        /// root and the unreachable blocks
+        block_id_t get_immediate_dominator(block_id_t id) const
+        {
+            return idom[id];
+        }
+
+        /// @brief Get the blocks immediately dominated by a block
+        /// @param id id of the block
+        /// @return children of the block in the tree
+        std::span<const block_id_t> get_children(block_id_t id) const
+        {
+            return std::span<const block_id_t>(children.data() + children_offsets[id],
+                                               children_offsets[id + 1] - children_offsets[id]);
+        }
+
+        /// @brief Get the dominance frontier of a block, the blocks where
+        /// the dominance of the block finishes
+        /// @param id id of the block
+        /// @return blocks of the frontier
+        std::span<const block_id_t> get_dominance_frontier(block_id_t id) const
+        {
+            return std::span<const block_id_t>(frontiers.data() + frontier_offsets[id],
+                                               frontier_offsets[id + 1] - frontier_offsets[id]);
+        }
+
+        /// @brief Check if a block dominates another, every block
+        /// dominates itself
+        /// @param a id of the dominator block
+        /// @param b id of the dominated block
+        /// @return true if every path from the root to `b` goes through `a`
+        bool dominates(block_id_t a, block_id_t b) const
+        {
+            if (!is_reachable(a) || !is_reachable(b))
+                return false;
+            return preorder[a] <= preorder[b] && preorder[b] <= last_preorder[a];
+        }
+
+        /// @brief Check if a block dominates another block different to it
+        /// @param a id of the dominator block
+        /// @param b id of the dominated block
+        /// @return true if `a` dominates `b` and they are different
+        bool strictly_dominates(block_id_t a, block_id_t b) const
+        {
+            return a != b && dominates(a, b);
+        }
+
+        /// @brief Check if a block dominates another
+        /// @param a dominator block
+        /// @param b dominated block
+        /// @return true if every path from the root to `b` goes through `a`
+        bool dominates(const DVMBasicBlock *a, const DVMBasicBlock *b) const
+        {
+            return dominates(a->get_id(), b->get_id());
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -28,7 +28,7 @@ namespace DEX
         /// @brief Vector of EncodedFields created through FieldID
         std::vector<encodedfield_t> fields;
     public:
-        ExternalClass(std::string& name) : name(name)
+        ExternalClass(const std::string& name) : name(name)
         {}
 
         /// @brief Get the name of the external class
@@ -0,0 +1,168 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file loops.hpp
+// @brief Loop nesting forest of the basic blocks of a method, with the
+// natural and the irreducible loops.
+
+#ifndef KUNAI_DEX_ANALYSIS_LOOPS_HPP
+#define KUNAI_DEX_ANALYSIS_LOOPS_HPP
+
+#include "Kunai/DEX/analysis/analysis.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Loops of a BasicBlocks graph organized as a forest, the
+    /// parent of a loop is the innermost loop that contains it. The
+    /// forest is created with the algorithm from Havlak ("Nesting of
+    /// reducible and irreducible loops"), a depth first search from the
+    /// start block and a union-find of the blocks, so it is almost linear
+    /// and it also finds the loops with more than one entry (irreducible
+    /// loops), which are common in obfuscated code.
+    ///
+    /// Each loop is identified by its position in the forest, the inner
+    /// loops always come before the loops that contain them.
+    class LoopForest
+    {
+    public:
+        using block_id_t = BasicBlocks::block_id_t;
+        using loop_id_t = std::uint32_t;
+
+        /// @brief value used for the blocks outside of any loop and
+        /// for the loops without parent
+        static constexpr loop_id_t no_loop = std::numeric_limits<loop_id_t>::max();
+
+    private:
+        /// @brief header block of each loop
+        std::vector<block_id_t> headers;
+
+        /// @brief parent of each loop
+        std::vector<loop_id_t> parents;
+
+        /// @brief depth of each loop, 1 for the outermost loops
+        std::vector<std::uint32_t> depths;
+
+        /// @brief is each loop reducible? (only one entry)
+        std::vector<std::uint8_t> reducible;
+
+        /// @brief start of the blocks of each loop in `loop_blocks`
+        std::vector<std::uint32_t> block_offsets;
+
+        /// @brief blocks whose innermost loop is each loop, the
+        /// header is the first one
+        std::vector<block_id_t> loop_blocks;
+
+        /// @brief innermost loop of each block
+        std::vector<loop_id_t> block_loop;
+
+        /// @brief maximum depth of the loops
+        std::uint32_t max_depth = 0;
+
+    public:
+        /// @brief Compute the loop nesting forest of a graph
+        /// @param blocks basic blocks of a method, with its start block
+        LoopForest(const BasicBlocks &blocks);
+
+        /// @brief Get the number of loops of the graph
+        /// @return number of loops
+        std::size_t get_number_of_loops() const
+        {
+            return headers.size();
+        }
+
+        /// @brief Get the header of a loop, the block where the loop
+        /// is entered, for irreducible loops one of the entries
+        /// @param loop id of the loop
+        /// @return id of the header block
+        block_id_t get_header(loop_id_t loop) const
+        {
+            return headers[loop];
+        }
+
+        /// @brief Get the loop that contains a loop
+        /// @param loop id of the loop
+        /// @return id of the parent loop, no_loop for the outermost loops
+        loop_id_t get_parent(loop_id_t loop) const
+        {
+            return parents[loop];
+        }
+
+        /// @brief Get the nesting depth of a loop
+        /// @param loop id of the loop
+        /// @return 1 for the outermost loops, 2 for the loops inside
+        /// of them, and so on
+        std::uint32_t get_depth(loop_id_t loop) const
+        {
+            return depths[loop];
+        }
+
+        /// @brief Check if a loop is reducible, if it has only one entry
+        /// @param loop id of the loop
+        /// @return true for natural loops, false for irreducible loops
+        bool is_reducible(loop_id_t loop) const
+        {
+            return reducible[loop];
+        }
+
+        /// @brief Get the blocks whose innermost loop is a loop, the
+        /// blocks of the inner loops are not included
+        /// @param loop id of the loop
+        /// @return ids of the blocks, the header first
+        std::span<const block_id_t> get_blocks(loop_id_t loop) const
+        {
+            return std::span<const block_id_t>(loop_blocks.data() + block_offsets[loop],
+                                               block_offsets[loop + 1] - block_offsets[loop]);
+        }
+
+        /// @brief Get the innermost loop that contains a block
+        /// @param id id of the block
+        /// @return id of the loop, no_loop if the block is not in a loop
+        loop_id_t get_loop_of(block_id_t id) const
+        {
+            return block_loop[id];
+        }
+
+        /// @brief Get the number of loops that contain a block
+        /// @param id id of the block
+        /// @return loop depth of the block, 0 outside of the loops
+        std::uint32_t get_loop_depth(block_id_t id) const
+        {
+            return block_loop[id] == no_loop ? 0 : depths[block_loop[id]];
+        }
+
+        /// @brief Check if a loop is the same or it is inside of another loop
+        /// @param inner id of the inner loop
+        /// @param outer id of the outer loop
+        /// @return true if `outer` contains `inner`
+        bool is_nested_in(loop_id_t inner, loop_id_t outer) const
+        {
+            for (; inner != no_loop; inner = parents[inner])
+                if (inner == outer)
+                    return true;
+            return false;
+        }
+
+        /// @brief Get the maximum nesting depth of the loops
+        /// @return 0 without loops
+        std::uint32_t get_max_depth() const
+        {
+            return max_depth;
+        }
+
+        /// @brief Get the number of irreducible loops
+        /// @return loops with more than one entry
+        std::size_t get_number_of_irreducible_loops() const;
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file method_metrics.hpp
+// @brief Table with the metrics of the control flow graph and the
+// instructions of many methods, one row per method.
+
+#ifndef KUNAI_DEX_ANALYSIS_METHOD_METRICS_HPP
+#define KUNAI_DEX_ANALYSIS_METHOD_METRICS_HPP
+
+#include "Kunai/DEX/analysis/analysis.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Metrics of a group of methods stored by columns, the
+    /// row `i` of every column belongs to `methods[i]`. Each row is
+    /// computed independently of the others, so the rows can be
+    /// filled from different threads once the table has its size.
+    struct MethodMetrics
+    {
+        /// @brief method of each row
+        std::vector<MethodAnalysis *> methods;
+
+        /// @brief number of basic blocks, start and end blocks included
+        std::vector<std::uint32_t> blocks;
+        /// @brief number of edges between the basic blocks
+        std::vector<std::uint32_t> edges;
+        /// @brief number of instructions
+        std::vector<std::uint32_t> instructions;
+        /// @brief cyclomatic complexity, edges - blocks + 2, and
+        /// 0 for the methods without code
+        std::vector<std::uint32_t> cyclomatic_complexity;
+
+        /// @brief number of loops
+        std::vector<std::uint32_t> loops;
+        /// @brief number of loops with more than one entry
+        std::vector<std::uint32_t> irreducible_loops;
+        /// @brief maximum nesting depth of the loops
+        std::vector<std::uint32_t> max_loop_depth;
+
+        /// @brief instructions of each kind of operation
+        std::vector<std::uint32_t> conditional_branches;
+        std::vector<std::uint32_t> unconditional_branches;
+        std::vector<std::uint32_t> returns;
+        std::vector<std::uint32_t> switches;
+        std::vector<std::uint32_t> invokes;
+        std::vector<std::uint32_t> moves;
+        std::vector<std::uint32_t> field_reads;
+        std::vector<std::uint32_t> field_writes;
+
+        /// @brief Create the rows of a group of methods, all
+        /// the metrics start at 0
+        /// @param rows methods of the table
+        void set_methods(std::vector<MethodAnalysis *> rows);
+
+        /// @brief Compute the metrics of one row. The basic blocks of
+        /// the method are created in case they do not exist yet.
+        /// @param row row to compute
+        void compute_row(std::size_t row);
+
+        /// @brief Get the number of rows of the table
+        /// @return number of methods
+        std::size_t size() const
+        {
+            return methods.size();
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,128 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file search.hpp
+// @brief Patterns and indexes used by the find_* methods of the analysis,
+// most of the queries are plain names that do not need a regular
+// expression, these are answered with sorted names and trigrams.
+
+#ifndef KUNAI_DEX_ANALYSIS_SEARCH_HPP
+#define KUNAI_DEX_ANALYSIS_SEARCH_HPP
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Regular expression of a find_* query. The pattern is checked
+    /// once, when it has no special characters (or only ^ and $ at the
+    /// ends) it is matched as a string, in other case the regular
+    /// expression is compiled once and kept in a cache shared by all the
+    /// queries. The result is always the same as std::regex_search.
+    class SearchPattern
+    {
+    public:
+        enum class kind_t
+        {
+            ANY,     //! matches everything ("", ".*")
+            EXACT,   //! ^literal$
+            PREFIX,  //! ^literal
+            SUFFIX,  //! literal$
+            LITERAL, //! literal anywhere
+            REGEX    //! needs the regular expression
+        };
+
+    private:
+        kind_t kind = kind_t::ANY;
+
+        /// @brief text to look for, without the anchors and escapes
+        std::string literal;
+
+        /// @brief compiled expression for kind_t::REGEX
+        std::shared_ptr<const std::regex> regex;
+
+        /// @brief Get a compiled regular expression from the cache
+        static std::shared_ptr<const std::regex> compile(const std::string &pattern);
+
+    public:
+        /// @brief Analyze a regular expression
+        /// @param pattern regular expression in ECMAScript syntax
+        SearchPattern(const std::string &pattern);
+
+        kind_t get_kind() const
+        {
+            return kind;
+        }
+
+        const std::string &get_literal() const
+        {
+            return literal;
+        }
+
+        /// @brief Does a text match the pattern?
+        /// @param text text to check
+        /// @return the same as std::regex_search
+        bool match(std::string_view text) const;
+    };
+
+    /// @brief Index over the names of a table of objects, the objects are
+    /// given by their position in the table. The names are kept sorted for
+    /// the exact and prefix queries, and the positions of every trigram of
+    /// the names are kept for looking for a text inside the names. The rest
+    /// of the queries scan the names, with a pool of threads for the big tables.
+    class NameIndex
+    {
+    public:
+        using position_t = std::uint32_t;
+
+    private:
+        /// @brief name of each position, the names belong to the table
+        std::vector<std::string_view> names;
+
+        /// @brief positions sorted by name
+        std::vector<position_t> sorted;
+
+        /// @brief positions of the names that contain each trigram
+        std::unordered_map<std::uint32_t, std::vector<position_t>> trigrams;
+
+        std::vector<position_t> scan(const SearchPattern &pattern, unsigned threads) const;
+
+    public:
+        /// @brief Create the index of a table
+        /// @param table_names name of each object of the table, these
+        /// must be alive while the index is used
+        /// @param with_trigrams create the trigrams, useful for big
+        /// tables with text queries (strings, methods)
+        void build(std::vector<std::string_view> table_names, bool with_trigrams);
+
+        /// @brief Get the number of names
+        std::size_t size() const
+        {
+            return names.size();
+        }
+
+        /// @brief Get the name of a position
+        std::string_view get_name(position_t position) const
+        {
+            return names[position];
+        }
+
+        /// @brief Get the positions whose name matches a pattern
+        /// @param pattern pattern to look for
+        /// @param threads threads for the scans, 0 for the hardware threads
+        /// @return sorted positions
+        std::vector<position_t> search(const SearchPattern &pattern, unsigned threads = 0) const;
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,340 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file ssa.hpp
+// @brief Static single assignment form of the registers of a method built
+// directly over the Dalvik instructions, together with a constant
+// propagation over the values of the SSA form.
+
+#ifndef KUNAI_DEX_ANALYSIS_SSA_HPP
+#define KUNAI_DEX_ANALYSIS_SSA_HPP
+
+#include "Kunai/DEX/analysis/dataflow.hpp"
+#include "Kunai/DEX/analysis/dominators.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief SSA form of the registers of a method. Every register written
+    /// by an instruction is a value, the parameters are values defined at
+    /// the start of the method, and the phis are values placed in the blocks
+    /// of the iterated dominance frontier of the definitions of a register
+    /// where the register is live (pruned SSA from Cytron et al.).
+    ///
+    /// The dominators follow the exceptional edges, a handler is reached
+    /// from the blocks that throw to it. Any instruction of those blocks
+    /// can throw, so a handler gets a phi for every live register written
+    /// by a block that throws to it, and the operand of that block is
+    /// no_value (the register has different values along the block).
+    ///
+    /// The instructions are not copied, the values point to the instructions
+    /// of the method, and everything is stored in flat arrays indexed by the
+    /// id of the values: first the parameters, then the registers written by
+    /// the instructions in the order of `RegisterAccesses::get_defs`, and at
+    /// the end the phis grouped by block. The wide values are two values,
+    /// one for each register of the pair.
+    class SSAForm
+    {
+    public:
+        using block_id_t = BasicBlocks::block_id_t;
+        using value_id_t = std::uint32_t;
+        using use_id_t = std::uint32_t;
+
+        /// @brief value used for the registers read without definition,
+        /// for the operands of a phi that come from unreachable blocks,
+        /// and for the operands of a handler for the registers written
+        /// by the block that throws
+        static constexpr value_id_t no_value = std::numeric_limits<value_id_t>::max();
+
+        /// @brief origin of a value
+        enum class value_kind_t : std::uint8_t
+        {
+            PARAMETER,  //! register of a parameter of the method
+            INSTRUCTION,//! register written by an instruction
+            PHI         //! join of the values of a register from different blocks
+        };
+
+    private:
+        /// @brief registers of the instructions
+        RegisterAccesses accesses;
+
+        /// @brief number of values of parameters
+        std::uint32_t number_of_parameters = 0;
+
+        /// @brief number of values written by the instructions
+        std::uint32_t number_of_defs = 0;
+
+        /// @brief register of each value
+        std::vector<std::uint16_t> value_registers;
+
+        /// @brief block of each phi
+        std::vector<block_id_t> phi_blocks;
+
+        /// @brief first phi of each block
+        std::vector<std::uint32_t> block_phi_offsets;
+
+        /// @brief start of the operands of each phi
+        std::vector<std::uint32_t> phi_operand_offsets;
+
+        /// @brief operands of all the phis, in the order of the
+        /// predecessors of the block and then the blocks that throw to it
+        std::vector<value_id_t> phi_operands;
+
+        /// @brief value read by each use of `RegisterAccesses`
+        std::vector<value_id_t> use_values;
+
+        /// @brief start of the instructions that read each value
+        std::vector<std::uint32_t> user_offsets;
+
+        /// @brief position of the instructions that read the values
+        std::vector<std::uint32_t> users;
+
+        /// @brief start of the phis that read each value
+        std::vector<std::uint32_t> phi_user_offsets;
+
+        /// @brief phis that read the values
+        std::vector<value_id_t> phi_users;
+
+        /// @brief Place the phis of the registers
+        /// @return blocks and registers of the phis, sorted by block
+        std::vector<std::pair<block_id_t, std::uint16_t>> place_phis(const BasicBlocks &blocks,
+                                                                     const DominatorTree &dominators,
+                                                                     const LivenessAnalysis &liveness);
+
+        /// @brief Give to every use and phi operand its value
+        void rename(const BasicBlocks &blocks, const DominatorTree &dominators);
+
+        /// @brief Create the lists of users of the values
+        void compute_users();
+
+    public:
+        /// @brief Build the SSA form of a method
+        /// @param method internal method to analyze
+        SSAForm(MethodAnalysis *method);
+
+        SSAForm(const SSAForm &) = delete;
+        SSAForm &operator=(const SSAForm &) = delete;
+
+        /// @brief Get the registers of the instructions of the method
+        const RegisterAccesses &get_register_accesses() const
+        {
+            return accesses;
+        }
+
+        /// @brief Get the number of values
+        /// @return parameters, registers written and phis
+        std::size_t get_number_of_values() const
+        {
+            return value_registers.size();
+        }
+
+        /// @brief Get the number of phis
+        /// @return phis of all the blocks
+        std::size_t get_number_of_phis() const
+        {
+            return phi_blocks.size();
+        }
+
+        /// @brief Get the origin of a value
+        /// @param value id of the value
+        /// @return kind of the value
+        value_kind_t get_kind(value_id_t value) const
+        {
+            if (value < number_of_parameters)
+                return value_kind_t::PARAMETER;
+            if (value < number_of_parameters + number_of_defs)
+                return value_kind_t::INSTRUCTION;
+            return value_kind_t::PHI;
+        }
+
+        /// @brief Get the register of a value
+        /// @param value id of the value
+        /// @return register
+        std::uint16_t get_register(value_id_t value) const
+        {
+            return value_registers[value];
+        }
+
+        /// @brief Get the position of the instruction that writes a value
+        /// @param value id of a value of kind INSTRUCTION
+        /// @return position of the instruction in the method
+        std::uint32_t get_instruction_index(value_id_t value) const;
+
+        /// @brief Get the instruction that writes a value
+        /// @param value id of the value
+        /// @return instruction, nullptr for parameters and phis
+        Instruction *get_instruction(value_id_t value) const
+        {
+            if (get_kind(value) != value_kind_t::INSTRUCTION)
+                return nullptr;
+            return accesses.get_instructions()[get_instruction_index(value)];
+        }
+
+        /// @brief Get the values written by an instruction
+        /// @param index position of the instruction
+        /// @return ids of the values, in the order of the registers
+        auto get_values_defined(std::uint32_t index) const
+        {
+            auto first = number_of_parameters + accesses.get_first_def(index);
+            return std::views::iota(first, number_of_parameters + accesses.get_first_def(index + 1));
+        }
+
+        /// @brief Get the value written by an instruction in a register
+        /// @param instr instruction of the method
+        /// @param reg register written
+        /// @return id of the value, no_value if the instruction does
+        /// not write the register
+        value_id_t get_value_defined(const Instruction *instr, std::uint16_t reg) const;
+
+        /// @brief Get the values read by an instruction
+        /// @param index position of the instruction
+        /// @return ids of the values, in the order of `RegisterAccesses::get_uses`
+        std::span<const value_id_t> get_values_used(std::uint32_t index) const
+        {
+            return std::span<const value_id_t>(use_values.data() + accesses.get_first_use(index),
+                                               accesses.get_uses(index).size());
+        }
+
+        /// @brief Get the value read by an instruction from a register
+        /// @param instr instruction of the method
+        /// @param reg register read
+        /// @return id of the value, no_value if the register is not read
+        /// or it has no definition
+        value_id_t get_value_used(const Instruction *instr, std::uint16_t reg) const;
+
+        /// @brief Get the phis of a block
+        /// @param id id of the block
+        /// @return ids of the phis
+        auto get_phis(block_id_t id) const
+        {
+            return std::views::iota(static_cast<value_id_t>(number_of_parameters + number_of_defs + block_phi_offsets[id]),
+                                    static_cast<value_id_t>(number_of_parameters + number_of_defs + block_phi_offsets[id + 1]));
+        }
+
+        /// @brief Get the block of a phi
+        /// @param value id of a phi
+        /// @return id of the block
+        block_id_t get_phi_block(value_id_t value) const
+        {
+            return phi_blocks[value - number_of_parameters - number_of_defs];
+        }
+
+        /// @brief Get the operands of a phi, one for each predecessor of
+        /// its block in the order of `BasicBlocks::get_predecessor_ids`
+        /// (none for the start block of a handler only reached by the
+        /// exceptions) followed by one for each block that throws to it
+        /// in the order of `BasicBlocks::get_exception_predecessor_ids`
+        /// @param value id of a phi
+        /// @return ids of the values
+        std::span<const value_id_t> get_phi_operands(value_id_t value) const
+        {
+            auto phi = value - number_of_parameters - number_of_defs;
+            return std::span<const value_id_t>(phi_operands.data() + phi_operand_offsets[phi],
+                                               phi_operand_offsets[phi + 1] - phi_operand_offsets[phi]);
+        }
+
+        /// @brief Get the instructions that read a value
+        /// @param value id of the value
+        /// @return positions of the instructions
+        std::span<const std::uint32_t> get_users(value_id_t value) const
+        {
+            return std::span<const std::uint32_t>(users.data() + user_offsets[value],
+                                                  user_offsets[value + 1] - user_offsets[value]);
+        }
+
+        /// @brief Get the phis that read a value
+        /// @param value id of the value
+        /// @return ids of the phis
+        std::span<const value_id_t> get_phi_users(value_id_t value) const
+        {
+            return std::span<const value_id_t>(phi_users.data() + phi_user_offsets[value],
+                                               phi_user_offsets[value + 1] - phi_user_offsets[value]);
+        }
+    };
+
+    /// @brief Sparse constant propagation over the values of the SSA form,
+    /// it finds the values that are always the same number or the same
+    /// string. The constants come from the const instructions and they go
+    /// through the moves, the phis and the arithmetic with literals.
+    class SSAConstantPropagation
+    {
+    public:
+        using value_id_t = SSAForm::value_id_t;
+
+        /// @brief value of the lattice of each SSA value
+        enum class state_t : std::uint8_t
+        {
+            UNKNOWN,      //! not evaluated yet
+            INTEGER,      //! always the same number
+            STRING,       //! always the same string
+            NOT_CONSTANT  //! different values
+        };
+
+    private:
+        /// @brief SSA form analyzed
+        const SSAForm &ssa;
+
+        /// @brief state of each value
+        std::vector<state_t> states;
+
+        /// @brief number of the INTEGER values, for the wide
+        /// values the low register keeps the 64 bits number and
+        /// the high register is not constant
+        std::vector<std::int64_t> integers;
+
+        /// @brief string of the STRING values
+        std::vector<const std::string *> strings;
+
+        /// @brief Compute the state of a value from its operands
+        void evaluate(value_id_t value, state_t &state, std::int64_t &integer, const std::string *&string) const;
+
+    public:
+        /// @brief Propagate the constants of a method
+        /// @param ssa SSA form of the method
+        SSAConstantPropagation(const SSAForm &ssa);
+
+        /// @brief Get the state of a value, no_value can be any value
+        /// so it is not constant
+        state_t get_state(value_id_t value) const
+        {
+            return value == SSAForm::no_value ? state_t::NOT_CONSTANT : states[value];
+        }
+
+        /// @brief Check if a value is always the same number
+        bool is_integer(value_id_t value) const
+        {
+            return get_state(value) == state_t::INTEGER;
+        }
+
+        /// @brief Check if a value is always the same string
+        bool is_string(value_id_t value) const
+        {
+            return get_state(value) == state_t::STRING;
+        }
+
+        /// @brief Get the number of an INTEGER value
+        std::int64_t get_integer(value_id_t value) const
+        {
+            return integers[value];
+        }
+
+        /// @brief Get the string of a STRING value
+        const std::string &get_string(value_id_t value) const
+        {
+            return *strings[value];
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,165 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file string_scanner.hpp
+// @brief Automaton of Aho-Corasick for looking for many literal patterns
+// (urls, domains, prefixes of keys...) in the strings of the dex files
+// with only one pass over every string.
+
+#ifndef KUNAI_DEX_ANALYSIS_STRING_SCANNER_HPP
+#define KUNAI_DEX_ANALYSIS_STRING_SCANNER_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Set of literal patterns compiled once into an automaton of
+    /// Aho-Corasick. The transitions of every state are stored sorted in
+    /// compressed rows, the root keeps one transition per byte, and every
+    /// state has a failure link and a link to the next state of its
+    /// failure chain that ends a pattern. A text is scanned once for all
+    /// the patterns. The set cannot be modified, so it can be used by
+    /// several threads at the same time.
+    class PatternSet
+    {
+    public:
+        using state_t = std::uint32_t;
+        using pattern_t = std::uint32_t;
+
+        /// @brief state without link
+        static constexpr state_t no_state = static_cast<state_t>(-1);
+
+    private:
+        /// @brief the patterns, pattern_t is the position
+        std::vector<std::string> patterns;
+
+        /// @brief state reached from the root with each byte
+        std::array<state_t, 256> root{};
+
+        /// @brief first transition of each state
+        std::vector<std::uint32_t> edge_offsets;
+
+        /// @brief byte of each transition, sorted for each state
+        std::vector<std::uint8_t> edge_bytes;
+
+        /// @brief state reached by each transition
+        std::vector<state_t> edge_targets;
+
+        /// @brief longest proper suffix of each state that
+        /// is also a state
+        std::vector<state_t> failure;
+
+        /// @brief next state in the failure chain that ends
+        /// a pattern, no_state if none
+        std::vector<state_t> output_link;
+
+        /// @brief first pattern ended by each state
+        std::vector<std::uint32_t> output_offsets;
+
+        /// @brief patterns ended by each state
+        std::vector<pattern_t> outputs;
+
+        /// @brief Get the state reached from a state with a byte,
+        /// following the failure links if needed
+        state_t next(state_t state, std::uint8_t byte) const
+        {
+            while (state != 0)
+            {
+                auto first = edge_bytes.begin() + edge_offsets[state];
+                auto last = edge_bytes.begin() + edge_offsets[state + 1];
+
+                // the states have few transitions
+                for (auto it = first; it != last; it++)
+                    if (*it == byte)
+                        return edge_targets[it - edge_bytes.begin()];
+
+                state = failure[state];
+            }
+
+            return root[byte];
+        }
+
+    public:
+        /// @brief Compile a set of patterns, the repeated patterns
+        /// are reported with each of their positions and the empty
+        /// patterns are never reported
+        /// @param patterns literal patterns, the bytes are compared
+        /// as they are (the dex strings are MUTF-8)
+        PatternSet(std::vector<std::string> patterns);
+
+        /// @brief Get the number of patterns
+        std::size_t size() const
+        {
+            return patterns.size();
+        }
+
+        /// @brief Get a pattern
+        const std::string &get_pattern(pattern_t pattern) const
+        {
+            return patterns[pattern];
+        }
+
+        /// @brief Get the number of states of the automaton
+        std::size_t get_number_of_states() const
+        {
+            return failure.size();
+        }
+
+        /// @brief Get the patterns ended by a state, without those
+        /// of its failure chain
+        std::span<const pattern_t> get_outputs(state_t state) const
+        {
+            return std::span<const pattern_t>(outputs).subspan(output_offsets[state], output_offsets[state + 1] - output_offsets[state]);
+        }
+
+        /// @brief Find all the occurrences of the patterns in a text,
+        /// overlapping occurrences included
+        /// @param text text to scan
+        /// @param callback called as callback(pattern, offset) with
+        /// the offset of the first byte of the occurrence, in the
+        /// order of the end of the occurrences
+        template <typename Callback>
+        void scan(std::string_view text, Callback &&callback) const
+        {
+            state_t state = 0;
+
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                state = next(state, static_cast<std::uint8_t>(text[i]));
+
+                for (auto out = output_offsets[state + 1] > output_offsets[state] ? state : output_link[state];
+                     out != no_state; out = output_link[out])
+                    for (auto pattern : get_outputs(out))
+                        callback(pattern, static_cast<std::uint32_t>(i + 1 - patterns[pattern].size()));
+            }
+        }
+
+        /// @brief Does a text contain any of the patterns?
+        bool contains_any(std::string_view text) const
+        {
+            state_t state = 0;
+
+            for (auto c : text)
+            {
+                state = next(state, static_cast<std::uint8_t>(c));
+
+                if (output_offsets[state + 1] > output_offsets[state] || output_link[state] != no_state)
+                    return true;
+            }
+
+            return false;
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
@@ -0,0 +1,252 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file symbols.hpp
+// @brief Table that gives a dense integer id to every class, method,
+// field and string of the analyzed dex files, so the analysis can work
+// with integers instead of names.
+
+#ifndef KUNAI_DEX_ANALYSIS_SYMBOLS_HPP
+#define KUNAI_DEX_ANALYSIS_SYMBOLS_HPP
+
+#include "Kunai/DEX/parser/parser.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    /// @brief Names interned with consecutive ids, the names are
+    /// stored only once and the ids never change.
+    class SymbolNames
+    {
+    public:
+        using symbol_id_t = std::uint32_t;
+
+        static constexpr symbol_id_t no_symbol = std::numeric_limits<symbol_id_t>::max();
+
+    private:
+        /// @brief names by id, a deque keeps the strings in place
+        /// so the keys of the index stay valid
+        std::deque<std::string> names;
+
+        /// @brief id of each name
+        std::unordered_map<std::string_view, symbol_id_t> index;
+
+    public:
+        /// @brief Get the id of a name, the name is added the first time
+        /// @param name name to intern
+        /// @return id of the name
+        symbol_id_t intern(std::string_view name);
+
+        /// @brief Get the id of a name without adding it
+        /// @param name name to look for
+        /// @return id of the name, no_symbol if it was never interned
+        symbol_id_t find(std::string_view name) const
+        {
+            auto it = index.find(name);
+            return it != index.end() ? it->second : no_symbol;
+        }
+
+        /// @brief Get the name of an id
+        /// @param id id of the name
+        /// @return constant reference to the name
+        const std::string &get_name(symbol_id_t id) const
+        {
+            return names[id];
+        }
+
+        /// @brief Get the number of names interned
+        /// @return number of ids
+        std::size_t size() const
+        {
+            return names.size();
+        }
+    };
+
+    /// @brief Symbols of all the dex files of an analysis. The classes
+    /// are named by their descriptor (Ljava/lang/Object;), the methods by
+    /// class->name(parameters)return, so the overloads with the same
+    /// shorty are different symbols, the fields by class->name:type and
+    /// the strings by their value.
+    ///
+    /// Every parser gets tables that translate the indexes used by its
+    /// instructions (type, method, field and string ids of the dex file)
+    /// into symbols, so the same class in two dex files is the same id.
+    class SymbolTable
+    {
+    public:
+        using symbol_id_t = SymbolNames::symbol_id_t;
+
+        static constexpr symbol_id_t no_symbol = SymbolNames::no_symbol;
+
+        /// @brief Translation of the ids of one dex file into symbols
+        struct parser_symbols_t
+        {
+            /// @brief parser of the dex file
+            Parser *parser;
+
+            /// @brief class of each type, no_symbol for the types
+            /// that are not classes (fundamental types and arrays)
+            std::vector<symbol_id_t> types;
+
+            /// @brief symbol of each method id
+            std::vector<symbol_id_t> methods;
+
+            /// @brief symbol of each field id
+            std::vector<symbol_id_t> fields;
+
+            /// @brief symbol of each string id
+            std::vector<symbol_id_t> strings;
+        };
+
+    private:
+        /// @brief names of the classes
+        SymbolNames classes;
+
+        /// @brief names of the methods
+        SymbolNames methods;
+
+        /// @brief names of the fields
+        SymbolNames fields;
+
+        /// @brief values of the strings
+        SymbolNames strings;
+
+        /// @brief class of each method, no_symbol if the method
+        /// belongs to an array type
+        std::vector<symbol_id_t> method_classes;
+
+        /// @brief first MethodID found for each method
+        std::vector<MethodID *> method_ids;
+
+        /// @brief tables of each parser, in the order these were added
+        std::deque<parser_symbols_t> parsers;
+
+    public:
+        /// @brief Get the name of the symbol of a method
+        /// @param method method of a dex file
+        /// @return class->name(parameters)return
+        static std::string method_name(MethodID *method);
+
+        /// @brief Get the name of the symbol of a field
+        /// @param field field of a dex file
+        /// @return class->name:type
+        static std::string field_name(FieldID *field);
+
+        /// @brief Intern all the types, methods, fields and strings
+        /// of a dex file
+        /// @param parser parser of the dex file
+        /// @return tables of the dex file
+        const parser_symbols_t &add_parser(Parser *parser);
+
+        /// @brief Get the tables of the dex files
+        /// @return tables in the order of add_parser
+        const std::deque<parser_symbols_t> &get_parsers() const
+        {
+            return parsers;
+        }
+
+        /// @brief Get the number of classes
+        std::size_t get_number_of_classes() const
+        {
+            return classes.size();
+        }
+
+        /// @brief Get the number of methods
+        std::size_t get_number_of_methods() const
+        {
+            return methods.size();
+        }
+
+        /// @brief Get the number of fields
+        std::size_t get_number_of_fields() const
+        {
+            return fields.size();
+        }
+
+        /// @brief Get the number of strings
+        std::size_t get_number_of_strings() const
+        {
+            return strings.size();
+        }
+
+        /// @brief Get the id of a class by its name
+        /// @return id, no_symbol if the class is not used
+        symbol_id_t find_class(std::string_view name) const
+        {
+            return classes.find(name);
+        }
+
+        /// @brief Get the id of a method by class->name(parameters)return
+        /// @return id, no_symbol if the method is not used
+        symbol_id_t find_method(std::string_view name) const
+        {
+            return methods.find(name);
+        }
+
+        /// @brief Get the id of a field by class->name:type
+        /// @return id, no_symbol if the field is not used
+        symbol_id_t find_field(std::string_view name) const
+        {
+            return fields.find(name);
+        }
+
+        /// @brief Get the id of a string by its value
+        /// @return id, no_symbol if the string is not in the dex files
+        symbol_id_t find_string(std::string_view value) const
+        {
+            return strings.find(value);
+        }
+
+        /// @brief Get the name of a class
+        const std::string &get_class_name(symbol_id_t id) const
+        {
+            return classes.get_name(id);
+        }
+
+        /// @brief Get the name of a method
+        const std::string &get_method_name(symbol_id_t id) const
+        {
+            return methods.get_name(id);
+        }
+
+        /// @brief Get the name of a field
+        const std::string &get_field_name(symbol_id_t id) const
+        {
+            return fields.get_name(id);
+        }
+
+        /// @brief Get the value of a string
+        const std::string &get_string(symbol_id_t id) const
+        {
+            return strings.get_name(id);
+        }
+
+        /// @brief Get the class of a method
+        /// @return id of the class, no_symbol for methods of arrays
+        symbol_id_t get_method_class(symbol_id_t id) const
+        {
+            return method_classes[id];
+        }
+
+        /// @brief Get the first MethodID found for a method, useful for
+        /// obtaining its name and prototype
+        MethodID *get_method_id(symbol_id_t id) const
+        {
+            return method_ids[id];
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
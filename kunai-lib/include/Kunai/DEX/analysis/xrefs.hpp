@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file xrefs.hpp
+// @brief Table with all the cross references of an analysis, stored once
+// as small records with the ids of the symbol table and indexed for
+// looking them up from both ends.
+
+#ifndef KUNAI_DEX_ANALYSIS_XREFS_HPP
+#define KUNAI_DEX_ANALYSIS_XREFS_HPP
+
+#include "Kunai/DEX/analysis/symbols.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace KUNAI
+{
+namespace DEX
+{
+    class ClassAnalysis;
+    class MethodAnalysis;
+    class FieldAnalysis;
+
+    /// @brief Cross references of all the methods. Every xref is one
+    /// record with the method that contains the instruction, the symbol
+    /// referenced, the type of reference and the offset of the
+    /// instruction. The records are sorted by method and offset, and
+    /// each type of reference has an index by the symbol referenced, so
+    /// both "xrefs from a method" and "xrefs to a symbol" are ranges.
+    class XrefTable
+    {
+    public:
+        using symbol_id_t = SymbolTable::symbol_id_t;
+
+        /// @brief what the instruction references
+        enum class xref_kind_t : std::uint8_t
+        {
+            CALL,         //! invoke-*, the destination is a method
+            FIELD_READ,   //! iget-* and sget-*, the destination is a field
+            FIELD_WRITE,  //! iput-* and sput-*, the destination is a field
+            STRING,       //! const-string, the destination is a string
+            NEW_INSTANCE, //! new-instance, the destination is a class
+            CONST_CLASS   //! const-class, the destination is a class
+        };
+
+        static constexpr std::size_t number_of_kinds = 6;
+
+        /// @brief one cross reference
+        struct xref_t
+        {
+            /// @brief method with the instruction
+            symbol_id_t src;
+            /// @brief method, field, string or class referenced
+            symbol_id_t dst;
+            /// @brief offset of the instruction in the method
+            std::uint32_t offset;
+            /// @brief what is referenced
+            xref_kind_t kind;
+            /// @brief opcode of the instruction
+            std::uint8_t opcode;
+
+            bool operator==(const xref_t &) const = default;
+        };
+
+    private:
+        /// @brief ids of the analysis
+        const SymbolTable &symbols;
+
+        /// @brief objects of each id of the analysis
+        const std::vector<ClassAnalysis *> &classes;
+        const std::vector<MethodAnalysis *> &methods;
+        const std::vector<FieldAnalysis *> &fields;
+
+        /// @brief all the xrefs, sorted by method, kind and offset
+        /// once the table is finished
+        std::vector<xref_t> xrefs;
+
+        /// @brief first xref of each method
+        std::vector<std::uint32_t> from_offsets;
+
+        /// @brief positions of the xrefs sorted by kind and destination
+        std::vector<std::uint32_t> to_xrefs;
+
+        /// @brief first position in `to_xrefs` of each destination,
+        /// one vector for each kind
+        std::array<std::vector<std::uint32_t>, number_of_kinds> to_offsets;
+
+        /// @brief number of times the table was finished
+        std::uint32_t generation = 0;
+
+    public:
+        XrefTable(const SymbolTable &symbols,
+                  const std::vector<ClassAnalysis *> &classes,
+                  const std::vector<MethodAnalysis *> &methods,
+                  const std::vector<FieldAnalysis *> &fields)
+            : symbols(symbols), classes(classes), methods(methods), fields(fields)
+        {
+        }
+
+        XrefTable(const XrefTable &) = delete;
+        XrefTable &operator=(const XrefTable &) = delete;
+
+        /// @brief Add a cross reference, it is not visible until
+        /// the table is finished
+        void add(symbol_id_t src, symbol_id_t dst, xref_kind_t kind,
+                 std::uint32_t opcode, std::uint64_t offset)
+        {
+            xrefs.push_back({src, dst, static_cast<std::uint32_t>(offset), kind,
+                             static_cast<std::uint8_t>(opcode)});
+        }
+
+        /// @brief Sort the cross references, remove the repeated ones
+        /// and create the indexes
+        void finish();
+
+        /// @brief Get the number of times the table was finished, the
+        /// data computed from the table is outdated when it changes
+        std::uint32_t get_generation() const
+        {
+            return generation;
+        }
+
+        /// @brief Get all the cross references
+        /// @return xrefs sorted by method, kind and offset
+        std::span<const xref_t> get_xrefs() const
+        {
+            return xrefs;
+        }
+
+        /// @brief Get a cross reference by its position
+        const xref_t &get_xref(std::uint32_t position) const
+        {
+            return xrefs[position];
+        }
+
+        /// @brief Get the cross references of the instructions of a method
+        /// @param method id of the method
+        /// @return xrefs sorted by kind and offset
+        std::span<const xref_t> get_xrefs_from(symbol_id_t method) const;
+
+        /// @brief Get the cross references of one kind from a method
+        /// @param method id of the method
+        /// @param kind type of reference
+        /// @return xrefs sorted by offset
+        std::span<const xref_t> get_xrefs_from(symbol_id_t method, xref_kind_t kind) const;
+
+        /// @brief Get the cross references to a symbol
+        /// @param kind type of reference, it gives the type of symbol
+        /// @param id id of the method, field, string or class
+        /// @return positions of the xrefs, sorted by method and offset
+        std::span<const std::uint32_t> get_xrefs_to(xref_kind_t kind, symbol_id_t id) const;
+
+        /// @brief Get the ClassAnalysis of a class id
+        ClassAnalysis *get_class(symbol_id_t id) const
+        {
+            return classes[id];
+        }
+
+        /// @brief Get the MethodAnalysis of a method id
+        MethodAnalysis *get_method(symbol_id_t id) const
+        {
+            return methods[id];
+        }
+
+        /// @brief Get the FieldAnalysis of a field id
+        FieldAnalysis *get_field(symbol_id_t id) const
+        {
+            return fields[id];
+        }
+
+        /// @brief Get the ClassAnalysis of the class of a method
+        ClassAnalysis *get_method_class(symbol_id_t id) const
+        {
+            return classes[symbols.get_method_class(id)];
+        }
+
+        /// @brief Get a view of the xrefs of one kind from a method
+        /// @param table xref table, with nullptr the view is empty
+        /// @param method id of the method
+        /// @param kind type of reference
+        /// @param project function that gives the value of each xref
+        /// @return view with the value of each xref
+        template <typename Project>
+        static auto from(const XrefTable *table, symbol_id_t method, xref_kind_t kind, Project project)
+        {
+            auto xrefs = table ? table->get_xrefs_from(method, kind) : std::span<const xref_t>{};
+            return xrefs | std::views::transform([table, project](const xref_t &xref)
+                                                 { return project(*table, xref); });
+        }
+
+        /// @brief Get a view of the xrefs of one kind to a symbol
+        /// @param table xref table, with nullptr the view is empty
+        /// @param kind type of reference
+        /// @param id id of the symbol
+        /// @param project function that gives the value of each xref
+        /// @return view with the value of each xref
+        template <typename Project>
+        static auto to(const XrefTable *table, xref_kind_t kind, symbol_id_t id, Project project)
+        {
+            auto positions = table ? table->get_xrefs_to(kind, id) : std::span<const std::uint32_t>{};
+            return positions | std::views::transform([table, project](std::uint32_t position)
+                                                     { return project(*table, table->get_xref(position)); });
+        }
+
+        /// @brief (class, method, offset) of the method with the xref
+        static std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t> caller(const XrefTable &table, const xref_t &xref)
+        {
+            return {table.get_method_class(xref.src), table.get_method(xref.src), xref.offset};
+        }
+
+        /// @brief (class, method, offset) of the method called
+        static std::tuple<ClassAnalysis *, MethodAnalysis *, std::uint64_t> callee(const XrefTable &table, const xref_t &xref)
+        {
+            return {table.get_method_class(xref.dst), table.get_method(xref.dst), xref.offset};
+        }
+
+        /// @brief (class of the method with the xref, field, offset)
+        static std::tuple<ClassAnalysis *, FieldAnalysis *, std::uint64_t> field(const XrefTable &table, const xref_t &xref)
+        {
+            return {table.get_method_class(xref.src), table.get_field(xref.dst), xref.offset};
+        }
+
+        /// @brief (class, offset) of the class used
+        static std::pair<ClassAnalysis *, std::uint64_t> class_used(const XrefTable &table, const xref_t &xref)
+        {
+            return {table.get_class(xref.dst), xref.offset};
+        }
+
+        /// @brief (method, offset) of the method with the xref
+        static std::pair<MethodAnalysis *, std::uint64_t> user(const XrefTable &table, const xref_t &xref)
+        {
+            return {table.get_method(xref.src), xref.offset};
+        }
+    };
+} // namespace DEX
+} // namespace KUNAI
+
+#endif
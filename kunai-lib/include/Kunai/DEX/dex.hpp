@@ -15,7 +15,12 @@
 #include "Kunai/Utils/kunaistream.hpp"
 #include "Kunai/DEX/parser/parser.hpp"
 #include "Kunai/DEX/DVM/dex_disassembler.hpp"
+#include "Kunai/DEX/DVM/disassembly_writer.hpp"
 #include "Kunai/DEX/analysis/dex_analysis.hpp"
+#include "Kunai/DEX/analysis/dominators.hpp"
+#include "Kunai/DEX/analysis/dataflow.hpp"
+#include "Kunai/DEX/analysis/ssa.hpp"
+#include "Kunai/DEX/analysis/loops.hpp"
 
 #include <memory>
 
@@ -100,8 +105,8 @@ namespace DEX
         }
         
         /// @brief Get the analysis object this needs the
-        /// disassembly and the parser, the dex will be
-        /// disassembled in case this function is called
+        /// disassembly and the parser, the methods of the dex
+        /// are disassembled when their instructions are requested
         /// @param create_xrefs create all the xrefs for the
         /// class, this can take a long time
         /// @return pointer to Analysis object or nullptr
@@ -35,7 +35,7 @@ namespace DEX
         /// @brief pretty name with all the information
         std::string pretty_name;
         /// @brief parent EncodedField
-        EncodedField * encoded_field;
+        EncodedField * encoded_field = nullptr;
     public:
 
         /// @brief Constructor of the FieldID
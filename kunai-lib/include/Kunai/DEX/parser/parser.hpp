@@ -71,6 +71,12 @@ namespace DEX
         /// @brief parse the dex file and obtain the different objects
         void parse_file();
 
+        /// @brief Some names of the types, fields and methods are created
+        /// and cached the first time they are requested, create all of them
+        /// so the parser can be read by several threads (for example while
+        /// disassembling the methods in parallel)
+        void create_pretty_names();
+
         /// @brief Return a const reference from the dex header
         /// @return const dex header reference
         const Header& get_header_const() const
@@ -58,6 +58,9 @@ namespace DEX
         DVMType *return_type;
         /// @brief vector of the parameter types
         std::vector<DVMType *> parameters;
+        /// @brief full descriptor of the prototype, for example
+        /// (ILjava/lang/String;)V
+        std::string descriptor;
         /// @brief Parse the parameters for the ProtoID
         /// @param stream stream where to read the type ids
         /// @param types for obtaining the types
@@ -84,6 +87,11 @@ namespace DEX
               return_type(types->get_type_from_order(return_type_idx))
         {
             parse_parameters(stream, types, parameters_off);
+
+            descriptor = "(";
+            for (auto parameter : parameters)
+                descriptor += parameter->get_raw();
+            descriptor += ")" + return_type->get_raw();
         }
 
         /// @brief Get constant reference to shorty_idx string
@@ -100,6 +108,21 @@ namespace DEX
             return shorty_idx;
         }
 
+        /// @brief Get constant reference to the full descriptor, unlike
+        /// the shorty it is different for every prototype
+        /// @return constant reference to descriptor
+        const std::string& get_descriptor() const
+        {
+            return descriptor;
+        }
+
+        /// @brief Get a reference to the full descriptor
+        /// @return reference to descriptor
+        std::string& get_descriptor()
+        {
+            return descriptor;
+        }
+
         /// @brief Get a constant reference to the return type
         /// @return constant reference to return type
         const DVMType* get_return_type() const
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file parallel.hpp
+// @brief Small helpers for running independent tasks in a pool of threads.
+
+#ifndef KUNAI_UTILS_PARALLEL_HPP
+#define KUNAI_UTILS_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KUNAI
+{
+namespace parallel
+{
+    /// @brief Obtain the number of threads to use for a job
+    /// @param requested number of threads requested by the user,
+    /// 0 to use the number of hardware threads
+    /// @return number of threads, always 1 or more
+    inline unsigned number_of_threads(unsigned requested = 0)
+    {
+        if (requested)
+            return requested;
+
+        auto hardware = std::thread::hardware_concurrency();
+
+        return hardware ? hardware : 1;
+    }
+
+    /// @brief Run a task for every index in [0, count). The indexes are
+    /// taken in increasing order from a shared counter, so threads that
+    /// finish small tasks take more of them. The calling thread works as
+    /// one of the workers, with one thread (or one task) no thread is
+    /// created. If a task throws, no more indexes are given and the first
+    /// exception is thrown again once all the workers finished.
+    /// @param count number of tasks
+    /// @param task callable as task(index, worker), worker is a number
+    /// in [0, threads) unique for each thread, useful for per-thread data
+    /// @param threads number of threads, 0 for the hardware threads
+    template <typename Task>
+    void parallel_for(std::size_t count, Task &&task, unsigned threads = 0)
+    {
+        auto workers = static_cast<unsigned>(
+            std::min<std::size_t>(number_of_threads(threads), count));
+
+        if (workers <= 1)
+        {
+            for (std::size_t i = 0; i < count; i++)
+                task(i, 0u);
+            return;
+        }
+
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto worker = [&](unsigned id)
+        {
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed);
+                 i < count;
+                 i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                try
+                {
+                    task(i, id);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    // stop giving indexes to the workers
+                    next.store(count, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+
+        for (unsigned id = 1; id < workers; id++)
+            pool.emplace_back(worker, id);
+
+        worker(0);
+
+        for (auto &thread : pool)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+} // namespace parallel
+} // namespace KUNAI
+
+#endif // KUNAI_UTILS_PARALLEL_HPP
@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file bytecode_scan.cpp
+
+#include "Kunai/DEX/DVM/bytecode_scan.hpp"
+#include "Kunai/DEX/DVM/dvm_types.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define KUNAI_BYTECODE_SCAN_SSE2
+#endif
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    using opcodes = TYPES::opcodes;
+
+    /// @brief Classify one code unit
+    /// @param unit 16-bit code unit
+    /// @param bits output bit for each one of the classes
+    void classify(std::uint16_t unit, std::uint64_t bits[])
+    {
+        auto op = unit & 0xFF;
+
+        bits[0] = (op >= opcodes::OP_THROW && op <= opcodes::OP_GOTO_32) ||
+                  (op >= opcodes::OP_IF_EQ && op <= opcodes::OP_IF_LEZ);
+        bits[1] = op == opcodes::OP_PACKED_SWITCH || op == opcodes::OP_SPARSE_SWITCH;
+        bits[2] = op == opcodes::OP_FILL_ARRAY_DATA;
+        bits[3] = op >= opcodes::OP_RETURN_VOID && op <= opcodes::OP_RETURN_OBJECT;
+        bits[4] = unit == opcodes::OP_PACKED_SWITCH_TABLE ||
+                  unit == opcodes::OP_SPARSE_SWITCH_TABLE ||
+                  unit == opcodes::OP_FILL_ARRAY_DATA_PAYLOAD;
+    }
+
+#ifdef KUNAI_BYTECODE_SCAN_SSE2
+    /// @brief Compare each 16-bit lane with a range of values
+    /// @param value lanes to compare
+    /// @param low lower value of the range
+    /// @param high higher value of the range
+    /// @return lanes set to 0xFFFF when the value is inside of the range
+    inline __m128i in_range(__m128i value, std::uint16_t low, std::uint16_t high)
+    {
+        // (value - low) <= (high - low) as unsigned values, done with a
+        // saturated subtraction that gives 0 only for values in range
+        auto shifted = _mm_sub_epi16(value, _mm_set1_epi16(static_cast<short>(low)));
+        auto over = _mm_subs_epu16(shifted, _mm_set1_epi16(static_cast<short>(high - low)));
+        return _mm_cmpeq_epi16(over, _mm_setzero_si128());
+    }
+
+    /// @brief Obtain one bit for each one of the 8 lanes
+    /// @param lanes result of a comparison
+    /// @return 8 bits, one per lane
+    inline std::uint64_t lanes_to_bits(__m128i lanes)
+    {
+        return static_cast<std::uint64_t>(
+            _mm_movemask_epi8(_mm_packs_epi16(lanes, _mm_setzero_si128())) & 0xFF);
+    }
+#endif
+}
+
+void BytecodeScan::scan(const std::vector<std::uint8_t> &bytecode)
+{
+    units = bytecode.size() / 2;
+    words = (units + 63) / 64;
+
+    constexpr auto classes = static_cast<std::size_t>(bytecode_class_t::CLASSES_NUMBER);
+
+    masks.assign(words * classes, 0);
+
+    auto data = bytecode.data();
+    std::size_t unit = 0;
+
+#ifdef KUNAI_BYTECODE_SCAN_SSE2
+    const auto low_byte = _mm_set1_epi16(0x00FF);
+
+    // 8 code units in each iteration
+    for (; unit + 8 <= units; unit += 8)
+    {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + unit * 2));
+        auto op = _mm_and_si128(value, low_byte);
+
+        auto branch = _mm_or_si128(in_range(op, opcodes::OP_THROW, opcodes::OP_GOTO_32),
+                                   in_range(op, opcodes::OP_IF_EQ, opcodes::OP_IF_LEZ));
+        auto switches = in_range(op, opcodes::OP_PACKED_SWITCH, opcodes::OP_SPARSE_SWITCH);
+        auto fill_array = _mm_cmpeq_epi16(op, _mm_set1_epi16(opcodes::OP_FILL_ARRAY_DATA));
+        auto returns = in_range(op, opcodes::OP_RETURN_VOID, opcodes::OP_RETURN_OBJECT);
+        auto payload = in_range(value, opcodes::OP_PACKED_SWITCH_TABLE, opcodes::OP_FILL_ARRAY_DATA_PAYLOAD);
+        // only 0x0100, 0x0200 and 0x0300, the low byte must be 0
+        payload = _mm_and_si128(payload, _mm_cmpeq_epi16(op, _mm_setzero_si128()));
+
+        __m128i lanes[] = {branch, switches, fill_array, returns, payload};
+
+        auto word = unit >> 6;
+        auto shift = unit & 63;
+
+        for (std::size_t c = 0; c < classes; c++)
+            masks[c * words + word] |= lanes_to_bits(lanes[c]) << shift;
+    }
+#endif
+
+    // the rest of the units, or all of them without SSE2
+    for (; unit < units; unit++)
+    {
+        std::uint64_t bits[classes];
+
+        classify(static_cast<std::uint16_t>(data[unit * 2] | (data[unit * 2 + 1] << 8)), bits);
+
+        for (std::size_t c = 0; c < classes; c++)
+            masks[c * words + (unit >> 6)] |= bits[c] << (unit & 63);
+    }
+}
+
+bool BytecodeScan::has_candidates(bytecode_class_t type) const
+{
+    auto first = mask(type);
+
+    for (std::size_t w = 0; w < words; w++)
+        if (first[w])
+            return true;
+
+    return false;
+}
@@ -135,6 +135,141 @@ const std::vector<std::uint32_t> may_throw_opcodes =
 };
 
 
+namespace
+{
+    /// @brief Read a little endian value from the bytecode
+    /// @tparam T type of the value to read
+    /// @param bytecode buffer to read from
+    /// @param index index of the first byte
+    /// @return value read
+    template <typename T>
+    T read_value(const std::vector<uint8_t> &bytecode, std::size_t index)
+    {
+        std::make_unsigned_t<T> value = 0;
+
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            value |= static_cast<std::make_unsigned_t<T>>(bytecode[index + i]) << (i * 8);
+
+        return static_cast<T>(value);
+    }
+
+    /// @brief Check that a reference of an instruction points
+    /// to an existing item of the DEX file
+    /// @param kind kind of the reference
+    /// @param id value of the reference
+    /// @param parser parser of the DEX file
+    /// @return false if the reference is out of bound
+    bool is_valid_reference(TYPES::Kind kind, std::uint64_t id, Parser *parser)
+    {
+        switch (kind)
+        {
+        case TYPES::Kind::STRING:
+            return id < parser->get_strings().get_number_of_strings();
+        case TYPES::Kind::TYPE:
+            return id < parser->get_types().get_number_of_types();
+        case TYPES::Kind::FIELD:
+            return id < parser->get_fields().get_number_of_fields();
+        case TYPES::Kind::METH:
+        case TYPES::Kind::METH_PROTO:
+            return id < parser->get_methods().get_number_of_methods();
+        case TYPES::Kind::PROTO:
+            return id < parser->get_protos().get_number_of_protos();
+        default:
+            return true;
+        }
+    }
+
+    /// @brief Throw the error of check_instruction, if any
+    /// @param type format of the instruction
+    /// @param bytecode bytecode of the method
+    /// @param index index of the instruction
+    /// @param parser parser to check the references
+    /// @param length length of the instruction
+    void throw_if_invalid(dexinsttype_t type, const std::vector<uint8_t> &bytecode,
+                          std::size_t index, Parser *parser, std::uint32_t length)
+    {
+        if (auto error = check_instruction(type, bytecode, index, parser))
+            throw exceptions::InvalidInstructionException(error, length);
+    }
+} // namespace
+
+const char *KUNAI::DEX::check_instruction(dexinsttype_t type, const std::vector<uint8_t> &bytecode,
+                                          std::size_t index, Parser *parser)
+{
+    auto opcode = bytecode[index];
+    auto high = bytecode[index + 1];
+
+    switch (type)
+    {
+    case dexinsttype_t::DEX_INSTRUCTION10X:
+        if (high != 0)
+            return "Instruction10x high byte should be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION20T:
+        if (high != 0)
+            return "Error reading Instruction20t padding must be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION32X:
+        if (high != 0)
+            return "Error reading Instruction32x padding must be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION21T:
+        if (read_value<std::int16_t>(bytecode, index + 2) == 0)
+            return "Error reading Instruction21t offset cannot be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION22T:
+        if (read_value<std::int16_t>(bytecode, index + 2) == 0)
+            return "Error reading Instruction22t offset cannot be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION30T:
+        if (high != 0)
+            return "Error reading Instruction30t padding must be 0";
+        if (read_value<std::int32_t>(bytecode, index + 2) == 0)
+            return "Error reading Instruction30t offset cannot be 0";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION35C:
+        if ((high >> 4) > 5)
+            return "Error in array size of Instruction35c, cannot be greater than 5";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION45CC:
+        if ((high >> 4) > 5)
+            return "Error in reg_count from Instruction45cc cannot be greater than 5";
+        break;
+    default:
+        break;
+    }
+
+    if (parser == nullptr)
+        return nullptr;
+
+    // the references must point to items of the DEX file
+    switch (type)
+    {
+    case dexinsttype_t::DEX_INSTRUCTION21C:
+    case dexinsttype_t::DEX_INSTRUCTION22C:
+    case dexinsttype_t::DEX_INSTRUCTION35C:
+    case dexinsttype_t::DEX_INSTRUCTION3RC:
+        if (!is_valid_reference(DalvikOpcodes::get_instruction_type(opcode), read_value<std::uint16_t>(bytecode, index + 2), parser))
+            return "Error reference out of bound in the instruction";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION31C:
+        if (!is_valid_reference(DalvikOpcodes::get_instruction_type(opcode), read_value<std::uint32_t>(bytecode, index + 2), parser))
+            return "Error reference out of bound in the instruction";
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION45CC:
+    case dexinsttype_t::DEX_INSTRUCTION4RCC:
+        if (!is_valid_reference(TYPES::Kind::METH, read_value<std::uint16_t>(bytecode, index + 2), parser))
+            return "Error method reference out of bound";
+        if (!is_valid_reference(TYPES::Kind::PROTO, read_value<std::uint16_t>(bytecode, index + 6), parser))
+            return "Error prototype reference out of bound";
+        break;
+    default:
+        break;
+    }
+
+    return nullptr;
+}
+
 bool Instruction::has_side_effects() const
 {
     if (std::find(side_effects_opcodes.begin(), side_effects_opcodes.end(), op) != side_effects_opcodes.end())
@@ -152,8 +287,7 @@ bool Instruction::may_throw() const
 Instruction10x::Instruction10x(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION10X, 2)
 {
-    if (op_codes[1] != 0)
-        throw exceptions::InvalidInstructionException("Instruction10x high byte should be 0", 2);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION10X, bytecode, index, parser, 2);
 
     op = op_codes[0];
 }
@@ -191,8 +325,8 @@ Instruction10t::Instruction10t(std::vector<uint8_t> &bytecode, std::size_t index
 Instruction20t::Instruction20t(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION20T, 4)
 {
-    if (op_codes[1] != 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction20t padding must be 0", 4);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION20T, bytecode, index, parser, 4);
+
     op = op_codes[0];
     nAAAA = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
 }
@@ -220,8 +354,7 @@ Instruction21t::Instruction21t(std::vector<uint8_t> &bytecode, std::size_t index
     vAA = op_codes[1];
     nBBBB = *(reinterpret_cast<std::int16_t *>(&op_codes[2]));
 
-    if (nBBBB == 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction21t offset cannot be 0", 4);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION21T, bytecode, index, parser, 4);
 }
 
 Instruction21s::Instruction21s(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
@@ -257,6 +390,8 @@ Instruction21h::Instruction21h(std::vector<uint8_t> &bytecode, std::size_t index
 Instruction21c::Instruction21c(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION21C, 4), parser(parser)
 {
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION21C, bytecode, index, parser, 4);
+
     op = op_codes[0];
     vAA = op_codes[1];
     iBBBB = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
@@ -325,8 +460,7 @@ Instruction22t::Instruction22t(std::vector<uint8_t> &bytecode, std::size_t index
     vB = (op_codes[1] & 0xF0) >> 4;
     nCCCC = *(reinterpret_cast<std::int16_t *>(&op_codes[2]));
 
-    if (nCCCC == 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction22t offset cannot be 0", 4);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION22T, bytecode, index, parser, 4);
 }
 
 Instruction22s::Instruction22s(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
@@ -341,6 +475,8 @@ Instruction22s::Instruction22s(std::vector<uint8_t> &bytecode, std::size_t index
 Instruction22c::Instruction22c(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION22C, 4), parser(parser)
 {
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION22C, bytecode, index, parser, 4);
+
     op = op_codes[0];
     vA = op_codes[1] & 0x0F;
     vB = (op_codes[1] & 0xF0) >> 4;
@@ -386,21 +522,16 @@ Instruction22cs::Instruction22cs(std::vector<uint8_t> &bytecode, std::size_t ind
 Instruction30t::Instruction30t(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION30T, 6)
 {
-    if (op_codes[1] != 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction30t padding must be 0", 6);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION30T, bytecode, index, parser, 6);
 
     op = op_codes[0];
     nAAAAAAAA = *(reinterpret_cast<std::int32_t *>(&op_codes[2]));
-
-    if (nAAAAAAAA == 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction30t offset cannot be 0", 6);
 }
 
 Instruction32x::Instruction32x(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION32X, 6)
 {
-    if (op_codes[1] != 0)
-        throw exceptions::InvalidInstructionException("Error reading Instruction32x padding must be 0", 6);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION32X, bytecode, index, parser, 6);
 
     op = op_codes[0];
     vAAAA = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
@@ -439,6 +570,8 @@ Instruction31t::Instruction31t(std::vector<uint8_t> &bytecode, std::size_t index
 Instruction31c::Instruction31c(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION31C, 6)
 {
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION31C, bytecode, index, parser, 6);
+
     op = op_codes[0];
     vAA = op_codes[1];
     iBBBBBBBB = *(reinterpret_cast<std::uint32_t *>(&op_codes[2]));
@@ -462,8 +595,7 @@ Instruction35c::Instruction35c(std::vector<uint8_t> &bytecode, std::size_t index
     reg[2] = op_codes[5] & 0x0F;
     reg[3] = (op_codes[5] & 0xF0) >> 4;
 
-    if (array_size > 5)
-        throw exceptions::InvalidInstructionException("Error in array size of Instruction35c, cannot be greater than 5", 6);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION35C, bytecode, index, parser, 6);
 
     for (size_t I = 0; I < array_size; ++I)
         registers.push_back(reg[I]);
@@ -487,32 +619,28 @@ Instruction35c::Instruction35c(std::vector<uint8_t> &bytecode, std::size_t index
 Instruction3rc::Instruction3rc(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION3RC, 6), parser(parser)
 {
-    std::uint16_t vCCCC;
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION3RC, bytecode, index, parser, 6);
+
     op = op_codes[0];
     array_size = op_codes[1];
-    index = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
+    // the parameter `index` hides the member
+    this->index = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
+    /// the registers go from vCCCC, they are not stored
     vCCCC = *(reinterpret_cast<std::uint16_t *>(&op_codes[4]));
 
-    /// assign the registers starting by vCCCC
-    for (std::uint16_t I = vCCCC, E = vCCCC + array_size;
-         I < E; ++I)
-    {
-        registers.push_back(I);
-    }
-
     switch (get_kind())
     {
     case TYPES::Kind::TYPE:
         is_type = true;
-        index_str = parser->get_types().get_type_from_order(index)->pretty_print();
+        index_str = parser->get_types().get_type_from_order(this->index)->pretty_print();
         break;
     case TYPES::Kind::METH:
         is_method = true;
-        index_str = parser->get_methods().get_method(index)->pretty_method();
+        index_str = parser->get_methods().get_method(this->index)->pretty_method();
         break;
     /// other maybe needs to be managed
     default:
-        index_str = std::to_string(index);
+        index_str = std::to_string(this->index);
     }
 }
 
@@ -529,16 +657,9 @@ Instruction45cc::Instruction45cc(std::vector<uint8_t> &bytecode, std::size_t ind
     regC = op_codes[4] & 0x0F;
     regF = (op_codes[5] & 0xF0) >> 4;
     regE = op_codes[5] & 0x0F;
-    prototype_reference = *(reinterpret_cast<std::uint16_t *>(&op_codes[8]));
-
-    if (reg_count > 5)
-        throw exceptions::InvalidInstructionException("Error in reg_count from Instruction45cc cannot be greater than 5", 8);
-
-    if (method_reference >= parser->get_methods().get_number_of_methods())
-        throw exceptions::InvalidInstructionException("Error method reference out of bound in Instruction45cc", 8);
+    prototype_reference = *(reinterpret_cast<std::uint16_t *>(&op_codes[6]));
 
-    if (prototype_reference >= parser->get_protos().get_number_of_protos())
-        throw exceptions::InvalidInstructionException("Error prototype reference out of bound in Instruction45cc", 8);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION45CC, bytecode, index, parser, 8);
 
     if (reg_count > 0)
         registers.push_back(regC);
@@ -558,22 +679,13 @@ Instruction45cc::Instruction45cc(std::vector<uint8_t> &bytecode, std::size_t ind
 Instruction4rcc::Instruction4rcc(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
     : Instruction(bytecode, index, dexinsttype_t::DEX_INSTRUCTION4RCC, 8)
 {
-    std::uint16_t vCCCC;
-
     op = op_codes[0];
     reg_count = op_codes[1];
     method_reference = *(reinterpret_cast<std::uint16_t *>(&op_codes[2]));
     vCCCC = *(reinterpret_cast<std::uint16_t *>(&op_codes[4]));
     prototype_reference = *(reinterpret_cast<std::uint16_t *>(&op_codes[6]));
 
-    if (method_reference >= parser->get_methods().get_number_of_methods())
-        throw exceptions::InvalidInstructionException("Error method reference out of bound in Instruction4rcc", 8);
-
-    if (prototype_reference >= parser->get_protos().get_number_of_protos())
-        throw exceptions::InvalidInstructionException("Error prototype reference out of bound in Instruction4rcc", 8);
-
-    for (std::uint16_t I = vCCCC, E = vCCCC + reg_count; I < E; ++I)
-        registers.push_back(I);
+    throw_if_invalid(dexinsttype_t::DEX_INSTRUCTION4RCC, bytecode, index, parser, 8);
 
     method_id = parser->get_methods().get_method(method_reference);
     prototype_id = parser->get_protos().get_proto_by_order(prototype_reference);
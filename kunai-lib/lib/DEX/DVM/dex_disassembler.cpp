@@ -30,58 +30,97 @@ void DexDisassembler::disassembly_dex()
         auto &methods = class_data_item.get_methods();
 
         for (auto method : methods)
-        {
-            auto &code_item_struct = method->get_code_item();
-
-            auto &buffer_instructions = code_item_struct.get_bytecode();
-
-            std::vector<std::unique_ptr<Instruction>> instructions;
-
-            try
-            {
-                if (algorithm == disassembly_algorithm::LINEAR_SWEEP_ALGORITHM)
-                    linear_sweep.disassembly(buffer_instructions, instructions);
-                else if (algorithm == disassembly_algorithm::RECURSIVE_TRAVERSAL_ALGORITHM)
-                    recursive_traversal.disassembly(buffer_instructions, method, instructions);
-
-                dex_instructions[method] = std::move(instructions);
-            }
-            catch (const std::exception &e)
-            {
-                disassembly_correct = false;
-                instructions.clear();
-                dex_instructions[method] = std::move(instructions);
-            }
-        }
+            disassemble_method(method);
     }
 
     logger->debug("disassembly_dex: finished disassembly of dex file");
 }
 
-std::vector<std::unique_ptr<Instruction>>
-DexDisassembler::disassembly_buffer(std::vector<std::uint8_t> &buffer)
+std::vector<Instruction *> &
+DexDisassembler::disassemble_method(EncodedMethod *method)
 {
-    std::vector<std::unique_ptr<Instruction>> instructions;
+    // the method was already disassembled, return
+    // the instructions from the cache
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
 
-    // since we don't know about the method, we use a simple
-    // linear sweep disassembly
-    linear_sweep.disassembly(buffer, instructions);
+        auto it = dex_instructions.find(method);
 
-    return instructions;
-}
+        if (it != dex_instructions.end())
+            return it->second;
+    }
+
+    auto &buffer_instructions = method->get_code_item().get_bytecode();
+
+    std::vector<Instruction *> instructions;
+
+    // the first chunk of the arena is big enough for the
+    // usual size of the instructions of the method
+    InstructionArena arena(buffer_instructions.size() * 16);
+
+    try
+    {
+        if (algorithm == disassembly_algorithm::LINEAR_SWEEP_ALGORITHM)
+            linear_sweep.disassembly(buffer_instructions, instructions, arena);
+        else if (algorithm == disassembly_algorithm::RECURSIVE_TRAVERSAL_ALGORITHM)
+            recursive_traversal.disassembly(buffer_instructions, get_exception_table(method), instructions, arena);
+    }
+    catch (const std::exception &e)
+    {
+        auto logger = LOGGER::logger();
+
+        logger->error("disassemble_method: error disassembling method {}: {}",
+                      method->getMethodID()->pretty_method(), e.what());
+
+        disassembly_correct = false;
+        instructions.clear();
+        arena.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
 
+    // the nodes of the maps do not move, so the references given
+    // to other threads stay valid while new methods are stored
+    auto stored = dex_instructions.try_emplace(method, std::move(instructions));
 
-void DexDisassembler::add_disassembly(DexDisassembler& other)
+    if (stored.second)
+        method_arenas.try_emplace(method, std::move(arena));
+
+    return stored.first->second;
+}
+
+const ExceptionTable &DexDisassembler::get_exception_table(EncodedMethod *method)
 {
-    for (auto & methods_instrs : other.dex_instructions)
     {
-        dex_instructions[methods_instrs.first] = std::move(methods_instrs.second);
+        std::lock_guard<std::mutex> lock(cache_mutex);
+
+        auto it = exception_tables.find(method);
+
+        if (it != exception_tables.end())
+            return it->second;
     }
+
+    ExceptionTable table(method);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    return exception_tables.try_emplace(method, std::move(table)).first->second;
 }
 
+std::vector<Instruction *>
+DexDisassembler::disassembly_buffer(std::vector<std::uint8_t> &buffer)
+{
+    return disassembly_buffer(buffer, buffer_arena);
+}
 
-DexDisassembler& DexDisassembler::operator+=(DexDisassembler& other)
+std::vector<Instruction *>
+DexDisassembler::disassembly_buffer(std::vector<std::uint8_t> &buffer, InstructionArena &arena)
 {
-    this->add_disassembly(other);
-    return *this;
-}
\ No newline at end of file
+    std::vector<Instruction *> instructions;
+
+    // since we don't know about the method, we use a simple
+    // linear sweep disassembly
+    linear_sweep.disassembly(buffer, instructions, arena);
+
+    return instructions;
+}
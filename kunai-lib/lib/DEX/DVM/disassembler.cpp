@@ -9,8 +9,12 @@
 #include "Kunai/DEX/DVM/dvm_types.hpp"
 #include "Kunai/Utils/logger.hpp"
 #include "Kunai/Exceptions/disassembler_exception.hpp"
+#include "Kunai/DEX/parser/parser.hpp"
 #include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
+#include "Kunai/DEX/DVM/exception_table.hpp"
 
+#include <array>
+#include <type_traits>
 #include <unordered_map>
 
 using namespace KUNAI::DEX;
@@ -19,7 +23,7 @@ namespace
 {
     /// @brief definition of a generator function for
     /// generating the different instructions
-    typedef std::unique_ptr<Instruction> (*generator_func)(std::vector<uint8_t> &, std::size_t, Parser *);
+    typedef Instruction *(*generator_func)(std::vector<uint8_t> &, std::size_t, Parser *, InstructionArena &);
 
     /// @brief Template that will generate all the instructions
     /// getter user in the disassembler
@@ -27,350 +31,593 @@ namespace
     /// @param bytecode bytecode to parse in the instruction
     /// @param index index in the bytecode
     /// @param parser parser for some of the instructions
-    /// @return unique pointer with a new instruction
+    /// @param arena arena where the instruction is created
+    /// @return pointer to the new instruction, owned by the arena
     template <class T>
-    std::unique_ptr<Instruction>
-    get_instruction(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
+    Instruction *
+    get_instruction(std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser, InstructionArena &arena)
     {
-        return std::make_unique<T>(bytecode, index, parser);
+        return arena.make<T>(bytecode, index, parser);
+    }
+
+    /// @brief Generator of an instruction together with
+    /// the format of the instruction
+    struct generator_t
+    {
+        /// @brief function that creates the instruction
+        generator_func generator = nullptr;
+        /// @brief format of the instruction
+        dexinsttype_t type = dexinsttype_t::DEX_NONE_OP;
+        /// @brief size in bytes of the format, Instruction00x does
+        /// not have a size but it is skipped as one code unit
+        std::uint32_t size = 0;
+    };
+
+    /// @brief Format of each one of the instruction classes, the first
+    /// digit in the name of the format is the number of code units
+    template <class T>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of{dexinsttype_t::DEX_NONE_OP, 0};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction00x>{dexinsttype_t::DEX_INSTRUCTION00X, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction10x>{dexinsttype_t::DEX_INSTRUCTION10X, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction12x>{dexinsttype_t::DEX_INSTRUCTION12X, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction11n>{dexinsttype_t::DEX_INSTRUCTION11N, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction11x>{dexinsttype_t::DEX_INSTRUCTION11X, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction10t>{dexinsttype_t::DEX_INSTRUCTION10T, 2};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction20t>{dexinsttype_t::DEX_INSTRUCTION20T, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction22x>{dexinsttype_t::DEX_INSTRUCTION22X, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction21t>{dexinsttype_t::DEX_INSTRUCTION21T, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction21s>{dexinsttype_t::DEX_INSTRUCTION21S, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction21h>{dexinsttype_t::DEX_INSTRUCTION21H, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction21c>{dexinsttype_t::DEX_INSTRUCTION21C, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction23x>{dexinsttype_t::DEX_INSTRUCTION23X, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction22b>{dexinsttype_t::DEX_INSTRUCTION22B, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction22t>{dexinsttype_t::DEX_INSTRUCTION22T, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction22s>{dexinsttype_t::DEX_INSTRUCTION22S, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction22c>{dexinsttype_t::DEX_INSTRUCTION22C, 4};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction30t>{dexinsttype_t::DEX_INSTRUCTION30T, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction32x>{dexinsttype_t::DEX_INSTRUCTION32X, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction31i>{dexinsttype_t::DEX_INSTRUCTION31I, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction31t>{dexinsttype_t::DEX_INSTRUCTION31T, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction31c>{dexinsttype_t::DEX_INSTRUCTION31C, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction35c>{dexinsttype_t::DEX_INSTRUCTION35C, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction3rc>{dexinsttype_t::DEX_INSTRUCTION3RC, 6};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction45cc>{dexinsttype_t::DEX_INSTRUCTION45CC, 8};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction4rcc>{dexinsttype_t::DEX_INSTRUCTION4RCC, 8};
+    template <>
+    constexpr std::pair<dexinsttype_t, std::uint32_t> format_of<Instruction51l>{dexinsttype_t::DEX_INSTRUCTION51L, 10};
+
+    /// @brief Create the entry of the table for an instruction class
+    /// @tparam T Instruction to generate with the entry
+    /// @return generator and format of the instruction
+    template <class T>
+    constexpr generator_t generator()
+    {
+        return {&get_instruction<T>, format_of<T>.first, format_of<T>.second};
     }
 
     /// @brief table of opcodes and generator pointers
     /// generators are generated for each instruction
-    std::unordered_map<TYPES::opcodes, generator_func> function_pointers = {
+    std::unordered_map<TYPES::opcodes, generator_t> function_pointers = {
         // Instruction00x
-        {TYPES::opcodes::OP_IGET_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IPUT_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_SGET_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_SPUT_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IGET_OBJECT_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IGET_WIDE_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IPUT_WIDE_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_SGET_WIDE_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_SPUT_WIDE_VOLATILE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_BREAKPOINT, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_THROW_VERIFICATION_ERROR, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_EXECUTE_INLINE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_EXECUTE_INLINE_RANGE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_INVOKE_OBJECT_INIT_RANGE, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_RETURN_VOID_BARRIER, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IGET_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IGET_WIDE_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IGET_OBJECT_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IPUT_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IPUT_WIDE_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_IPUT_OBJECT_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_INVOKE_VIRTUAL_QUICK, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_INVOKE_VIRTUAL_QUICK_RANGE, &get_instruction<Instruction00x>},
+        {TYPES::opcodes::OP_IGET_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IPUT_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_SGET_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_SPUT_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IGET_OBJECT_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IGET_WIDE_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IPUT_WIDE_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_SGET_WIDE_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_SPUT_WIDE_VOLATILE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_BREAKPOINT, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_THROW_VERIFICATION_ERROR, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_EXECUTE_INLINE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_EXECUTE_INLINE_RANGE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_INVOKE_OBJECT_INIT_RANGE, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_RETURN_VOID_BARRIER, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IGET_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IGET_WIDE_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IGET_OBJECT_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IPUT_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IPUT_WIDE_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_IPUT_OBJECT_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_INVOKE_VIRTUAL_QUICK, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_INVOKE_VIRTUAL_QUICK_RANGE, generator<Instruction00x>()},
         // Instruction12x
-        {TYPES::opcodes::OP_MOVE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MOVE_WIDE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MOVE_OBJECT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_ARRAY_LENGTH, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NEG_INT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NOT_INT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NEG_LONG, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NOT_LONG, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NEG_FLOAT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_NEG_DOUBLE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_LONG, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_FLOAT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_DOUBLE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_LONG_TO_INT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_LONG_TO_FLOAT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_LONG_TO_DOUBLE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_FLOAT_TO_INT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_FLOAT_TO_LONG, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_FLOAT_TO_DOUBLE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DOUBLE_TO_INT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DOUBLE_TO_LONG, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DOUBLE_TO_FLOAT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_BYTE, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_CHAR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_INT_TO_SHORT, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_ADD_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SUB_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MUL_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DIV_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_REM_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_AND_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_OR_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_XOR_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SHL_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SHR_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_USHR_INT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_ADD_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SUB_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MUL_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DIV_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_REM_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_AND_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_OR_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_XOR_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SHL_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SHR_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_USHR_LONG_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_ADD_FLOAT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SUB_FLOAT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MUL_FLOAT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DIV_FLOAT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_REM_FLOAT_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_ADD_DOUBLE_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_SUB_DOUBLE_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_MUL_DOUBLE_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_DIV_DOUBLE_2ADDR, &get_instruction<Instruction12x>},
-        {TYPES::opcodes::OP_REM_DOUBLE_2ADDR, &get_instruction<Instruction12x>},
+        {TYPES::opcodes::OP_MOVE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MOVE_WIDE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MOVE_OBJECT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_ARRAY_LENGTH, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NEG_INT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NOT_INT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NEG_LONG, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NOT_LONG, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NEG_FLOAT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_NEG_DOUBLE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_LONG, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_FLOAT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_DOUBLE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_LONG_TO_INT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_LONG_TO_FLOAT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_LONG_TO_DOUBLE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_FLOAT_TO_INT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_FLOAT_TO_LONG, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_FLOAT_TO_DOUBLE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DOUBLE_TO_INT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DOUBLE_TO_LONG, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DOUBLE_TO_FLOAT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_BYTE, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_CHAR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_INT_TO_SHORT, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_ADD_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SUB_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MUL_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DIV_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_REM_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_AND_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_OR_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_XOR_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SHL_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SHR_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_USHR_INT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_ADD_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SUB_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MUL_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DIV_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_REM_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_AND_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_OR_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_XOR_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SHL_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SHR_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_USHR_LONG_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_ADD_FLOAT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SUB_FLOAT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MUL_FLOAT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DIV_FLOAT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_REM_FLOAT_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_ADD_DOUBLE_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_SUB_DOUBLE_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_MUL_DOUBLE_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_DIV_DOUBLE_2ADDR, generator<Instruction12x>()},
+        {TYPES::opcodes::OP_REM_DOUBLE_2ADDR, generator<Instruction12x>()},
         // Instruction22x
-        {TYPES::opcodes::OP_MOVE_FROM16, &get_instruction<Instruction22x>},
-        {TYPES::opcodes::OP_MOVE_WIDE_FROM16, &get_instruction<Instruction22x>},
-        {TYPES::opcodes::OP_MOVE_OBJECT_FROM16, &get_instruction<Instruction22x>},
+        {TYPES::opcodes::OP_MOVE_FROM16, generator<Instruction22x>()},
+        {TYPES::opcodes::OP_MOVE_WIDE_FROM16, generator<Instruction22x>()},
+        {TYPES::opcodes::OP_MOVE_OBJECT_FROM16, generator<Instruction22x>()},
         // Instruction32x
-        {TYPES::opcodes::OP_MOVE_16, &get_instruction<Instruction32x>},
-        {TYPES::opcodes::OP_MOVE_WIDE_16, &get_instruction<Instruction32x>},
-        {TYPES::opcodes::OP_MOVE_OBJECT_16, &get_instruction<Instruction32x>},
+        {TYPES::opcodes::OP_MOVE_16, generator<Instruction32x>()},
+        {TYPES::opcodes::OP_MOVE_WIDE_16, generator<Instruction32x>()},
+        {TYPES::opcodes::OP_MOVE_OBJECT_16, generator<Instruction32x>()},
         // Instruction11x
-        {TYPES::opcodes::OP_MOVE_RESULT, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_MOVE_RESULT_WIDE, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_MOVE_RESULT_OBJECT, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_MOVE_EXCEPTION, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_RETURN, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_RETURN_WIDE, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_RETURN_OBJECT, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_MONITOR_ENTER, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_MONITOR_EXIT, &get_instruction<Instruction11x>},
-        {TYPES::opcodes::OP_THROW, &get_instruction<Instruction11x>},
+        {TYPES::opcodes::OP_MOVE_RESULT, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_MOVE_RESULT_WIDE, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_MOVE_RESULT_OBJECT, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_MOVE_EXCEPTION, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_RETURN, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_RETURN_WIDE, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_RETURN_OBJECT, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_MONITOR_ENTER, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_MONITOR_EXIT, generator<Instruction11x>()},
+        {TYPES::opcodes::OP_THROW, generator<Instruction11x>()},
         // Instruction10x
-        {TYPES::opcodes::OP_RETURN_VOID, &get_instruction<Instruction10x>},
-        {TYPES::opcodes::OP_NOP, &get_instruction<Instruction10x>},
+        {TYPES::opcodes::OP_RETURN_VOID, generator<Instruction10x>()},
+        {TYPES::opcodes::OP_NOP, generator<Instruction10x>()},
         // Instruction11n
-        {TYPES::opcodes::OP_CONST_4, &get_instruction<Instruction11n>},
+        {TYPES::opcodes::OP_CONST_4, generator<Instruction11n>()},
         // Instruction21s
-        {TYPES::opcodes::OP_CONST_16, &get_instruction<Instruction21s>},
-        {TYPES::opcodes::OP_CONST_WIDE_16, &get_instruction<Instruction21s>},
+        {TYPES::opcodes::OP_CONST_16, generator<Instruction21s>()},
+        {TYPES::opcodes::OP_CONST_WIDE_16, generator<Instruction21s>()},
         // Instruction31i
-        {TYPES::opcodes::OP_CONST, &get_instruction<Instruction31i>},
-        {TYPES::opcodes::OP_CONST_WIDE_32, &get_instruction<Instruction31i>},
+        {TYPES::opcodes::OP_CONST, generator<Instruction31i>()},
+        {TYPES::opcodes::OP_CONST_WIDE_32, generator<Instruction31i>()},
         // Instruction21h
-        {TYPES::opcodes::OP_CONST_HIGH16, &get_instruction<Instruction21h>},
-        {TYPES::opcodes::OP_CONST_WIDE_HIGH16, &get_instruction<Instruction21h>},
+        {TYPES::opcodes::OP_CONST_HIGH16, generator<Instruction21h>()},
+        {TYPES::opcodes::OP_CONST_WIDE_HIGH16, generator<Instruction21h>()},
         // Instruction51l
-        {TYPES::opcodes::OP_CONST_WIDE, &get_instruction<Instruction51l>},
+        {TYPES::opcodes::OP_CONST_WIDE, generator<Instruction51l>()},
         // Instruction21c
-        {TYPES::opcodes::OP_CONST_STRING, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_CONST_CLASS, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_CHECK_CAST, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_NEW_INSTANCE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_WIDE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_OBJECT, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_BOOLEAN, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_BYTE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_CHAR, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SGET_SHORT, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_WIDE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_OBJECT, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_BOOLEAN, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_BYTE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_CHAR, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_SHORT, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_SPUT_OBJECT_VOLATILE, &get_instruction<Instruction21c>},
-        {TYPES::opcodes::OP_CONST_METHOD_TYPE, &get_instruction<Instruction21c>},
+        {TYPES::opcodes::OP_CONST_STRING, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_CONST_CLASS, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_CHECK_CAST, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_NEW_INSTANCE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_WIDE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_OBJECT, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_BOOLEAN, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_BYTE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_CHAR, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SGET_SHORT, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_WIDE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_OBJECT, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_BOOLEAN, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_BYTE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_CHAR, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_SHORT, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_SPUT_OBJECT_VOLATILE, generator<Instruction21c>()},
+        {TYPES::opcodes::OP_CONST_METHOD_TYPE, generator<Instruction21c>()},
         // Instruction31c
-        {TYPES::opcodes::OP_CONST_STRING_JUMBO, &get_instruction<Instruction31c>},
+        {TYPES::opcodes::OP_CONST_STRING_JUMBO, generator<Instruction31c>()},
         // Instruction22c
-        {TYPES::opcodes::OP_INSTANCE_OF, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_NEW_ARRAY, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_WIDE, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_OBJECT, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_BOOLEAN, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_BYTE, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_CHAR, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IGET_SHORT, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_WIDE, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_OBJECT, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_BOOLEAN, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_BYTE, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_CHAR, &get_instruction<Instruction22c>},
-        {TYPES::opcodes::OP_IPUT_SHORT, &get_instruction<Instruction22c>},
+        {TYPES::opcodes::OP_INSTANCE_OF, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_NEW_ARRAY, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_WIDE, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_OBJECT, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_BOOLEAN, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_BYTE, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_CHAR, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IGET_SHORT, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_WIDE, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_OBJECT, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_BOOLEAN, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_BYTE, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_CHAR, generator<Instruction22c>()},
+        {TYPES::opcodes::OP_IPUT_SHORT, generator<Instruction22c>()},
         // Instruction35c
-        {TYPES::opcodes::OP_FILLED_NEW_ARRAY, &get_instruction<Instruction35c>},
-        {TYPES::opcodes::OP_INVOKE_VIRTUAL, &get_instruction<Instruction35c>},
-        {TYPES::opcodes::OP_INVOKE_SUPER, &get_instruction<Instruction35c>},
-        {TYPES::opcodes::OP_INVOKE_DIRECT, &get_instruction<Instruction35c>},
-        {TYPES::opcodes::OP_INVOKE_STATIC, &get_instruction<Instruction35c>},
-        {TYPES::opcodes::OP_INVOKE_INTERFACE, &get_instruction<Instruction35c>},
+        {TYPES::opcodes::OP_FILLED_NEW_ARRAY, generator<Instruction35c>()},
+        {TYPES::opcodes::OP_INVOKE_VIRTUAL, generator<Instruction35c>()},
+        {TYPES::opcodes::OP_INVOKE_SUPER, generator<Instruction35c>()},
+        {TYPES::opcodes::OP_INVOKE_DIRECT, generator<Instruction35c>()},
+        {TYPES::opcodes::OP_INVOKE_STATIC, generator<Instruction35c>()},
+        {TYPES::opcodes::OP_INVOKE_INTERFACE, generator<Instruction35c>()},
         // Instruction3rc
-        {TYPES::opcodes::OP_FILLED_NEW_ARRAY_RANGE, &get_instruction<Instruction3rc>},
-        {TYPES::opcodes::OP_INVOKE_VIRTUAL_RANGE, &get_instruction<Instruction3rc>},
-        {TYPES::opcodes::OP_INVOKE_SUPER_RANGE, &get_instruction<Instruction3rc>},
-        {TYPES::opcodes::OP_INVOKE_DIRECT_RANGE, &get_instruction<Instruction3rc>},
-        {TYPES::opcodes::OP_INVOKE_STATIC_RANGE, &get_instruction<Instruction3rc>},
-        {TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE, &get_instruction<Instruction3rc>},
+        {TYPES::opcodes::OP_FILLED_NEW_ARRAY_RANGE, generator<Instruction3rc>()},
+        {TYPES::opcodes::OP_INVOKE_VIRTUAL_RANGE, generator<Instruction3rc>()},
+        {TYPES::opcodes::OP_INVOKE_SUPER_RANGE, generator<Instruction3rc>()},
+        {TYPES::opcodes::OP_INVOKE_DIRECT_RANGE, generator<Instruction3rc>()},
+        {TYPES::opcodes::OP_INVOKE_STATIC_RANGE, generator<Instruction3rc>()},
+        {TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE, generator<Instruction3rc>()},
         // Instruction31t
-        {TYPES::opcodes::OP_FILL_ARRAY_DATA, &get_instruction<Instruction31t>},
-        {TYPES::opcodes::OP_PACKED_SWITCH, &get_instruction<Instruction31t>},
-        {TYPES::opcodes::OP_SPARSE_SWITCH, &get_instruction<Instruction31t>},
+        {TYPES::opcodes::OP_FILL_ARRAY_DATA, generator<Instruction31t>()},
+        {TYPES::opcodes::OP_PACKED_SWITCH, generator<Instruction31t>()},
+        {TYPES::opcodes::OP_SPARSE_SWITCH, generator<Instruction31t>()},
         // Instruction10t
-        {TYPES::opcodes::OP_GOTO, &get_instruction<Instruction10t>},
+        {TYPES::opcodes::OP_GOTO, generator<Instruction10t>()},
         // Instruction20t
-        {TYPES::opcodes::OP_GOTO_16, &get_instruction<Instruction20t>},
+        {TYPES::opcodes::OP_GOTO_16, generator<Instruction20t>()},
         // Instruction30t
-        {TYPES::opcodes::OP_GOTO_32, &get_instruction<Instruction30t>},
+        {TYPES::opcodes::OP_GOTO_32, generator<Instruction30t>()},
         // Instruction23x
-        {TYPES::opcodes::OP_CMPL_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_CMPG_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_CMPL_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_CMPG_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_CMP_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_ADD_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SUB_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_MUL_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_DIV_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_REM_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AND_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_OR_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_XOR_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SHL_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SHR_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_USHR_INT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_ADD_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SUB_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_MUL_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_DIV_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_REM_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AND_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_OR_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_XOR_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SHL_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SHR_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_USHR_LONG, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_ADD_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SUB_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_MUL_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_DIV_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_REM_FLOAT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_ADD_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_SUB_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_MUL_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_DIV_DOUBLE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_REM_DOUBLE, &get_instruction<Instruction23x>},
+        {TYPES::opcodes::OP_CMPL_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_CMPG_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_CMPL_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_CMPG_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_CMP_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_ADD_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SUB_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_MUL_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_DIV_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_REM_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AND_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_OR_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_XOR_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SHL_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SHR_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_USHR_INT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_ADD_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SUB_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_MUL_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_DIV_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_REM_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AND_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_OR_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_XOR_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SHL_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SHR_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_USHR_LONG, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_ADD_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SUB_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_MUL_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_DIV_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_REM_FLOAT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_ADD_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_SUB_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_MUL_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_DIV_DOUBLE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_REM_DOUBLE, generator<Instruction23x>()},
         // Instruction22t
-        {TYPES::opcodes::OP_IF_EQ, &get_instruction<Instruction22t>},
-        {TYPES::opcodes::OP_IF_NE, &get_instruction<Instruction22t>},
-        {TYPES::opcodes::OP_IF_LT, &get_instruction<Instruction22t>},
-        {TYPES::opcodes::OP_IF_GE, &get_instruction<Instruction22t>},
-        {TYPES::opcodes::OP_IF_GT, &get_instruction<Instruction22t>},
-        {TYPES::opcodes::OP_IF_LE, &get_instruction<Instruction22t>},
+        {TYPES::opcodes::OP_IF_EQ, generator<Instruction22t>()},
+        {TYPES::opcodes::OP_IF_NE, generator<Instruction22t>()},
+        {TYPES::opcodes::OP_IF_LT, generator<Instruction22t>()},
+        {TYPES::opcodes::OP_IF_GE, generator<Instruction22t>()},
+        {TYPES::opcodes::OP_IF_GT, generator<Instruction22t>()},
+        {TYPES::opcodes::OP_IF_LE, generator<Instruction22t>()},
         // Instruction21t
-        {TYPES::opcodes::OP_IF_EQZ, &get_instruction<Instruction21t>},
-        {TYPES::opcodes::OP_IF_NEZ, &get_instruction<Instruction21t>},
-        {TYPES::opcodes::OP_IF_LTZ, &get_instruction<Instruction21t>},
-        {TYPES::opcodes::OP_IF_GEZ, &get_instruction<Instruction21t>},
-        {TYPES::opcodes::OP_IF_GTZ, &get_instruction<Instruction21t>},
-        {TYPES::opcodes::OP_IF_LEZ, &get_instruction<Instruction21t>},
+        {TYPES::opcodes::OP_IF_EQZ, generator<Instruction21t>()},
+        {TYPES::opcodes::OP_IF_NEZ, generator<Instruction21t>()},
+        {TYPES::opcodes::OP_IF_LTZ, generator<Instruction21t>()},
+        {TYPES::opcodes::OP_IF_GEZ, generator<Instruction21t>()},
+        {TYPES::opcodes::OP_IF_GTZ, generator<Instruction21t>()},
+        {TYPES::opcodes::OP_IF_LEZ, generator<Instruction21t>()},
         // Instruction00x
-        {TYPES::opcodes::OP_UNUSED_3E, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_3F, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_40, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_41, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_42, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_43, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_73, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_79, &get_instruction<Instruction00x>},
-        {TYPES::opcodes::OP_UNUSED_7A, &get_instruction<Instruction00x>},
+        {TYPES::opcodes::OP_UNUSED_3E, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_3F, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_40, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_41, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_42, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_43, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_73, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_79, generator<Instruction00x>()},
+        {TYPES::opcodes::OP_UNUSED_7A, generator<Instruction00x>()},
         // Instruction23x
-        {TYPES::opcodes::OP_AGET, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_WIDE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_OBJECT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_BOOLEAN, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_BYTE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_CHAR, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_AGET_SHORT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_WIDE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_OBJECT, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_BOOLEAN, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_BYTE, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_CHAR, &get_instruction<Instruction23x>},
-        {TYPES::opcodes::OP_APUT_SHORT, &get_instruction<Instruction23x>},
+        {TYPES::opcodes::OP_AGET, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_WIDE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_OBJECT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_BOOLEAN, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_BYTE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_CHAR, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_AGET_SHORT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_WIDE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_OBJECT, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_BOOLEAN, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_BYTE, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_CHAR, generator<Instruction23x>()},
+        {TYPES::opcodes::OP_APUT_SHORT, generator<Instruction23x>()},
         // Instruction22s
-        {TYPES::opcodes::OP_ADD_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_SUB_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_MUL_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_DIV_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_REM_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_AND_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_OR_INT_LIT16, &get_instruction<Instruction22s>},
-        {TYPES::opcodes::OP_XOR_INT_LIT16, &get_instruction<Instruction22s>},
+        {TYPES::opcodes::OP_ADD_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_SUB_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_MUL_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_DIV_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_REM_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_AND_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_OR_INT_LIT16, generator<Instruction22s>()},
+        {TYPES::opcodes::OP_XOR_INT_LIT16, generator<Instruction22s>()},
         // Instruction22b
-        {TYPES::opcodes::OP_ADD_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_SUB_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_MUL_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_DIV_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_REM_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_AND_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_OR_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_XOR_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_SHL_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_SHR_INT_LIT8, &get_instruction<Instruction22b>},
-        {TYPES::opcodes::OP_USHR_INT_LIT8, &get_instruction<Instruction22b>},
+        {TYPES::opcodes::OP_ADD_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_SUB_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_MUL_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_DIV_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_REM_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_AND_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_OR_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_XOR_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_SHL_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_SHR_INT_LIT8, generator<Instruction22b>()},
+        {TYPES::opcodes::OP_USHR_INT_LIT8, generator<Instruction22b>()},
         // Instruction45cc
-        {TYPES::opcodes::OP_INVOKE_SUPER_QUICK, &get_instruction<Instruction45cc>},
+        {TYPES::opcodes::OP_INVOKE_SUPER_QUICK, generator<Instruction45cc>()},
         // Instruction4rcc
-        {TYPES::opcodes::OP_INVOKE_SUPER_QUICK_RANGE, &get_instruction<Instruction4rcc>},
+        {TYPES::opcodes::OP_INVOKE_SUPER_QUICK_RANGE, generator<Instruction4rcc>()},
         // Instruction35c
-        {TYPES::opcodes::OP_IPUT_OBJECT_VOLATILE, &get_instruction<Instruction35c>},
+        {TYPES::opcodes::OP_IPUT_OBJECT_VOLATILE, generator<Instruction35c>()},
         // Instruction3rc
-        {TYPES::opcodes::OP_SGET_OBJECT_VOLATILE, &get_instruction<Instruction3rc>},
+        {TYPES::opcodes::OP_SGET_OBJECT_VOLATILE, generator<Instruction3rc>()},
         // Instruction21c
 
     };
 
+    /// @brief the same table indexed directly by the opcode, so the
+    /// lookup of an instruction does not need to hash the opcode
+    const std::array<generator_t, 256> generators = []
+    {
+        std::array<generator_t, 256> table{};
+
+        for (const auto &[opcode, gen] : function_pointers)
+            if (static_cast<std::uint32_t>(opcode) < table.size())
+                table[opcode] = gen;
+
+        return table;
+    }();
+
+    /// @brief Read a little endian value from the bytecode
+    /// @tparam T type of the value to read
+    /// @param bytecode buffer to read from
+    /// @param index index of the first byte
+    /// @return value read
+    template <typename T>
+    T read_value(const std::vector<uint8_t> &bytecode, std::size_t index)
+    {
+        std::make_unsigned_t<T> value = 0;
+
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            value |= static_cast<std::make_unsigned_t<T>>(bytecode[index + i]) << (i * 8);
+
+        return static_cast<T>(value);
+    }
+
+    /// @brief Get the size of a payload from its header
+    /// @param bytecode buffer with the payload
+    /// @param index index of the payload
+    /// @param ident second byte of the payload, its kind
+    /// @return size in bytes of the payload, if the header does not
+    /// fit in the buffer the size of the header is returned
+    std::uint64_t get_payload_size(const std::vector<uint8_t> &bytecode, std::size_t index, std::uint8_t ident)
+    {
+        // header: ident(2) + size(2) + first_key(4) for the packed-switch,
+        // ident(2) + size(2) for the sparse-switch, and ident(2) +
+        // element_width(2) + size(4) for the fill-array-data
+        std::uint64_t header = ident == 0x02 ? 4 : 8;
+
+        if (index + header > bytecode.size())
+            return header;
+
+        switch (ident)
+        {
+        case 0x01:
+            return header + read_value<std::uint16_t>(bytecode, index + 2) * 4ULL;
+        case 0x02:
+            return header + read_value<std::uint16_t>(bytecode, index + 2) * 8ULL;
+        default:
+        {
+            auto data = static_cast<std::uint64_t>(read_value<std::uint16_t>(bytecode, index + 2)) *
+                        read_value<std::uint32_t>(bytecode, index + 4);
+            return header + data + (data & 1);
+        }
+        }
+    }
 } // namespace
 
-std::unique_ptr<Instruction> Disassembler::disassemble_instruction(
+Instruction *Disassembler::disassemble_instruction(
+    std::uint32_t opcode,
+    std::vector<uint8_t> &bytecode,
+    std::size_t index,
+    InstructionArena &arena)
+{
+    auto instr = disassemble_instruction(opcode, bytecode, index, parser, arena);
+
+    if (instr)
+        last_instr = instr;
+
+    return instr;
+}
+
+Instruction *Disassembler::disassemble_instruction(
     std::uint32_t opcode,
     std::vector<uint8_t> &bytecode,
-    std::size_t index)
+    std::size_t index,
+    Parser *parser,
+    InstructionArena &arena)
 {
-    auto logger = LOGGER::logger();
-    std::unique_ptr<Instruction> instr = nullptr;
+    Instruction *instr = nullptr;
 
     if (TYPES::opcodes::OP_NOP == opcode)
     {
         auto second_opcode = bytecode[index + 1];
 
         if (second_opcode == 0x03) // filled-array-data
-            instr = ::get_instruction<FillArrayData>(bytecode, index, parser);
+            instr = ::get_instruction<FillArrayData>(bytecode, index, parser, arena);
         else if (second_opcode == 0x01) // packed-switch-data
-            instr = ::get_instruction<PackedSwitch>(bytecode, index, parser);
+            instr = ::get_instruction<PackedSwitch>(bytecode, index, parser, arena);
         else if (second_opcode == 0x02) // sparse-switch-data
-            instr = ::get_instruction<SparseSwitch>(bytecode, index, parser);
+            instr = ::get_instruction<SparseSwitch>(bytecode, index, parser, arena);
         else
-            instr = ::function_pointers[TYPES::opcodes::OP_NOP](bytecode, index, parser);
+            instr = ::generators[TYPES::opcodes::OP_NOP].generator(bytecode, index, parser, arena);
     }
     else
     {
-        auto it = ::function_pointers.find(static_cast<TYPES::opcodes>(opcode));
-
-        if (it != ::function_pointers.end())
-            instr = it->second(bytecode, index, parser);
+        if (opcode < ::generators.size() && ::generators[opcode].generator)
+            instr = ::generators[opcode].generator(bytecode, index, parser, arena);
         else
         {
+            auto logger = LOGGER::logger();
             logger->error("Error in disassembler, opcode {} not recognized", opcode);
             throw exceptions::DisassemblerException("Error in disassembler, not recognized opcode");
         }
     }
 
-    if (instr)
-        last_instr = instr.get();
+    return instr;
+}
+
+std::uint32_t Disassembler::get_instruction_size(const std::vector<uint8_t> &bytecode, std::size_t index)
+{
+    if (index >= bytecode.size())
+        return 0;
+
+    auto opcode = bytecode[index];
+
+    // payloads start with a nop with the kind in the high byte
+    if (opcode == TYPES::opcodes::OP_NOP && index + 1 < bytecode.size() &&
+        bytecode[index + 1] >= 0x01 && bytecode[index + 1] <= 0x03)
+    {
+        auto size = ::get_payload_size(bytecode, index, bytecode[index + 1]);
+
+        return static_cast<std::uint32_t>(std::min<std::uint64_t>(size, UINT32_MAX));
+    }
+
+    return ::generators[opcode].size;
+}
+
+bool Disassembler::is_valid_instruction(const std::vector<uint8_t> &bytecode, std::size_t index, Parser *parser)
+{
+    auto size = get_instruction_size(bytecode, index);
+
+    if (size == 0 || index + size > bytecode.size())
+        return false;
+
+    auto opcode = bytecode[index];
+    auto high = bytecode[index + 1];
+
+    // the payloads are only limited by their size
+    if (opcode == TYPES::opcodes::OP_NOP && high >= 0x01 && high <= 0x03)
+        return true;
+
+    // the same check used by the constructors of the instructions
+    return check_instruction(::generators[opcode].type, bytecode, index, parser) == nullptr;
+}
+
+Instruction *Disassembler::disassemble_checked_instruction(
+    std::vector<uint8_t> &bytecode,
+    std::size_t index,
+    std::size_t end,
+    InstructionArena &arena,
+    std::uint32_t &size)
+{
+    auto instr = disassemble_checked_instruction(bytecode, index, end, parser, arena, size);
+
+    last_instr = instr;
 
     return instr;
 }
 
+Instruction *Disassembler::disassemble_checked_instruction(
+    std::vector<uint8_t> &bytecode,
+    std::size_t index,
+    std::size_t end,
+    Parser *parser,
+    InstructionArena &arena,
+    std::uint32_t &size)
+{
+    auto available = end - index;
+
+    size = get_instruction_size(bytecode, index);
+
+    // the instruction is decoded only if it is correct and it fits
+    // before the end. In other case it is reported as an incorrect
+    // instruction with its size, so the decoding continues after it,
+    // or with one code unit (or the bytes left) when its size is
+    // unknown or it does not fit before the end
+    if (size == 0 || size > available || !is_valid_instruction(bytecode, index, parser))
+    {
+        auto logger = LOGGER::logger();
+        logger->debug("Invalid instruction in the index: {}, opcode: {}, size: {}, available: {}",
+                      index, bytecode[index], size, available);
+
+        size = size && size <= available ? size : static_cast<std::uint32_t>(std::min<std::size_t>(2, available));
+        return arena.make<DalvikIncorrectInstruction>(bytecode, index, size);
+    }
+
+    try
+    {
+        return disassemble_instruction(bytecode[index], bytecode, index, parser, arena);
+    }
+    catch (const std::exception &e)
+    {
+        auto logger = LOGGER::logger();
+        logger->error("Error reading index: {}, opcode: {}, message: {}", index, bytecode[index], e.what());
+
+        return arena.make<DalvikIncorrectInstruction>(bytecode, index, size);
+    }
+}
+
 std::vector<std::int64_t> Disassembler::determine_next(Instruction *instruction, std::uint64_t curr_idx)
 {
     if (!instruction)
@@ -453,6 +700,10 @@ std::vector<std::int64_t> Disassembler::determine_next(Instruction *instruction,
         case Instruction31t::PACKED_SWITCH:
         {
             auto packed_switch = switch_instr->get_packed_switch();
+
+            if (!packed_switch)
+                break;
+
             const auto &targets = packed_switch->get_targets();
 
             for (auto &target : targets)
@@ -462,6 +713,10 @@ std::vector<std::int64_t> Disassembler::determine_next(Instruction *instruction,
         case Instruction31t::SPARSE_SWITCH:
         {
             auto sparse_switch = switch_instr->get_sparse_switch();
+
+            if (!sparse_switch)
+                break;
+
             const auto &keys_targets = sparse_switch->get_keys_targets();
 
             for (auto &key_target : keys_targets)
@@ -558,68 +813,5 @@ std::int32_t Disassembler::get_unconditional_jump_target(Instruction *instr)
 
 std::vector<Disassembler::exceptions_data> Disassembler::determine_exception(EncodedMethod *method)
 {
-    /// pair of TryItem and EncodedCatchHandlers
-    using try_encoded = std::pair<TryItem *, EncodedCatchHandler *>;
-    /// vector of pairs
-    using vector_try_encoded = std::vector<try_encoded>;
-
-    std::unordered_map<std::uint64_t,
-                       vector_try_encoded>
-        h_off;
-
-    std::vector<Disassembler::exceptions_data> exceptions;
-
-    if (!method || !method->get_code_item().get_number_try_items())
-        return {};
-
-    auto &code_item = method->get_code_item();
-
-    // retrieve all the try items with the handler
-    // of the offset
-    for (auto &try_item : code_item.get_try_items())
-    {
-        auto offset_handler = try_item->get_handler_off() +
-                              code_item.get_encoded_catch_handler_offset();
-        h_off[offset_handler].push_back({try_item.get(), nullptr});
-    }
-
-    // add the encoded catch handlers to the structure
-    for (auto &encoded_catch_handler : code_item.get_encoded_catch_handlers())
-    {
-        auto it = h_off.find(encoded_catch_handler->get_offset());
-
-        if (it == h_off.end())
-            continue;
-
-        for (auto &v : it->second)
-            v.second = encoded_catch_handler.get();
-    }
-
-    // now create the exceptions structure
-    for (auto &off_values : h_off)
-    {
-        for (auto &values : off_values.second)
-        {
-            auto try_value = values.first;
-            auto handler_catch = values.second;
-
-            Disassembler::exceptions_data z;
-
-            z.try_value_start_addr = try_value->get_start_addr() * 2;
-            z.try_value_end_addr = (try_value->get_start_addr() * 2) +
-                                   (try_value->get_insn_count() * 2) - 1;
-
-            for (auto &catch_type_pair : handler_catch->get_handlers())
-            {
-                z.handler.push_back({catch_type_pair->get_exception_type(), catch_type_pair->get_addr() * 2});
-            }
-
-            if (handler_catch->get_size() <= 0)
-                z.handler.push_back({&throwable_class, handler_catch->get_catch_all_addr() * 2});
-
-            exceptions.push_back(z);
-        }
-    }
-
-    return exceptions;
-}
\ No newline at end of file
+    return ExceptionTable(method).get_exceptions();
+}
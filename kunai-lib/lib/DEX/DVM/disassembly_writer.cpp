@@ -0,0 +1,313 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file disassembly_writer.cpp
+
+#include "Kunai/DEX/DVM/disassembly_writer.hpp"
+#include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
+#include "Kunai/DEX/DVM/instruction_range.hpp"
+#include "Kunai/Exceptions/generic_exception.hpp"
+#include "Kunai/Utils/logger.hpp"
+#include "Kunai/Utils/parallel.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#define KUNAI_WRITE ::_write
+#define KUNAI_OPEN ::_open
+#define KUNAI_CLOSE ::_close
+#else
+#include <unistd.h>
+#define KUNAI_WRITE ::write
+#define KUNAI_OPEN ::open
+#define KUNAI_CLOSE ::close
+#endif
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    /// @brief number of bytes of an instruction shown in each line
+    constexpr std::size_t bytes_per_line = 8;
+
+    /// @brief Append a string to a buffer
+    /// @param out buffer where the text is appended
+    /// @param str text to append
+    inline void append(fmt::memory_buffer &out, std::string_view str)
+    {
+        out.append(str.data(), str.data() + str.size());
+    }
+
+    /// @brief Append the string of some access flags, followed
+    /// by a space when there is any flag
+    /// @param out buffer where the text is appended
+    /// @param flags string with the access flags
+    inline void append_flags(fmt::memory_buffer &out, const std::string &flags)
+    {
+        if (flags.empty())
+            return;
+        append(out, flags);
+        out.push_back(' ');
+    }
+
+    /// @brief Append a byte as two hexadecimal digits and a space
+    /// @param out buffer where the text is appended
+    /// @param byte value to append
+    inline void append_byte(fmt::memory_buffer &out, std::uint8_t byte)
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        const char text[] = {digits[byte >> 4], digits[byte & 0xF], ' '};
+        out.append(text, text + 3);
+    }
+
+    /// @brief Append the address, bytes and text of an instruction
+    /// in the same format used by the dalvik-disassembler tool
+    /// @param out buffer where the text is appended
+    /// @param instr instruction to append
+    void append_instruction(fmt::memory_buffer &out, Instruction &instr)
+    {
+        fmt::format_to(std::back_inserter(out), "    {:08x}  ", instr.get_address());
+
+        const auto &opcodes = instr.get_opcodes();
+
+        std::size_t column = 0;
+
+        for (auto byte : opcodes)
+        {
+            if (column == bytes_per_line)
+            {
+                append(out, "\n              ");
+                column = 0;
+            }
+
+            append_byte(out, byte);
+            column++;
+        }
+
+        for (; column < bytes_per_line; column++)
+            append(out, "   ");
+
+        append(out, instr.print_instruction());
+        out.push_back('\n');
+    }
+
+    /// @brief Write all the content of a buffer to a file
+    /// descriptor, retrying the partial writes
+    /// @param fd file descriptor
+    /// @param out buffer to write
+    void write_buffer(int fd, const fmt::memory_buffer &out)
+    {
+        auto data = out.data();
+        auto remaining = out.size();
+
+        while (remaining)
+        {
+            auto written = KUNAI_WRITE(fd, data, static_cast<unsigned>(std::min<std::size_t>(remaining, 1 << 30)));
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw exceptions::generic_exception(
+                    std::string("disassembly_writer.cpp: error writing the disassembly: ") + std::strerror(errno));
+            }
+
+            data += written;
+            remaining -= static_cast<std::size_t>(written);
+        }
+    }
+}
+
+void DisassemblyWriter::prepare_parser()
+{
+    // the logger is created in the first call
+    LOGGER::logger();
+
+    parser->create_pretty_names();
+}
+
+void DisassemblyWriter::format_method(EncodedMethod *method, fmt::memory_buffer &out)
+{
+    auto &code_item = method->get_code_item();
+
+    append(out, ".method ");
+    append_flags(out, DalvikOpcodes::get_method_access_flags(method));
+    append(out, method->getMethodID()->pretty_method());
+    out.push_back('\n');
+
+    if (!code_item.get_bytecode().empty())
+    {
+        fmt::format_to(std::back_inserter(out), "    .registers {}\n", code_item.get_registers_size());
+
+        InstructionRange range(code_item, parser);
+
+        for (auto &instr : range)
+            append_instruction(out, instr);
+    }
+
+    append(out, ".end method\n\n");
+}
+
+void DisassemblyWriter::format_class(ClassDef *class_def, fmt::memory_buffer &out)
+{
+    append(out, ".class ");
+    append_flags(out, DalvikOpcodes::get_access_flags_str(class_def->get_access_flags()));
+    append(out, class_def->get_class_idx()->get_name());
+    out.push_back('\n');
+
+    if (auto super_class = class_def->get_superclass())
+    {
+        append(out, ".super ");
+        append(out, super_class->get_name());
+        out.push_back('\n');
+    }
+
+    if (!class_def->get_source_file().empty())
+        fmt::format_to(std::back_inserter(out), ".source \"{}\"\n", class_def->get_source_file());
+
+    for (auto interface : class_def->get_interfaces())
+    {
+        append(out, ".implements ");
+        append(out, interface->get_name());
+        out.push_back('\n');
+    }
+
+    out.push_back('\n');
+
+    auto &class_data = class_def->get_class_data_item();
+
+    for (auto field : class_data.get_fields())
+    {
+        append(out, ".field ");
+        append_flags(out, DalvikOpcodes::get_field_access_flags(field));
+        append(out, field->get_field()->get_name());
+        out.push_back(':');
+        append(out, field->get_field()->get_type()->get_raw());
+        out.push_back('\n');
+    }
+
+    if (!class_data.get_fields().empty())
+        out.push_back('\n');
+
+    for (auto method : class_data.get_methods())
+        format_method(method, out);
+}
+
+void DisassemblyWriter::write(int fd)
+{
+    auto logger = LOGGER::logger();
+
+    prepare_parser();
+
+    auto &class_defs = parser->get_classes().get_classdefs();
+    auto total = class_defs.size();
+
+    // more threads than hardware threads or than classes do not
+    // help, and the number of buffers depends on them
+    auto workers = static_cast<unsigned>(std::min<std::size_t>(
+        {parallel::number_of_threads(threads), parallel::number_of_threads(), std::max<std::size_t>(total, 1)}));
+
+    // ring of buffers, class i is formatted in the buffer i % slots once
+    // the class that used it before was written, so once the buffers
+    // grow to the size of the biggest classes there are no more
+    // allocations for the text
+    auto slots = workers * classes_per_thread;
+    std::vector<fmt::memory_buffer> buffers(slots);
+    std::vector<std::uint8_t> ready(slots, 0);
+
+    std::mutex mutex;
+    std::condition_variable slot_free;
+    std::size_t written = 0;
+    bool flushing = false;
+    bool failed = false;
+
+    logger->info("DisassemblyWriter: writing {} classes with {} threads", total, workers);
+
+    parallel::parallel_for(
+        total, [&](std::size_t i, unsigned)
+        {
+            auto slot = i % slots;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slot_free.wait(lock, [&]
+                               { return failed || i < written + slots; });
+                if (failed)
+                    return;
+            }
+
+            try
+            {
+                buffers[slot].clear();
+                format_class(class_defs[i].get(), buffers[slot]);
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                ready[slot] = 1;
+
+                // one thread at a time writes the buffers that are
+                // ready in the order of the classes, the output is
+                // the same for any number of threads
+                if (flushing)
+                    return;
+
+                flushing = true;
+
+                while (!failed && written < total && ready[written % slots])
+                {
+                    auto next = written % slots;
+
+                    lock.unlock();
+                    write_buffer(fd, buffers[next]);
+                    lock.lock();
+
+                    ready[next] = 0;
+                    written++;
+                    slot_free.notify_all();
+                }
+
+                flushing = false;
+            }
+            catch (...)
+            {
+                // the classes after this one would wait forever for
+                // their buffers, wake them up to finish
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                flushing = false;
+                slot_free.notify_all();
+                throw;
+            } },
+        workers);
+}
+
+void DisassemblyWriter::write(const std::string &file_path)
+{
+    auto fd = KUNAI_OPEN(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+        throw exceptions::generic_exception("disassembly_writer.cpp: cannot open the file " + file_path);
+
+    try
+    {
+        write(fd);
+    }
+    catch (...)
+    {
+        KUNAI_CLOSE(fd);
+        throw;
+    }
+
+    KUNAI_CLOSE(fd);
+}
@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file exception_table.cpp
+
+#include "Kunai/DEX/DVM/exception_table.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include <unordered_map>
+
+using namespace KUNAI::DEX;
+
+DVMType *ExceptionTable::get_throwable_class()
+{
+    // the pretty name is created here, so the class can
+    // be read later from different threads
+    static DVMClass throwable_class = []
+    {
+        DVMClass throwable("Ljava/lang/Throwable;");
+        throwable.pretty_print();
+        return throwable;
+    }();
+
+    return &throwable_class;
+}
+
+ExceptionTable::ExceptionTable(EncodedMethod *method)
+{
+    if (!method || !method->get_code_item().get_number_try_items())
+        return;
+
+    auto &code_item = method->get_code_item();
+
+    // the handlers are referenced by their offset
+    std::unordered_map<std::uint64_t, EncodedCatchHandler *> handlers_by_offset;
+
+    for (auto &encoded_catch_handler : code_item.get_encoded_catch_handlers())
+        handlers_by_offset[encoded_catch_handler->get_offset()] = encoded_catch_handler.get();
+
+    exceptions.reserve(code_item.get_try_items().size());
+
+    for (auto &try_item : code_item.get_try_items())
+    {
+        auto offset_handler = try_item->get_handler_off() +
+                              code_item.get_encoded_catch_handler_offset();
+
+        auto it = handlers_by_offset.find(offset_handler);
+
+        // a try item without handlers cannot catch anything
+        if (it == handlers_by_offset.end())
+            continue;
+
+        auto handler_catch = it->second;
+
+        Disassembler::exceptions_data z;
+
+        z.try_value_start_addr = try_item->get_start_addr() * 2;
+        z.try_value_end_addr = (try_item->get_start_addr() * 2) +
+                               (try_item->get_insn_count() * 2) - 1;
+
+        for (auto &catch_type_pair : handler_catch->get_handlers())
+            z.handler.push_back({catch_type_pair->get_exception_type(), catch_type_pair->get_addr() * 2});
+
+        if (handler_catch->get_size() <= 0)
+            z.handler.push_back({get_throwable_class(), handler_catch->get_catch_all_addr() * 2});
+
+        exceptions.push_back(std::move(z));
+    }
+
+    // the try items should be sorted already, but
+    // nothing stops a modified file from doing otherwise
+    std::stable_sort(exceptions.begin(), exceptions.end(),
+                     [](const Disassembler::exceptions_data &a, const Disassembler::exceptions_data &b)
+                     { return a.try_value_start_addr < b.try_value_start_addr; });
+
+    build_index();
+}
+
+void ExceptionTable::build_index()
+{
+    for (const auto &exception : exceptions)
+    {
+        bounds.push_back(exception.try_value_start_addr);
+        bounds.push_back(exception.try_value_end_addr + 1);
+    }
+
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    auto segments = bounds.empty() ? 0 : bounds.size() - 1;
+
+    segment_offsets.assign(segments + 1, 0);
+
+    // one sweep over the segments, the try blocks are added when
+    // their start is reached and removed after their end, the
+    // active ones are kept in the order of `exceptions`
+    std::set<std::size_t> active;
+    // end of each active try block, the next to finish first
+    std::priority_queue<std::pair<std::uint64_t, std::size_t>,
+                        std::vector<std::pair<std::uint64_t, std::size_t>>,
+                        std::greater<>>
+        ends;
+    std::size_t next = 0;
+
+    for (std::size_t i = 0; i < segments; i++)
+    {
+        for (; next < exceptions.size() && exceptions[next].try_value_start_addr <= bounds[i]; next++)
+        {
+            active.insert(next);
+            ends.emplace(exceptions[next].try_value_end_addr + 1, next);
+        }
+
+        for (; !ends.empty() && ends.top().first <= bounds[i]; ends.pop())
+            active.erase(ends.top().second);
+
+        for (auto exception : active)
+            covering.push_back(&exceptions[exception]);
+
+        segment_offsets[i + 1] = static_cast<std::uint32_t>(covering.size());
+    }
+}
+
+std::span<const Disassembler::exceptions_data *const>
+ExceptionTable::get_exceptions_at(std::uint64_t address) const
+{
+    // first bound bigger than the address, the
+    // segment of the address is the previous one
+    auto it = std::upper_bound(bounds.begin(), bounds.end(), address);
+
+    if (it == bounds.begin() || it == bounds.end())
+        return {};
+
+    auto segment = static_cast<std::size_t>(std::distance(bounds.begin(), it)) - 1;
+
+    return std::span<const Disassembler::exceptions_data *const>(
+        covering.data() + segment_offsets[segment],
+        segment_offsets[segment + 1] - segment_offsets[segment]);
+}
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file instruction_arena.cpp
+
+#include "Kunai/DEX/DVM/instruction_arena.hpp"
+
+#include <cstdint>
+
+using namespace KUNAI::DEX;
+
+InstructionArena::InstructionArena(InstructionArena &&other) noexcept
+    : chunks(std::move(other.chunks)),
+      current(std::exchange(other.current, nullptr)),
+      remaining(std::exchange(other.remaining, 0)),
+      next_chunk_size(other.next_chunk_size),
+      current_chunk_size(std::exchange(other.current_chunk_size, 0)),
+      external(std::exchange(other.external, nullptr)),
+      external_size(std::exchange(other.external_size, 0)),
+      last(std::exchange(other.last, nullptr)),
+      objects(std::exchange(other.objects, 0))
+{
+    other.chunks.clear();
+}
+
+InstructionArena &InstructionArena::operator=(InstructionArena &&other) noexcept
+{
+    if (this != &other)
+    {
+        clear();
+
+        chunks = std::move(other.chunks);
+        current = std::exchange(other.current, nullptr);
+        remaining = std::exchange(other.remaining, 0);
+        next_chunk_size = other.next_chunk_size;
+        current_chunk_size = std::exchange(other.current_chunk_size, 0);
+        external = std::exchange(other.external, nullptr);
+        external_size = std::exchange(other.external_size, 0);
+        last = std::exchange(other.last, nullptr);
+        objects = std::exchange(other.objects, 0);
+
+        other.chunks.clear();
+    }
+
+    return *this;
+}
+
+void *InstructionArena::allocate(std::size_t size, std::size_t alignment)
+{
+    auto padding = (alignment - (reinterpret_cast<std::uintptr_t>(current) & (alignment - 1))) & (alignment - 1);
+
+    if (current == nullptr || padding + size > remaining)
+    {
+        // chunks are allocated with the alignment of new,
+        // enough for any of the instructions
+        auto chunk_size = next_chunk_size;
+
+        if (chunk_size < size + alignment)
+            chunk_size = size + alignment;
+
+        chunks.push_back(std::make_unique<std::byte[]>(chunk_size));
+
+        current = chunks.back().get();
+        remaining = chunk_size;
+        current_chunk_size = chunk_size;
+        padding = (alignment - (reinterpret_cast<std::uintptr_t>(current) & (alignment - 1))) & (alignment - 1);
+
+        if (next_chunk_size < max_chunk_size)
+            next_chunk_size *= 2;
+    }
+
+    auto memory = current + padding;
+
+    current += padding + size;
+    remaining -= padding + size;
+
+    return memory;
+}
+
+void InstructionArena::clear()
+{
+    // destroy the instructions in the inverse order of creation
+    while (last)
+    {
+        auto prev = last->prev;
+        last->object->~Instruction();
+        last = prev;
+    }
+
+    objects = 0;
+
+    if (!chunks.empty())
+    {
+        // keep the last chunk, it is the biggest one
+        if (chunks.size() > 1)
+        {
+            auto last_chunk = std::move(chunks.back());
+            chunks.clear();
+            chunks.push_back(std::move(last_chunk));
+        }
+
+        current = chunks.back().get();
+        remaining = current_chunk_size;
+    }
+    else if (external)
+    {
+        current = external;
+        remaining = external_size;
+    }
+}
@@ -0,0 +1,28 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file instruction_range.cpp
+
+#include "Kunai/DEX/DVM/instruction_range.hpp"
+
+using namespace KUNAI::DEX;
+
+void InstructionRange::decode_next()
+{
+    // destroy the previous instruction, the slot is reused
+    arena.clear();
+    current = nullptr;
+
+    if (next_idx >= bytecode.size())
+        return;
+
+    // incorrect bytes are returned as DalvikIncorrectInstruction
+    std::uint32_t size;
+
+    current = Disassembler::disassemble_checked_instruction(bytecode, next_idx, bytecode.size(), parser, arena, size);
+    current->set_address(next_idx);
+
+    next_idx += size;
+}
@@ -6,118 +6,159 @@
 // @file linear_sweep_disassembler.cpp
 
 #include "Kunai/DEX/DVM/linear_sweep_disassembler.hpp"
-#include "Kunai/Exceptions/disassembler_exception.hpp"
-#include "Kunai/Exceptions/invalidinstruction_exception.hpp"
-#include "Kunai/Utils/logger.hpp"
 
-#include <unordered_map>
+#include <algorithm>
 
 using namespace KUNAI::DEX;
 
-/// namespace
-///{
-///     bool compare_by_address(const std::unique_ptr<Instruction>& a,
-///                             const std::unique_ptr<Instruction>& b)
-///     {
-///         return a->get_address() < b->get_address();
-///     }
-/// }
+void LinearSweepDisassembler::find_payloads(std::vector<std::uint8_t> &buffer_bytes,
+                                            std::vector<payload_range_t> &payloads)
+{
+    auto buffer_size = buffer_bytes.size();
+
+    payloads.clear();
+
+    // walk the instructions only reading their size, the
+    // switches and fill-array-data give the payloads
+    for (std::uint64_t idx = 0; idx < buffer_size;)
+    {
+        auto size = Disassembler::get_instruction_size(buffer_bytes, idx);
+        std::uint8_t ident = 0;
+
+        switch (buffer_bytes[idx])
+        {
+        case TYPES::opcodes::OP_PACKED_SWITCH:
+            ident = 0x01;
+            break;
+        case TYPES::opcodes::OP_SPARSE_SWITCH:
+            ident = 0x02;
+            break;
+        case TYPES::opcodes::OP_FILL_ARRAY_DATA:
+            ident = 0x03;
+            break;
+        }
+
+        if (ident && idx + size <= buffer_size)
+        {
+            auto offset = static_cast<std::int32_t>(
+                buffer_bytes[idx + 2] | (buffer_bytes[idx + 3] << 8) |
+                (buffer_bytes[idx + 4] << 16) | (static_cast<std::uint32_t>(buffer_bytes[idx + 5]) << 24));
+            auto target = static_cast<std::int64_t>(idx) + static_cast<std::int64_t>(offset) * 2;
+
+            if (target >= 0 && static_cast<std::uint64_t>(target) + 1 < buffer_size &&
+                buffer_bytes[target] == 0 && buffer_bytes[target + 1] == ident)
+            {
+                auto payload_size = Disassembler::get_instruction_size(buffer_bytes, target);
+
+                if (static_cast<std::uint64_t>(target) + payload_size <= buffer_size)
+                    payloads.push_back({static_cast<std::uint64_t>(target), target + payload_size});
+            }
+        }
+
+        // unknown opcodes are skipped as one code unit
+        idx += size ? size : 2;
+    }
+
+    if (payloads.size() < 2)
+        return;
+
+    // sorted and without overlaps, a payload
+    // that overlaps a previous one is dropped
+    std::sort(payloads.begin(), payloads.end());
+
+    std::size_t last = 0;
+
+    for (std::size_t i = 1; i < payloads.size(); i++)
+        if (payloads[i].first >= payloads[last].second)
+            payloads[++last] = payloads[i];
+
+    payloads.resize(last + 1);
+}
 
 void LinearSweepDisassembler::disassembly(std::vector<std::uint8_t> &buffer_bytes,
-                                          std::vector<std::unique_ptr<Instruction>> &instructions)
+                                          std::vector<Instruction *> &instructions,
+                                          InstructionArena &arena)
 {
-    auto logger = LOGGER::logger();
-    std::unordered_map<std::uint64_t, Instruction *> cache_instr; // cache for searching for switch instructions
+    std::vector<std::size_t> switches;                            // position of the switch instructions
+    std::vector<payload_range_t> payloads;                        // payloads referenced from the code
     std::uint64_t idx = 0;                                        // index of the instr
-    std::unique_ptr<Instruction> instr;                           // insruction to create
+    Instruction *instr;                                           // insruction to create
     auto buffer_size = buffer_bytes.size();                       // size of the buffer
-    std::uint32_t opcode;                                         // opcode of the operation
-    bool exist_switch = false;                                    // check a switch exist
+    std::uint32_t size;                                           // size of the instruction
+    auto first = instructions.size();                             // first instruction of this buffer
+    std::size_t next_payload = 0;                                 // next payload in the buffer
+
+    find_payloads(buffer_bytes, payloads);
 
     while (idx < buffer_size)
     {
-        opcode = static_cast<std::uint32_t>(buffer_bytes[idx]);
+        // the instructions end at most where the next payload
+        // starts, so the payloads are never decoded as code
+        std::uint64_t end = buffer_size;
 
-        try
+        if (next_payload < payloads.size())
         {
-            if (!exist_switch &&
-                (opcode == TYPES::opcodes::OP_PACKED_SWITCH ||
-                 opcode == TYPES::opcodes::OP_SPARSE_SWITCH))
-                exist_switch = true;
+            const auto &payload = payloads[next_payload];
 
-            instr = disassembler->disassemble_instruction(
-                opcode,
-                buffer_bytes,
-                idx);
-
-            if (instr)
+            if (idx == payload.first)
             {
-                instr->set_address(idx);
-
-                instructions.push_back(std::move(instr));
-
-                cache_instr[idx] = instructions.back().get();
-
-                idx += instructions.back()->get_instruction_length();
+                end = payload.second;
+                next_payload++;
             }
+            else
+                end = payload.first;
         }
-        catch (const exceptions::InvalidInstructionException &i)
-        {
-            logger->error("InvalidInstructionException in the index: {}, opcode: {}, message: {}, instr size: {}",
-                          idx, opcode, i.what(), i.size());
-            // in case there was an invalid instr
-            // create a DalvikIncorrectInstruction
-            instr = std::make_unique<DalvikIncorrectInstruction>(buffer_bytes, idx, i.size());
 
-            instr->set_address(idx);
+        instr = Disassembler::disassemble_checked_instruction(buffer_bytes, idx, end, disassembler->get_parser(), arena, size);
 
-            // set the instr into the vector
-            instructions.push_back(std::move(instr));
+        instr->set_address(idx);
 
-            cache_instr[idx] = instructions.back().get();
+        auto opcode = buffer_bytes[idx];
 
-            idx += i.size();
-        }
-        catch (const std::exception &e)
-        {
-            logger->error("Error reading index: {}, opcode: {}, message: {}",
-                          idx, opcode, e.what());
-            idx += 1;
-        }
-    }
+        if ((opcode == TYPES::opcodes::OP_PACKED_SWITCH ||
+             opcode == TYPES::opcodes::OP_SPARSE_SWITCH) &&
+            instr->get_instruction_type() == dexinsttype_t::DEX_INSTRUCTION31T)
+            switches.push_back(instructions.size());
 
-    if (exist_switch)
-        assign_switch_if_any(instructions, cache_instr);
+        instructions.push_back(instr);
 
-    /// std::sort(instructions.begin(), instructions.end(), ::compare_by_address);
-    std::sort(instructions.begin(), instructions.end(), [=](const std::unique_ptr<Instruction> &a, const std::unique_ptr<Instruction> &b)
-              { return a->get_address() < b->get_address(); });
+        idx += size;
+    }
+
+    // the sweep only moves forward, so the instructions
+    // are already sorted by address
+    if (!switches.empty())
+        assign_switch_if_any(instructions, first, switches);
 }
 
 void LinearSweepDisassembler::assign_switch_if_any(
-    std::vector<std::unique_ptr<Instruction>> &instructions,
-    std::unordered_map<std::uint64_t, Instruction *> &cache_instructions)
+    std::vector<Instruction *> &instructions,
+    std::size_t first,
+    const std::vector<std::size_t> &switches)
 {
-    for (auto &instr : instructions)
+    for (auto pos : switches)
     {
-        auto op_code = instr->get_instruction_opcode();
+        auto instr31t = reinterpret_cast<Instruction31t *>(instructions[pos]);
+        auto op_code = instr31t->get_instruction_opcode();
 
-        if (op_code == TYPES::opcodes::OP_PACKED_SWITCH ||
-            op_code == TYPES::opcodes::OP_SPARSE_SWITCH)
-        {
-            auto instr31t = reinterpret_cast<Instruction31t *>(instr.get());
+        auto switch_idx = static_cast<std::int64_t>(instr31t->get_address()) + (instr31t->get_offset() * 2);
 
-            auto switch_idx = instr31t->get_address() + (instr31t->get_offset() * 2);
+        if (switch_idx < 0)
+            continue;
 
-            auto it = cache_instructions.find(switch_idx);
+        auto it = std::lower_bound(instructions.begin() + first, instructions.end(),
+                                   static_cast<std::uint64_t>(switch_idx),
+                                   [](const Instruction *instr, std::uint64_t address)
+                                   { return instr->get_address() < address; });
 
-            if (it != cache_instructions.end())
-            {
-                if (op_code == TYPES::opcodes::OP_PACKED_SWITCH)
-                    instr31t->set_packed_switch(reinterpret_cast<PackedSwitch *>(it->second));
-                else if (op_code == TYPES::opcodes::OP_SPARSE_SWITCH)
-                    instr31t->set_sparse_switch(reinterpret_cast<SparseSwitch *>(it->second));
-            }
-        }
+        if (it == instructions.end() || (*it)->get_address() != static_cast<std::uint64_t>(switch_idx))
+            continue;
+
+        if (op_code == TYPES::opcodes::OP_PACKED_SWITCH &&
+            (*it)->get_instruction_type() == dexinsttype_t::DEX_PACKEDSWITCH)
+            instr31t->set_packed_switch(reinterpret_cast<PackedSwitch *>(*it));
+        else if (op_code == TYPES::opcodes::OP_SPARSE_SWITCH &&
+                 (*it)->get_instruction_type() == dexinsttype_t::DEX_SPARSESWITCH)
+            instr31t->set_sparse_switch(reinterpret_cast<SparseSwitch *>(*it));
     }
-}
\ No newline at end of file
+}
@@ -6,98 +6,147 @@
 // @file recursive_traversal_disassembler.cpp
 
 #include "Kunai/DEX/DVM/recursive_traversal_disassembler.hpp"
+#include "Kunai/DEX/DVM/bytecode_scan.hpp"
 #include "Kunai/Exceptions/disassembler_exception.hpp"
 #include "Kunai/Exceptions/invalidinstruction_exception.hpp"
 #include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
 
 using namespace KUNAI::DEX;
 
-///namespace
-///{
-///    bool compare_by_address(const std::unique_ptr<Instruction> &a,
-///                            const std::unique_ptr<Instruction> &b)
-///    {
-///        return a->get_address() < b->get_address();
-///    }
-///}
+namespace
+{
+    /// @brief Working memory of the recursive traversal, it is kept
+    /// per thread and reused between methods, so once the buffers
+    /// have grown to the size of the biggest method no more memory
+    /// is requested.
+    struct traversal_scratch_t
+    {
+        /// @brief bitmap with one bit per code unit, a bit is set
+        /// when an instruction starts in that code unit
+        std::vector<std::uint64_t> seen;
+        /// @brief pending addresses to analyze
+        std::vector<std::uint64_t> worklist;
+        /// @brief instruction that starts in each code unit
+        std::vector<Instruction *> by_unit;
+        /// @brief code units that can change the control flow
+        BytecodeScan scan;
+    };
+
+    thread_local traversal_scratch_t scratch;
+
+    bool is_seen(std::uint64_t idx)
+    {
+        auto unit = idx >> 1;
+        return (scratch.seen[unit >> 6] >> (unit & 63)) & 1;
+    }
+
+    void set_seen(std::uint64_t idx)
+    {
+        auto unit = idx >> 1;
+        scratch.seen[unit >> 6] |= (std::uint64_t(1) << (unit & 63));
+    }
+}
 
 void RecursiveTraversalDisassembler::disassembly(std::vector<std::uint8_t> &buffer_bytes,
                                                  EncodedMethod *method,
-                                                 std::vector<std::unique_ptr<Instruction>> &instructions)
+                                                 std::vector<Instruction *> &instructions,
+                                                 InstructionArena &arena)
+{
+    ExceptionTable exception_table(method);
+
+    disassembly(buffer_bytes, exception_table, instructions, arena);
+}
+
+void RecursiveTraversalDisassembler::disassembly(std::vector<std::uint8_t> &buffer_bytes,
+                                                 const ExceptionTable &exception_table,
+                                                 std::vector<Instruction *> &instructions,
+                                                 InstructionArena &arena)
 {
     auto logger = LOGGER::logger();
-    // cache instructions for quick searching
-    std::unordered_map<std::uint64_t, Instruction *> cache_instrs;
-    // unordered map for keeping track of analyzed
-    // we keep an index and a bollean value
-    std::unordered_map<std::uint64_t, bool> seen;
     // index of the instruction
     std::uint64_t idx = 0;
     // instruction pointer
-    std::unique_ptr<Instruction> instruction;
+    Instruction *instruction;
     // size of the buffer
     auto buffer_size = buffer_bytes.size();
+    // number of 16-bit code units of the method
+    auto units = (buffer_size + 1) / 2;
     // opcode
     std::uint32_t opcode;
-
-    auto exceptions = disassembler->determine_exception(method);
+    // number of instructions found
+    std::size_t found = 0;
+
+    // reset the working memory, these calls do not
+    // release the memory so it can be reused
+    scratch.seen.assign((units + 63) / 64, 0);
+    scratch.worklist.clear();
+    scratch.by_unit.clear();
+    scratch.by_unit.resize(units);
+    scratch.scan.scan(buffer_bytes);
+
+    auto push = [&](std::int64_t target)
+    {
+        if (target >= 0 &&
+            static_cast<std::uint64_t>(target) < buffer_size &&
+            !is_seen(target))
+            scratch.worklist.push_back(target);
+    };
 
     // take every method start at index 0
-    Q.push(0);
+    push(0);
 
     // now all the handlers from the exceptions
-    for (auto &exception : exceptions)
+    for (auto &exception : exception_table.get_exceptions())
     {
         // add try parts
-        Q.push(exception.try_value_start_addr);
+        push(exception.try_value_start_addr);
 
         // add now the catches
         for (auto &handler : exception.handler)
-            Q.push(handler.handler_start_addr);
+            push(handler.handler_start_addr);
     }
 
-    while (!Q.empty())
+    while (!scratch.worklist.empty())
     {
-        // obtain always the first from the queue
-        idx = Q.front();
-        Q.pop();
+        idx = scratch.worklist.back();
+        scratch.worklist.pop_back();
 
-        // in case it is a seen address
-        // continue
-        if (seen[idx])
-            continue;
-
-        while (idx < buffer_size)
+        // follow the code until we find an address already
+        // analyzed, or the flow cannot continue
+        while (idx < buffer_size && !is_seen(idx))
         {
-
             try
             {
                 /// classical linear sweep disassembly
                 opcode = buffer_bytes[idx];
 
-                instruction = disassembler->disassemble_instruction(opcode, buffer_bytes, idx);
+                instruction = Disassembler::disassemble_instruction(opcode, buffer_bytes, idx, disassembler->get_parser(), arena);
 
-                if (instruction)
-                {
-                    instruction->set_address(idx);
+                if (!instruction)
+                    break;
 
-                    instructions.push_back(std::move(instruction));
+                auto current = instruction;
 
-                    cache_instrs[idx] = instructions.back().get();
-                }
+                current->set_address(idx);
+                set_seen(idx);
+                scratch.by_unit[idx >> 1] = instruction;
+                found++;
 
-                seen[idx] = true;
+                // only the candidates from the scan can change the
+                // control flow, the rest go to the next instruction
+                // without looking for their operation
+                if (!scratch.scan.is_control_flow_candidate(idx))
+                {
+                    idx += current->get_instruction_length();
+                    continue;
+                }
 
                 auto operation = DalvikOpcodes::get_instruction_operation(opcode);
 
-                /// analyze in case of FILL_ARRAY_DATA, each one
-                /// we have to disassembly the data
+                /// analyze in case of FILL_ARRAY_DATA, the data
+                /// is decoded directly as a payload
                 if (opcode == TYPES::opcodes::OP_FILL_ARRAY_DATA)
-                {
-                    auto fill_array_data = reinterpret_cast<Instruction31t *>(instructions.back().get());
-
-                    Q.push(idx + (fill_array_data->get_offset() * 2));
-                }
+                    found += analyze_payload(reinterpret_cast<Instruction31t *>(current), buffer_bytes, arena);
 
                 if (
                     // conditional jump
@@ -108,21 +157,19 @@ void RecursiveTraversalDisassembler::disassembly(std::vector<std::uint8_t> &buff
                     operation == TYPES::Operation::MULTI_BRANCH_DVM_OPCODE)
                 {
                     if (operation == TYPES::Operation::MULTI_BRANCH_DVM_OPCODE)
-                        analyze_switch(instructions, cache_instrs, buffer_bytes);
+                        found += analyze_payload(reinterpret_cast<Instruction31t *>(current), buffer_bytes, arena);
 
-                    auto next_offsets = disassembler->determine_next(cache_instrs[idx], idx);
-
-                    for (auto next_offset : next_offsets)
-                    {
-                        if (!seen[next_offset])
-                            Q.push(next_offset);
-                    }
+                    for (auto next_offset : disassembler->determine_next(current, idx))
+                        push(next_offset);
 
                     if (operation == TYPES::Operation::UNCONDITIONAL_BRANCH_DVM_OPCODE)
                         break;
                 }
+                // after a return the flow does not continue
+                else if (operation == TYPES::Operation::RET_BRANCH_DVM_OPCODE)
+                    break;
 
-                idx += cache_instrs[idx]->get_instruction_length();
+                idx += current->get_instruction_length();
             }
             catch (const exceptions::InvalidInstructionException &i)
             {
@@ -130,49 +177,85 @@ void RecursiveTraversalDisassembler::disassembly(std::vector<std::uint8_t> &buff
                               idx, opcode, i.what(), i.size());
                 // in case there was an invalid instruction
                 // create a DalvikIncorrectInstruction
-                instruction = std::make_unique<DalvikIncorrectInstruction>(buffer_bytes, idx, i.size());
-
-                // set the instruction into the vector
-                instructions.push_back(std::move(instruction));
+                instruction = arena.make<DalvikIncorrectInstruction>(buffer_bytes, idx, i.size());
+                instruction->set_address(idx);
 
-                cache_instrs[idx] = instructions.back().get();
+                set_seen(idx);
+                scratch.by_unit[idx >> 1] = instruction;
+                found++;
 
                 idx += i.size();
             }
             catch (const std::exception &e)
             {
                 logger->error("Error reading index: {}, opcode: {}, message: {}", idx, opcode, e.what());
-                idx += 1;
+                // instructions are aligned to code units
+                idx += 2;
             }
         }
     }
 
-    /// std::sort(instructions.begin(), instructions.end(), ::compare_by_address);
-    std::sort(instructions.begin(), instructions.end(), [=](const std::unique_ptr<Instruction> &a, const std::unique_ptr<Instruction> &b)
-              { return a->get_address() < b->get_address(); });
+    // the index is sorted by address, so we can emit the
+    // instructions in order without sorting them
+    instructions.reserve(instructions.size() + found);
+
+    for (auto instr : scratch.by_unit)
+    {
+        if (instr)
+            instructions.push_back(instr);
+    }
 }
 
-void RecursiveTraversalDisassembler::analyze_switch(
-    std::vector<std::unique_ptr<Instruction>> &instructions,
-    std::unordered_map<std::uint64_t, Instruction *> &cache_instrs,
-    std::vector<std::uint8_t> &buffer_bytes)
+std::size_t RecursiveTraversalDisassembler::analyze_payload(
+    Instruction31t *instr31t,
+    std::vector<std::uint8_t> &buffer_bytes,
+    InstructionArena &arena)
 {
-    auto instr31t = reinterpret_cast<Instruction31t *>(instructions.back().get());
+    auto payload_idx = static_cast<std::int64_t>(instr31t->get_address()) + (instr31t->get_offset() * 2);
 
-    auto switch_idx = instr31t->get_address() + (instr31t->get_offset() * 2);
+    if (payload_idx < 0 ||
+        static_cast<std::uint64_t>(payload_idx) >= buffer_bytes.size())
+        return 0;
 
-    auto opcode = buffer_bytes[switch_idx];
+    auto &payload = scratch.by_unit[payload_idx >> 1];
+    std::size_t decoded = 0;
 
-    auto new_instruction = disassembler->disassemble_instruction(opcode, buffer_bytes, switch_idx);
+    // the payload may be shared by different instructions
+    // decode it only the first time
+    if (!is_seen(payload_idx))
+    {
+        auto opcode = buffer_bytes[payload_idx];
+        Instruction *new_instruction;
 
-    new_instruction->set_address(switch_idx);
+        try
+        {
+            new_instruction = Disassembler::disassemble_instruction(opcode, buffer_bytes, payload_idx, disassembler->get_parser(), arena);
+        }
+        catch (const std::exception &e)
+        {
+            auto logger = LOGGER::logger();
+            logger->error("Error reading payload in index: {}, message: {}", payload_idx, e.what());
+            return 0;
+        }
+
+        if (!new_instruction)
+            return 0;
+
+        new_instruction->set_address(payload_idx);
+        set_seen(payload_idx);
+        payload = new_instruction;
+        decoded = 1;
+    }
 
-    instructions.push_back(std::move(new_instruction));
+    if (!payload)
+        return decoded;
 
-    cache_instrs[switch_idx] = instructions.back().get();
+    if (instr31t->get_type_of_switch() == Instruction31t::type_of_switch_t::PACKED_SWITCH &&
+        payload->get_instruction_type() == dexinsttype_t::DEX_PACKEDSWITCH)
+        instr31t->set_packed_switch(reinterpret_cast<PackedSwitch *>(payload));
+    else if (instr31t->get_type_of_switch() == Instruction31t::type_of_switch_t::SPARSE_SWITCH &&
+             payload->get_instruction_type() == dexinsttype_t::DEX_SPARSESWITCH)
+        instr31t->set_sparse_switch(reinterpret_cast<SparseSwitch *>(payload));
 
-    if (instr31t->get_type_of_switch() == Instruction31t::type_of_switch_t::PACKED_SWITCH)
-        instr31t->set_packed_switch(reinterpret_cast<PackedSwitch *>(cache_instrs[switch_idx]));
-    else if (instr31t->get_type_of_switch() == Instruction31t::type_of_switch_t::SPARSE_SWITCH)
-        instr31t->set_sparse_switch(reinterpret_cast<SparseSwitch *>(cache_instrs[switch_idx]));
+    return decoded;
 }
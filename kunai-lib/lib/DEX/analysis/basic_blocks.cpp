@@ -10,126 +10,289 @@
 
 using namespace KUNAI::DEX;
 
-void BasicBlocks::remove_node(DVMBasicBlock *node)
+namespace
 {
-    // with this we provide RAII
-    // TODO: Remove unused variable
-    std::unique_ptr<DVMBasicBlock> const node_ (node);
-
-    if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
-        throw exceptions::AnalysisException("remove_mode: given node does not exist in graph");
-
-    if (node->is_start_block() || node->is_end_block())
-        throw exceptions::AnalysisException("remove_node: start or end blocks cannot be removed");
-
-    auto node_type = get_node_type(node);
-
-    if (node_type == JOIN_NODE) // len(predecessors) > 1
+    /// @brief Pack the ids of an edge in one value
+    /// @param src id of the source block
+    /// @param dst id of the destination block
+    /// @return key of the edge
+    inline std::uint64_t edge_key(std::uint32_t src, std::uint32_t dst)
     {
-        auto suc = *sucessors[node].begin();
+        return (static_cast<std::uint64_t>(src) << 32) | dst;
+    }
 
-        // delete from predecessors of sucessor
-        predecessors[suc].erase(node);
-        // remove the edge
-        std::remove(edges.begin(), edges.end(), std::make_pair(node, suc));
+    /// @brief Create the compressed rows of sucessors and predecessors
+    /// of a list of edges, keeping the order of the edges
+    void build_rows(const BasicBlocks::edges_t &edges, std::size_t number_of_blocks,
+                    std::vector<std::uint32_t> &sucessor_offsets,
+                    std::vector<BasicBlocks::block_id_t> &sucessor_ids,
+                    std::vector<std::uint32_t> &predecessor_offsets,
+                    std::vector<BasicBlocks::block_id_t> &predecessor_ids)
+    {
+        sucessor_offsets.assign(number_of_blocks + 1, 0);
+        predecessor_offsets.assign(number_of_blocks + 1, 0);
 
-        for (auto pred : predecessors[node])
+        // count the neighbours of each block
+        for (const auto &[src, dst] : edges)
         {
-            // delete the edge from predecessor to the node
-            std::remove(edges.begin(), edges.end(), std::make_pair(pred, node));
-            // delete from sucessors[pred] the node
-            sucessors[pred].erase(node);
+            sucessor_offsets[src->get_id() + 1]++;
+            predecessor_offsets[dst->get_id() + 1]++;
         }
 
-        for (auto pred : predecessors[node])
+        for (std::size_t i = 0; i < number_of_blocks; i++)
         {
-            // now add new one with successor
-            edges.push_back(std::make_pair(pred, suc));
-            // add the predecessor of sucesspr
-            predecessors[suc]
-                .insert(pred);
-            // add the sucessor of pred
-            sucessors[pred].insert(suc);
+            sucessor_offsets[i + 1] += sucessor_offsets[i];
+            predecessor_offsets[i + 1] += predecessor_offsets[i];
         }
-    }
-    else if (node_type == BRANCH_NODE) // len(sucessors) > 1
-    {
-        auto pred = *predecessors[node].begin();
 
-        // delete from sucessors of pred
-        sucessors[pred].erase(node);
-        // remove the edge
-        remove(edges.begin(), edges.end(), std::make_pair(pred, node));
+        sucessor_ids.resize(edges.size());
+        predecessor_ids.resize(edges.size());
 
-        // now disconnect the node from the sucessors
-        for (auto suc : sucessors[node])
-        {
-            // remove the edges node->suc
-            std::remove(edges.begin(), edges.end(), std::make_pair(node, suc));
-            // remove the node as predecessor of this sucessor
-            predecessors[suc].erase(node);
-        }
+        // place the neighbours keeping the order of the edges
+        std::vector<std::uint32_t> next_sucessor(sucessor_offsets.begin(), sucessor_offsets.end() - 1);
+        std::vector<std::uint32_t> next_predecessor(predecessor_offsets.begin(), predecessor_offsets.end() - 1);
 
-        for (auto suc : sucessors[node])
+        for (const auto &[src, dst] : edges)
         {
-            // add the edges
-            edges.push_back(std::make_pair(pred, suc));
-            // add the predecessor of sucesspr
-            predecessors[suc].insert(pred);
-            // add the sucessor of pred
-            sucessors[pred].insert(suc);
+            sucessor_ids[next_sucessor[src->get_id()]++] = dst->get_id();
+            predecessor_ids[next_predecessor[dst->get_id()]++] = src->get_id();
         }
     }
-    else
-    {
-        DVMBasicBlock *pred, *suc;
-        if (predecessors[node].size() == 1)
-        {
-            pred = *predecessors[node].begin();
+}
 
-            // delete from sucessors of pred
-            sucessors[pred].erase(node);
-            // remove the edge
-            remove(edges.begin(), edges.end(), std::make_pair(pred, node));
-        }
+DVMBasicBlock *BasicBlocks::create_block()
+{
+    auto &block = blocks.emplace_back();
 
-        if (sucessors[node].size() == 1)
-        {
-            auto suc = *sucessors[node].begin();
+    block.id = static_cast<block_id_t>(blocks.size() - 1);
 
-            // delete from predecessors of sucessor
-            predecessors[suc].erase(node);
-            // remove the edge
-            std::remove(edges.begin(), edges.end(), std::make_pair(node, suc));
-        }
+    in_graph.push_back(1);
+    nodes.push_back(&block);
 
-        if (pred != nullptr && suc != nullptr)
-        {
-            edges.push_back(std::make_pair(pred, suc));
-            // add sucessor to pred
-            sucessors[pred].insert(suc);
-            // add predecessor to suc
-            predecessors[suc].insert(pred);
-        }
+    block_index_valid = false;
+    invalidate_edges();
+
+    return &block;
+}
+
+void BasicBlocks::add_node(DVMBasicBlock *node)
+{
+    if (!owns(node))
+        throw exceptions::AnalysisException("add_node: given node was not created by the graph");
+
+    if (in_graph[node->get_id()])
+        return;
+
+    in_graph[node->get_id()] = 1;
+    nodes.push_back(node);
+
+    block_index_valid = false;
+}
+
+void BasicBlocks::add_edge(DVMBasicBlock *src, DVMBasicBlock *dst)
+{
+    add_node(src);
+    add_node(dst);
+
+    // now insert the edge, only once
+    if (!edge_set.insert(edge_key(src->get_id(), dst->get_id())).second)
+        return;
+
+    edges.push_back(std::make_pair(src, dst));
+
+    invalidate_edges();
+}
+
+void BasicBlocks::add_exception_edge(DVMBasicBlock *src, DVMBasicBlock *dst)
+{
+    add_node(src);
+    add_node(dst);
+
+    if (!exception_edge_set.insert(edge_key(src->get_id(), dst->get_id())).second)
+        return;
+
+    exception_edges.push_back(std::make_pair(src, dst));
+
+    invalidate_edges();
+}
+
+void BasicBlocks::build_adjacency() const
+{
+    build_rows(edges, blocks.size(), sucessor_offsets, sucessor_ids,
+               predecessor_offsets, predecessor_ids);
+    build_rows(exception_edges, blocks.size(), exception_sucessor_offsets, exception_sucessor_ids,
+               exception_predecessor_offsets, exception_predecessor_ids);
+
+    adjacency_valid = true;
+}
+
+void BasicBlocks::build_connected() const
+{
+    predecessors.clear();
+    sucessors.clear();
+
+    for (auto node : nodes)
+    {
+        auto &node_predecessors = predecessors[node];
+        for (auto pred : get_predecessors(node))
+            node_predecessors.insert(pred);
+
+        auto &node_sucessors = sucessors[node];
+        for (auto suc : get_sucessors(node))
+            node_sucessors.insert(suc);
     }
 
-    // now delete the node from the predecessors and sucessors
-    predecessors.erase(node);
-    sucessors.erase(node);
+    connected_valid = true;
+}
+
+std::span<const BasicBlocks::block_id_t> BasicBlocks::get_sucessor_ids(block_id_t id) const
+{
+    if (!adjacency_valid)
+        build_adjacency();
 
-    // finally delete from vector
-    std::remove(nodes.begin(), nodes.end(), node);
+    return std::span<const block_id_t>(sucessor_ids.data() + sucessor_offsets[id],
+                                       sucessor_offsets[id + 1] - sucessor_offsets[id]);
 }
 
-DVMBasicBlock *BasicBlocks::get_basic_block_by_idx(std::uint64_t idx)
+std::span<const BasicBlocks::block_id_t> BasicBlocks::get_predecessor_ids(block_id_t id) const
+{
+    if (!adjacency_valid)
+        build_adjacency();
+
+    return std::span<const block_id_t>(predecessor_ids.data() + predecessor_offsets[id],
+                                       predecessor_offsets[id + 1] - predecessor_offsets[id]);
+}
+
+std::span<const BasicBlocks::block_id_t> BasicBlocks::get_exception_sucessor_ids(block_id_t id) const
 {
+    if (!adjacency_valid)
+        build_adjacency();
+
+    return std::span<const block_id_t>(exception_sucessor_ids.data() + exception_sucessor_offsets[id],
+                                       exception_sucessor_offsets[id + 1] - exception_sucessor_offsets[id]);
+}
+
+std::span<const BasicBlocks::block_id_t> BasicBlocks::get_exception_predecessor_ids(block_id_t id) const
+{
+    if (!adjacency_valid)
+        build_adjacency();
+
+    return std::span<const block_id_t>(exception_predecessor_ids.data() + exception_predecessor_offsets[id],
+                                       exception_predecessor_offsets[id + 1] - exception_predecessor_offsets[id]);
+}
+
+bool BasicBlocks::is_reached_by_exceptions_only(block_id_t id) const
+{
+    if (get_exception_predecessor_ids(id).empty())
+        return false;
+
+    auto preds = get_predecessor_ids(id);
+
+    if (preds.size() != 1 || !blocks[preds[0]].is_start_block())
+        return false;
+
+    // the first sucessor of the start block is the entry of the method
+    return get_sucessor_ids(preds[0]).front() != id;
+}
+
+void BasicBlocks::remove_node(DVMBasicBlock *node)
+{
+    if (!owns(node) || !in_graph[node->get_id()])
+        throw exceptions::AnalysisException("remove_mode: given node does not exist in graph");
+
+    if (node->is_start_block() || node->is_end_block())
+        throw exceptions::AnalysisException("remove_node: start or end blocks cannot be removed");
+
+    std::vector<DVMBasicBlock *> node_predecessors, node_sucessors;
+
+    for (auto pred : get_predecessors(node))
+        if (pred != node)
+            node_predecessors.push_back(pred);
+
+    for (auto suc : get_sucessors(node))
+        if (suc != node)
+            node_sucessors.push_back(suc);
+
+    // remove the edges of the node
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [&](const auto &edge)
+                               {
+                                   if (edge.first != node && edge.second != node)
+                                       return false;
+                                   edge_set.erase(edge_key(edge.first->get_id(), edge.second->get_id()));
+                                   return true;
+                               }),
+                edges.end());
+
+    exception_edges.erase(std::remove_if(exception_edges.begin(), exception_edges.end(),
+                                         [&](const auto &edge)
+                                         {
+                                             if (edge.first != node && edge.second != node)
+                                                 return false;
+                                             exception_edge_set.erase(edge_key(edge.first->get_id(), edge.second->get_id()));
+                                             return true;
+                                         }),
+                          exception_edges.end());
+
+    invalidate_edges();
+
+    // delete from the nodes
+    in_graph[node->get_id()] = 0;
+    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+    block_index_valid = false;
+
+    // the predecessors now go to the sucessors
+    for (auto pred : node_predecessors)
+        for (auto suc : node_sucessors)
+            add_edge(pred, suc);
+}
+
+void BasicBlocks::build_block_index()
+{
+    std::vector<std::pair<std::uint64_t, DVMBasicBlock *>> sorted_blocks;
+
+    sorted_blocks.reserve(nodes.size());
+
     for (const auto node : nodes)
     {
-        if (node->is_start_block() || node->is_end_block())
+        if (node->is_start_block() || node->is_end_block() ||
+            node->get_nb_instructions() == 0)
             continue;
-        if (idx >= node->get_first_address() && idx <= node->get_last_address())
-            return node;
+        sorted_blocks.emplace_back(node->get_first_address(), node);
+    }
+
+    std::stable_sort(sorted_blocks.begin(), sorted_blocks.end(),
+                     [](const auto &a, const auto &b)
+                     { return a.first < b.first; });
+
+    block_starts.clear();
+    blocks_by_address.clear();
+
+    for (const auto &[address, node] : sorted_blocks)
+    {
+        block_starts.push_back(address);
+        blocks_by_address.push_back(node);
     }
 
+    block_index_valid = true;
+}
+
+DVMBasicBlock *BasicBlocks::get_basic_block_by_idx(std::uint64_t idx)
+{
+    if (!block_index_valid)
+        build_block_index();
+
+    // first block that starts after idx, the
+    // block of idx can only be the previous one
+    auto it = std::upper_bound(block_starts.begin(), block_starts.end(), idx);
+
+    if (it == block_starts.begin())
+        return nullptr;
+
+    auto node = blocks_by_address[std::distance(block_starts.begin(), it) - 1];
+
+    if (idx <= node->get_last_address())
+        return node;
+
     return nullptr;
 }
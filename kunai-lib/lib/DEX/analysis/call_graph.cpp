@@ -0,0 +1,317 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file call_graph.cpp
+
+#include "Kunai/DEX/analysis/call_graph.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace KUNAI::DEX;
+
+SinkReachability::SinkReachability(const CallGraph *graph, std::size_t sinks)
+    : graph(graph), words((sinks + 63) / 64), bits(graph->get_number_of_components() * words, 0)
+{
+}
+
+const std::uint64_t *SinkReachability::get_bits(node_t method) const
+{
+    return bits.data() + graph->get_component(method) * words;
+}
+
+bool SinkReachability::reaches(node_t method, std::size_t sink) const
+{
+    return (get_bits(method)[sink / 64] >> (sink % 64)) & 1;
+}
+
+bool SinkReachability::reaches_any(node_t method) const
+{
+    auto method_bits = get_bits(method);
+
+    return std::any_of(method_bits, method_bits + words, [](std::uint64_t word)
+                       { return word != 0; });
+}
+
+std::vector<std::size_t> SinkReachability::get_sinks(node_t method) const
+{
+    std::vector<std::size_t> sinks;
+    auto method_bits = get_bits(method);
+
+    for (std::size_t word = 0; word < words; word++)
+        for (std::size_t bit = 0; bit < 64; bit++)
+            if ((method_bits[word] >> bit) & 1)
+                sinks.push_back(word * 64 + bit);
+
+    return sinks;
+}
+
+CallGraph::CallGraph(const XrefTable &xrefs, std::size_t number_of_methods,
+                     const ClassHierarchy *hierarchy, ClassHierarchy::dispatch_t mode)
+{
+    callee_offsets.resize(number_of_methods + 1);
+
+    // the calls of a method are sorted by offset in the table,
+    // every method keeps its callees sorted and only once
+    for (std::size_t method = 0; method < number_of_methods; method++)
+    {
+        auto start = callees.size();
+
+        callee_offsets[method] = static_cast<std::uint32_t>(start);
+
+        for (const auto &xref : xrefs.get_xrefs_from(static_cast<node_t>(method), XrefTable::xref_kind_t::CALL))
+        {
+            if (hierarchy == nullptr)
+            {
+                callees.push_back(xref.dst);
+                continue;
+            }
+
+            auto targets = hierarchy->get_targets(xref.dst, xref.opcode, mode);
+            callees.insert(callees.end(), targets.begin(), targets.end());
+        }
+
+        std::sort(callees.begin() + start, callees.end());
+        callees.erase(std::unique(callees.begin() + start, callees.end()), callees.end());
+    }
+
+    callee_offsets[number_of_methods] = static_cast<std::uint32_t>(callees.size());
+
+    // the callers are filled visiting the methods in order,
+    // so these are sorted too
+    caller_offsets.assign(number_of_methods + 1, 0);
+
+    for (auto callee : callees)
+        caller_offsets[callee + 1]++;
+
+    for (std::size_t i = 1; i < caller_offsets.size(); i++)
+        caller_offsets[i] += caller_offsets[i - 1];
+
+    callers.resize(callees.size());
+
+    std::vector<std::uint32_t> next(caller_offsets.begin(), caller_offsets.end() - 1);
+
+    for (std::size_t method = 0; method < number_of_methods; method++)
+        for (auto callee : get_callees(static_cast<node_t>(method)))
+            callers[next[callee]++] = static_cast<node_t>(method);
+
+    compute_components();
+}
+
+void CallGraph::compute_components()
+{
+    constexpr std::uint32_t unvisited = std::numeric_limits<std::uint32_t>::max();
+
+    auto n = get_number_of_nodes();
+
+    std::vector<std::uint32_t> index(n, unvisited), lowlink(n, 0);
+    std::vector<std::uint8_t> on_stack(n, 0);
+    std::vector<node_t> stack;
+    // method being visited and position of its next callee
+    std::vector<std::pair<node_t, std::uint32_t>> visiting;
+    std::uint32_t next_index = 0;
+
+    components.assign(n, 0);
+
+    auto discover = [&](node_t method)
+    {
+        index[method] = lowlink[method] = next_index++;
+        stack.push_back(method);
+        on_stack[method] = 1;
+        visiting.emplace_back(method, callee_offsets[method]);
+    };
+
+    // Tarjan's algorithm without recursion, the call graph of
+    // big applications is too deep for the stack of a thread
+    for (node_t root = 0; root < n; root++)
+    {
+        if (index[root] != unvisited)
+            continue;
+
+        discover(root);
+
+        while (!visiting.empty())
+        {
+            auto method = visiting.back().first;
+            auto &position = visiting.back().second;
+
+            if (position < callee_offsets[method + 1])
+            {
+                auto callee = callees[position++];
+
+                if (index[callee] == unvisited)
+                    discover(callee);
+                else if (on_stack[callee])
+                    lowlink[method] = std::min(lowlink[method], index[callee]);
+
+                continue;
+            }
+
+            // all the callees visited, the method is the root
+            // of a component if it cannot reach an older method
+            if (lowlink[method] == index[method])
+            {
+                auto component = static_cast<component_t>(component_sizes.size());
+                std::uint32_t size = 0;
+                node_t member;
+
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = 0;
+                    components[member] = component;
+                    size++;
+                } while (member != method);
+
+                component_sizes.push_back(size);
+            }
+
+            visiting.pop_back();
+
+            if (!visiting.empty())
+            {
+                auto caller = visiting.back().first;
+                lowlink[caller] = std::min(lowlink[caller], lowlink[method]);
+            }
+        }
+    }
+
+    // condensation of the graph
+    std::vector<std::pair<component_t, component_t>> edges;
+
+    for (node_t method = 0; method < n; method++)
+        for (auto callee : get_callees(method))
+            if (components[method] != components[callee])
+                edges.emplace_back(components[method], components[callee]);
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    successor_offsets.assign(component_sizes.size() + 1, 0);
+    successors.reserve(edges.size());
+
+    for (const auto &edge : edges)
+    {
+        successor_offsets[edge.first + 1]++;
+        successors.push_back(edge.second);
+    }
+
+    for (std::size_t i = 1; i < successor_offsets.size(); i++)
+        successor_offsets[i] += successor_offsets[i - 1];
+}
+
+std::vector<CallGraph::node_t> CallGraph::breadth_first(std::span<const node_t> sources,
+                                                        node_t target,
+                                                        std::vector<node_t> *parents) const
+{
+    std::vector<std::uint8_t> visited(get_number_of_nodes(), 0);
+    std::vector<node_t> order;
+
+    // the order works as the queue of the search
+    for (auto source : sources)
+    {
+        if (visited[source])
+            continue;
+
+        visited[source] = 1;
+        order.push_back(source);
+
+        if (parents)
+            (*parents)[source] = source;
+    }
+
+    for (std::size_t next = 0; next < order.size(); next++)
+    {
+        if (order[next] == target)
+        {
+            order.resize(next + 1);
+            return order;
+        }
+
+        for (auto callee : get_callees(order[next]))
+        {
+            if (visited[callee])
+                continue;
+
+            visited[callee] = 1;
+            order.push_back(callee);
+
+            if (parents)
+                (*parents)[callee] = order[next];
+        }
+    }
+
+    // with a target, the methods visited are useless if not found
+    if (target != SymbolTable::no_symbol)
+        order.clear();
+
+    return order;
+}
+
+std::vector<CallGraph::node_t> CallGraph::depth_first(node_t method) const
+{
+    std::vector<std::uint8_t> visited(get_number_of_nodes(), 0);
+    std::vector<node_t> order, pending{method};
+
+    while (!pending.empty())
+    {
+        auto current = pending.back();
+        pending.pop_back();
+
+        if (visited[current])
+            continue;
+
+        visited[current] = 1;
+        order.push_back(current);
+
+        // reversed so the first callee is the first visited
+        auto current_callees = get_callees(current);
+
+        for (auto it = current_callees.rbegin(); it != current_callees.rend(); it++)
+            if (!visited[*it])
+                pending.push_back(*it);
+    }
+
+    return order;
+}
+
+std::vector<CallGraph::node_t> CallGraph::get_path(node_t from, node_t to) const
+{
+    std::vector<node_t> parents(get_number_of_nodes(), SymbolTable::no_symbol);
+    std::vector<node_t> path;
+
+    if (breadth_first(std::span<const node_t>(&from, 1), to, &parents).empty())
+        return path;
+
+    for (auto method = to; method != from; method = parents[method])
+        path.push_back(method);
+
+    path.push_back(from);
+
+    std::reverse(path.begin(), path.end());
+
+    return path;
+}
+
+SinkReachability CallGraph::reach_sinks(std::span<const node_t> sinks) const
+{
+    SinkReachability reachability(this, sinks.size());
+    auto words = reachability.words;
+    auto &bits = reachability.bits;
+
+    for (std::size_t sink = 0; sink < sinks.size(); sink++)
+        bits[components[sinks[sink]] * words + sink / 64] |= std::uint64_t(1) << (sink % 64);
+
+    // the successors of a component have a lower number,
+    // so their bits are complete when the component is visited
+    for (component_t component = 0; component < get_number_of_components(); component++)
+        for (auto successor : get_successors(component))
+            for (std::size_t word = 0; word < words; word++)
+                bits[component * words + word] |= bits[successor * words + word];
+
+    return reachability;
+}
@@ -0,0 +1,507 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file class_hierarchy.cpp
+
+#include "Kunai/DEX/analysis/class_hierarchy.hpp"
+#include "Kunai/DEX/analysis/analysis.hpp"
+#include "Kunai/Utils/logger.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    constexpr std::uint32_t not_numbered = std::numeric_limits<std::uint32_t>::max();
+
+    bool is_invoke_interface(std::uint32_t opcode)
+    {
+        return opcode == TYPES::opcodes::OP_INVOKE_INTERFACE ||
+               opcode == TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE;
+    }
+
+    std::uint64_t declaration_key(ClassHierarchy::class_t cls, ClassHierarchy::selector_t selector)
+    {
+        return (static_cast<std::uint64_t>(cls) << 32) | selector;
+    }
+}
+
+ClassHierarchy::ClassHierarchy(const SymbolTable &symbols,
+                               const std::vector<ClassAnalysis *> &classes,
+                               const std::vector<MethodAnalysis *> &methods,
+                               const XrefTable &xrefs)
+{
+    auto logger = LOGGER::logger();
+
+    auto number_of_classes = symbols.get_number_of_classes();
+
+    superclasses.assign(number_of_classes, SymbolTable::no_symbol);
+    interface.assign(number_of_classes, 0);
+
+    std::vector<std::vector<class_t>> direct_interfaces(number_of_classes);
+
+    // only the classes of the dex files have a definition
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+    {
+        auto class_analysis = classes[cls];
+
+        if (class_analysis == nullptr || class_analysis->is_class_external())
+            continue;
+
+        auto class_def = std::get<ClassDef *>(class_analysis->get_class_definition());
+
+        interface[cls] = (class_def->get_access_flags() & TYPES::access_flags::ACC_INTERFACE) != 0;
+
+        if (auto superclass = class_def->get_superclass())
+            superclasses[cls] = symbols.find_class(superclass->get_name());
+
+        for (auto implemented : class_def->get_interfaces())
+        {
+            auto id = symbols.find_class(implemented->get_name());
+
+            if (id != SymbolTable::no_symbol)
+                direct_interfaces[cls].push_back(id);
+        }
+    }
+
+    // the external classes have no definition, they are interfaces
+    // when a class of the dex implements them or when they are the
+    // class of the method of an invoke-interface
+    auto is_external = [&](class_t cls)
+    {
+        return classes[cls] == nullptr || classes[cls]->is_class_external();
+    };
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        for (auto implemented : direct_interfaces[cls])
+            if (is_external(implemented))
+                interface[implemented] = 1;
+
+    for (const auto &xref : xrefs.get_xrefs())
+    {
+        if (xref.kind != XrefTable::xref_kind_t::CALL || !is_invoke_interface(xref.opcode))
+            continue;
+
+        auto cls = symbols.get_method_class(xref.dst);
+
+        if (cls != SymbolTable::no_symbol && is_external(cls))
+            interface[cls] = 1;
+    }
+
+    // subclasses of each class
+    std::vector<std::uint32_t> child_offsets(number_of_classes + 1, 0);
+    std::vector<class_t> children(number_of_classes);
+
+    for (auto superclass : superclasses)
+        if (superclass != SymbolTable::no_symbol)
+            child_offsets[superclass + 1]++;
+
+    for (std::size_t i = 1; i < child_offsets.size(); i++)
+        child_offsets[i] += child_offsets[i - 1];
+
+    std::vector<std::uint32_t> next_child(child_offsets.begin(), child_offsets.end() - 1);
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        if (superclasses[cls] != SymbolTable::no_symbol)
+            children[next_child[superclasses[cls]]++] = cls;
+
+    // number the tree of superclasses depth first, the subclasses
+    // of a class take the numbers from pre to end
+    pre.assign(number_of_classes, not_numbered);
+    end.assign(number_of_classes, 0);
+
+    std::vector<class_t> order(number_of_classes);
+    std::vector<std::pair<class_t, std::uint32_t>> visiting;
+    std::uint32_t number = 0;
+
+    auto number_tree = [&](class_t root)
+    {
+        order[number] = root;
+        pre[root] = number++;
+        visiting.emplace_back(root, child_offsets[root]);
+
+        while (!visiting.empty())
+        {
+            auto cls = visiting.back().first;
+            auto &position = visiting.back().second;
+
+            if (position < child_offsets[cls + 1])
+            {
+                auto child = children[position++];
+
+                if (pre[child] != not_numbered)
+                    continue;
+
+                order[number] = child;
+                pre[child] = number++;
+                visiting.emplace_back(child, child_offsets[child]);
+                continue;
+            }
+
+            end[cls] = number;
+            visiting.pop_back();
+        }
+    };
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        if (superclasses[cls] == SymbolTable::no_symbol)
+            number_tree(cls);
+
+    // a malformed dex can have a cycle of superclasses,
+    // the cycle is broken in one of its classes
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+    {
+        if (pre[cls] != not_numbered)
+            continue;
+
+        logger->warn("ClassHierarchy: cycle of superclasses found in {}, the superclass is ignored",
+                     symbols.get_class_name(cls));
+
+        superclasses[cls] = SymbolTable::no_symbol;
+        number_tree(cls);
+    }
+
+    // chains of superclasses, the superclass is always
+    // numbered before its subclasses
+    chain_offsets.assign(number_of_classes + 1, 0);
+
+    std::vector<std::uint32_t> chain_sizes(number_of_classes, 1);
+
+    for (auto cls : order)
+        if (superclasses[cls] != SymbolTable::no_symbol)
+            chain_sizes[cls] += chain_sizes[superclasses[cls]];
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        chain_offsets[cls + 1] = chain_offsets[cls] + chain_sizes[cls];
+
+    chains.resize(chain_offsets.back());
+
+    for (auto cls : order)
+    {
+        auto chain = chains.begin() + chain_offsets[cls];
+
+        *chain = cls;
+
+        if (superclasses[cls] != SymbolTable::no_symbol)
+        {
+            auto super_chain = get_superclass_chain(superclasses[cls]);
+            std::copy(super_chain.begin(), super_chain.end(), chain + 1);
+        }
+    }
+
+    // interfaces implemented by each class: its own interfaces,
+    // the interfaces these extend and those of the superclasses
+    std::vector<std::vector<class_t>> closures(number_of_classes);
+    std::vector<std::uint8_t> state(number_of_classes, 0);
+
+    auto compute_closure = [&](auto &self, class_t cls) -> void
+    {
+        // 1 while computing, so a cycle of interfaces stops here
+        state[cls] = 1;
+
+        auto &closure = closures[cls];
+
+        for (auto implemented : direct_interfaces[cls])
+        {
+            closure.push_back(implemented);
+
+            if (state[implemented] == 0)
+                self(self, implemented);
+            if (state[implemented] == 2)
+                closure.insert(closure.end(), closures[implemented].begin(), closures[implemented].end());
+        }
+
+        auto superclass = superclasses[cls];
+
+        if (superclass != SymbolTable::no_symbol)
+        {
+            if (state[superclass] == 0)
+                self(self, superclass);
+            if (state[superclass] == 2)
+                closure.insert(closure.end(), closures[superclass].begin(), closures[superclass].end());
+        }
+
+        std::sort(closure.begin(), closure.end());
+        closure.erase(std::unique(closure.begin(), closure.end()), closure.end());
+
+        state[cls] = 2;
+    };
+
+    // in depth first order the superclasses are computed first
+    for (auto cls : order)
+        if (state[cls] == 0)
+            compute_closure(compute_closure, cls);
+
+    interface_offsets.assign(number_of_classes + 1, 0);
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        interface_offsets[cls + 1] = interface_offsets[cls] + static_cast<std::uint32_t>(closures[cls].size());
+
+    interfaces.reserve(interface_offsets.back());
+
+    for (auto &closure : closures)
+        interfaces.insert(interfaces.end(), closure.begin(), closure.end());
+
+    std::vector<std::vector<class_t>>().swap(closures);
+
+    // classes that implement each interface, visited
+    // in depth first order so they are sorted by number
+    implementor_offsets.assign(number_of_classes + 1, 0);
+
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        if (!interface[cls])
+            for (auto implemented : get_interfaces(cls))
+                implementor_offsets[implemented + 1]++;
+
+    for (std::size_t i = 1; i < implementor_offsets.size(); i++)
+        implementor_offsets[i] += implementor_offsets[i - 1];
+
+    implementors.resize(implementor_offsets.back());
+
+    std::vector<std::uint32_t> next_implementor(implementor_offsets.begin(), implementor_offsets.end() - 1);
+
+    for (auto cls : order)
+        if (!interface[cls])
+            for (auto implemented : get_interfaces(cls))
+                implementors[next_implementor[implemented]++] = cls;
+
+    // selectors and declarations of the methods
+    auto number_of_methods = symbols.get_number_of_methods();
+
+    method_selectors.resize(number_of_methods);
+    method_classes.resize(number_of_methods);
+    concrete.assign(number_of_methods, 0);
+
+    SymbolNames selectors;
+    std::vector<std::pair<selector_t, declaration_t>> found;
+
+    for (method_t method = 0; method < number_of_methods; method++)
+    {
+        // class->name(parameters)return, the selector is after the class
+        std::string_view name = symbols.get_method_name(method);
+
+        auto selector = selectors.intern(name.substr(name.find("->") + 2));
+        auto cls = symbols.get_method_class(method);
+        auto method_analysis = methods[method];
+
+        method_selectors[method] = selector;
+        method_classes[method] = cls;
+
+        if (cls == SymbolTable::no_symbol || method_analysis == nullptr)
+            continue;
+
+        if (method_analysis->external())
+        {
+            // the method is called through a class of the dex that
+            // does not declare it, it is inherited from a superclass
+            if (classes[cls] == nullptr || !classes[cls]->is_class_external())
+                continue;
+
+            // the code of an external method is unknown, it can run
+            concrete[method] = 1;
+        }
+        else
+        {
+            auto flags = std::get<EncodedMethod *>(method_analysis->get_encoded_method())->get_access_flags();
+            concrete[method] = (flags & TYPES::access_flags::ACC_ABSTRACT) == 0;
+        }
+
+        declarations[declaration_key(cls, selector)] = method;
+        found.push_back({selector, {pre[cls], cls, method}});
+    }
+
+    number_of_selectors = selectors.size();
+
+    std::sort(found.begin(), found.end(), [](const auto &a, const auto &b)
+              { return std::tie(a.first, a.second.pre, a.second.method) <
+                       std::tie(b.first, b.second.pre, b.second.method); });
+
+    dispatch_offsets.assign(number_of_selectors + 1, 0);
+    dispatch.reserve(found.size());
+
+    for (const auto &declaration : found)
+    {
+        dispatch_offsets[declaration.first + 1]++;
+        dispatch.push_back(declaration.second);
+    }
+
+    for (std::size_t i = 1; i < dispatch_offsets.size(); i++)
+        dispatch_offsets[i] += dispatch_offsets[i - 1];
+
+    // classes used by new-instance, for RTA
+    for (class_t cls = 0; cls < number_of_classes; cls++)
+        if (!xrefs.get_xrefs_to(XrefTable::xref_kind_t::NEW_INSTANCE, cls).empty())
+            instantiated.push_back(cls);
+
+    std::sort(instantiated.begin(), instantiated.end(), [this](class_t a, class_t b)
+              { return pre[a] < pre[b]; });
+
+    logger->debug("ClassHierarchy: {} classes, {} selectors and {} instantiated classes",
+                  number_of_classes, number_of_selectors, instantiated.size());
+}
+
+std::span<const ClassHierarchy::declaration_t> ClassHierarchy::get_declarations(selector_t selector,
+                                                                               std::uint32_t first,
+                                                                               std::uint32_t last) const
+{
+    auto table = get_dispatch_table(selector);
+
+    auto begin = std::partition_point(table.begin(), table.end(), [first](const declaration_t &declaration)
+                                      { return declaration.pre < first; });
+    auto finish = std::partition_point(begin, table.end(), [last](const declaration_t &declaration)
+                                       { return declaration.pre < last; });
+
+    return {begin, finish};
+}
+
+void ClassHierarchy::add_target(method_t method, std::vector<method_t> &targets) const
+{
+    if (method != SymbolTable::no_symbol && concrete[method])
+        targets.push_back(method);
+}
+
+bool ClassHierarchy::is_instantiated(class_t cls) const
+{
+    auto it = std::partition_point(instantiated.begin(), instantiated.end(), [this, cls](class_t other)
+                                   { return pre[other] < pre[cls]; });
+
+    return it != instantiated.end() && *it == cls;
+}
+
+bool ClassHierarchy::is_subtype(class_t cls, class_t type) const
+{
+    if (is_subclass(cls, type))
+        return true;
+
+    if (!interface[type])
+        return false;
+
+    auto implemented = get_interfaces(cls);
+
+    return std::binary_search(implemented.begin(), implemented.end(), type);
+}
+
+ClassHierarchy::method_t ClassHierarchy::resolve(class_t cls, selector_t selector) const
+{
+    for (auto superclass : get_superclass_chain(cls))
+    {
+        auto it = declarations.find(declaration_key(superclass, selector));
+
+        if (it != declarations.end())
+            return it->second;
+    }
+
+    return SymbolTable::no_symbol;
+}
+
+std::vector<ClassHierarchy::method_t> ClassHierarchy::get_targets(method_t method,
+                                                                  std::uint32_t opcode,
+                                                                  dispatch_t mode) const
+{
+    std::vector<method_t> targets;
+
+    auto cls = method_classes[method];
+    auto selector = method_selectors[method];
+
+    if (cls == SymbolTable::no_symbol)
+        return {method};
+
+    switch (opcode)
+    {
+    // one target, the first declaration from the class of the
+    // instruction (for invoke-super it is already the superclass)
+    case TYPES::opcodes::OP_INVOKE_SUPER:
+    case TYPES::opcodes::OP_INVOKE_DIRECT:
+    case TYPES::opcodes::OP_INVOKE_STATIC:
+    case TYPES::opcodes::OP_INVOKE_SUPER_RANGE:
+    case TYPES::opcodes::OP_INVOKE_DIRECT_RANGE:
+    case TYPES::opcodes::OP_INVOKE_STATIC_RANGE:
+    {
+        auto target = resolve(cls, selector);
+        return {target != SymbolTable::no_symbol ? target : method};
+    }
+    case TYPES::opcodes::OP_INVOKE_VIRTUAL:
+    case TYPES::opcodes::OP_INVOKE_INTERFACE:
+    case TYPES::opcodes::OP_INVOKE_VIRTUAL_RANGE:
+    case TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE:
+        break;
+    default:
+        return {method};
+    }
+
+    // an invoke-interface always goes through an interface, even
+    // if the class of the method was never seen as one
+    auto through_interface = interface[cls] || is_invoke_interface(opcode);
+
+    // the method of the interface is a target when it has code: a
+    // default method, or an external one that external classes
+    // (not in the hierarchy) can implement
+    if (through_interface)
+        add_target(resolve(cls, selector), targets);
+
+    if (mode == dispatch_t::CHA)
+    {
+        // the method inherited by the receiver and the
+        // declarations of the subclasses of the receiver
+        auto add_cone = [&](class_t root)
+        {
+            add_target(resolve(root, selector), targets);
+
+            for (const auto &declaration : get_declarations(selector, pre[root] + 1, end[root]))
+                add_target(declaration.method, targets);
+        };
+
+        if (through_interface)
+        {
+            std::uint32_t covered = 0;
+
+            // the implementors are sorted by number, those inside
+            // the subclasses of a previous one are already covered
+            for (auto implementor : get_implementors(cls))
+            {
+                if (pre[implementor] < covered)
+                    continue;
+
+                add_cone(implementor);
+                covered = end[implementor];
+            }
+        }
+        else
+            add_cone(cls);
+    }
+    else
+    {
+        if (through_interface)
+        {
+            for (auto instantiated_cls : instantiated)
+            {
+                auto implemented = get_interfaces(instantiated_cls);
+
+                if (std::binary_search(implemented.begin(), implemented.end(), cls))
+                    add_target(resolve(instantiated_cls, selector), targets);
+            }
+        }
+        else
+        {
+            auto first = std::partition_point(instantiated.begin(), instantiated.end(), [this, cls](class_t other)
+                                              { return pre[other] < pre[cls]; });
+
+            for (auto it = first; it != instantiated.end() && pre[*it] < end[cls]; it++)
+                add_target(resolve(*it, selector), targets);
+        }
+    }
+
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    if (targets.empty())
+        targets.push_back(method);
+
+    return targets;
+}
@@ -45,6 +45,10 @@ void ClassAnalysis::add_method(MethodAnalysis* method_analysis)
 
     methods[method_key] = method_analysis;
 
+    // the xrefs of the new method are not in the maps
+    xrefto_generation = 0;
+    xreffrom_generation = 0;
+
     if (is_external)
         std::get<ExternalClass*>(class_def)->add_external_method(std::get<ExternalMethod*>(method_analysis->get_encoded_method()));
 }
@@ -81,3 +85,72 @@ FieldAnalysis *ClassAnalysis::get_field_analysis(EncodedField *field)
     return fields[field].get();
 }
 
+
+const ClassAnalysis::classxref &ClassAnalysis::get_xrefto() const
+{
+    std::lock_guard<std::mutex> lock(xrefs_mutex);
+
+    if (xref_table == nullptr ||
+        (xrefto_generation != 0 && xrefto_generation == xref_table->get_generation()))
+        return xrefto;
+
+    xrefto.clear();
+    xrefto_generation = xref_table->get_generation();
+
+    for (const auto &method : methods)
+    {
+        for (const auto &xref : xref_table->get_xrefs_from(method.second->get_symbol_id()))
+        {
+            auto ref_kind = static_cast<TYPES::REF_TYPE>(xref.opcode);
+
+            switch (xref.kind)
+            {
+            case XrefTable::xref_kind_t::CALL:
+                xrefto[xref_table->get_method_class(xref.dst)].insert(
+                    std::make_tuple(ref_kind, xref_table->get_method(xref.dst), xref.offset));
+                break;
+            case XrefTable::xref_kind_t::NEW_INSTANCE:
+            case XrefTable::xref_kind_t::CONST_CLASS:
+                xrefto[xref_table->get_class(xref.dst)].insert(
+                    std::make_tuple(ref_kind, method.second, xref.offset));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    return xrefto;
+}
+
+const ClassAnalysis::classxref &ClassAnalysis::get_xreffrom() const
+{
+    std::lock_guard<std::mutex> lock(xrefs_mutex);
+
+    if (xref_table == nullptr ||
+        (xreffrom_generation != 0 && xreffrom_generation == xref_table->get_generation()))
+        return xreffrom;
+
+    xreffrom.clear();
+    xreffrom_generation = xref_table->get_generation();
+
+    auto add_users = [&](XrefTable::xref_kind_t kind, XrefTable::symbol_id_t dst)
+    {
+        for (auto position : xref_table->get_xrefs_to(kind, dst))
+        {
+            const auto &xref = xref_table->get_xref(position);
+
+            xreffrom[xref_table->get_method_class(xref.src)].insert(
+                std::make_tuple(static_cast<TYPES::REF_TYPE>(xref.opcode),
+                                xref_table->get_method(xref.src), xref.offset));
+        }
+    };
+
+    for (const auto &method : methods)
+        add_users(XrefTable::xref_kind_t::CALL, method.second->get_symbol_id());
+
+    add_users(XrefTable::xref_kind_t::NEW_INSTANCE, id);
+    add_users(XrefTable::xref_kind_t::CONST_CLASS, id);
+
+    return xreffrom;
+}
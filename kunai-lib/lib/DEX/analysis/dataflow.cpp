@@ -0,0 +1,838 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file dataflow.cpp
+
+#include "Kunai/DEX/analysis/dataflow.hpp"
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    using opcodes = TYPES::opcodes;
+
+    /// @brief Check if an instruction writes a wide value (long or double)
+    bool writes_wide(std::uint32_t op)
+    {
+        switch (op)
+        {
+        case opcodes::OP_MOVE_WIDE:
+        case opcodes::OP_MOVE_WIDE_FROM16:
+        case opcodes::OP_MOVE_WIDE_16:
+        case opcodes::OP_MOVE_RESULT_WIDE:
+        case opcodes::OP_CONST_WIDE_16:
+        case opcodes::OP_CONST_WIDE_32:
+        case opcodes::OP_CONST_WIDE:
+        case opcodes::OP_CONST_WIDE_HIGH16:
+        case opcodes::OP_AGET_WIDE:
+        case opcodes::OP_IGET_WIDE:
+        case opcodes::OP_SGET_WIDE:
+        case opcodes::OP_NEG_LONG:
+        case opcodes::OP_NOT_LONG:
+        case opcodes::OP_NEG_DOUBLE:
+        case opcodes::OP_INT_TO_LONG:
+        case opcodes::OP_INT_TO_DOUBLE:
+        case opcodes::OP_LONG_TO_DOUBLE:
+        case opcodes::OP_FLOAT_TO_LONG:
+        case opcodes::OP_FLOAT_TO_DOUBLE:
+        case opcodes::OP_DOUBLE_TO_LONG:
+            return true;
+        default:
+            // binary operations of long and double
+            return (op >= opcodes::OP_ADD_LONG && op <= opcodes::OP_USHR_LONG) ||
+                   (op >= opcodes::OP_ADD_DOUBLE && op <= opcodes::OP_REM_DOUBLE) ||
+                   (op >= opcodes::OP_ADD_LONG_2ADDR && op <= opcodes::OP_USHR_LONG_2ADDR) ||
+                   (op >= opcodes::OP_ADD_DOUBLE_2ADDR && op <= opcodes::OP_REM_DOUBLE_2ADDR);
+        }
+    }
+
+    /// @brief Check if the first register read by an instruction is wide
+    bool reads_wide(std::uint32_t op)
+    {
+        switch (op)
+        {
+        case opcodes::OP_MOVE_WIDE:
+        case opcodes::OP_MOVE_WIDE_FROM16:
+        case opcodes::OP_MOVE_WIDE_16:
+        case opcodes::OP_RETURN_WIDE:
+        case opcodes::OP_APUT_WIDE:
+        case opcodes::OP_IPUT_WIDE:
+        case opcodes::OP_SPUT_WIDE:
+        case opcodes::OP_CMPL_DOUBLE:
+        case opcodes::OP_CMPG_DOUBLE:
+        case opcodes::OP_CMP_LONG:
+        case opcodes::OP_NEG_LONG:
+        case opcodes::OP_NOT_LONG:
+        case opcodes::OP_NEG_DOUBLE:
+        case opcodes::OP_LONG_TO_INT:
+        case opcodes::OP_LONG_TO_FLOAT:
+        case opcodes::OP_LONG_TO_DOUBLE:
+        case opcodes::OP_DOUBLE_TO_INT:
+        case opcodes::OP_DOUBLE_TO_LONG:
+        case opcodes::OP_DOUBLE_TO_FLOAT:
+            return true;
+        default:
+            return (op >= opcodes::OP_ADD_LONG && op <= opcodes::OP_USHR_LONG) ||
+                   (op >= opcodes::OP_ADD_DOUBLE && op <= opcodes::OP_REM_DOUBLE) ||
+                   (op >= opcodes::OP_ADD_LONG_2ADDR && op <= opcodes::OP_USHR_LONG_2ADDR) ||
+                   (op >= opcodes::OP_ADD_DOUBLE_2ADDR && op <= opcodes::OP_REM_DOUBLE_2ADDR);
+        }
+    }
+
+    /// @brief Check if the second register read by an instruction is wide,
+    /// the shifts of long values take the amount as an int
+    bool reads_wide_second(std::uint32_t op)
+    {
+        if (op == opcodes::OP_CMPL_DOUBLE || op == opcodes::OP_CMPG_DOUBLE || op == opcodes::OP_CMP_LONG)
+            return true;
+        return (op >= opcodes::OP_ADD_LONG && op <= opcodes::OP_REM_LONG) ||
+               (op >= opcodes::OP_AND_LONG && op <= opcodes::OP_XOR_LONG) ||
+               (op >= opcodes::OP_ADD_DOUBLE && op <= opcodes::OP_REM_DOUBLE) ||
+               (op >= opcodes::OP_ADD_LONG_2ADDR && op <= opcodes::OP_XOR_LONG_2ADDR) ||
+               (op >= opcodes::OP_ADD_DOUBLE_2ADDR && op <= opcodes::OP_REM_DOUBLE_2ADDR);
+    }
+
+    /// @brief Add a register, and the next one for wide values
+    void add_register(std::vector<std::uint16_t> &list, std::uint32_t reg, bool wide)
+    {
+        list.push_back(static_cast<std::uint16_t>(reg));
+        if (wide)
+            list.push_back(static_cast<std::uint16_t>(reg + 1));
+    }
+}
+
+void BitVector::fill()
+{
+    std::fill(words.begin(), words.end(), ~std::uint64_t(0));
+
+    // the bits after the size are kept to 0
+    if (bits % 64)
+        words.back() = (std::uint64_t(1) << (bits % 64)) - 1;
+}
+
+bool BitVector::none() const
+{
+    return std::all_of(words.begin(), words.end(), [](std::uint64_t word)
+                       { return word == 0; });
+}
+
+std::size_t BitVector::count() const
+{
+    std::size_t result = 0;
+    for (auto word : words)
+        result += static_cast<std::size_t>(std::popcount(word));
+    return result;
+}
+
+bool BitVector::union_with(const BitVector &other)
+{
+    std::uint64_t changed = 0;
+
+    for (std::size_t i = 0; i < words.size(); i++)
+    {
+        auto word = words[i] | other.words[i];
+        changed |= word ^ words[i];
+        words[i] = word;
+    }
+
+    return changed != 0;
+}
+
+bool BitVector::intersect_with(const BitVector &other)
+{
+    std::uint64_t changed = 0;
+
+    for (std::size_t i = 0; i < words.size(); i++)
+    {
+        auto word = words[i] & other.words[i];
+        changed |= word ^ words[i];
+        words[i] = word;
+    }
+
+    return changed != 0;
+}
+
+void BitVector::subtract(const BitVector &other)
+{
+    for (std::size_t i = 0; i < words.size(); i++)
+        words[i] &= ~other.words[i];
+}
+
+RegisterAccesses::RegisterAccesses(MethodAnalysis *method)
+    : instructions(method->get_instructions()), number_of_registers(0), first_parameter(0)
+{
+    if (!method->external())
+    {
+        number_of_registers = method->get_number_of_registers();
+
+        auto incoming = std::get<EncodedMethod *>(method->get_encoded_method())->get_code_item().get_incomings_args();
+
+        first_parameter = number_of_registers - std::min<std::uint32_t>(incoming, number_of_registers);
+    }
+
+    std::vector<std::uint16_t> written, read;
+
+    def_offsets.reserve(instructions.size() + 1);
+    use_offsets.reserve(instructions.size() + 1);
+
+    def_offsets.push_back(0);
+    use_offsets.push_back(0);
+
+    for (auto instr : instructions)
+    {
+        written.clear();
+        read.clear();
+
+        get_registers(instr, written, read);
+
+        for (auto reg : written)
+            if (reg < number_of_registers)
+                defs.push_back(reg);
+
+        for (auto reg : read)
+            if (reg < number_of_registers)
+                uses.push_back(reg);
+
+        def_offsets.push_back(static_cast<std::uint32_t>(defs.size()));
+        use_offsets.push_back(static_cast<std::uint32_t>(uses.size()));
+    }
+}
+
+void RegisterAccesses::get_registers(Instruction *instr,
+                                     std::vector<std::uint16_t> &written,
+                                     std::vector<std::uint16_t> &read)
+{
+    auto op = instr->get_instruction_opcode();
+
+    switch (instr->get_instruction_type())
+    {
+    case dexinsttype_t::DEX_INSTRUCTION12X:
+    {
+        auto i = reinterpret_cast<Instruction12x *>(instr);
+
+        // the operations /2addr read and write the first register
+        if (op >= opcodes::OP_ADD_INT_2ADDR && op <= opcodes::OP_REM_DOUBLE_2ADDR)
+            add_register(read, i->get_destination(), writes_wide(op));
+        add_register(read, i->get_source(), op >= opcodes::OP_ADD_INT_2ADDR ? reads_wide_second(op) : reads_wide(op));
+        add_register(written, i->get_destination(), writes_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION11N:
+        add_register(written, reinterpret_cast<Instruction11n *>(instr)->get_destination(), false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION11X:
+    {
+        auto reg = reinterpret_cast<Instruction11x *>(instr)->get_destination();
+
+        // move-result and move-exception write the register, return,
+        // throw and the monitors read it
+        if (op >= opcodes::OP_MOVE_RESULT && op <= opcodes::OP_MOVE_EXCEPTION)
+            add_register(written, reg, writes_wide(op));
+        else
+            add_register(read, reg, reads_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22X:
+    {
+        auto i = reinterpret_cast<Instruction22x *>(instr);
+        add_register(read, i->get_source(), reads_wide(op));
+        add_register(written, i->get_destination(), writes_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION32X:
+    {
+        auto i = reinterpret_cast<Instruction32x *>(instr);
+        add_register(read, i->get_source(), reads_wide(op));
+        add_register(written, i->get_destination(), writes_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION21T:
+        add_register(read, reinterpret_cast<Instruction21t *>(instr)->get_check_reg(), false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION21S:
+        add_register(written, reinterpret_cast<Instruction21s *>(instr)->get_destination(), writes_wide(op));
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION21H:
+        add_register(written, reinterpret_cast<Instruction21h *>(instr)->get_destination(), writes_wide(op));
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION31I:
+        add_register(written, reinterpret_cast<Instruction31i *>(instr)->get_destination(), writes_wide(op));
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION31C:
+        add_register(written, reinterpret_cast<Instruction31c *>(instr)->get_destination(), false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION51L:
+        add_register(written, reinterpret_cast<Instruction51l *>(instr)->get_first_register(), true);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION21C:
+    {
+        auto reg = reinterpret_cast<Instruction21c *>(instr)->get_destination();
+
+        // check-cast does not change the value of the register
+        if ((op >= opcodes::OP_SPUT && op <= opcodes::OP_SPUT_SHORT) || op == opcodes::OP_CHECK_CAST)
+            add_register(read, reg, reads_wide(op));
+        else
+            add_register(written, reg, writes_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION23X:
+    {
+        auto i = reinterpret_cast<Instruction23x *>(instr);
+
+        if (op >= opcodes::OP_APUT && op <= opcodes::OP_APUT_SHORT)
+        {
+            add_register(read, i->get_destination(), reads_wide(op));
+            add_register(read, i->get_first_source(), false);
+            add_register(read, i->get_second_source(), false);
+            break;
+        }
+
+        // aget reads the array and the index
+        auto array_get = op >= opcodes::OP_AGET && op <= opcodes::OP_AGET_SHORT;
+
+        add_register(read, i->get_first_source(), !array_get && reads_wide(op));
+        add_register(read, i->get_second_source(), !array_get && reads_wide_second(op));
+        add_register(written, i->get_destination(), writes_wide(op));
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22B:
+    {
+        auto i = reinterpret_cast<Instruction22b *>(instr);
+        add_register(read, i->get_first_operand(), false);
+        add_register(written, i->get_destination(), false);
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22S:
+    {
+        auto i = reinterpret_cast<Instruction22s *>(instr);
+        add_register(read, i->get_first_operand(), false);
+        add_register(written, i->get_destination(), false);
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22T:
+    {
+        auto i = reinterpret_cast<Instruction22t *>(instr);
+        add_register(read, i->get_first_operand(), false);
+        add_register(read, i->get_second_operand(), false);
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22C:
+    {
+        auto i = reinterpret_cast<Instruction22c *>(instr);
+
+        if (op >= opcodes::OP_IPUT && op <= opcodes::OP_IPUT_SHORT)
+        {
+            add_register(read, i->get_destination(), reads_wide(op));
+            add_register(read, i->get_operand(), false);
+        }
+        else
+        {
+            add_register(read, i->get_operand(), false);
+            add_register(written, i->get_destination(), writes_wide(op));
+        }
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION22CS:
+    {
+        // odex quick field accesses, both registers are taken as read
+        auto i = reinterpret_cast<Instruction22cs *>(instr);
+        add_register(read, i->get_register_A(), false);
+        add_register(read, i->get_register_B(), false);
+        break;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION31T:
+        add_register(read, reinterpret_cast<Instruction31t *>(instr)->get_ref_register(), false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION35C:
+        for (auto reg : reinterpret_cast<Instruction35c *>(instr)->get_registers())
+            add_register(read, reg, false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION45CC:
+        for (auto reg : reinterpret_cast<Instruction45cc *>(instr)->get_registers())
+            add_register(read, reg, false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION3RC:
+        for (auto reg : reinterpret_cast<Instruction3rc *>(instr)->get_registers())
+            add_register(read, reg, false);
+        break;
+    case dexinsttype_t::DEX_INSTRUCTION4RCC:
+        for (auto reg : reinterpret_cast<Instruction4rcc *>(instr)->get_registers())
+            add_register(read, reg, false);
+        break;
+    default:
+        // nop, gotos, payloads and incorrect instructions
+        break;
+    }
+}
+
+std::uint32_t RegisterAccesses::get_index(const Instruction *instr) const
+{
+    auto address = instr->get_address();
+
+    auto it = std::lower_bound(instructions.begin(), instructions.end(), address,
+                               [](const Instruction *a, std::uint64_t addr)
+                               { return a->get_address() < addr; });
+
+    if (it == instructions.end() || *it != instr)
+        return static_cast<std::uint32_t>(instructions.size());
+
+    return static_cast<std::uint32_t>(it - instructions.begin());
+}
+
+DataFlowAnalysis::DataFlowAnalysis(const BasicBlocks &blocks, direction_t direction,
+                                   meet_t meet, std::size_t number_of_bits)
+    : blocks(blocks), direction(direction), meet(meet), number_of_bits(number_of_bits),
+      boundary(number_of_bits)
+{
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    gen.assign(number_of_blocks, BitVector(number_of_bits));
+    kill.assign(number_of_blocks, BitVector(number_of_bits));
+    in.assign(number_of_blocks, BitVector(number_of_bits));
+    out.assign(number_of_blocks, BitVector(number_of_bits));
+    exception_gen.assign(number_of_blocks, BitVector(number_of_bits));
+
+    auto start = std::numeric_limits<block_id_t>::max();
+
+    for (auto node : blocks.get_nodes())
+    {
+        if (node->is_start_block())
+        {
+            start = node->get_id();
+            break;
+        }
+    }
+
+    if (start == std::numeric_limits<block_id_t>::max())
+        return;
+
+    // iterative depth first search for the postorder
+    std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+    std::vector<std::uint8_t> visited(number_of_blocks, 0);
+
+    stack.emplace_back(start, 0);
+    visited[start] = 1;
+
+    while (!stack.empty())
+    {
+        auto &[id, next] = stack.back();
+        auto sucessors = blocks.get_sucessor_ids(id);
+        auto handlers = blocks.get_exception_sucessor_ids(id);
+
+        // the handlers go after the normal sucessors
+        if (next < sucessors.size() + handlers.size())
+        {
+            auto suc = next < sucessors.size() ? sucessors[next] : handlers[next - sucessors.size()];
+            next++;
+
+            if (!visited[suc])
+            {
+                visited[suc] = 1;
+                stack.emplace_back(suc, 0);
+            }
+            continue;
+        }
+
+        order.push_back(id);
+        stack.pop_back();
+    }
+
+    std::reverse(order.begin(), order.end());
+}
+
+void DataFlowAnalysis::solve()
+{
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    std::vector<std::uint8_t> reachable(number_of_blocks, 0);
+    std::vector<std::uint8_t> pending(number_of_blocks, 0);
+
+    for (auto id : order)
+    {
+        reachable[id] = 1;
+        pending[id] = 1;
+
+        // the intersection starts from the top value
+        if (meet == meet_t::INTERSECTION)
+        {
+            in[id].fill();
+            out[id].fill();
+        }
+        else
+        {
+            in[id].clear();
+            out[id].clear();
+        }
+    }
+
+    bool forward = direction == direction_t::FORWARD;
+
+    // the backward problems go through the blocks in postorder
+    std::vector<block_id_t> visit(order);
+
+    if (!forward)
+        std::reverse(visit.begin(), visit.end());
+
+    BitVector joined(number_of_bits), result(number_of_bits), thrown(number_of_bits);
+
+    iterations = 0;
+
+    bool remaining = !visit.empty();
+
+    auto join = [&](const BitVector &value, bool &first)
+    {
+        if (first)
+            joined = value;
+        else if (meet == meet_t::UNION)
+            joined.union_with(value);
+        else
+            joined.intersect_with(value);
+
+        first = false;
+    };
+
+    auto push = [&](std::span<const block_id_t> targets)
+    {
+        for (auto target : targets)
+        {
+            if (reachable[target] && !pending[target])
+            {
+                pending[target] = 1;
+                remaining = true;
+            }
+        }
+    };
+
+    while (remaining)
+    {
+        remaining = false;
+
+        for (auto id : visit)
+        {
+            if (!pending[id])
+                continue;
+
+            pending[id] = 0;
+            iterations++;
+
+            // meet of the values that come from the neighbours
+            bool first = true;
+
+            for (auto source : forward ? blocks.get_predecessor_ids(id) : blocks.get_sucessor_ids(id))
+            {
+                if (!reachable[source])
+                    continue;
+
+                // the values of a handler only come from the blocks that throw
+                if (blocks.is_reached_by_exceptions_only(forward ? id : source))
+                    continue;
+
+                join(forward ? out[source] : in[source], first);
+            }
+
+            // forward, the values of the blocks that throw to the handler
+            if (forward)
+            {
+                for (auto source : blocks.get_exception_predecessor_ids(id))
+                {
+                    if (!reachable[source])
+                        continue;
+
+                    thrown = in[source];
+
+                    if (meet == meet_t::UNION)
+                    {
+                        thrown.union_with(out[source]);
+                        thrown.union_with(exception_gen[source]);
+                    }
+                    else
+                        thrown.intersect_with(out[source]);
+
+                    join(thrown, first);
+                }
+            }
+
+            if (first)
+                joined = boundary;
+
+            // transfer function of the block
+            result = joined;
+            result.subtract(kill[id]);
+            result.union_with(gen[id]);
+
+            // backward, the values live at the handlers of the block
+            if (!forward)
+            {
+                for (auto handler : blocks.get_exception_sucessor_ids(id))
+                {
+                    if (!reachable[handler])
+                        continue;
+
+                    if (meet == meet_t::UNION)
+                        result.union_with(in[handler]);
+                    else
+                        result.intersect_with(in[handler]);
+                }
+            }
+
+            auto &input = forward ? in[id] : out[id];
+            auto &output = forward ? out[id] : in[id];
+
+            bool input_changed = joined != input;
+
+            input = joined;
+
+            if (result == output)
+            {
+                // the handlers also see the value at the start of the block
+                if (forward && input_changed)
+                    push(blocks.get_exception_sucessor_ids(id));
+                continue;
+            }
+
+            output = result;
+
+            if (forward)
+            {
+                push(blocks.get_sucessor_ids(id));
+                push(blocks.get_exception_sucessor_ids(id));
+            }
+            else
+            {
+                push(blocks.get_predecessor_ids(id));
+                push(blocks.get_exception_predecessor_ids(id));
+            }
+        }
+    }
+}
+
+LivenessAnalysis::LivenessAnalysis(MethodAnalysis *method, const RegisterAccesses &accesses)
+    : DataFlowAnalysis(method->get_basic_blocks(), direction_t::BACKWARD, meet_t::UNION,
+                       accesses.get_number_of_registers())
+{
+    const auto &instructions = accesses.get_instructions();
+
+    for (auto block : blocks.get_nodes())
+    {
+        auto &block_instructions = block->get_instructions();
+
+        if (block_instructions.empty())
+            continue;
+
+        auto &uses = gen[block->get_id()];
+        auto &defs = kill[block->get_id()];
+
+        auto index = accesses.get_index(block_instructions.front());
+
+        for (auto instr : block_instructions)
+        {
+            if (index >= instructions.size() || instructions[index] != instr)
+                index = accesses.get_index(instr);
+
+            // the registers read before being written in the block
+            for (auto reg : accesses.get_uses(index))
+                if (!defs.test(reg))
+                    uses.set(reg);
+
+            for (auto reg : accesses.get_defs(index))
+                defs.set(reg);
+
+            index++;
+        }
+    }
+
+    solve();
+}
+
+ReachingDefinitions::ReachingDefinitions(MethodAnalysis *method, const RegisterAccesses &accesses)
+    : DataFlowAnalysis(method->get_basic_blocks(), direction_t::FORWARD, meet_t::UNION,
+                       accesses.get_number_of_registers() - accesses.get_first_parameter() +
+                           accesses.get_number_of_defs()),
+      accesses(accesses)
+{
+    auto number_of_registers = accesses.get_number_of_registers();
+    const auto &instructions = accesses.get_instructions();
+
+    definitions.reserve(number_of_bits);
+
+    // the parameters are defined when the method starts
+    for (auto reg = accesses.get_first_parameter(); reg < number_of_registers; reg++)
+    {
+        boundary.set(definitions.size());
+        definitions.push_back({parameter, static_cast<std::uint16_t>(reg)});
+    }
+
+    number_of_parameters = static_cast<std::uint32_t>(definitions.size());
+
+    for (std::uint32_t i = 0; i < instructions.size(); i++)
+        for (auto reg : accesses.get_defs(i))
+            definitions.push_back({i, reg});
+
+    // definitions grouped by register
+    register_offsets.assign(number_of_registers + 1, 0);
+
+    for (const auto &def : definitions)
+        register_offsets[def.reg + 1]++;
+
+    for (std::uint32_t i = 0; i < number_of_registers; i++)
+        register_offsets[i + 1] += register_offsets[i];
+
+    register_defs.resize(definitions.size());
+
+    std::vector<std::uint32_t> next_def(register_offsets.begin(), register_offsets.end() - 1);
+
+    for (def_id_t def = 0; def < definitions.size(); def++)
+        register_defs[next_def[definitions[def].reg]++] = def;
+
+    for (auto block : blocks.get_nodes())
+    {
+        auto &block_instructions = block->get_instructions();
+
+        if (block_instructions.empty())
+            continue;
+
+        auto &generated = gen[block->get_id()];
+        auto &killed = kill[block->get_id()];
+
+        auto index = accesses.get_index(block_instructions.front());
+
+        for (auto instr : block_instructions)
+        {
+            if (index >= instructions.size() || instructions[index] != instr)
+                index = accesses.get_index(instr);
+
+            // only the last definition of a register leaves the block,
+            // but all of them reach the handlers
+            transfer(index, generated);
+
+            for (auto def = get_first_definition(index); def < get_first_definition(index + 1); def++)
+                exception_gen[block->get_id()].set(def);
+
+            for (auto reg : accesses.get_defs(index))
+                for (auto def : get_definitions_of(reg))
+                    killed.set(def);
+
+            index++;
+        }
+    }
+
+    solve();
+}
+
+void ReachingDefinitions::transfer(std::uint32_t index, BitVector &reaching) const
+{
+    auto def = get_first_definition(index);
+
+    for (auto reg : accesses.get_defs(index))
+    {
+        for (auto other : get_definitions_of(reg))
+            reaching.reset(other);
+
+        reaching.set(def++);
+    }
+}
+
+DefUseChains::DefUseChains(MethodAnalysis *method)
+    : accesses(method), reaching(method, accesses)
+{
+    const auto &instructions = accesses.get_instructions();
+    const auto &blocks = method->get_basic_blocks();
+
+    uses.reserve(accesses.get_number_of_uses());
+
+    for (std::uint32_t i = 0; i < instructions.size(); i++)
+        for (auto reg : accesses.get_uses(i))
+            uses.push_back({i, reg});
+
+    // pairs of use and definition, found walking the blocks
+    std::vector<std::pair<use_id_t, def_id_t>> chains;
+    BitVector current;
+
+    for (auto id : reaching.get_order())
+    {
+        auto &block_instructions = blocks.get_block(id)->get_instructions();
+
+        if (block_instructions.empty())
+            continue;
+
+        current = reaching.get_in(id);
+
+        auto index = accesses.get_index(block_instructions.front());
+
+        for (auto instr : block_instructions)
+        {
+            if (index >= instructions.size() || instructions[index] != instr)
+                index = accesses.get_index(instr);
+
+            auto use = accesses.get_first_use(index);
+
+            for (auto reg : accesses.get_uses(index))
+            {
+                for (auto def : reaching.get_definitions_of(reg))
+                    if (current.test(def))
+                        chains.emplace_back(use, def);
+                use++;
+            }
+
+            reaching.transfer(index, current);
+
+            index++;
+        }
+    }
+
+    // definitions of each use
+    use_offsets.assign(uses.size() + 1, 0);
+
+    for (const auto &[use, def] : chains)
+        use_offsets[use + 1]++;
+
+    for (std::size_t i = 0; i < uses.size(); i++)
+        use_offsets[i + 1] += use_offsets[i];
+
+    use_defs.resize(chains.size());
+
+    std::vector<std::uint32_t> next(use_offsets.begin(), use_offsets.end() - 1);
+
+    for (const auto &[use, def] : chains)
+        use_defs[next[use]++] = def;
+
+    // uses of each definition, in the order of the uses
+    auto number_of_defs = reaching.get_definitions().size();
+
+    def_offsets.assign(number_of_defs + 1, 0);
+
+    for (auto def : use_defs)
+        def_offsets[def + 1]++;
+
+    for (std::size_t i = 0; i < number_of_defs; i++)
+        def_offsets[i + 1] += def_offsets[i];
+
+    def_uses.resize(use_defs.size());
+
+    next.assign(def_offsets.begin(), def_offsets.end() - 1);
+
+    for (use_id_t use = 0; use < uses.size(); use++)
+        for (auto def : get_definitions_of(use))
+            def_uses[next[def]++] = use;
+}
+
+std::span<const DefUseChains::def_id_t> DefUseChains::get_definitions_of(const Instruction *instr, std::uint16_t reg) const
+{
+    auto index = accesses.get_index(instr);
+
+    if (index >= accesses.size())
+        return {};
+
+    auto use = accesses.get_first_use(index);
+
+    for (auto used : accesses.get_uses(index))
+    {
+        if (used == reg)
+            return get_definitions_of(use);
+        use++;
+    }
+
+    return {};
+}
@@ -7,22 +7,32 @@
 
 #include "Kunai/DEX/analysis/dex_analysis.hpp"
 #include "Kunai/Utils/logger.hpp"
+#include "Kunai/Utils/parallel.hpp"
 
-#include <regex>
+#include <algorithm>
 
 using namespace KUNAI::DEX;
 
-void Analysis::add(Parser *parser)
+void Analysis::add(Parser *parser, DexDisassembler *parser_disassembler)
 {
     auto logger = LOGGER::logger();
 
     parsers.push_back(parser);
+    search_index.outdated = true;
+
+    auto &parser_symbols = symbols.add_parser(parser);
+
+    class_analyses.resize(symbols.get_number_of_classes(), nullptr);
+    method_analyses.resize(symbols.get_number_of_methods(), nullptr);
+    string_analyses.resize(symbols.get_number_of_strings(), nullptr);
+    field_analyses.resize(symbols.get_number_of_fields(), nullptr);
 
     auto &class_dex = parser->get_classes();
 
     logger->debug("Addind to the analysis {} number of classes", class_dex.get_number_of_classes());
 
-    auto & all_methods_instructions = disassembler->get_dex_instructions();
+    if (parser_disassembler == nullptr)
+        parser_disassembler = disassembler;
 
     for (auto &class_def_item : class_dex.get_classdefs())
     {
@@ -31,6 +41,14 @@ void Analysis::add(Parser *parser)
         classes[name] = std::make_unique<ClassAnalysis>(class_def_item.get());
         auto &new_class = classes[name];
 
+        auto class_id = symbols.find_class(name);
+
+        if (class_id != SymbolTable::no_symbol)
+        {
+            class_analyses[class_id] = new_class.get();
+            new_class->set_xref_table(&xref_table, class_id);
+        }
+
         // get the class data item to retrieve the methods
         auto &class_data_item = class_def_item->get_class_data_item();
 
@@ -42,20 +60,98 @@ void Analysis::add(Parser *parser)
             /// now create a method analysis
             auto method_name = method_id->pretty_method();
 
-            methods[method_name] = std::make_unique<MethodAnalysis>(encoded_method, all_methods_instructions[encoded_method]);
+            methods[method_name] = std::make_unique<MethodAnalysis>(encoded_method, parser_disassembler);
             auto new_method = methods[method_name].get();
 
             new_class->add_method(new_method);
-            // maybe not needed method_hashes
-            auto hash = name + method_id->get_name() + method_id->get_proto()->get_shorty_idx();
-            method_hashes[hash] = new_method;
+
+            auto id = symbols.find_method(SymbolTable::method_name(method_id));
+
+            if (id != SymbolTable::no_symbol)
+            {
+                method_analyses[id] = new_method;
+                new_method->set_xref_table(&xref_table, id);
+            }
         }
     }
 
+    logger->debug("Analysis: {} classes, {} methods and {} strings referenced by the dex file",
+                  parser_symbols.types.size(), parser_symbols.methods.size(), parser_symbols.strings.size());
+
     logger->info("Analysis: correctly added parser to analysis object");
 }
 
-void Analysis::create_xrefs()
+void Analysis::create_all_basic_blocks(unsigned threads)
+{
+    auto logger = LOGGER::logger();
+
+    // pair of size of the bytecode and method
+    std::vector<std::pair<std::size_t, MethodAnalysis *>> pending;
+
+    pending.reserve(methods.size());
+
+    // the names are created by the instructions the first time
+    // they are needed, create them before using the threads, the
+    // basic blocks of each method disassemble it in its thread
+    for (auto parser : parsers)
+        parser->create_pretty_names();
+
+    for (auto &method : methods)
+    {
+        auto method_analysis = method.second.get();
+
+        if (method_analysis->external())
+            continue;
+
+        auto &bytecode = std::get<EncodedMethod *>(method_analysis->get_encoded_method())->get_code_item().get_bytecode();
+
+        if (bytecode.empty())
+            continue;
+
+        pending.emplace_back(bytecode.size(), method_analysis);
+    }
+
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const auto &a, const auto &b)
+                     { return a.first > b.first; });
+
+    logger->info("create_all_basic_blocks: creating the basic blocks of {} methods", pending.size());
+
+    parallel::parallel_for(
+        pending.size(), [&](std::size_t i, unsigned)
+        { pending[i].second->create_basic_blocks(); },
+        threads);
+
+    logger->info("create_all_basic_blocks: finished creating the basic blocks");
+}
+
+MethodMetrics Analysis::compute_method_metrics(unsigned threads)
+{
+    auto logger = LOGGER::logger();
+
+    MethodMetrics metrics;
+    std::vector<MethodAnalysis *> rows;
+
+    create_all_basic_blocks(threads);
+
+    for (auto &method : methods)
+        if (!method.second->external())
+            rows.push_back(method.second.get());
+
+    metrics.set_methods(std::move(rows));
+
+    logger->info("compute_method_metrics: computing the metrics of {} methods", metrics.size());
+
+    // every task writes only its own row
+    parallel::parallel_for(
+        metrics.size(), [&](std::size_t i, unsigned)
+        { metrics.compute_row(i); },
+        threads);
+
+    return metrics;
+}
+
+void Analysis::create_xrefs(unsigned threads)
 {
     auto logger = LOGGER::logger();
 
@@ -69,303 +165,427 @@ void Analysis::create_xrefs()
     }
 
     created_xrefs = true;
+    search_index.outdated = true;
 
     logger->debug("create_xref(): creating xrefs for {} dex files", parsers.size());
 
+    // one task per method, in the order of the parsers and classes
+    struct task_t
+    {
+        const SymbolTable::parser_symbols_t *parser_symbols;
+        SymbolTable::symbol_id_t class_id;
+        ClassAnalysis *class_analysis;
+        MethodAnalysis *method_analysis;
+    };
+
+    std::vector<task_t> tasks;
+
+    // the names are created by the instructions the first time
+    // they are needed, create them before using the threads, each
+    // thread disassembles the methods it scans
     for (auto parser : parsers)
+        parser->create_pretty_names();
+
+    for (size_t i = 0; i < parsers.size(); i++)
     {
-        static size_t i = 0;
-        logger->debug("Analyzing {} parser", i++);
+        logger->debug("Analyzing {} parser", i);
 
-        auto &class_dex = parser->get_classes();
-        auto &class_def_items = class_dex.get_classdefs();
+        auto &class_dex = parsers[i]->get_classes();
+        auto &parser_symbols = symbols.get_parsers()[i];
 
         logger->debug("Number of classes to analyze: {}", class_dex.get_number_of_classes());
 
-        for (auto &class_def_item : class_def_items)
+        for (auto &class_def_item : class_dex.get_classdefs())
         {
-            static size_t j = 0;
-            logger->debug("Analyzing class number {}", j++);
+            auto class_id = symbols.find_class(class_def_item->get_class_idx()->get_name());
+            auto class_analysis = class_analyses[class_id];
 
-            _create_xrefs(class_def_item.get());
+            for (auto &method : class_def_item->get_class_data_item().get_methods())
+            {
+                auto it = methods.find(method->getMethodID()->pretty_method());
+
+                if (it == methods.end() || it->second->get_symbol_id() == SymbolTable::no_symbol)
+                    continue;
+
+                tasks.push_back({&parser_symbols, class_id, class_analysis, it->second.get()});
+            }
         }
     }
 
+    logger->debug("create_xref(): scanning {} methods", tasks.size());
+
+    // every task writes only its own bucket
+    std::vector<std::vector<pending_xref_t>> buckets(tasks.size());
+
+    parallel::parallel_for(
+        tasks.size(), [&](std::size_t i, unsigned)
+        { _scan_xrefs(*tasks[i].parser_symbols, tasks[i].class_id, tasks[i].method_analysis, buckets[i]); },
+        threads);
+
+    // the external classes, methods and strings are created
+    // in the same order than with just one thread
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        for (const auto &xref : buckets[i])
+            _apply_xref(tasks[i].class_analysis, tasks[i].method_analysis, xref);
+
+        std::vector<pending_xref_t>().swap(buckets[i]);
+    }
+
+    xref_table.finish();
+
+    logger->debug("create_xref(): {} xrefs after removing the repeated ones", xref_table.get_xrefs().size());
+
     logger->info("Cross-references correctly created");
 }
 
-void Analysis::_create_xrefs(ClassDef *current_class)
+CallGraph Analysis::build_call_graph(const ClassHierarchy *hierarchy, ClassHierarchy::dispatch_t mode) const
 {
     auto logger = LOGGER::logger();
 
-    /// take the name of the analyzed class
-    auto &current_class_name = current_class->get_class_idx()->get_name();
-    auto &class_data_item = current_class->get_class_data_item();
+    if (xref_table.get_xrefs().empty())
+        logger->warn("build_call_graph(): there are no xrefs, call create_xrefs() first");
 
-    auto class_analysis_working_on = classes[current_class_name].get();
+    CallGraph call_graph(xref_table, symbols.get_number_of_methods(), hierarchy, mode);
 
-    /// get all the methods
-    auto &current_methods = class_data_item.get_methods();
+    logger->info("build_call_graph(): {} methods, {} calls and {} strongly connected components",
+                 call_graph.get_number_of_nodes(), call_graph.get_number_of_edges(),
+                 call_graph.get_number_of_components());
 
-    for (auto &method : current_methods)
-    {
-        // Obtain the MethodAnalysis*
-        auto current_method_analysis = methods[method->getMethodID()->pretty_method()].get();
+    return call_graph;
+}
 
-        for (auto &instr : current_method_analysis->get_instructions())
-        {
-            auto off = instr->get_address();
-            auto instruction = instr.get();
-            auto op_value = instr->get_instruction_opcode();
+ClassHierarchy Analysis::build_class_hierarchy() const
+{
+    auto logger = LOGGER::logger();
 
-            // check for: `const-class` and `new-instance` instructions
-            if (op_value == TYPES::opcodes::OP_CONST_CLASS ||
-                op_value == TYPES::opcodes::OP_NEW_INSTANCE)
-            {
-                auto const_class_new_instance = reinterpret_cast<Instruction21c *>(instruction);
+    if (xref_table.get_xrefs().empty())
+        logger->warn("build_class_hierarchy(): there are no xrefs, call create_xrefs() first");
 
-                // check we get a TYPE from CONST_CLASS
-                // or from NEW_INSTANCE, any other Kind (FIELD, PROTO, etc)
-                // it is not valid in this case
-                if (const_class_new_instance->get_kind() != TYPES::Kind::TYPE ||
-                    const_class_new_instance->get_source_dvmtype()->get_type() != DVMType::CLASS)
-                    continue;
+    return ClassHierarchy(symbols, class_analyses, method_analyses, xref_table);
+}
 
-                auto cls_name = const_class_new_instance->get_source_dvmclass()->get_name();
+std::vector<Analysis::string_match_t> Analysis::scan_strings(const PatternSet &patterns, bool only_used, unsigned threads) const
+{
+    auto logger = LOGGER::logger();
 
-                // avoid analyzing our own class name
-                if (cls_name == current_class_name)
-                    continue;
+    // strings checked by each task
+    constexpr std::size_t strings_per_task = 1024;
 
-                // if the name of the class is not already in the classes,
-                // probably we are treating with an external class
-                if (classes.find(cls_name) == classes.end())
-                {
-                    external_classes[cls_name] = std::make_unique<ExternalClass>(cls_name);
-                    classes[cls_name] = std::make_unique<ClassAnalysis>(external_classes[cls_name].get());
-                }
-
-                auto oth_cls = classes[cls_name].get();
-
-                /// add the cross references
-                class_analysis_working_on->add_xref_to(static_cast<TYPES::REF_TYPE>(op_value),
-                                                       oth_cls, current_method_analysis, off);
-                oth_cls->add_xref_from(static_cast<TYPES::REF_TYPE>(op_value),
-                                       class_analysis_working_on, current_method_analysis, off);
-
-                /// check if is a const-class
-                if (op_value == TYPES::opcodes::OP_CONST_CLASS)
-                {
-                    current_method_analysis->add_xrefconstclass(oth_cls, off);
-                    oth_cls->add_xref_const_class(current_method_analysis, off);
-                }
-                /// check if it is a new instance
-                else if (op_value == TYPES::opcodes::OP_NEW_INSTANCE)
-                {
-                    current_method_analysis->add_xrefnewinstance(oth_cls, off);
-                    oth_cls->add_xref_new_instance(current_method_analysis, off);
-                }
-            }
+    auto number_of_strings = symbols.get_number_of_strings();
+
+    if (only_used && xref_table.get_xrefs().empty())
+        logger->warn("scan_strings(): there are no xrefs, call create_xrefs() first");
+
+    // every task writes only its own block, so the
+    // matches are in the order of the string ids
+    std::vector<std::vector<string_match_t>> blocks((number_of_strings + strings_per_task - 1) / strings_per_task);
 
-            /// check for instructions like: invoke-*
-            else if (TYPES::opcodes::OP_INVOKE_VIRTUAL <= op_value &&
-                     op_value <= TYPES::opcodes::OP_INVOKE_INTERFACE)
+    parallel::parallel_for(
+        blocks.size(), [&](std::size_t task, unsigned)
+        {
+            auto last = std::min(number_of_strings, (task + 1) * strings_per_task);
+
+            for (auto i = task * strings_per_task; i < last; i++)
             {
-                auto invoke_ = reinterpret_cast<Instruction35c *>(instruction);
+                auto id = static_cast<SymbolTable::symbol_id_t>(i);
+                auto sites = xref_table.get_xrefs_to(XrefTable::xref_kind_t::STRING, id);
 
-                // get the invoke of method
-                if (invoke_->get_kind() != TYPES::Kind::METH)
+                if (only_used && sites.empty())
                     continue;
 
-                /// check that called method comes from a class
-                /// (not from other type like an Array)
-                if (invoke_->get_method()->get_class()->get_type() != DVMType::CLASS)
-                {
-                    logger->warn("Found a call to a method from non class (type found {})",
-                                 invoke_->get_method()->get_class()->print_type());
-                    continue;
-                }
+                patterns.scan(symbols.get_string(id), [&](PatternSet::pattern_t pattern, std::uint32_t offset)
+                              { blocks[task].push_back({id, pattern, offset, sites}); });
+            } },
+        threads);
 
-                auto method_called = invoke_->get_method();
+    std::vector<string_match_t> matches;
 
-                auto &cls_name = reinterpret_cast<DVMClass *>(method_called->get_class())->get_name();
-                auto &method_name = method_called->get_name();
-                auto &proto = method_called->get_proto()->get_shorty_idx();
+    for (auto &block : blocks)
+        matches.insert(matches.end(), block.begin(), block.end());
 
-                /// information of method and class called
-                auto oth_meth = _resolve_method(cls_name, method_name, proto);
-                auto oth_cls = classes[cls_name].get();
+    logger->info("scan_strings(): {} matches of {} patterns in {} strings", matches.size(), patterns.size(), number_of_strings);
 
-                class_analysis_working_on->add_method_xref_to(current_method_analysis, oth_cls, oth_meth, off);
-                oth_cls->add_method_xref_from(oth_meth, class_analysis_working_on, current_method_analysis, off);
+    return matches;
+}
 
-                class_analysis_working_on->add_xref_to(static_cast<TYPES::REF_TYPE>(op_value), oth_cls, oth_meth, off);
-                oth_cls->add_xref_from(static_cast<TYPES::REF_TYPE>(op_value), class_analysis_working_on, current_method_analysis, off);
-            }
-            /// check for instructions like: invoke-xxx/range
-            else if (TYPES::opcodes::OP_INVOKE_VIRTUAL_RANGE <= op_value &&
-                     op_value <= TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE)
-            {
-                auto invoke_xxx_range = reinterpret_cast<Instruction3rc *>(instruction);
+void Analysis::_scan_xrefs(const SymbolTable::parser_symbols_t &parser_symbols,
+                           SymbolTable::symbol_id_t current_class,
+                           MethodAnalysis *current_method_analysis,
+                           std::vector<pending_xref_t> &xrefs) const
+{
+    auto logger = LOGGER::logger();
 
-                // check if we are calling something different to a method
-                if (invoke_xxx_range->get_kind() != TYPES::Kind::METH)
-                    continue;
+    for (auto &instr : current_method_analysis->get_instructions())
+    {
+        auto off = instr->get_address();
+        auto instruction = instr;
+        auto op_value = instr->get_instruction_opcode();
 
-                auto method_id = invoke_xxx_range->get_operand_method();
+        // check for: `const-class` and `new-instance` instructions
+        if (op_value == TYPES::opcodes::OP_CONST_CLASS ||
+            op_value == TYPES::opcodes::OP_NEW_INSTANCE)
+        {
+            auto const_class_new_instance = reinterpret_cast<Instruction21c *>(instruction);
 
-                auto &cls_name = reinterpret_cast<DVMClass *>(method_id->get_class())->get_name();
-                auto &method_name = method_id->get_name();
-                auto &proto = method_id->get_proto()->get_shorty_idx();
+            // check we get a TYPE from CONST_CLASS
+            // or from NEW_INSTANCE, any other Kind (FIELD, PROTO, etc)
+            // it is not valid in this case
+            if (const_class_new_instance->get_kind() != TYPES::Kind::TYPE)
+                continue;
 
-                auto oth_meth = _resolve_method(cls_name, method_name, proto);
-                auto oth_cls = classes[cls_name].get();
+            // only the classes have an id
+            auto cls_id = parser_symbols.types[const_class_new_instance->get_source()];
 
-                class_analysis_working_on->add_method_xref_to(
-                    current_method_analysis, oth_cls, oth_meth, off);
-                oth_cls->add_method_xref_from(
-                    oth_meth, class_analysis_working_on, current_method_analysis, off);
+            // avoid analyzing our own class name
+            if (cls_id == SymbolTable::no_symbol || cls_id == current_class)
+                continue;
 
-                class_analysis_working_on->add_xref_to(
-                    static_cast<TYPES::REF_TYPE>(op_value), oth_cls, oth_meth, off);
-                oth_cls->add_xref_from(
-                    static_cast<TYPES::REF_TYPE>(op_value), class_analysis_working_on, current_method_analysis, off);
-            }
+            pending_xref_t xref{pending_xref_t::CLASS, op_value, off};
+            xref.id = cls_id;
+            xrefs.push_back(xref);
+        }
 
-            // now check for string usage: const-string
-            else if (op_value == TYPES::opcodes::OP_CONST_STRING)
+        /// check for instructions like: invoke-* and invoke-xxx/range
+        else if ((TYPES::opcodes::OP_INVOKE_VIRTUAL <= op_value &&
+                  op_value <= TYPES::opcodes::OP_INVOKE_INTERFACE) ||
+                 (TYPES::opcodes::OP_INVOKE_VIRTUAL_RANGE <= op_value &&
+                  op_value <= TYPES::opcodes::OP_INVOKE_INTERFACE_RANGE))
+        {
+            std::uint16_t method_index;
+
+            if (op_value <= TYPES::opcodes::OP_INVOKE_INTERFACE)
             {
-                auto const_string = reinterpret_cast<Instruction21c *>(instruction);
+                auto invoke_ = reinterpret_cast<Instruction35c *>(instruction);
 
-                if (!const_string->is_source_string())
+                // get the invoke of method
+                if (invoke_->get_kind() != TYPES::Kind::METH)
                     continue;
 
-                auto &string_value = const_string->get_source_str();
+                method_index = invoke_->get_type_idx();
+            }
+            else
+            {
+                auto invoke_xxx_range = reinterpret_cast<Instruction3rc *>(instruction);
 
-                if (strings.find(string_value) == strings.end())
-                    strings[string_value] = std::make_unique<StringAnalysis>(string_value);
+                // check if we are calling something different to a method
+                if (invoke_xxx_range->get_kind() != TYPES::Kind::METH)
+                    continue;
 
-                strings[string_value]->add_xreffrom(class_analysis_working_on, current_method_analysis, off);
+                method_index = invoke_xxx_range->get_index_value();
             }
 
-            /// check now for field usage, we first
-            /// analyze those from OP_IGET to OP_IPUT_SHORT
-            /// then those from OP_SGET to OP_SPUT_SHORT
-            else if (TYPES::opcodes::OP_IGET <= op_value &&
-                     op_value <= TYPES::opcodes::OP_IPUT_SHORT)
-            {
-                auto op_i = reinterpret_cast<Instruction22c *>(instruction);
-                auto checked_field = op_i->get_checked_field();
+            auto method_id = parser_symbols.methods[method_index];
 
-                if (op_i->get_kind() != TYPES::Kind::FIELD ||
-                    checked_field == nullptr)
-                    continue;
+            /// check that called method comes from a class
+            /// (not from other type like an Array)
+            if (symbols.get_method_class(method_id) == SymbolTable::no_symbol)
+            {
+                logger->warn("Found a call to a method from non class (type found {})",
+                             symbols.get_method_id(method_id)->get_class()->print_type());
+                continue;
+            }
 
-                auto operation = DalvikOpcodes::get_instruction_operation(op_i->get_instruction_opcode());
+            pending_xref_t xref{pending_xref_t::METHOD, op_value, off};
+            xref.id = method_id;
+            xrefs.push_back(xref);
+        }
 
-                /// is a read operation?
-                if (operation == TYPES::Operation::FIELD_READ_DVM_OPCODE)
-                {
-                    // retrieve the encoded field from the FieldID
-                    auto field_item = checked_field->get_encoded_field();
+        // now check for string usage: const-string
+        else if (op_value == TYPES::opcodes::OP_CONST_STRING)
+        {
+            auto const_string = reinterpret_cast<Instruction21c *>(instruction);
 
-                    classes[current_class_name]->add_field_xref_read(
-                        current_method_analysis, class_analysis_working_on, field_item, off);
+            if (!const_string->is_source_string())
+                continue;
 
-                    // necessary to give a field analysis to the add_xref_read method
-                    // we can get the created by the add_field_xref_read.
-                    auto field_analysis = classes[current_class_name]->get_field_analysis(field_item);
-                    current_method_analysis->add_xrefread(class_analysis_working_on, field_analysis, off);
-                }
-                /// is a write operation?
-                else if (operation == TYPES::Operation::FIELD_WRITE_DVM_OPCODE)
-                {
-                    // retrieve the encoded field from the FieldID
-                    auto field_item = checked_field->get_encoded_field();
+            pending_xref_t xref{pending_xref_t::STRING, op_value, off};
+            xref.id = parser_symbols.strings[const_string->get_source()];
+            xref.string = &const_string->get_source_str();
+            xrefs.push_back(xref);
+        }
 
-                    classes[current_class_name]->add_field_xref_write(
-                        current_method_analysis, class_analysis_working_on, field_item, off);
+        /// check now for field usage, we first
+        /// analyze those from OP_IGET to OP_IPUT_SHORT
+        /// then those from OP_SGET to OP_SPUT_SHORT
+        else if (TYPES::opcodes::OP_IGET <= op_value &&
+                 op_value <= TYPES::opcodes::OP_IPUT_SHORT)
+        {
+            auto op_i = reinterpret_cast<Instruction22c *>(instruction);
+            auto checked_field = op_i->get_checked_field();
+
+            /// same as for the static fields, the external
+            /// fields do not have an EncodedField
+            if (op_i->get_kind() != TYPES::Kind::FIELD ||
+                checked_field == nullptr ||
+                checked_field->get_encoded_field() == nullptr)
+                continue;
+
+            auto operation = DalvikOpcodes::get_instruction_operation(op_value);
+
+            if (operation == TYPES::Operation::FIELD_READ_DVM_OPCODE)
+                xrefs.push_back({pending_xref_t::FIELD_READ, op_value, off});
+            else if (operation == TYPES::Operation::FIELD_WRITE_DVM_OPCODE)
+                xrefs.push_back({pending_xref_t::FIELD_WRITE, op_value, off});
+            else
+                continue;
+
+            // retrieve the encoded field from the FieldID
+            xrefs.back().id = parser_symbols.fields[op_i->get_checked_id()];
+            xrefs.back().field = checked_field->get_encoded_field();
+        }
+        /// now time to check OP_SGET to OP_SPUT_SHORT
+        else if (TYPES::opcodes::OP_SGET <= op_value &&
+                 op_value <= TYPES::opcodes::OP_SPUT_SHORT)
+        {
+            auto op_s = reinterpret_cast<Instruction21c *>(instruction);
+            auto checked_field = op_s->get_source_field();
+
+            /// if the instruction is not a FIELD Kind instruction
+            /// if there are not checked field, or the EncodedField
+            /// of the Field is nullptr (an external field), leave!
+            if (op_s->get_kind() != TYPES::Kind::FIELD ||
+                checked_field == nullptr ||
+                checked_field->get_encoded_field() == nullptr)
+                continue;
+
+            auto operation = DalvikOpcodes::get_instruction_operation(op_value);
+
+            if (operation == TYPES::Operation::FIELD_READ_DVM_OPCODE)
+                xrefs.push_back({pending_xref_t::FIELD_READ, op_value, off});
+            else if (operation == TYPES::Operation::FIELD_WRITE_DVM_OPCODE)
+                xrefs.push_back({pending_xref_t::FIELD_WRITE, op_value, off});
+            else
+                continue;
+
+            xrefs.back().id = parser_symbols.fields[op_s->get_source()];
+            xrefs.back().field = checked_field->get_encoded_field();
+        }
+    }
+}
 
-                    // same as before
-                    auto field_analysis = classes[current_class_name]->get_field_analysis(field_item);
+void Analysis::_apply_xref(ClassAnalysis *class_analysis_working_on,
+                           MethodAnalysis *current_method_analysis,
+                           const pending_xref_t &xref)
+{
+    auto off = xref.off;
+    auto op_value = xref.op_value;
+    auto current_method = current_method_analysis->get_symbol_id();
 
-                    current_method_analysis->add_xrefwrite(class_analysis_working_on, field_analysis, off);
-                }
-            }
-            /// now time to check OP_SGET to OP_SPUT_SHORT
-            else if (TYPES::opcodes::OP_SGET <= op_value &&
-                     op_value <= TYPES::opcodes::OP_SPUT_SHORT)
-            {
-                auto op_s = reinterpret_cast<Instruction21c *>(instruction);
-                auto checked_field = op_s->get_source_field();
-
-                /// if the instruction is not a FIELD Kind instruction
-                /// if there are not checked field, or the EncodedField
-                /// of the Field is nullptr (an external field), leave!
-                if (op_s->get_kind() != TYPES::Kind::FIELD ||
-                    checked_field == nullptr ||
-                    checked_field->get_encoded_field() == nullptr)
-                    continue;
+    switch (xref.kind)
+    {
+    case pending_xref_t::CLASS:
+    {
+        // the class is created if it is external
+        _resolve_class(xref.id);
+
+        xref_table.add(current_method, xref.id,
+                       op_value == TYPES::opcodes::OP_CONST_CLASS ? XrefTable::xref_kind_t::CONST_CLASS
+                                                                  : XrefTable::xref_kind_t::NEW_INSTANCE,
+                       op_value, off);
+        break;
+    }
+    case pending_xref_t::METHOD:
+    {
+        // the method and its class are created if these are external
+        _resolve_method(xref.id);
 
-                auto operation = DalvikOpcodes::get_instruction_operation(op_s->get_instruction_opcode());
+        xref_table.add(current_method, xref.id, XrefTable::xref_kind_t::CALL, op_value, off);
+        break;
+    }
+    case pending_xref_t::STRING:
+    {
+        auto &string_analysis = string_analyses[xref.id];
 
-                // is read operation
-                if (operation == TYPES::Operation::FIELD_READ_DVM_OPCODE)
-                {
-                    auto field_item = checked_field->get_encoded_field();
+        if (string_analysis == nullptr)
+        {
+            auto &string_value = *xref.string;
+            auto &new_string = strings[string_value];
 
-                    classes[current_class_name]->add_field_xref_read(
-                        current_method_analysis, class_analysis_working_on, field_item, off);
+            if (new_string == nullptr)
+                new_string = std::make_unique<StringAnalysis>(string_value);
 
-                    /// necessary to give a field analysis to the add_xref_read method
-                    /// we can get the created by the add_field_xref_read.
-                    auto field_analysis = classes[current_class_name]->get_field_analysis(field_item);
-                    current_method_analysis->add_xrefread(class_analysis_working_on, field_analysis, off);
-                }
-                else if (operation == TYPES::Operation::FIELD_WRITE_DVM_OPCODE)
-                {
-                    auto field_item = checked_field->get_encoded_field();
+            string_analysis = new_string.get();
+            string_analysis->set_xref_table(&xref_table, xref.id);
+        }
 
-                    classes[current_class_name]->add_field_xref_write(
-                        current_method_analysis, class_analysis_working_on, field_item, off);
+        xref_table.add(current_method, xref.id, XrefTable::xref_kind_t::STRING, op_value, off);
+        break;
+    }
+    case pending_xref_t::FIELD_READ:
+    case pending_xref_t::FIELD_WRITE:
+    {
+        auto &field_analysis = field_analyses[xref.id];
 
-                    /// same as before
-                    auto field_analysis = classes[current_class_name]->get_field_analysis(field_item);
-                    current_method_analysis->add_xrefwrite(class_analysis_working_on, field_analysis, off);
-                }
-            }
+        // the FieldAnalysis is kept by the class of the method
+        // that uses the field first
+        if (field_analysis == nullptr)
+        {
+            field_analysis = class_analysis_working_on->add_field(xref.field);
+            field_analysis->set_xref_table(&xref_table, xref.id);
         }
+
+        xref_table.add(current_method, xref.id,
+                       xref.kind == pending_xref_t::FIELD_READ ? XrefTable::xref_kind_t::FIELD_READ
+                                                               : XrefTable::xref_kind_t::FIELD_WRITE,
+                       op_value, off);
+        break;
+    }
     }
 }
 
-MethodAnalysis *Analysis::_resolve_method(std::string &class_name,
-                                          std::string &method_name, std::string &method_descriptor)
+ClassAnalysis *Analysis::_resolve_class(SymbolTable::symbol_id_t class_id)
 {
-    std::string const m_hash = class_name + method_name + method_descriptor;
-    std::vector<std::unique_ptr<Instruction>> empty_instructions;
+    auto &class_analysis = class_analyses[class_id];
 
-    auto it = method_hashes.find(m_hash);
+    if (class_analysis)
+        return class_analysis;
 
-    if (it != method_hashes.end())
-        return it->second;
+    // if the name of the class is not already in the classes,
+    // probably we are treating with an external class
+    auto &class_name = symbols.get_class_name(class_id);
 
-    // create if necessary a class
     if (classes.find(class_name) == classes.end())
     {
         external_classes[class_name] = std::make_unique<ExternalClass>(class_name);
-        // add external class
         classes[class_name] = std::make_unique<ClassAnalysis>(external_classes[class_name].get());
     }
 
-    external_methods[m_hash] = std::make_unique<ExternalMethod>(class_name, method_name, method_descriptor);
-    auto meth_analysis = std::make_unique<MethodAnalysis>(external_methods[m_hash].get(), empty_instructions);
-    auto meth_analysis_p_ = meth_analysis.get();
+    class_analysis = classes[class_name].get();
+    class_analysis->set_xref_table(&xref_table, class_id);
+
+    return class_analysis;
+}
+
+MethodAnalysis *Analysis::_resolve_method(SymbolTable::symbol_id_t method_id)
+{
+    auto &method_analysis = method_analyses[method_id];
+
+    if (method_analysis)
+        return method_analysis;
+
+    // create if necessary a class
+    auto class_analysis = _resolve_class(symbols.get_method_class(method_id));
+
+    auto method = symbols.get_method_id(method_id);
+    // the external method keeps a reference to the name, the names
+    // of the symbol table cannot be modified
+    auto &class_name = class_analysis->name();
+    auto &m_hash = symbols.get_method_name(method_id);
+
+    // the descriptor makes the name different for every overload
+    auto &external_method = external_methods[m_hash];
+    external_method = std::make_unique<ExternalMethod>(class_name, method->get_name(), method->get_proto()->get_descriptor());
+
+    auto meth_analysis = std::make_unique<MethodAnalysis>(external_method.get(), nullptr);
+    method_analysis = meth_analysis.get();
+    method_analysis->set_xref_table(&xref_table, method_id);
+
     // add to all the collections we have
-    method_hashes[m_hash] = meth_analysis_p_;
-    classes[class_name]->add_method(meth_analysis_p_);
-    methods[external_methods[m_hash]->pretty_method_name()] = std::move(meth_analysis);
+    class_analysis->add_method(method_analysis);
+    methods[external_method->pretty_method_name()] = std::move(meth_analysis);
 
-    return method_hashes[m_hash];
+    return method_analysis;
 }
 
 std::vector<FieldAnalysis *> &Analysis::get_fields()
@@ -384,17 +604,145 @@ std::vector<FieldAnalysis *> &Analysis::get_fields()
     return all_fields;
 }
 
+namespace
+{
+    /// @brief column of a table queried with a pattern
+    struct column_t
+    {
+        const NameIndex &index;
+        const SearchPattern &pattern;
+    };
+
+    /// @brief how many names a kind of pattern usually matches,
+    /// the lowest is the best column for the candidates
+    int selectivity(SearchPattern::kind_t kind)
+    {
+        switch (kind)
+        {
+        case SearchPattern::kind_t::EXACT:
+            return 0;
+        case SearchPattern::kind_t::PREFIX:
+            return 1;
+        case SearchPattern::kind_t::SUFFIX:
+        case SearchPattern::kind_t::LITERAL:
+            return 2;
+        case SearchPattern::kind_t::REGEX:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+
+    /// @brief Get the rows of a table where every column matches its
+    /// pattern, the candidates come from the most selective column
+    /// and the rest of the columns are checked only for them
+    /// @return sorted rows
+    std::vector<NameIndex::position_t> search_table(std::initializer_list<column_t> columns)
+    {
+        auto best = std::min_element(columns.begin(), columns.end(), [](const column_t &a, const column_t &b)
+                                     { return selectivity(a.pattern.get_kind()) < selectivity(b.pattern.get_kind()); });
+
+        auto rows = best->index.search(best->pattern);
+
+        std::erase_if(rows, [&](NameIndex::position_t row)
+                      { return std::any_of(columns.begin(), columns.end(), [&](const column_t &column)
+                                           { return &column != best && !column.pattern.match(column.index.get_name(row)); }); });
+
+        return rows;
+    }
+}
+
+void Analysis::_update_search_index()
+{
+    auto &index = search_index;
+
+    // the maps can be modified through their getters too
+    if (!index.outdated &&
+        index.classes.size() == classes.size() &&
+        index.methods.size() == methods.size() &&
+        index.strings.size() == strings.size())
+        return;
+
+    std::vector<std::string_view> class_names, method_class_names, method_names, method_access_flags,
+        string_values, field_class_names, field_names, field_types, field_access_flags;
+
+    index.classes.clear();
+    index.fields.clear();
+    index.field_access_flags_str.clear();
+
+    for (const auto &c : classes)
+    {
+        index.classes.push_back(c.second.get());
+        class_names.push_back(c.second->name());
+
+        for (const auto &f : c.second->get_fields())
+        {
+            index.fields.push_back(f.second.get());
+            field_class_names.push_back(c.second->name());
+            index.field_access_flags_str.push_back(DalvikOpcodes::get_access_flags_str(f.second->get_field()->get_access_flags()));
+        }
+    }
+
+    // the strings of the access flags do not move from here
+    for (std::size_t i = 0; i < index.fields.size(); i++)
+    {
+        auto field = index.fields[i];
+
+        field_names.push_back(field->get_name());
+        field_types.push_back(field->get_field()->get_field()->get_type()->get_raw());
+        field_access_flags.push_back(index.field_access_flags_str[i]);
+    }
+
+    index.methods.clear();
+
+    for (const auto &m : methods)
+    {
+        index.methods.push_back(m.second.get());
+        method_class_names.push_back(m.second->get_class_name());
+        method_names.push_back(m.second->get_name());
+        method_access_flags.push_back(m.second->get_access_flags());
+    }
+
+    index.strings.clear();
+
+    for (const auto &s : strings)
+    {
+        index.strings.push_back(s.second.get());
+        string_values.push_back(s.first);
+    }
+
+    // the trigrams are created for the columns queried with
+    // text, not for the types and the access flags
+    index.class_names.build(std::move(class_names), true);
+    index.method_class_names.build(std::move(method_class_names), true);
+    index.method_names.build(std::move(method_names), true);
+    index.method_access_flags.build(std::move(method_access_flags), false);
+    index.string_values.build(std::move(string_values), true);
+    index.field_class_names.build(std::move(field_class_names), true);
+    index.field_names.build(std::move(field_names), true);
+    index.field_types.build(std::move(field_types), false);
+    index.field_access_flags.build(std::move(field_access_flags), false);
+
+    index.outdated = false;
+}
+
 std::vector<ClassAnalysis *> Analysis::find_classes(std::string &name, bool no_external = false)
 {
     std::vector<ClassAnalysis *> found_classes;
-    std::regex const class_name_regex(name);
+    SearchPattern class_name_pattern(name);
 
-    for (const auto &c : classes)
+    std::lock_guard<std::mutex> lock(search_index.mutex);
+
+    _update_search_index();
+
+    for (auto row : search_index.class_names.search(class_name_pattern))
     {
-        if (no_external && c.second->is_class_external())
+        auto class_analysis = search_index.classes[row];
+
+        if (no_external && class_analysis->is_class_external())
             continue;
-        if (std::regex_search(c.second->name(), class_name_regex))
-            found_classes.push_back(c.second.get());
+
+        found_classes.push_back(class_analysis);
     }
 
     return found_classes;
@@ -408,22 +756,29 @@ std::vector<MethodAnalysis *> Analysis::find_methods(std::string &class_name,
 {
     std::vector<MethodAnalysis *> methods_vector;
 
-    std::regex class_name_regex(class_name),
-        method_name_regex(method_name),
-        descriptor_regex(descriptor),
-        accessflags_regex(accessflags);
+    // the descriptor is parsed, so a wrong expression still
+    // throws, but as before it does not filter the methods
+    SearchPattern class_name_pattern(class_name),
+        method_name_pattern(method_name),
+        descriptor_pattern(descriptor),
+        accessflags_pattern(accessflags);
 
-    for (const auto &m : methods)
+    std::lock_guard<std::mutex> lock(search_index.mutex);
+
+    _update_search_index();
+
+    auto rows = search_table({{search_index.method_class_names, class_name_pattern},
+                              {search_index.method_names, method_name_pattern},
+                              {search_index.method_access_flags, accessflags_pattern}});
+
+    for (auto row : rows)
     {
-        const auto &method = m.second;
+        auto method = search_index.methods[row];
 
         if (no_external && method->external())
             continue;
 
-        if (std::regex_search(method->get_class_name(), class_name_regex) &&
-            std::regex_search(method->get_name(), method_name_regex) &&
-            std::regex_search(method->get_access_flags(), accessflags_regex))
-            methods_vector.push_back(method.get());
+        methods_vector.push_back(method);
     }
 
     return methods_vector;
@@ -432,13 +787,14 @@ std::vector<MethodAnalysis *> Analysis::find_methods(std::string &class_name,
 std::vector<StringAnalysis *> Analysis::find_strings(std::string &str)
 {
     std::vector<StringAnalysis *> strings_list;
-    std::regex const str_reg(str);
+    SearchPattern str_pattern(str);
 
-    for (const auto &s : strings)
-    {
-        if (std::regex_search(s.first, str_reg))
-            strings_list.push_back(s.second.get());
-    }
+    std::lock_guard<std::mutex> lock(search_index.mutex);
+
+    _update_search_index();
+
+    for (auto row : search_index.string_values.search(str_pattern))
+        strings_list.push_back(search_index.strings[row]);
 
     return strings_list;
 }
@@ -448,28 +804,24 @@ std::vector<FieldAnalysis *> Analysis::find_fields(std::string &class_name,
                                                    std::string &field_type,
                                                    std::string &accessflags)
 {
-    std::regex class_name_regex(class_name),
-        field_name_regex(field_name),
-        field_type_regex(field_type),
-        accessflags_regex(accessflags);
+    SearchPattern class_name_pattern(class_name),
+        field_name_pattern(field_name),
+        field_type_pattern(field_type),
+        accessflags_pattern(accessflags);
 
     std::vector<FieldAnalysis *> fields_list;
 
-    for (const auto &c : classes)
-    {
-        if (!std::regex_search(c.second->name(), class_name_regex))
-            continue;
+    std::lock_guard<std::mutex> lock(search_index.mutex);
 
-        for (const auto &f : c.second->get_fields())
-        {
-            auto access_flags_str = DalvikOpcodes::get_access_flags_str(f.second->get_field()->get_access_flags());
+    _update_search_index();
 
-            if (std::regex_search(f.second->get_name(), field_name_regex) &&
-                std::regex_search(f.second->get_field()->get_field()->get_type()->get_raw(), field_type_regex) &&
-                std::regex_search(access_flags_str, accessflags_regex))
-                fields_list.push_back(f.second.get());
-        }
-    }
+    auto rows = search_table({{search_index.field_class_names, class_name_pattern},
+                              {search_index.field_names, field_name_pattern},
+                              {search_index.field_types, field_type_pattern},
+                              {search_index.field_access_flags, accessflags_pattern}});
+
+    for (auto row : rows)
+        fields_list.push_back(search_index.fields[row]);
 
     return fields_list;
-}
\ No newline at end of file
+}
@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file dominators.cpp
+
+#include "Kunai/DEX/analysis/dominators.hpp"
+
+#include <algorithm>
+
+using namespace KUNAI::DEX;
+
+DominatorTree::DominatorTree(const BasicBlocks &blocks, bool post_dominators, bool exceptions)
+    : post_dominators(post_dominators), exceptions(exceptions)
+{
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    if (exceptions)
+        compute_exception_graph(blocks);
+
+    rpo_number.assign(number_of_blocks, no_block);
+    idom.assign(number_of_blocks, no_block);
+
+    for (auto node : blocks.get_nodes())
+    {
+        if ((!post_dominators && node->is_start_block()) ||
+            (post_dominators && node->is_end_block()))
+        {
+            root = node->get_id();
+            break;
+        }
+    }
+
+    if (root != no_block)
+    {
+        compute_reverse_postorder(blocks);
+        compute_immediate_dominators(blocks);
+    }
+
+    compute_tree();
+    compute_frontiers(blocks);
+}
+
+void DominatorTree::compute_exception_graph(const BasicBlocks &blocks)
+{
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    // the normal edges go first, the edges from the start block
+    // to the handlers that nothing jumps to are skipped
+    std::vector<std::pair<block_id_t, block_id_t>> edges;
+
+    for (auto node : blocks.get_nodes())
+    {
+        auto id = node->get_id();
+
+        for (auto suc : blocks.get_sucessor_ids(id))
+            if (!blocks.is_reached_by_exceptions_only(suc))
+                edges.emplace_back(id, suc);
+    }
+
+    for (const auto &[src, dst] : blocks.get_exception_edges())
+        edges.emplace_back(src->get_id(), dst->get_id());
+
+    sucessor_offsets.assign(number_of_blocks + 1, 0);
+    predecessor_offsets.assign(number_of_blocks + 1, 0);
+
+    for (const auto &[src, dst] : edges)
+    {
+        sucessor_offsets[src + 1]++;
+        predecessor_offsets[dst + 1]++;
+    }
+
+    for (std::size_t i = 0; i < number_of_blocks; i++)
+    {
+        sucessor_offsets[i + 1] += sucessor_offsets[i];
+        predecessor_offsets[i + 1] += predecessor_offsets[i];
+    }
+
+    sucessor_ids.resize(edges.size());
+    predecessor_ids.resize(edges.size());
+
+    std::vector<std::uint32_t> next_sucessor(sucessor_offsets.begin(), sucessor_offsets.end() - 1);
+    std::vector<std::uint32_t> next_predecessor(predecessor_offsets.begin(), predecessor_offsets.end() - 1);
+
+    for (const auto &[src, dst] : edges)
+    {
+        sucessor_ids[next_sucessor[src]++] = dst;
+        predecessor_ids[next_predecessor[dst]++] = src;
+    }
+}
+
+void DominatorTree::compute_reverse_postorder(const BasicBlocks &blocks)
+{
+    // iterative depth first search, each entry keeps the
+    // block and the position of the next neighbour to visit
+    std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+    std::vector<std::uint8_t> visited(rpo_number.size(), 0);
+
+    stack.emplace_back(root, 0);
+    visited[root] = 1;
+
+    while (!stack.empty())
+    {
+        auto &[id, next] = stack.back();
+        auto neighbours = forward(blocks, id);
+
+        if (next < neighbours.size())
+        {
+            auto neighbour = neighbours[next++];
+
+            if (!visited[neighbour])
+            {
+                visited[neighbour] = 1;
+                stack.emplace_back(neighbour, 0);
+            }
+            continue;
+        }
+
+        // all the neighbours visited, it goes to the postorder
+        reverse_postorder.push_back(id);
+        stack.pop_back();
+    }
+
+    std::reverse(reverse_postorder.begin(), reverse_postorder.end());
+
+    for (std::uint32_t i = 0; i < reverse_postorder.size(); i++)
+        rpo_number[reverse_postorder[i]] = i;
+}
+
+void DominatorTree::compute_immediate_dominators(const BasicBlocks &blocks)
+{
+    // walk up the tree from two blocks until both fingers
+    // meet, the block with the bigger number goes first
+    auto intersect = [&](block_id_t a, block_id_t b)
+    {
+        while (a != b)
+        {
+            while (rpo_number[a] > rpo_number[b])
+                a = idom[a];
+            while (rpo_number[b] > rpo_number[a])
+                b = idom[b];
+        }
+        return a;
+    };
+
+    idom[root] = root;
+
+    bool changed = true;
+
+    while (changed)
+    {
+        changed = false;
+
+        // the root is the first one, skip it
+        for (std::size_t i = 1; i < reverse_postorder.size(); i++)
+        {
+            auto id = reverse_postorder[i];
+            auto new_idom = no_block;
+
+            for (auto pred : backward(blocks, id))
+            {
+                // only the processed predecessors
+                if (rpo_number[pred] == no_block || idom[pred] == no_block)
+                    continue;
+
+                new_idom = new_idom == no_block ? pred : intersect(pred, new_idom);
+            }
+
+            if (new_idom != idom[id])
+            {
+                idom[id] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // the root has no immediate dominator
+    idom[root] = no_block;
+}
+
+void DominatorTree::compute_tree()
+{
+    auto number_of_blocks = idom.size();
+
+    children_offsets.assign(number_of_blocks + 1, 0);
+
+    for (auto id : reverse_postorder)
+        if (idom[id] != no_block)
+            children_offsets[idom[id] + 1]++;
+
+    for (std::size_t i = 0; i < number_of_blocks; i++)
+        children_offsets[i + 1] += children_offsets[i];
+
+    children.resize(children_offsets[number_of_blocks]);
+
+    std::vector<std::uint32_t> next_child(children_offsets.begin(), children_offsets.end() - 1);
+
+    // the children are stored in reverse postorder
+    for (auto id : reverse_postorder)
+        if (idom[id] != no_block)
+            children[next_child[idom[id]]++] = id;
+
+    preorder.assign(number_of_blocks, no_block);
+    last_preorder.assign(number_of_blocks, no_block);
+
+    if (root == no_block)
+        return;
+
+    // number the tree in preorder, the subtree of a block
+    // is the interval [preorder, last_preorder]
+    std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+    std::uint32_t counter = 0;
+
+    stack.emplace_back(root, 0);
+    preorder[root] = counter++;
+
+    while (!stack.empty())
+    {
+        auto &[id, next] = stack.back();
+        auto node_children = get_children(id);
+
+        if (next < node_children.size())
+        {
+            auto child = node_children[next++];
+            preorder[child] = counter++;
+            stack.emplace_back(child, 0);
+            continue;
+        }
+
+        last_preorder[id] = counter - 1;
+        stack.pop_back();
+    }
+}
+
+void DominatorTree::compute_frontiers(const BasicBlocks &blocks)
+{
+    auto number_of_blocks = idom.size();
+
+    std::vector<std::vector<block_id_t>> node_frontiers(number_of_blocks);
+
+    for (auto id : reverse_postorder)
+    {
+        auto preds = backward(blocks, id);
+
+        if (preds.size() < 2)
+            continue;
+
+        for (auto pred : preds)
+        {
+            if (rpo_number[pred] == no_block)
+                continue;
+
+            // every block from the predecessor up to the immediate
+            // dominator of the join block has it in its frontier
+            for (auto runner = pred; runner != idom[id] && runner != no_block; runner = idom[runner])
+            {
+                auto &frontier = node_frontiers[runner];
+
+                // the join blocks are processed one by one, so a
+                // repeated block is always the last one added
+                if (!frontier.empty() && frontier.back() == id)
+                    break;
+
+                frontier.push_back(id);
+            }
+        }
+    }
+
+    frontier_offsets.assign(number_of_blocks + 1, 0);
+
+    for (std::size_t i = 0; i < number_of_blocks; i++)
+        frontier_offsets[i + 1] = frontier_offsets[i] + static_cast<std::uint32_t>(node_frontiers[i].size());
+
+    frontiers.reserve(frontier_offsets[number_of_blocks]);
+
+    for (const auto &frontier : node_frontiers)
+        frontiers.insert(frontiers.end(), frontier.begin(), frontier.end());
+}
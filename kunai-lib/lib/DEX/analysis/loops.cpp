@@ -0,0 +1,254 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file loops.cpp
+
+#include "Kunai/DEX/analysis/loops.hpp"
+
+#include <algorithm>
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    /// @brief value for the blocks not visited by the search
+    constexpr std::uint32_t not_visited = std::numeric_limits<std::uint32_t>::max();
+}
+
+LoopForest::LoopForest(const BasicBlocks &blocks)
+{
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    block_loop.assign(number_of_blocks, no_loop);
+    block_offsets.push_back(0);
+
+    auto start = no_loop;
+
+    for (auto node : blocks.get_nodes())
+    {
+        if (node->is_start_block())
+        {
+            start = node->get_id();
+            break;
+        }
+    }
+
+    if (start == no_loop)
+        return;
+
+    // the algorithm works with the preorder number of the blocks,
+    // `nodes` gives the block of each number, and the subtree of
+    // the number w in the search is the interval [w, last[w]]
+    std::vector<std::uint32_t> number(number_of_blocks, not_visited);
+    std::vector<block_id_t> nodes;
+    std::vector<std::uint32_t> last;
+
+    {
+        std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+
+        number[start] = 0;
+        nodes.push_back(start);
+        stack.emplace_back(start, 0);
+
+        while (!stack.empty())
+        {
+            auto &[id, next] = stack.back();
+            auto sucessors = blocks.get_sucessor_ids(id);
+
+            if (next < sucessors.size())
+            {
+                auto suc = sucessors[next++];
+
+                if (number[suc] == not_visited)
+                {
+                    number[suc] = static_cast<std::uint32_t>(nodes.size());
+                    nodes.push_back(suc);
+                    stack.emplace_back(suc, 0);
+                }
+                continue;
+            }
+
+            if (last.size() < nodes.size())
+                last.resize(nodes.size());
+            last[number[id]] = static_cast<std::uint32_t>(nodes.size() - 1);
+            stack.pop_back();
+        }
+    }
+
+    auto size = static_cast<std::uint32_t>(nodes.size());
+
+    last.resize(size);
+
+    auto is_ancestor = [&](std::uint32_t w, std::uint32_t v)
+    {
+        return w <= v && v <= last[w];
+    };
+
+    // split the predecessors between the ones that come from
+    // the subtree of the block (back edges) and the rest
+    std::vector<std::vector<std::uint32_t>> back_preds(size), non_back_preds(size);
+
+    for (std::uint32_t w = 0; w < size; w++)
+    {
+        for (auto pred : blocks.get_predecessor_ids(nodes[w]))
+        {
+            auto v = number[pred];
+
+            if (v == not_visited)
+                continue;
+
+            if (is_ancestor(w, v))
+                back_preds[w].push_back(v);
+            else
+                non_back_preds[w].push_back(v);
+        }
+    }
+
+    // union-find where the representative of a set is the
+    // header of the outermost loop found until now
+    std::vector<std::uint32_t> representative(size);
+
+    for (std::uint32_t i = 0; i < size; i++)
+        representative[i] = i;
+
+    auto find = [&](std::uint32_t x)
+    {
+        auto root = x;
+        while (representative[root] != root)
+            root = representative[root];
+        // path compression
+        while (representative[x] != root)
+        {
+            auto next = representative[x];
+            representative[x] = root;
+            x = next;
+        }
+        return root;
+    };
+
+    std::vector<loop_id_t> header_loop(size, no_loop);
+    std::vector<std::uint32_t> pool_mark(size, not_visited);
+    std::vector<std::uint32_t> node_pool, worklist;
+
+    // the blocks are visited from the deepest in the search, so
+    // the inner loops are collapsed before the outer ones
+    for (auto w = size; w-- > 0;)
+    {
+        bool self_loop = false;
+        bool irreducible = false;
+
+        node_pool.clear();
+
+        for (auto v : back_preds[w])
+        {
+            if (v == w)
+            {
+                self_loop = true;
+                continue;
+            }
+
+            auto x = find(v);
+
+            if (pool_mark[x] != w)
+            {
+                pool_mark[x] = w;
+                node_pool.push_back(x);
+            }
+        }
+
+        worklist = node_pool;
+
+        // go backwards from the back edges to the header,
+        // all the blocks found are part of the loop
+        while (!worklist.empty())
+        {
+            auto x = worklist.back();
+            worklist.pop_back();
+
+            for (std::size_t i = 0; i < non_back_preds[x].size(); i++)
+            {
+                auto ydash = find(non_back_preds[x][i]);
+
+                if (!is_ancestor(w, ydash))
+                {
+                    // an entry that does not go through the header
+                    irreducible = true;
+                    non_back_preds[w].push_back(ydash);
+                }
+                else if (ydash != w && pool_mark[ydash] != w)
+                {
+                    pool_mark[ydash] = w;
+                    node_pool.push_back(ydash);
+                    worklist.push_back(ydash);
+                }
+            }
+        }
+
+        if (node_pool.empty() && !self_loop)
+            continue;
+
+        auto loop = static_cast<loop_id_t>(headers.size());
+
+        headers.push_back(nodes[w]);
+        parents.push_back(no_loop);
+        reducible.push_back(!irreducible);
+
+        header_loop[w] = loop;
+        block_loop[nodes[w]] = loop;
+
+        for (auto x : node_pool)
+        {
+            representative[x] = w;
+
+            if (header_loop[x] != no_loop)
+                parents[header_loop[x]] = loop;
+            else
+                block_loop[nodes[x]] = loop;
+        }
+    }
+
+    auto number_of_loops = headers.size();
+
+    // the parents are created after their children
+    depths.assign(number_of_loops, 1);
+
+    for (auto loop = number_of_loops; loop-- > 0;)
+    {
+        if (parents[loop] != no_loop)
+            depths[loop] = depths[parents[loop]] + 1;
+        max_depth = std::max(max_depth, depths[loop]);
+    }
+
+    // blocks of each loop, the header first and
+    // the rest in the order of the search
+    block_offsets.assign(number_of_loops + 1, 0);
+
+    for (auto id : nodes)
+        if (block_loop[id] != no_loop)
+            block_offsets[block_loop[id] + 1]++;
+
+    for (std::size_t i = 0; i < number_of_loops; i++)
+        block_offsets[i + 1] += block_offsets[i];
+
+    loop_blocks.resize(block_offsets[number_of_loops]);
+
+    std::vector<std::uint32_t> next_block(block_offsets.begin(), block_offsets.end() - 1);
+
+    for (std::size_t loop = 0; loop < number_of_loops; loop++)
+        loop_blocks[next_block[loop]++] = headers[loop];
+
+    for (auto id : nodes)
+    {
+        auto loop = block_loop[id];
+
+        if (loop != no_loop && headers[loop] != id)
+            loop_blocks[next_block[loop]++] = id;
+    }
+}
+
+std::size_t LoopForest::get_number_of_irreducible_loops() const
+{
+    return static_cast<std::size_t>(std::count(reducible.begin(), reducible.end(), 0));
+}
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file method_metrics.cpp
+
+#include "Kunai/DEX/analysis/method_metrics.hpp"
+#include "Kunai/DEX/analysis/loops.hpp"
+#include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
+
+using namespace KUNAI::DEX;
+
+void MethodMetrics::set_methods(std::vector<MethodAnalysis *> rows)
+{
+    methods = std::move(rows);
+
+    auto rows_size = methods.size();
+
+    for (auto column : {&blocks, &edges, &instructions, &cyclomatic_complexity,
+                        &loops, &irreducible_loops, &max_loop_depth,
+                        &conditional_branches, &unconditional_branches, &returns,
+                        &switches, &invokes, &moves, &field_reads, &field_writes})
+        column->assign(rows_size, 0);
+}
+
+void MethodMetrics::compute_row(std::size_t row)
+{
+    auto method = methods[row];
+
+    auto &method_instructions = method->get_instructions();
+
+    instructions[row] = static_cast<std::uint32_t>(method_instructions.size());
+
+    for (auto instr : method_instructions)
+    {
+        switch (DalvikOpcodes::get_instruction_operation(instr->get_instruction_opcode()))
+        {
+        case TYPES::Operation::CONDITIONAL_BRANCH_DVM_OPCODE:
+            conditional_branches[row]++;
+            break;
+        case TYPES::Operation::UNCONDITIONAL_BRANCH_DVM_OPCODE:
+            unconditional_branches[row]++;
+            break;
+        case TYPES::Operation::RET_BRANCH_DVM_OPCODE:
+            returns[row]++;
+            break;
+        case TYPES::Operation::MULTI_BRANCH_DVM_OPCODE:
+            switches[row]++;
+            break;
+        case TYPES::Operation::CALL_DVM_OPCODE:
+            invokes[row]++;
+            break;
+        case TYPES::Operation::DATA_MOVEMENT_DVM_OPCODE:
+            moves[row]++;
+            break;
+        case TYPES::Operation::FIELD_READ_DVM_OPCODE:
+            field_reads[row]++;
+            break;
+        case TYPES::Operation::FIELD_WRITE_DVM_OPCODE:
+            field_writes[row]++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    const auto &basic_blocks = method->get_basic_blocks();
+
+    blocks[row] = static_cast<std::uint32_t>(basic_blocks.get_number_of_basic_blocks());
+    edges[row] = static_cast<std::uint32_t>(basic_blocks.get_edges().size());
+
+    // without code there are no blocks
+    if (blocks[row] == 0)
+        return;
+
+    // the start and the end blocks keep the graph connected
+    if (edges[row] + 2 > blocks[row])
+        cyclomatic_complexity[row] = edges[row] + 2 - blocks[row];
+
+    LoopForest forest(basic_blocks);
+
+    loops[row] = static_cast<std::uint32_t>(forest.get_number_of_loops());
+    irreducible_loops[row] = static_cast<std::uint32_t>(forest.get_number_of_irreducible_loops());
+    max_loop_depth[row] = forest.get_max_depth();
+}
@@ -9,8 +9,10 @@
 #include "Kunai/DEX/analysis/analysis.hpp"
 #include "Kunai/Utils/logger.hpp"
 #include "Kunai/DEX/DVM/disassembler.hpp"
+#include "Kunai/DEX/DVM/dex_disassembler.hpp"
 #include "Kunai/DEX/DVM/dalvik_opcodes.hpp"
 
+#include <algorithm>
 #include <queue>
 
 using namespace KUNAI::DEX;
@@ -96,10 +98,66 @@ const std::string &MethodAnalysis::get_full_name() const
     return full_name;
 }
 
+std::vector<Instruction *> &MethodAnalysis::get_instructions()
+{
+    if (instructions)
+        return *instructions;
+
+    if (is_external || !disassembler)
+        instructions = &no_instructions;
+    else
+        instructions = &disassembler->disassemble_method(std::get<EncodedMethod *>(method_encoded));
+
+    return *instructions;
+}
+
+Instruction *MethodAnalysis::get_instruction_at(std::uint64_t address)
+{
+    auto &method_instructions = get_instructions();
+
+    if (instruction_addresses.size() != method_instructions.size())
+    {
+        instruction_addresses.clear();
+        instruction_addresses.reserve(method_instructions.size());
+
+        for (auto instr : method_instructions)
+            instruction_addresses.push_back(instr->get_address());
+    }
+
+    auto it = std::lower_bound(instruction_addresses.begin(), instruction_addresses.end(), address);
+
+    if (it == instruction_addresses.end() || *it != address)
+        return nullptr;
+
+    return method_instructions[std::distance(instruction_addresses.begin(), it)];
+}
+
+const ExceptionTable &MethodAnalysis::get_exception_table()
+{
+    if (exception_table)
+        return *exception_table;
+
+    if (is_external || !disassembler)
+        exception_table = &no_exceptions;
+    else
+        exception_table = &disassembler->get_exception_table(std::get<EncodedMethod *>(method_encoded));
+
+    return *exception_table;
+}
+
 void MethodAnalysis::create_basic_blocks()
 {
+    if (basic_blocks_created)
+        return;
+
+    basic_blocks_created = true;
+
+    auto &method_instructions = get_instructions();
+
+    if (method_instructions.empty())
+        return;
+
     /// utilities to create the basic blocks
-    std::vector<std::int64_t> entry_points;
     std::unordered_map<std::uint64_t,
                        std::vector<std::int64_t>>
         targets_jumps;
@@ -113,17 +171,36 @@ void MethodAnalysis::create_basic_blocks()
                   method->getMethodID()->pretty_method());
 
     // we always have an start block
-    DVMBasicBlock *start = new DVMBasicBlock();
+    DVMBasicBlock *start = basic_blocks.create_block();
 
     start->set_start_block(true);
-    basic_blocks.add_node(start);
 
     // create the first block
-    DVMBasicBlock *current = new DVMBasicBlock();
+    DVMBasicBlock *current = basic_blocks.create_block();
     basic_blocks.add_edge(start, current);
 
+    auto &bytecode = method->get_code_item().get_bytecode();
+
+    // leaders of the blocks, one bit per code unit, a bit
+    // is set when a block must start in that code unit
+    auto units = (bytecode.size() + 1) / 2;
+    std::vector<std::uint64_t> leaders((units + 63) / 64, 0);
+
+    auto set_leader = [&](std::int64_t address)
+    {
+        auto unit = static_cast<std::uint64_t>(address) >> 1;
+        if (address >= 0 && unit < units)
+            leaders[unit >> 6] |= std::uint64_t(1) << (unit & 63);
+    };
+
+    auto is_leader = [&](std::uint64_t address)
+    {
+        auto unit = address >> 1;
+        return unit < units && ((leaders[unit >> 6] >> (unit & 63)) & 1);
+    };
+
     // detect the targets of the jumps and switches
-    for (const auto &instruction : instructions)
+    for (const auto &instruction : method_instructions)
     {
         auto operation = DalvikOpcodes::get_instruction_operation(instruction->get_instruction_opcode());
 
@@ -132,16 +209,17 @@ void MethodAnalysis::create_basic_blocks()
             operation == TYPES::Operation::MULTI_BRANCH_DVM_OPCODE)
         {
             auto idx = instruction->get_address();
-            auto ins = instruction.get();
+            auto ins = instruction;
 
             auto v = disassembler.determine_next(ins, idx);
+            for (auto target : v)
+                set_leader(target);
             targets_jumps[idx] = std::move(v);
-            entry_points.insert(entry_points.end(), targets_jumps[idx].begin(), targets_jumps[idx].end());
         }
     }
 
     // now analyze the exceptions and obtain the entry point addresses
-    exceptions = disassembler.determine_exception(method);
+    auto &exceptions = get_exception_table().get_exceptions();
 
     for (const auto &except : exceptions)
     {
@@ -150,30 +228,26 @@ void MethodAnalysis::create_basic_blocks()
         /// entry_points.push_back(except.try_value_start_addr);
         for (const auto &handler : except.handler)
         {
-            entry_points.push_back(handler.handler_start_addr);
+            set_leader(handler.handler_start_addr);
         }
     }
 
-    for (const auto &instruction : instructions)
+    for (const auto &instruction : method_instructions)
     {
         auto idx = instruction->get_address();
-        auto ins = instruction.get();
+        auto ins = instruction;
 
         /// if we find a new entry point, create a new basic block
-        if (std::find(entry_points.begin(), entry_points.end(), static_cast<std::int64_t>(idx)) != entry_points.end() &&
-            current->get_nb_instructions() != 0)
+        if (is_leader(idx) && current->get_nb_instructions() != 0)
         {
             auto prev = current;
-            current = new DVMBasicBlock();
+            current = basic_blocks.create_block();
             /// if last instruction is not a terminator
             /// we must create an edge because it comes
-            /// from a fallthrough block
+            /// from a fallthrough block, in other case
+            /// the edge will be added later
             if (!prev->get_terminator())
                 basic_blocks.add_edge(prev, current);
-            /// in other case, just add the node, and later
-            /// will be added the edge
-            else
-                basic_blocks.add_node(current);
         }
 
         current->add_instruction(ins);
@@ -193,7 +267,9 @@ void MethodAnalysis::create_basic_blocks()
         {
             auto dst = basic_blocks.get_basic_block_by_idx(dst_idx);
 
-            basic_blocks.add_edge(src, dst);
+            // targets outside of the method do not have a block
+            if (dst)
+                basic_blocks.add_edge(src, dst);
         }
     }
 
@@ -201,37 +277,69 @@ void MethodAnalysis::create_basic_blocks()
     for (const auto &except : exceptions)
     {
         auto try_bb = basic_blocks.get_basic_block_by_idx(except.try_value_start_addr);
-        try_bb->set_try_block(true);
+        if (try_bb)
+            try_bb->set_try_block(true);
 
         for (const auto &handler : except.handler)
         {
             auto catch_bb = basic_blocks.get_basic_block_by_idx(handler.handler_start_addr);
+            if (!catch_bb)
+                continue;
             catch_bb->set_catch_block(true);
             catch_bb->set_handler_type(handler.handler_type);
         }
     }
 
+    /// a try can start or finish in the middle of a block, so every
+    /// instruction is checked, any of them can throw to the handlers
+    if (!exceptions.empty())
+    {
+        auto &exception_table = get_exception_table();
+
+        for (auto node : basic_blocks.get_nodes())
+        {
+            for (auto instr : node->get_instructions())
+            {
+                for (auto except : exception_table.get_exceptions_at(instr->get_address()))
+                {
+                    for (const auto &handler : except->handler)
+                    {
+                        auto catch_bb = basic_blocks.get_basic_block_by_idx(handler.handler_start_addr);
+                        if (catch_bb)
+                            basic_blocks.add_exception_edge(node, catch_bb);
+                    }
+                }
+            }
+        }
+    }
+
     // we always finish with an ending block
-    DVMBasicBlock *end = new DVMBasicBlock();
+    DVMBasicBlock *end = basic_blocks.create_block();
 
     end->set_end_block(true);
-    basic_blocks.add_node(end);
 
-    for (auto &node : basic_blocks.get_nodes())
+    // the edges are added once all the nodes were checked,
+    // so the sucessors are not created again for each node
+    BasicBlocks::edges_t new_edges;
+
+    for (auto node : basic_blocks.get_nodes())
     {
         if (node->is_start_block() || node->is_end_block())
             continue;
 
         /// if the node has not predecessors, add start
         /// node as its predecessor
-        if (basic_blocks.get_predecessors()[node].size() == 0)
-            basic_blocks.add_edge(start, node);
+        if (basic_blocks.get_predecessor_ids(node->get_id()).empty())
+            new_edges.emplace_back(start, node);
 
         /// if the node has not sucessors, add end node
         /// as its sucessor
-        if (basic_blocks.get_sucessors()[node].size() == 0)
-            basic_blocks.add_edge(node, end);
+        if (basic_blocks.get_sucessor_ids(node->get_id()).empty())
+            new_edges.emplace_back(node, end);
     }
+
+    for (const auto &[src, dst] : new_edges)
+        basic_blocks.add_edge(src, dst);
 }
 
 void MethodAnalysis::dump_instruction_dot(std::ofstream &dot_file, Instruction *instr)
@@ -310,6 +418,8 @@ void MethodAnalysis::dump_method_dot(std::ofstream &dot_file)
     if (full_name.empty())
         get_full_name();
 
+    create_basic_blocks();
+
     // first dump the headers of the dot file
     dot_file << "digraph \"" << full_name << "\"{\n";
     dot_file << "style=\"dashed\";\n";
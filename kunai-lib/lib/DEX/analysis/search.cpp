@@ -0,0 +1,271 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file search.cpp
+
+#include "Kunai/DEX/analysis/search.hpp"
+#include "Kunai/Utils/parallel.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <numeric>
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    /// @brief names checked by each task of a scan
+    constexpr std::size_t names_per_task = 4096;
+
+    /// @brief scans of fewer names are done by the calling
+    /// thread, starting the threads costs more than the scan
+    constexpr std::size_t names_per_parallel_scan = 32768;
+
+    /// @brief compiled expressions kept in the cache, the cache
+    /// is emptied when it is full
+    constexpr std::size_t regex_cache_size = 4096;
+
+    std::uint32_t trigram(std::string_view text, std::size_t i)
+    {
+        return (static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16) |
+               (static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8) |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 2]));
+    }
+
+    /// @brief Keep the positions that satisfy a predicate, the positions
+    /// are checked in blocks by a pool of threads
+    template <typename Predicate>
+    std::vector<NameIndex::position_t> filter(std::size_t count,
+                                              Predicate &&predicate,
+                                              unsigned threads)
+    {
+        std::vector<std::vector<NameIndex::position_t>> found((count + names_per_task - 1) / names_per_task);
+
+        if (count < names_per_parallel_scan)
+            threads = 1;
+
+        KUNAI::parallel::parallel_for(
+            found.size(), [&](std::size_t task, unsigned)
+            {
+                auto last = std::min(count, (task + 1) * names_per_task);
+
+                for (auto i = task * names_per_task; i < last; i++)
+                    if (predicate(i))
+                        found[task].push_back(static_cast<NameIndex::position_t>(i)); },
+            threads);
+
+        std::vector<NameIndex::position_t> result;
+
+        for (auto &block : found)
+            result.insert(result.end(), block.begin(), block.end());
+
+        return result;
+    }
+}
+
+std::shared_ptr<const std::regex> SearchPattern::compile(const std::string &pattern)
+{
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const std::regex>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+
+        auto it = cache.find(pattern);
+
+        if (it != cache.end())
+            return it->second;
+    }
+
+    // compiled out of the lock, an incorrect pattern throws here
+    // as it did when the regex was created in every query
+    auto regex = std::make_shared<const std::regex>(pattern, std::regex::ECMAScript | std::regex::optimize);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    if (cache.size() >= regex_cache_size)
+        cache.clear();
+
+    return cache.emplace(pattern, std::move(regex)).first->second;
+}
+
+SearchPattern::SearchPattern(const std::string &pattern)
+{
+    // expressions that match any text
+    if (pattern.empty() || pattern == ".*" || pattern == "^.*" || pattern == ".*$")
+        return;
+
+    std::string_view body = pattern;
+
+    bool starts = !body.empty() && body.front() == '^';
+
+    if (starts)
+        body.remove_prefix(1);
+
+    // the $ is an anchor only if it is not escaped
+    std::size_t backslashes = 0;
+
+    if (!body.empty() && body.back() == '$')
+        for (auto it = body.rbegin() + 1; it != body.rend() && *it == '\\'; it++)
+            backslashes++;
+
+    bool ends = !body.empty() && body.back() == '$' && backslashes % 2 == 0;
+
+    if (ends)
+        body.remove_suffix(1);
+
+    for (std::size_t i = 0; i < body.size(); i++)
+    {
+        auto c = body[i];
+
+        // escaped punctuation is the character itself, the escaped
+        // letters and digits are classes (\d, \w...) or references
+        bool special = c == '\\'
+                           ? i + 1 == body.size() || std::isalnum(static_cast<unsigned char>(body[i + 1]))
+                           : std::string_view("^$.|?*+()[]{}").find(c) != std::string_view::npos;
+
+        if (special)
+        {
+            literal.clear();
+            kind = kind_t::REGEX;
+            regex = compile(pattern);
+            return;
+        }
+
+        if (c == '\\')
+            c = body[++i];
+
+        literal.push_back(c);
+    }
+
+    if (starts && ends)
+        kind = kind_t::EXACT;
+    else if (literal.empty())
+        kind = kind_t::ANY;
+    else if (starts)
+        kind = kind_t::PREFIX;
+    else if (ends)
+        kind = kind_t::SUFFIX;
+    else
+        kind = kind_t::LITERAL;
+}
+
+bool SearchPattern::match(std::string_view text) const
+{
+    switch (kind)
+    {
+    case kind_t::ANY:
+        return true;
+    case kind_t::EXACT:
+        return text == literal;
+    case kind_t::PREFIX:
+        return text.starts_with(literal);
+    case kind_t::SUFFIX:
+        return text.ends_with(literal);
+    case kind_t::LITERAL:
+        return text.find(literal) != std::string_view::npos;
+    default:
+        return std::regex_search(text.begin(), text.end(), *regex);
+    }
+}
+
+void NameIndex::build(std::vector<std::string_view> table_names, bool with_trigrams)
+{
+    names = std::move(table_names);
+
+    sorted.resize(names.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [this](position_t a, position_t b)
+              { return names[a] < names[b] || (names[a] == names[b] && a < b); });
+
+    trigrams.clear();
+
+    if (!with_trigrams)
+        return;
+
+    for (position_t position = 0; position < names.size(); position++)
+    {
+        auto name = names[position];
+
+        for (std::size_t i = 0; i + 3 <= name.size(); i++)
+        {
+            auto &list = trigrams[trigram(name, i)];
+
+            // positions are visited in order, a repeated
+            // trigram of the same name is the last one
+            if (list.empty() || list.back() != position)
+                list.push_back(position);
+        }
+    }
+}
+
+std::vector<NameIndex::position_t> NameIndex::scan(const SearchPattern &pattern, unsigned threads) const
+{
+    return filter(
+        names.size(), [&](std::size_t i)
+        { return pattern.match(names[i]); },
+        threads);
+}
+
+std::vector<NameIndex::position_t> NameIndex::search(const SearchPattern &pattern, unsigned threads) const
+{
+    std::vector<position_t> result;
+    const auto &literal = pattern.get_literal();
+
+    auto by_name = [this](position_t position, std::string_view name)
+    { return names[position] < name; };
+
+    switch (pattern.get_kind())
+    {
+    case SearchPattern::kind_t::ANY:
+        result.resize(names.size());
+        std::iota(result.begin(), result.end(), 0);
+        return result;
+
+    case SearchPattern::kind_t::EXACT:
+    case SearchPattern::kind_t::PREFIX:
+    {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), std::string_view(literal), by_name);
+
+        for (; it != sorted.end() && pattern.match(names[*it]); it++)
+            result.push_back(*it);
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    case SearchPattern::kind_t::LITERAL:
+    case SearchPattern::kind_t::SUFFIX:
+    {
+        if (trigrams.empty() || literal.size() < 3)
+            return scan(pattern, threads);
+
+        // the names with the rarest trigram of the text are the
+        // only ones that can contain it
+        const std::vector<position_t> *candidates = nullptr;
+
+        for (std::size_t i = 0; i + 3 <= literal.size(); i++)
+        {
+            auto it = trigrams.find(trigram(literal, i));
+
+            if (it == trigrams.end())
+                return result;
+
+            if (candidates == nullptr || it->second.size() < candidates->size())
+                candidates = &it->second;
+        }
+
+        for (auto position : *candidates)
+            if (pattern.match(names[position]))
+                result.push_back(position);
+
+        return result;
+    }
+
+    default:
+        return scan(pattern, threads);
+    }
+}
@@ -0,0 +1,664 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file ssa.cpp
+
+#include "Kunai/DEX/analysis/ssa.hpp"
+
+#include <algorithm>
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    /// @brief Get the normal predecessors of a block that give an
+    /// operand to its phis, none for the handlers only reached by
+    /// the exceptions
+    std::span<const BasicBlocks::block_id_t> normal_predecessors(const BasicBlocks &blocks, BasicBlocks::block_id_t id)
+    {
+        if (blocks.is_reached_by_exceptions_only(id))
+            return {};
+        return blocks.get_predecessor_ids(id);
+    }
+}
+
+SSAForm::SSAForm(MethodAnalysis *method)
+    : accesses(method)
+{
+    const auto &blocks = method->get_basic_blocks();
+    auto number_of_registers = accesses.get_number_of_registers();
+
+    number_of_parameters = number_of_registers - accesses.get_first_parameter();
+    number_of_defs = static_cast<std::uint32_t>(accesses.get_number_of_defs());
+
+    DominatorTree dominators(blocks, false, true);
+    LivenessAnalysis liveness(method, accesses);
+
+    auto phis = place_phis(blocks, dominators, liveness);
+
+    value_registers.reserve(number_of_parameters + number_of_defs + phis.size());
+
+    for (auto reg = accesses.get_first_parameter(); reg < number_of_registers; reg++)
+        value_registers.push_back(static_cast<std::uint16_t>(reg));
+
+    for (std::uint32_t i = 0; i < accesses.size(); i++)
+        for (auto reg : accesses.get_defs(i))
+            value_registers.push_back(reg);
+
+    // the phis of each block and their operands
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+
+    block_phi_offsets.assign(number_of_blocks + 1, 0);
+    phi_operand_offsets.reserve(phis.size() + 1);
+    phi_operand_offsets.push_back(0);
+
+    for (const auto &[block, reg] : phis)
+    {
+        block_phi_offsets[block + 1]++;
+        phi_blocks.push_back(block);
+        value_registers.push_back(reg);
+        phi_operand_offsets.push_back(phi_operand_offsets.back() +
+                                      static_cast<std::uint32_t>(normal_predecessors(blocks, block).size() +
+                                                                 blocks.get_exception_predecessor_ids(block).size()));
+    }
+
+    for (std::size_t i = 0; i < number_of_blocks; i++)
+        block_phi_offsets[i + 1] += block_phi_offsets[i];
+
+    phi_operands.assign(phi_operand_offsets.back(), no_value);
+    use_values.assign(accesses.get_number_of_uses(), no_value);
+
+    rename(blocks, dominators);
+    compute_users();
+}
+
+std::vector<std::pair<SSAForm::block_id_t, std::uint16_t>> SSAForm::place_phis(const BasicBlocks &blocks,
+                                                                                const DominatorTree &dominators,
+                                                                                const LivenessAnalysis &liveness)
+{
+    const auto &instructions = accesses.get_instructions();
+    auto number_of_registers = accesses.get_number_of_registers();
+
+    // pairs of register and block where it is written
+    std::vector<std::pair<std::uint16_t, block_id_t>> def_blocks;
+
+    // pairs of register and handler that need a phi, the handler can
+    // see any of the values written by the block that throws
+    std::vector<std::pair<std::uint16_t, block_id_t>> handler_defs;
+
+    if (dominators.get_root() != DominatorTree::no_block)
+        for (auto reg = accesses.get_first_parameter(); reg < number_of_registers; reg++)
+            def_blocks.emplace_back(static_cast<std::uint16_t>(reg), dominators.get_root());
+
+    for (auto block : blocks.get_nodes())
+    {
+        auto &block_instructions = block->get_instructions();
+
+        if (block_instructions.empty())
+            continue;
+
+        auto index = accesses.get_index(block_instructions.front());
+
+        for (auto instr : block_instructions)
+        {
+            if (index >= instructions.size() || instructions[index] != instr)
+                index = accesses.get_index(instr);
+
+            for (auto reg : accesses.get_defs(index))
+            {
+                def_blocks.emplace_back(reg, block->get_id());
+
+                for (auto handler : blocks.get_exception_sucessor_ids(block->get_id()))
+                    if (liveness.is_live_in(handler, reg))
+                        handler_defs.emplace_back(reg, handler);
+            }
+
+            index++;
+        }
+    }
+
+    std::sort(def_blocks.begin(), def_blocks.end());
+    def_blocks.erase(std::unique(def_blocks.begin(), def_blocks.end()), def_blocks.end());
+
+    std::sort(handler_defs.begin(), handler_defs.end());
+    handler_defs.erase(std::unique(handler_defs.begin(), handler_defs.end()), handler_defs.end());
+
+    std::vector<std::pair<block_id_t, std::uint16_t>> phis;
+
+    // the marks store the register + 1 that visited the block last
+    auto number_of_blocks = blocks.get_number_of_block_ids();
+    std::vector<std::uint32_t> has_phi(number_of_blocks, 0), in_worklist(number_of_blocks, 0);
+    std::vector<block_id_t> worklist;
+
+    std::size_t next_handler = 0;
+
+    for (std::size_t first = 0; first < def_blocks.size();)
+    {
+        auto reg = def_blocks[first].first;
+        std::uint32_t mark = reg + 1;
+
+        worklist.clear();
+
+        for (; first < def_blocks.size() && def_blocks[first].first == reg; first++)
+        {
+            worklist.push_back(def_blocks[first].second);
+            in_worklist[def_blocks[first].second] = mark;
+        }
+
+        // the registers are written in the blocks that throw, so
+        // every register of `handler_defs` is in `def_blocks`
+        for (; next_handler < handler_defs.size() && handler_defs[next_handler].first == reg; next_handler++)
+        {
+            auto handler = handler_defs[next_handler].second;
+
+            has_phi[handler] = mark;
+            phis.emplace_back(handler, reg);
+
+            if (in_worklist[handler] != mark)
+            {
+                in_worklist[handler] = mark;
+                worklist.push_back(handler);
+            }
+        }
+
+        while (!worklist.empty())
+        {
+            auto x = worklist.back();
+            worklist.pop_back();
+
+            for (auto y : dominators.get_dominance_frontier(x))
+            {
+                // a dead register does not need a phi
+                if (has_phi[y] == mark || !liveness.is_live_in(y, reg))
+                    continue;
+
+                has_phi[y] = mark;
+                phis.emplace_back(y, reg);
+
+                // the phi is a new definition of the register
+                if (in_worklist[y] != mark)
+                {
+                    in_worklist[y] = mark;
+                    worklist.push_back(y);
+                }
+            }
+        }
+    }
+
+    std::sort(phis.begin(), phis.end());
+
+    return phis;
+}
+
+void SSAForm::rename(const BasicBlocks &blocks, const DominatorTree &dominators)
+{
+    auto root = dominators.get_root();
+
+    if (root == DominatorTree::no_block)
+        return;
+
+    const auto &instructions = accesses.get_instructions();
+
+    // value of each register in the current block, and the
+    // previous values to restore when a block is left
+    std::vector<value_id_t> current(accesses.get_number_of_registers(), no_value);
+    std::vector<std::pair<std::uint16_t, value_id_t>> saved;
+
+    for (std::uint32_t i = 0; i < number_of_parameters; i++)
+        current[value_registers[i]] = i;
+
+    // number of the visit of the block that wrote each register last,
+    // the handlers can see any of the values written by a block
+    std::vector<std::uint32_t> written(accesses.get_number_of_registers(), 0);
+    std::uint32_t visit = 0;
+
+    auto define = [&](std::uint16_t reg, value_id_t value)
+    {
+        saved.emplace_back(reg, current[reg]);
+        current[reg] = value;
+    };
+
+    // depth first search over the dominator tree, each entry keeps the
+    // block, the next child to visit and the size of `saved` at entry
+    struct entry_t
+    {
+        block_id_t block;
+        std::uint32_t next;
+        std::size_t mark;
+    };
+
+    std::vector<entry_t> stack;
+
+    auto enter = [&](block_id_t id)
+    {
+        stack.push_back({id, 0, saved.size()});
+        visit++;
+
+        for (auto phi : get_phis(id))
+            define(value_registers[phi], phi);
+
+        auto &block_instructions = blocks.get_block(id)->get_instructions();
+
+        if (!block_instructions.empty())
+        {
+            auto index = accesses.get_index(block_instructions.front());
+
+            for (auto instr : block_instructions)
+            {
+                if (index >= instructions.size() || instructions[index] != instr)
+                    index = accesses.get_index(instr);
+
+                auto use = accesses.get_first_use(index);
+
+                for (auto reg : accesses.get_uses(index))
+                    use_values[use++] = current[reg];
+
+                auto value = number_of_parameters + accesses.get_first_def(index);
+
+                for (auto reg : accesses.get_defs(index))
+                {
+                    written[reg] = visit;
+                    define(reg, value++);
+                }
+
+                index++;
+            }
+        }
+
+        // operands of the phis of the sucessors
+        for (auto suc : blocks.get_sucessor_ids(id))
+        {
+            auto preds = normal_predecessors(blocks, suc);
+            auto it = std::find(preds.begin(), preds.end(), id);
+
+            if (it == preds.end())
+                continue;
+
+            auto position = static_cast<std::uint32_t>(it - preds.begin());
+
+            for (auto phi : get_phis(suc))
+            {
+                auto phi_index = phi - number_of_parameters - number_of_defs;
+                phi_operands[phi_operand_offsets[phi_index] + position] = current[value_registers[phi]];
+            }
+        }
+
+        // the operands of the handlers go after the normal predecessors,
+        // a register written by the block has no single value
+        for (auto handler : blocks.get_exception_sucessor_ids(id))
+        {
+            auto preds = blocks.get_exception_predecessor_ids(handler);
+            auto position = static_cast<std::uint32_t>(normal_predecessors(blocks, handler).size() +
+                                                       (std::find(preds.begin(), preds.end(), id) - preds.begin()));
+
+            for (auto phi : get_phis(handler))
+            {
+                auto reg = value_registers[phi];
+                auto phi_index = phi - number_of_parameters - number_of_defs;
+                phi_operands[phi_operand_offsets[phi_index] + position] = written[reg] == visit ? no_value : current[reg];
+            }
+        }
+    };
+
+    enter(root);
+
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        auto children = dominators.get_children(top.block);
+
+        if (top.next < children.size())
+        {
+            auto child = children[top.next++];
+            enter(child);
+            continue;
+        }
+
+        // restore the values from before the block
+        for (auto mark = top.mark; saved.size() > mark; saved.pop_back())
+            current[saved.back().first] = saved.back().second;
+
+        stack.pop_back();
+    }
+}
+
+void SSAForm::compute_users()
+{
+    auto number_of_values = value_registers.size();
+
+    // the marks avoid repeating a user that reads the same value twice
+    std::vector<std::uint32_t> last(number_of_values, 0);
+
+    user_offsets.assign(number_of_values + 1, 0);
+
+    for (std::uint32_t i = 0; i < accesses.size(); i++)
+        for (auto value : get_values_used(i))
+            if (value != no_value && last[value] != i + 1)
+            {
+                last[value] = i + 1;
+                user_offsets[value + 1]++;
+            }
+
+    for (std::size_t i = 0; i < number_of_values; i++)
+        user_offsets[i + 1] += user_offsets[i];
+
+    users.resize(user_offsets[number_of_values]);
+
+    std::vector<std::uint32_t> next(user_offsets.begin(), user_offsets.end() - 1);
+    std::fill(last.begin(), last.end(), 0);
+
+    for (std::uint32_t i = 0; i < accesses.size(); i++)
+        for (auto value : get_values_used(i))
+            if (value != no_value && last[value] != i + 1)
+            {
+                last[value] = i + 1;
+                users[next[value]++] = i;
+            }
+
+    // same for the operands of the phis
+    auto first_phi = number_of_parameters + number_of_defs;
+
+    phi_user_offsets.assign(number_of_values + 1, 0);
+    std::fill(last.begin(), last.end(), 0);
+
+    for (value_id_t phi = first_phi; phi < number_of_values; phi++)
+        for (auto value : get_phi_operands(phi))
+            if (value != no_value && last[value] != phi + 1)
+            {
+                last[value] = phi + 1;
+                phi_user_offsets[value + 1]++;
+            }
+
+    for (std::size_t i = 0; i < number_of_values; i++)
+        phi_user_offsets[i + 1] += phi_user_offsets[i];
+
+    phi_users.resize(phi_user_offsets[number_of_values]);
+
+    next.assign(phi_user_offsets.begin(), phi_user_offsets.end() - 1);
+    std::fill(last.begin(), last.end(), 0);
+
+    for (value_id_t phi = first_phi; phi < number_of_values; phi++)
+        for (auto value : get_phi_operands(phi))
+            if (value != no_value && last[value] != phi + 1)
+            {
+                last[value] = phi + 1;
+                phi_users[next[value]++] = phi;
+            }
+}
+
+std::uint32_t SSAForm::get_instruction_index(value_id_t value) const
+{
+    return accesses.get_def_instruction(value - number_of_parameters);
+}
+
+SSAForm::value_id_t SSAForm::get_value_defined(const Instruction *instr, std::uint16_t reg) const
+{
+    auto index = accesses.get_index(instr);
+
+    if (index >= accesses.size())
+        return no_value;
+
+    auto value = number_of_parameters + accesses.get_first_def(index);
+
+    for (auto written : accesses.get_defs(index))
+    {
+        if (written == reg)
+            return value;
+        value++;
+    }
+
+    return no_value;
+}
+
+SSAForm::value_id_t SSAForm::get_value_used(const Instruction *instr, std::uint16_t reg) const
+{
+    auto index = accesses.get_index(instr);
+
+    if (index >= accesses.size())
+        return no_value;
+
+    auto values = get_values_used(index);
+    auto registers = accesses.get_uses(index);
+
+    for (std::size_t i = 0; i < registers.size(); i++)
+        if (registers[i] == reg)
+            return values[i];
+
+    return no_value;
+}
+
+SSAConstantPropagation::SSAConstantPropagation(const SSAForm &ssa)
+    : ssa(ssa)
+{
+    auto number_of_values = ssa.get_number_of_values();
+
+    states.assign(number_of_values, state_t::UNKNOWN);
+    integers.assign(number_of_values, 0);
+    strings.assign(number_of_values, nullptr);
+
+    std::vector<value_id_t> worklist;
+    std::vector<std::uint8_t> in_worklist(number_of_values, 1);
+
+    worklist.reserve(number_of_values);
+
+    // the first values are popped first
+    for (auto value = static_cast<value_id_t>(number_of_values); value-- > 0;)
+        worklist.push_back(value);
+
+    auto push = [&](value_id_t value)
+    {
+        if (!in_worklist[value])
+        {
+            in_worklist[value] = 1;
+            worklist.push_back(value);
+        }
+    };
+
+    while (!worklist.empty())
+    {
+        auto value = worklist.back();
+        worklist.pop_back();
+        in_worklist[value] = 0;
+
+        auto state = state_t::UNKNOWN;
+        std::int64_t integer = 0;
+        const std::string *string = nullptr;
+
+        evaluate(value, state, integer, string);
+
+        if (state == states[value] && integer == integers[value] && string == strings[value])
+            continue;
+
+        states[value] = state;
+        integers[value] = integer;
+        strings[value] = string;
+
+        for (auto user : ssa.get_users(value))
+            for (auto defined : ssa.get_values_defined(user))
+                push(defined);
+
+        for (auto phi : ssa.get_phi_users(value))
+            push(phi);
+    }
+}
+
+void SSAConstantPropagation::evaluate(value_id_t value, state_t &state, std::int64_t &integer, const std::string *&string) const
+{
+    using opcodes = TYPES::opcodes;
+
+    state = state_t::NOT_CONSTANT;
+
+    switch (ssa.get_kind(value))
+    {
+    case SSAForm::value_kind_t::PARAMETER:
+        return;
+    case SSAForm::value_kind_t::PHI:
+    {
+        // meet of the operands, the unknown ones are ignored and the
+        // operands without value (no_value) are not constant
+        state = state_t::UNKNOWN;
+
+        for (auto operand : ssa.get_phi_operands(value))
+        {
+            auto operand_state = get_state(operand);
+
+            if (operand_state == state_t::UNKNOWN)
+                continue;
+
+            if (operand_state == state_t::NOT_CONSTANT ||
+                (state != state_t::UNKNOWN &&
+                 (state != operand_state || integers[operand] != integer || strings[operand] != string)))
+            {
+                state = state_t::NOT_CONSTANT;
+                return;
+            }
+
+            state = operand_state;
+            integer = integers[operand];
+            string = strings[operand];
+        }
+        return;
+    }
+    default:
+        break;
+    }
+
+    auto index = ssa.get_instruction_index(value);
+    auto instr = ssa.get_register_accesses().get_instructions()[index];
+    auto op = instr->get_instruction_opcode();
+
+    // the number of a wide constant is kept by the low register
+    // of the pair, the high register has only half of the bits
+    auto high_register = value != *ssa.get_values_defined(index).begin();
+
+    auto constant = [&](std::int64_t number)
+    {
+        if (high_register)
+            return;
+
+        state = state_t::INTEGER;
+        integer = number;
+    };
+
+    switch (instr->get_instruction_type())
+    {
+    case dexinsttype_t::DEX_INSTRUCTION11N:
+        constant(reinterpret_cast<Instruction11n *>(instr)->get_source());
+        return;
+    case dexinsttype_t::DEX_INSTRUCTION21S:
+        constant(reinterpret_cast<Instruction21s *>(instr)->get_source());
+        return;
+    case dexinsttype_t::DEX_INSTRUCTION21H:
+        constant(reinterpret_cast<Instruction21h *>(instr)->get_source());
+        return;
+    case dexinsttype_t::DEX_INSTRUCTION31I:
+        constant(static_cast<std::int32_t>(reinterpret_cast<Instruction31i *>(instr)->get_source()));
+        return;
+    case dexinsttype_t::DEX_INSTRUCTION51L:
+        constant(reinterpret_cast<Instruction51l *>(instr)->get_wide_value());
+        return;
+    case dexinsttype_t::DEX_INSTRUCTION21C:
+    {
+        auto const_instr = reinterpret_cast<Instruction21c *>(instr);
+
+        if (op == opcodes::OP_CONST_STRING && const_instr->is_source_string())
+        {
+            state = state_t::STRING;
+            string = &const_instr->get_source_str();
+        }
+        return;
+    }
+    case dexinsttype_t::DEX_INSTRUCTION31C:
+        state = state_t::STRING;
+        string = &reinterpret_cast<Instruction31c *>(instr)->get_string_value();
+        return;
+    default:
+        break;
+    }
+
+    auto operands = ssa.get_values_used(index);
+
+    // the moves copy the value in the same position of the pair
+    if (op >= opcodes::OP_MOVE && op <= opcodes::OP_MOVE_OBJECT_16)
+    {
+        auto position = value - *ssa.get_values_defined(index).begin();
+
+        if (position >= operands.size())
+            return;
+
+        auto source = operands[position];
+
+        state = get_state(source);
+
+        if (state != state_t::UNKNOWN && state != state_t::NOT_CONSTANT)
+        {
+            integer = integers[source];
+            string = strings[source];
+        }
+        return;
+    }
+
+    // int operations with a literal: add, rsub, mul, div, rem, and, or,
+    // xor and for the lit8 ones also shl, shr and ushr
+    std::uint32_t operation;
+    std::int32_t literal;
+
+    if (op >= opcodes::OP_ADD_INT_LIT16 && op <= opcodes::OP_XOR_INT_LIT16)
+    {
+        operation = op - opcodes::OP_ADD_INT_LIT16;
+        literal = reinterpret_cast<Instruction22s *>(instr)->get_second_operand();
+    }
+    else if (op >= opcodes::OP_ADD_INT_LIT8 && op <= opcodes::OP_USHR_INT_LIT8)
+    {
+        operation = op - opcodes::OP_ADD_INT_LIT8;
+        literal = reinterpret_cast<Instruction22b *>(instr)->get_second_operand();
+    }
+    else
+        return;
+
+    if (operands.empty())
+        return;
+
+    state = get_state(operands[0]);
+
+    if (state != state_t::INTEGER)
+    {
+        if (state == state_t::STRING)
+            state = state_t::NOT_CONSTANT;
+        return;
+    }
+
+    auto a = static_cast<std::int32_t>(integers[operands[0]]);
+    auto ua = static_cast<std::uint32_t>(a);
+    auto ub = static_cast<std::uint32_t>(literal);
+    std::uint32_t result;
+
+    switch (operation)
+    {
+    case 0: result = ua + ub; break;
+    case 1: result = ub - ua; break;
+    case 2: result = ua * ub; break;
+    case 3:
+    case 4:
+        if (literal == 0)
+        {
+            state = state_t::NOT_CONSTANT;
+            return;
+        }
+        if (a == std::numeric_limits<std::int32_t>::min() && literal == -1)
+            result = operation == 3 ? ua : 0;
+        else
+            result = static_cast<std::uint32_t>(operation == 3 ? a / literal : a % literal);
+        break;
+    case 5: result = ua & ub; break;
+    case 6: result = ua | ub; break;
+    case 7: result = ua ^ ub; break;
+    case 8: result = ua << (ub & 31); break;
+    case 9: result = static_cast<std::uint32_t>(a >> (ub & 31)); break;
+    default: result = ua >> (ub & 31); break;
+    }
+
+    constant(static_cast<std::int32_t>(result));
+}
@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file string_scanner.cpp
+
+#include "Kunai/DEX/analysis/string_scanner.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using namespace KUNAI::DEX;
+
+PatternSet::PatternSet(std::vector<std::string> set_patterns)
+    : patterns(std::move(set_patterns))
+{
+    // trie of the patterns, the transitions of each state
+    // are kept sorted by byte
+    std::vector<std::vector<std::pair<std::uint8_t, state_t>>> children(1);
+    std::vector<std::vector<pattern_t>> ends(1);
+
+    auto child = [&](state_t state, std::uint8_t byte)
+    {
+        auto &edges = children[state];
+        auto it = std::lower_bound(edges.begin(), edges.end(), byte, [](const auto &edge, std::uint8_t b)
+                                   { return edge.first < b; });
+
+        return it != edges.end() && it->first == byte ? it->second : no_state;
+    };
+
+    for (pattern_t pattern = 0; pattern < patterns.size(); pattern++)
+    {
+        if (patterns[pattern].empty())
+            continue;
+
+        state_t state = 0;
+
+        for (auto c : patterns[pattern])
+        {
+            auto byte = static_cast<std::uint8_t>(c);
+            auto next_state = child(state, byte);
+
+            if (next_state == no_state)
+            {
+                next_state = static_cast<state_t>(children.size());
+
+                auto &edges = children[state];
+                auto it = std::lower_bound(edges.begin(), edges.end(), byte, [](const auto &edge, std::uint8_t b)
+                                           { return edge.first < b; });
+                edges.insert(it, {byte, next_state});
+
+                children.emplace_back();
+                ends.emplace_back();
+            }
+
+            state = next_state;
+        }
+
+        ends[state].push_back(pattern);
+    }
+
+    auto number_of_states = children.size();
+
+    failure.assign(number_of_states, 0);
+    output_link.assign(number_of_states, no_state);
+
+    // the failure links are computed breadth first, so the
+    // link of a state is always shorter and already known
+    std::vector<state_t> queue;
+
+    for (const auto &edge : children[0])
+    {
+        root[edge.first] = edge.second;
+        queue.push_back(edge.second);
+    }
+
+    for (std::size_t next_position = 0; next_position < queue.size(); next_position++)
+    {
+        auto state = queue[next_position];
+
+        for (const auto &edge : children[state])
+        {
+            auto target = edge.second;
+            auto fallback = failure[state];
+
+            while (fallback != 0 && child(fallback, edge.first) == no_state)
+                fallback = failure[fallback];
+
+            auto link = child(fallback, edge.first);
+
+            failure[target] = link == no_state ? 0 : link;
+            output_link[target] = ends[failure[target]].empty() ? output_link[failure[target]] : failure[target];
+
+            queue.push_back(target);
+        }
+    }
+
+    // compressed rows of the transitions and the outputs
+    edge_offsets.resize(number_of_states + 1);
+    output_offsets.resize(number_of_states + 1);
+
+    for (std::size_t state = 0; state < number_of_states; state++)
+    {
+        edge_offsets[state] = static_cast<std::uint32_t>(edge_bytes.size());
+        output_offsets[state] = static_cast<std::uint32_t>(outputs.size());
+
+        for (const auto &edge : children[state])
+        {
+            edge_bytes.push_back(edge.first);
+            edge_targets.push_back(edge.second);
+        }
+
+        outputs.insert(outputs.end(), ends[state].begin(), ends[state].end());
+    }
+
+    edge_offsets[number_of_states] = static_cast<std::uint32_t>(edge_bytes.size());
+    output_offsets[number_of_states] = static_cast<std::uint32_t>(outputs.size());
+}
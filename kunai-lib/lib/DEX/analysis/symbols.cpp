@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file symbols.cpp
+
+#include "Kunai/DEX/analysis/symbols.hpp"
+
+using namespace KUNAI::DEX;
+
+SymbolNames::symbol_id_t SymbolNames::intern(std::string_view name)
+{
+    auto it = index.find(name);
+
+    if (it != index.end())
+        return it->second;
+
+    auto id = static_cast<symbol_id_t>(names.size());
+    auto &stored = names.emplace_back(name);
+
+    index.emplace(stored, id);
+
+    return id;
+}
+
+std::string SymbolTable::method_name(MethodID *method)
+{
+    return method->get_class()->get_raw() + "->" + method->get_name() + method->get_proto()->get_descriptor();
+}
+
+std::string SymbolTable::field_name(FieldID *field)
+{
+    return field->get_class()->get_raw() + "->" + field->get_name() + ":" + field->get_type()->get_raw();
+}
+
+const SymbolTable::parser_symbols_t &SymbolTable::add_parser(Parser *parser)
+{
+    auto &symbols = parsers.emplace_back();
+
+    symbols.parser = parser;
+
+    auto &ordered_types = parser->get_types().get_ordered_types();
+
+    symbols.types.reserve(ordered_types.size());
+
+    for (auto &type : ordered_types)
+    {
+        if (type->get_type() == DVMType::CLASS)
+            symbols.types.push_back(classes.intern(reinterpret_cast<DVMClass *>(type.get())->get_name()));
+        else
+            symbols.types.push_back(no_symbol);
+    }
+
+    auto &method_list = parser->get_methods().get_methods();
+
+    symbols.methods.reserve(method_list.size());
+
+    for (auto &method : method_list)
+    {
+        auto id = methods.intern(method_name(method.get()));
+
+        // first time the method is found
+        if (id == method_classes.size())
+        {
+            auto cls = method->get_class();
+
+            method_classes.push_back(cls->get_type() == DVMType::CLASS
+                                         ? classes.intern(reinterpret_cast<DVMClass *>(cls)->get_name())
+                                         : no_symbol);
+            method_ids.push_back(method.get());
+        }
+
+        symbols.methods.push_back(id);
+    }
+
+    auto &field_list = parser->get_fields().get_fields();
+
+    symbols.fields.reserve(field_list.size());
+
+    for (auto &field : field_list)
+        symbols.fields.push_back(fields.intern(field_name(field.get())));
+
+    auto &ordered_strings = parser->get_strings().get_ordered_strings();
+
+    symbols.strings.reserve(ordered_strings.size());
+
+    for (auto &value : ordered_strings)
+        symbols.strings.push_back(strings.intern(value));
+
+    return symbols;
+}
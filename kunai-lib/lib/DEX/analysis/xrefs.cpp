@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer: library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @author Ernesto Java <javaernesto@gmail.com>
+//
+// @file xrefs.cpp
+
+#include "Kunai/DEX/analysis/xrefs.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace KUNAI::DEX;
+
+namespace
+{
+    /// @brief number of symbols that can be destination of a kind of xref
+    std::size_t number_of_destinations(const SymbolTable &symbols, XrefTable::xref_kind_t kind)
+    {
+        switch (kind)
+        {
+        case XrefTable::xref_kind_t::CALL:
+            return symbols.get_number_of_methods();
+        case XrefTable::xref_kind_t::FIELD_READ:
+        case XrefTable::xref_kind_t::FIELD_WRITE:
+            return symbols.get_number_of_fields();
+        case XrefTable::xref_kind_t::STRING:
+            return symbols.get_number_of_strings();
+        default:
+            return symbols.get_number_of_classes();
+        }
+    }
+}
+
+void XrefTable::finish()
+{
+    std::sort(xrefs.begin(), xrefs.end(), [](const xref_t &a, const xref_t &b)
+              { return std::tie(a.src, a.kind, a.offset, a.dst, a.opcode) <
+                       std::tie(b.src, b.kind, b.offset, b.dst, b.opcode); });
+
+    xrefs.erase(std::unique(xrefs.begin(), xrefs.end()), xrefs.end());
+    xrefs.shrink_to_fit();
+
+    // index of the source methods
+    from_offsets.assign(symbols.get_number_of_methods() + 1, 0);
+
+    for (const auto &xref : xrefs)
+        from_offsets[xref.src + 1]++;
+
+    for (std::size_t i = 1; i < from_offsets.size(); i++)
+        from_offsets[i] += from_offsets[i - 1];
+
+    // index of the destinations, each kind takes a consecutive
+    // part of to_xrefs, so the offsets of a kind start where
+    // the previous kind finished
+    std::uint32_t base = 0;
+
+    for (std::size_t kind = 0; kind < number_of_kinds; kind++)
+    {
+        auto &offsets = to_offsets[kind];
+
+        offsets.assign(number_of_destinations(symbols, static_cast<xref_kind_t>(kind)) + 1, 0);
+        offsets[0] = base;
+
+        for (const auto &xref : xrefs)
+            if (static_cast<std::size_t>(xref.kind) == kind)
+                offsets[xref.dst + 1]++;
+
+        for (std::size_t i = 1; i < offsets.size(); i++)
+            offsets[i] += offsets[i - 1];
+
+        base = offsets.back();
+    }
+
+    // xrefs are visited by method and offset, so each destination
+    // keeps its xrefs in that order
+    to_xrefs.resize(xrefs.size());
+
+    std::array<std::vector<std::uint32_t>, number_of_kinds> next;
+
+    for (std::size_t kind = 0; kind < number_of_kinds; kind++)
+        next[kind].assign(to_offsets[kind].begin(), to_offsets[kind].end() - 1);
+
+    for (std::uint32_t i = 0; i < xrefs.size(); i++)
+        to_xrefs[next[static_cast<std::size_t>(xrefs[i].kind)][xrefs[i].dst]++] = i;
+
+    generation++;
+}
+
+std::span<const XrefTable::xref_t> XrefTable::get_xrefs_from(symbol_id_t method) const
+{
+    if (static_cast<std::size_t>(method) + 1 >= from_offsets.size())
+        return {};
+
+    return std::span<const xref_t>(xrefs).subspan(from_offsets[method],
+                                                  from_offsets[method + 1] - from_offsets[method]);
+}
+
+std::span<const XrefTable::xref_t> XrefTable::get_xrefs_from(symbol_id_t method, xref_kind_t kind) const
+{
+    auto all = get_xrefs_from(method);
+
+    auto begin = std::partition_point(all.begin(), all.end(), [kind](const xref_t &xref)
+                                      { return xref.kind < kind; });
+    auto end = std::partition_point(begin, all.end(), [kind](const xref_t &xref)
+                                    { return xref.kind == kind; });
+
+    return {begin, end};
+}
+
+std::span<const std::uint32_t> XrefTable::get_xrefs_to(xref_kind_t kind, symbol_id_t id) const
+{
+    const auto &offsets = to_offsets[static_cast<std::size_t>(kind)];
+
+    if (static_cast<std::size_t>(id) + 1 >= offsets.size())
+        return {};
+
+    return std::span<const std::uint32_t>(to_xrefs).subspan(offsets[id], offsets[id + 1] - offsets[id]);
+}
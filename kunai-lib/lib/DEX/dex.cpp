@@ -34,12 +34,9 @@ Analysis * Dex::get_analysis(bool create_xrefs)
 {
     if (!parsing_correct)
         return nullptr;
-    /// disassembly the dex file
-    dex_disassembler->disassembly_dex();
-    /// check if disassembly was correct
-    if (!dex_disassembler->correct_disassembly())
-        return nullptr;
-    
+    /// the methods are disassembled on demand by
+    /// the analysis object, no need to disassembly
+    /// the whole dex file here
     analysis = std::make_unique<Analysis>(parser.get(), dex_disassembler.get(), create_xrefs);
 
     return analysis.get();
@@ -45,4 +45,16 @@ void Parser::parse_file()
     classes.parse_classes(stream, dex_header.class_defs_size, dex_header.class_defs_off, &strings, &types, &fields, &methods);
 
     logger->debug("parser.cpp: dex file parsing correct");
-}
\ No newline at end of file
+}
+
+void Parser::create_pretty_names()
+{
+    for (const auto &type : types.get_ordered_types())
+        type->pretty_print();
+
+    for (const auto &field : fields.get_fields())
+        field->pretty_field();
+
+    for (const auto &method : methods.get_methods())
+        method->pretty_method();
+}
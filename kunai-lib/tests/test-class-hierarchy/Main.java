@@ -0,0 +1,53 @@
+interface Shape {
+    int area();
+}
+
+abstract class Base implements Shape {
+    public abstract int area();
+
+    public String name() {
+        return "base";
+    }
+}
+
+class Square extends Base {
+    public int area() {
+        return 4;
+    }
+}
+
+class Circle extends Base {
+    public int area() {
+        return 3;
+    }
+
+    public String name() {
+        return "circle";
+    }
+}
+
+class Tile implements Shape {
+    public int area() {
+        return 1;
+    }
+}
+
+class Task implements Runnable {
+    public void run() {
+    }
+}
+
+public class Main {
+
+    public static void main(String[] args) {
+        Base base = new Square();
+        Shape shape = new Tile();
+
+        System.out.println(base.area());
+        System.out.println(base.name());
+        System.out.println(shape.area());
+
+        Runnable task = new Task();
+        task.run();
+    }
+}
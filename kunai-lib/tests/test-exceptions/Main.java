@@ -0,0 +1,18 @@
+public class Main {
+
+    public static int test(int a) {
+        int x = 1;
+
+        try {
+            a = 10 / a;
+            x = 2;
+        } catch (ArithmeticException e) {
+        }
+
+        return x;
+    }
+
+    public static void main(String[] args) {
+        System.out.println(test(args.length));
+    }
+}
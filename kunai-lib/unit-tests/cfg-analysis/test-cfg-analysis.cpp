@@ -0,0 +1,497 @@
+//--------------------------------------------------------------------*- C++ -*-
+// Kunai-static-analyzer, library for doing analysis of dalvik files
+// @author Farenain <kunai.static.analysis@gmail.com>
+// @file test-cfg-analysis.cpp
+// @brief Unit test script for the analyses over the basic blocks of the methods
+
+#include "test-cfg-analysis.inc"
+#include "Kunai/DEX/dex.hpp"
+#include "Kunai/Utils/logger.hpp"
+#include <algorithm>
+#include <assert.h>
+
+using namespace KUNAI::DEX;
+
+/// @brief Find a method by its name in an analysis
+MethodAnalysis *find_method(Analysis *analysis, const std::string &name)
+{
+    for (const auto &method : analysis->get_methods())
+        if (method.second->get_name() == name)
+            return method.second.get();
+    return nullptr;
+}
+
+/// @brief Get the id of the block that starts in an address
+BasicBlocks::block_id_t block(MethodAnalysis *method, std::uint64_t address)
+{
+    auto bb = method->get_block_at(address);
+    assert(bb && bb->get_first_address() == address && "Expected a block in the address");
+    return bb->get_id();
+}
+
+/// @brief Get the id of the start or the end block
+BasicBlocks::block_id_t special_block(MethodAnalysis *method, bool start)
+{
+    for (auto bb : method->get_basic_blocks().get_nodes())
+        if ((start && bb->is_start_block()) || (!start && bb->is_end_block()))
+            return bb->get_id();
+    assert(false && "Expected start and end blocks");
+    return 0;
+}
+
+/// @brief Dominators of the main method of test-try-catch:
+///
+///     start -> 0, start -> 76
+///     0 -> 30, 0 -> 46, 30 -> 60, 46 -> 60
+///     60 -> 92, 76 -> 92, 92 -> end
+void test_dominators(MethodAnalysis *main)
+{
+    auto &blocks = main->get_basic_blocks();
+
+    auto start = special_block(main, true);
+    auto end = special_block(main, false);
+    auto b0 = block(main, 0), b30 = block(main, 30), b46 = block(main, 46);
+    auto b60 = block(main, 60), b76 = block(main, 76), b92 = block(main, 92);
+
+    DominatorTree dominators(blocks);
+
+    assert(dominators.get_root() == start && "Expected start block as root of the dominator tree");
+    assert(dominators.get_reverse_postorder().size() == 8 && "Expected all the blocks reachable");
+    assert(dominators.get_immediate_dominator(start) == DominatorTree::no_block && "Root with immediate dominator");
+    assert(dominators.get_immediate_dominator(b0) == start && "Incorrect immediate dominator of block 0");
+    assert(dominators.get_immediate_dominator(b30) == b0 && "Incorrect immediate dominator of block 30");
+    assert(dominators.get_immediate_dominator(b46) == b0 && "Incorrect immediate dominator of block 46");
+    assert(dominators.get_immediate_dominator(b60) == b0 && "Incorrect immediate dominator of block 60");
+    assert(dominators.get_immediate_dominator(b76) == start && "Incorrect immediate dominator of block 76");
+    assert(dominators.get_immediate_dominator(b92) == start && "Incorrect immediate dominator of block 92");
+    assert(dominators.get_immediate_dominator(end) == b92 && "Incorrect immediate dominator of end block");
+
+    assert(dominators.dominates(b0, b60) && dominators.dominates(b0, b0) && "Block 0 must dominate block 60");
+    assert(!dominators.dominates(b30, b60) && "Block 30 cannot dominate block 60");
+    assert(!dominators.dominates(b0, b92) && "Block 0 cannot dominate block 92");
+    assert(dominators.strictly_dominates(start, end) && !dominators.strictly_dominates(b92, b92) && "Incorrect strict dominance");
+    assert(dominators.get_children(b0).size() == 3 && "Expected three children of block 0");
+
+    auto frontier = dominators.get_dominance_frontier(b30);
+    assert(frontier.size() == 1 && frontier[0] == b60 && "Incorrect frontier of block 30");
+    frontier = dominators.get_dominance_frontier(b0);
+    assert(frontier.size() == 1 && frontier[0] == b92 && "Incorrect frontier of block 0");
+    assert(dominators.get_dominance_frontier(b92).empty() && "Incorrect frontier of block 92");
+
+    DominatorTree post_dominators(blocks, true);
+
+    assert(post_dominators.get_root() == end && "Expected end block as root of the post-dominator tree");
+    assert(post_dominators.get_immediate_dominator(b92) == end && "Incorrect immediate post-dominator of block 92");
+    assert(post_dominators.get_immediate_dominator(b0) == b60 && "Incorrect immediate post-dominator of block 0");
+    assert(post_dominators.get_immediate_dominator(b30) == b60 && "Incorrect immediate post-dominator of block 30");
+    assert(post_dominators.get_immediate_dominator(b76) == b92 && "Incorrect immediate post-dominator of block 76");
+    assert(post_dominators.get_immediate_dominator(start) == b92 && "Incorrect immediate post-dominator of start block");
+    assert(post_dominators.dominates(b60, b46) && !post_dominators.dominates(b60, b76) && "Incorrect post-dominance");
+
+    frontier = post_dominators.get_dominance_frontier(b30);
+    assert(frontier.size() == 1 && frontier[0] == b0 && "Incorrect post-dominance frontier of block 30");
+}
+
+/// @brief Loops of graphs created by hand:
+///
+///     irreducible: start -> a, start -> b, a -> b, b -> a, b -> end
+///     nested: start -> h1, h1 -> h2, h2 -> h2, h2 -> t, t -> h1, h1 -> end
+void test_manual_loops()
+{
+    {
+        BasicBlocks blocks;
+
+        auto start = blocks.create_block();
+        auto a = blocks.create_block();
+        auto b = blocks.create_block();
+        auto end = blocks.create_block();
+
+        start->set_start_block(true);
+        end->set_end_block(true);
+
+        blocks.add_edge(start, a);
+        blocks.add_edge(start, b);
+        blocks.add_edge(a, b);
+        blocks.add_edge(b, a);
+        blocks.add_edge(b, end);
+
+        LoopForest forest(blocks);
+
+        assert(forest.get_number_of_loops() == 1 && "Expected one irreducible loop");
+        assert(!forest.is_reducible(0) && forest.get_number_of_irreducible_loops() == 1 && "Loop must be irreducible");
+        assert(forest.get_blocks(0).size() == 2 && "Expected two blocks in the irreducible loop");
+        assert(forest.get_loop_of(a->get_id()) == 0 && forest.get_loop_of(b->get_id()) == 0 && "Blocks out of the loop");
+        assert(forest.get_loop_of(start->get_id()) == LoopForest::no_loop && "Start block inside of a loop");
+    }
+
+    {
+        BasicBlocks blocks;
+
+        auto start = blocks.create_block();
+        auto h1 = blocks.create_block();
+        auto h2 = blocks.create_block();
+        auto t = blocks.create_block();
+        auto end = blocks.create_block();
+
+        start->set_start_block(true);
+        end->set_end_block(true);
+
+        blocks.add_edge(start, h1);
+        blocks.add_edge(h1, h2);
+        blocks.add_edge(h2, h2);
+        blocks.add_edge(h2, t);
+        blocks.add_edge(t, h1);
+        blocks.add_edge(h1, end);
+
+        LoopForest forest(blocks);
+
+        assert(forest.get_number_of_loops() == 2 && "Expected two nested loops");
+        assert(forest.get_number_of_irreducible_loops() == 0 && "Nested loops must be reducible");
+        assert(forest.get_max_depth() == 2 && "Expected nesting depth of 2");
+
+        auto inner = forest.get_loop_of(h2->get_id());
+        auto outer = forest.get_loop_of(h1->get_id());
+
+        assert(forest.get_header(inner) == h2->get_id() && forest.get_header(outer) == h1->get_id() && "Incorrect headers");
+        assert(inner < outer && forest.get_parent(inner) == outer && "Inner loop must be inside of the outer loop");
+        assert(forest.is_nested_in(inner, outer) && !forest.is_nested_in(outer, inner) && "Incorrect nesting");
+        assert(forest.get_loop_of(t->get_id()) == outer && forest.get_loop_depth(h2->get_id()) == 2 && "Incorrect loop of the blocks");
+        assert(forest.get_blocks(outer).size() == 2 && forest.get_blocks(outer)[0] == h1->get_id() && "Header must be the first block");
+    }
+}
+
+/// @brief Loop of the method test of test-loop, a while loop
+void test_loop_method(MethodAnalysis *method)
+{
+    LoopForest forest(method->get_basic_blocks());
+
+    assert(forest.get_number_of_loops() == 1 && "Expected one loop in the method");
+    assert(forest.is_reducible(0) && forest.get_max_depth() == 1 && "Expected a natural loop");
+    assert(forest.get_loop_depth(special_block(method, true)) == 0 && "Start block inside of a loop");
+}
+
+/// @brief Metrics of all the methods of test-try-catch
+void test_metrics(Analysis *analysis, MethodAnalysis *main)
+{
+    auto metrics = analysis->compute_method_metrics(2);
+
+    assert(metrics.size() > 0 && metrics.blocks.size() == metrics.size() && "Expected one row per method");
+
+    for (std::size_t i = 0; i < metrics.size(); i++)
+    {
+        assert(metrics.instructions[i] == metrics.methods[i]->get_instructions().size() && "Incorrect number of instructions");
+
+        if (metrics.methods[i] != main)
+            continue;
+
+        assert(metrics.blocks[i] == 8 && metrics.edges[i] == 9 && "Incorrect size of the graph of main");
+        assert(metrics.cyclomatic_complexity[i] == 3 && "Incorrect cyclomatic complexity of main");
+        assert(metrics.loops[i] == 0 && metrics.max_loop_depth[i] == 0 && "Unexpected loops in main");
+        assert(metrics.returns[i] == 1 && metrics.invokes[i] > 0 && "Incorrect instruction mix of main");
+    }
+}
+
+/// @brief Get the addresses of the instructions that define the value
+/// of a register read in an address
+std::vector<std::uint64_t> definitions(MethodAnalysis *method, const DefUseChains &chains,
+                                       std::uint64_t address, std::uint16_t reg)
+{
+    std::vector<std::uint64_t> result;
+    const auto &instructions = chains.get_register_accesses().get_instructions();
+
+    for (auto def : chains.get_definitions_of(method->get_instruction_at(address), reg))
+    {
+        auto index = chains.get_definitions()[def].instruction;
+        result.push_back(index == ReachingDefinitions::parameter ? UINT64_MAX : instructions[index]->get_address());
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/// @brief Dataflow of the method test of test-loop:
+///
+///     0: const/4 v0, 0
+///     2: const/16 v1, 10
+///     6: if-ge v0, v1, 10
+///     10: sget-object v1, ...
+///     14: invoke-virtual {v1, v0}, ...
+///     20: add-int/lit8 v0, v0, 1
+///     24: goto 2
+///     26: return-void
+void test_dataflow_loop(MethodAnalysis *method)
+{
+    DefUseChains chains(method);
+    LivenessAnalysis liveness(method, chains.get_register_accesses());
+
+    auto header = block(method, 2), body = block(method, 10), exit = block(method, 26);
+
+    assert(liveness.is_live_in(header, 0) && !liveness.is_live_in(header, 1) && "Expected v0 live in the loop header");
+    assert(liveness.is_live_out(body, 0) && "Expected v0 live after the body of the loop");
+    assert(liveness.get_in(exit).none() && "Expected nothing live in the exit");
+
+    assert((definitions(method, chains, 6, 0) == std::vector<std::uint64_t>{0, 20}) && "Incorrect definitions of v0 in the comparison");
+    assert((definitions(method, chains, 6, 1) == std::vector<std::uint64_t>{2}) && "Incorrect definitions of v1 in the comparison");
+    assert((definitions(method, chains, 14, 1) == std::vector<std::uint64_t>{10}) && "Incorrect definitions of v1 in the call");
+    assert(definitions(method, chains, 6, 2).empty() && "Register not read by the instruction");
+
+    // the increment is read by the comparison, the call and itself
+    const auto &accesses = chains.get_register_accesses();
+    auto increment = chains.get_reaching_definitions().get_first_definition(accesses.get_index(method->get_instruction_at(20)));
+
+    assert(chains.get_uses_of(increment).size() == 3 && "Expected three uses of the increment");
+}
+
+/// @brief Dataflow with wide registers in the method test of test-cast
+///
+///     0: const-wide v0, ...
+///     10: iput-wide v0, v2, ...
+///     76: iget-wide v3, v2, ...
+///     80: const-wide/high16 v0, ...
+///     84: add-double/2addr v3, v0
+void test_dataflow_wide(MethodAnalysis *method)
+{
+    DefUseChains chains(method);
+    const auto &accesses = chains.get_register_accesses();
+
+    auto defs = accesses.get_defs(accesses.get_index(method->get_instruction_at(0)));
+    assert(defs.size() == 2 && defs[0] == 0 && defs[1] == 1 && "Expected a wide definition of v0 and v1");
+
+    auto uses = accesses.get_uses(accesses.get_index(method->get_instruction_at(84)));
+    assert(uses.size() == 4 && "Expected two wide registers read by add-double/2addr");
+
+    assert((definitions(method, chains, 10, 1) == std::vector<std::uint64_t>{0}) && "Incorrect definition of the high register");
+    assert((definitions(method, chains, 84, 4) == std::vector<std::uint64_t>{76}) && "Incorrect definition of v4");
+    assert((definitions(method, chains, 10, 2) == std::vector<std::uint64_t>{UINT64_MAX}) && "Expected the parameter this in v2");
+
+    LivenessAnalysis liveness(method, accesses);
+
+    auto start = special_block(method, true);
+    assert(liveness.is_live_out(start, 2) && !liveness.is_live_out(start, 0) && "Incorrect live registers at the start");
+}
+
+/// @brief Dataflow through the handler of the main method of test-try-catch,
+/// the try covers the division of the block 60 and v3 is the parameter
+///
+///     0: new-instance v3, ...
+///     60: const/4 v1, 3
+///     62: div-int/2addr v1, v0
+///     64: sget-object v0, ...
+///     76: move-exception v0
+///     92: invoke-virtual {v3}, ...
+void test_dataflow_exceptions(MethodAnalysis *main)
+{
+    auto &blocks = main->get_basic_blocks();
+
+    auto start = special_block(main, true);
+    auto b60 = block(main, 60), b76 = block(main, 76);
+
+    auto handlers = blocks.get_exception_sucessor_ids(b60);
+    assert(handlers.size() == 1 && handlers[0] == b76 && "Expected an exceptional edge from block 60 to the handler");
+    assert(blocks.get_exception_predecessor_ids(b76).size() == 1 && "Expected only block 60 throwing to the handler");
+    assert(blocks.get_exception_sucessor_ids(block(main, 0)).empty() && "Block 0 is not covered by the try");
+
+    DefUseChains chains(main);
+    LivenessAnalysis liveness(main, chains.get_register_accesses());
+
+    // v3 is read after the handler, but the parameter is overwritten
+    // before the try
+    assert(liveness.is_live_in(b76, 3) && liveness.is_live_in(b60, 3) && "Expected v3 live in the handler and the try");
+    assert(!liveness.is_live_out(start, 3) && "The parameter v3 is not live at the start");
+
+    // all the definitions of the try reach the handler, also v1 = 3
+    // overwritten by the division, but not the parameter
+    const auto &accesses = chains.get_register_accesses();
+    const auto &reaching = chains.get_reaching_definitions();
+    auto constant = reaching.get_first_definition(accesses.get_index(main->get_instruction_at(60)));
+    auto division = reaching.get_first_definition(accesses.get_index(main->get_instruction_at(62)));
+
+    assert(reaching.get_in(b76).test(constant) && reaching.get_in(b76).test(division) && "Expected the definitions of the try in the handler");
+    assert(!reaching.get_out(b60).test(constant) && "v1 = 3 does not leave block 60");
+    assert(!reaching.get_in(b76).test(0) && "The parameter does not reach the handler");
+
+    assert((definitions(main, chains, 92, 3) == std::vector<std::uint64_t>{0}) && "Expected v3 only defined by new-instance");
+    assert((definitions(main, chains, 86, 0) == std::vector<std::uint64_t>{78}) && "Incorrect definition of v0 in the handler");
+}
+
+/// @brief SSA form of the loop of the method test of test-loop, v0 is
+/// joined in the header from the initialization and the increment
+void test_ssa_loop(MethodAnalysis *method)
+{
+    SSAForm ssa(method);
+    SSAConstantPropagation constants(ssa);
+
+    auto header = block(method, 2);
+    auto phis = ssa.get_phis(header);
+
+    assert(ssa.get_number_of_phis() == 1 && std::ranges::distance(phis) == 1 && "Expected one phi in the loop header");
+
+    auto phi = *phis.begin();
+    auto init = ssa.get_value_defined(method->get_instruction_at(0), 0);
+    auto increment = ssa.get_value_defined(method->get_instruction_at(20), 0);
+
+    assert(ssa.get_kind(phi) == SSAForm::value_kind_t::PHI && ssa.get_register(phi) == 0 && "Expected a phi of v0");
+    assert(ssa.get_phi_block(phi) == header && "Incorrect block of the phi");
+
+    auto operands = ssa.get_phi_operands(phi);
+    assert(operands.size() == 2 && "Expected an operand for each predecessor");
+    assert(std::ranges::find(operands, init) != operands.end() && std::ranges::find(operands, increment) != operands.end() && "Incorrect operands of the phi");
+
+    assert(ssa.get_value_used(method->get_instruction_at(6), 0) == phi && "Expected the phi in the comparison");
+    assert(ssa.get_value_used(method->get_instruction_at(20), 0) == phi && "Expected the phi in the increment");
+    assert(ssa.get_instruction(increment) == method->get_instruction_at(20) && "Incorrect instruction of the increment");
+    assert(ssa.get_users(phi).size() == 3 && ssa.get_phi_users(increment).size() == 1 && "Incorrect users of the values");
+
+    assert(constants.is_integer(init) && constants.get_integer(init) == 0 && "Expected v0 = 0 before the loop");
+    assert(constants.get_integer(ssa.get_value_defined(method->get_instruction_at(2), 1)) == 10 && "Expected v1 = 10 in the header");
+    assert(constants.get_state(phi) == SSAConstantPropagation::state_t::NOT_CONSTANT && "The counter of the loop is not constant");
+}
+
+/// @brief SSA form with wide registers and constant strings
+void test_ssa_constants(MethodAnalysis *cast_method, MethodAnalysis *main)
+{
+    SSAForm ssa(cast_method);
+    SSAConstantPropagation constants(ssa);
+
+    auto low = ssa.get_value_defined(cast_method->get_instruction_at(0), 0);
+    auto high = ssa.get_value_defined(cast_method->get_instruction_at(0), 1);
+
+    assert(low != SSAForm::no_value && high == low + 1 && "Expected a value for each register of the pair");
+    assert(ssa.get_value_used(cast_method->get_instruction_at(10), 1) == high && "Incorrect value of the high register");
+    assert(ssa.get_kind(ssa.get_value_used(cast_method->get_instruction_at(10), 2)) == SSAForm::value_kind_t::PARAMETER && "Expected the parameter this");
+    assert(constants.is_integer(low) && constants.get_integer(low) == 4634555860285128704 && "Expected a wide constant");
+    assert(!constants.is_integer(high) && "The high register does not keep the wide constant");
+    assert(constants.get_integer(ssa.get_value_defined(cast_method->get_instruction_at(22), 0)) == 69 && "Incorrect const-wide/16");
+    assert(!constants.is_integer(ssa.get_value_defined(cast_method->get_instruction_at(22), 1)) && "The high register does not keep the wide constant");
+    assert(constants.get_integer(ssa.get_value_defined(cast_method->get_instruction_at(14), 5)) == 0x428a0000 && "Incorrect const/high16");
+
+    SSAForm main_ssa(main);
+    SSAConstantPropagation main_constants(main_ssa);
+
+    auto message = main_ssa.get_value_used(main->get_instruction_at(38), 2);
+
+    assert(main_constants.is_string(message) && main_constants.get_string(message).find("You gave me value 0") != std::string::npos && "Expected a constant string");
+    assert(!main_constants.is_integer(main_ssa.get_value_defined(main->get_instruction_at(62), 1)) && "The division reads the input");
+}
+
+/// @brief SSA form of the method test of test-exceptions, x is 1 or 2
+/// when the try and the catch join:
+///
+///     0: const/4 v0, 1
+///     2: const/16 v1, 10
+///     6: div-int/2addr v1, v2       (try 6-9, catch 12)
+///     8: const/4 v0, 2
+///     10: return v0
+///     12: move-exception v1
+///     14: goto 10
+void test_ssa_exceptions(MethodAnalysis *method)
+{
+    auto &blocks = method->get_basic_blocks();
+
+    auto start = special_block(method, true);
+    auto b0 = block(method, 0), b10 = block(method, 10), b12 = block(method, 12);
+
+    assert(DominatorTree(blocks).get_immediate_dominator(b12) == start && "Expected the handler under the start block");
+
+    DominatorTree dominators(blocks, false, true);
+
+    assert(dominators.follows_exceptions() && "Expected the exceptional edges followed");
+    assert(dominators.get_immediate_dominator(b12) == b0 && "Expected the handler dominated by the try");
+    assert(dominators.get_immediate_dominator(b10) == b0 && "Expected the join dominated by the try");
+
+    SSAForm ssa(method);
+    SSAConstantPropagation constants(ssa);
+
+    // the handler can see x = 1 or x = 2
+    auto handler_phis = ssa.get_phis(b12);
+    assert(std::ranges::distance(handler_phis) == 1 && "Expected one phi of v0 in the handler");
+
+    auto handler_phi = *handler_phis.begin();
+    auto handler_operands = ssa.get_phi_operands(handler_phi);
+
+    assert(ssa.get_register(handler_phi) == 0 && "Expected a phi of v0");
+    assert(handler_operands.size() == 1 && handler_operands[0] == SSAForm::no_value && "Expected no single value from the try");
+
+    auto join = ssa.get_value_used(method->get_instruction_at(10), 0);
+    auto two = ssa.get_value_defined(method->get_instruction_at(8), 0);
+
+    assert(ssa.get_kind(join) == SSAForm::value_kind_t::PHI && ssa.get_phi_block(join) == b10 && "Expected a phi in the join");
+
+    auto operands = ssa.get_phi_operands(join);
+    assert(operands.size() == 2 && std::ranges::find(operands, two) != operands.end() &&
+           std::ranges::find(operands, handler_phi) != operands.end() && "Incorrect operands of the join");
+
+    assert(constants.get_integer(two) == 2 && "Expected x = 2 in the try");
+    assert(constants.get_state(SSAForm::no_value) == SSAConstantPropagation::state_t::NOT_CONSTANT && "no_value cannot be constant");
+    assert(constants.get_state(handler_phi) == SSAConstantPropagation::state_t::NOT_CONSTANT && "x is not constant in the handler");
+    assert(!constants.is_integer(join) && "x is not constant after the try");
+}
+
+int main()
+{
+    std::string dex_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-try-catch/Main.dex";
+
+    auto logger = KUNAI::LOGGER::logger();
+
+    logger->set_level(spdlog::level::debug);
+
+    auto dex = KUNAI::DEX::Dex::parse_dex_file(dex_file_path);
+
+    if (!dex->get_parsing_correct())
+        return -1;
+
+    auto analysis = dex->get_analysis(false);
+
+    auto main = find_method(analysis, "main");
+
+    assert(main && "Expected main method");
+
+    test_dominators(main);
+    test_dataflow_exceptions(main);
+    test_manual_loops();
+    test_metrics(analysis, main);
+
+    std::string loop_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-loop/classes.dex";
+
+    auto loop_dex = KUNAI::DEX::Dex::parse_dex_file(loop_file_path);
+
+    if (!loop_dex->get_parsing_correct())
+        return -1;
+
+    auto loop_method = find_method(loop_dex->get_analysis(false), "test");
+
+    assert(loop_method && "Expected test method");
+
+    test_loop_method(loop_method);
+    test_dataflow_loop(loop_method);
+    test_ssa_loop(loop_method);
+
+    std::string cast_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-cast/classes.dex";
+
+    auto cast_dex = KUNAI::DEX::Dex::parse_dex_file(cast_file_path);
+
+    if (!cast_dex->get_parsing_correct())
+        return -1;
+
+    auto cast_method = find_method(cast_dex->get_analysis(false), "test");
+
+    assert(cast_method && "Expected test method");
+
+    test_dataflow_wide(cast_method);
+    test_ssa_constants(cast_method, main);
+
+    std::string exceptions_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-exceptions/classes.dex";
+
+    auto exceptions_dex = KUNAI::DEX::Dex::parse_dex_file(exceptions_file_path);
+
+    if (!exceptions_dex->get_parsing_correct())
+        return -1;
+
+    auto exceptions_method = find_method(exceptions_dex->get_analysis(false), "test");
+
+    assert(exceptions_method && "Expected test method");
+
+    test_ssa_exceptions(exceptions_method);
+
+    return 0;
+}
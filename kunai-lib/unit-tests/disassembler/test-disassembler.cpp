@@ -7,8 +7,12 @@
 #include <iostream>
 #include <assert.h>
 #include <vector>
+#include <ranges>
+#include <cstdio>
 
 #include "Kunai/DEX/dex.hpp"
+#include "Kunai/DEX/DVM/instruction_range.hpp"
+#include "Kunai/DEX/DVM/bytecode_scan.hpp"
 #include "Kunai/Utils/logger.hpp"
 #include "test-disassembler.inc"
 
@@ -37,6 +41,27 @@ std::vector<std::string> expected_result = {
     "return-void"
 };
 
+std::vector<std::uint8_t> payload_buffer = {
+    0x2b, 0x02, 0x0b, 0x00, 0x00, 0x00, // packed-switch v2, +11 (payload at code unit 11)
+    0x32, 0x10, 0x04, 0x00,             // if-eq v0, v1, +4
+    0x28, 0x02,                         // goto +2
+    0x0e, 0x00,                         // return-void
+    0x00, 0x00,                         // nop (alignment)
+    0x26, 0x00, 0x00, 0x00, 0x00, 0x00, // fill-array-data v0, +0 (operand only)
+    0x00, 0x01, 0x01, 0x00,             // code unit 11: packed-switch-payload, size 1
+    0x00, 0x00, 0x00, 0x00,             // first key
+    0x02, 0x00, 0x00, 0x00};            // target
+
+std::vector<std::uint8_t> junk_buffer = {
+    0x2b, 0x00, 0x06, 0x00, 0x00, 0x00, // packed-switch v0, +6
+    0x0e, 0x01,                         // junk, return-void high byte must be 0
+    0x0e, 0x00,                         // return-void
+    0x14, 0x00,                         // junk, const would overlap the payload
+    0x00, 0x01, 0x01, 0x00,             // packed-switch-payload, size 1
+    0x00, 0x00, 0x00, 0x00,             // first key
+    0x04, 0x00, 0x00, 0x00,             // target
+    0x6e, 0x10};                        // junk, truncated invoke-virtual
+
 int main()
 {
     std::string dex_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-disassembler/classes.dex";
@@ -55,6 +80,29 @@ int main()
 
     auto disassembler = dex->get_dex_disassembler();
 
+    // disassembly only the main method first, the result
+    // must be cached and reused by the whole dex disassembly
+    std::vector<KUNAI::DEX::Instruction *> *main_instrs = nullptr;
+
+    for (auto &class_def : dex->get_parser()->get_classes().get_classdefs())
+    {
+        for (auto encoded_method : class_def->get_class_data_item().get_methods())
+        {
+            if (encoded_method->getMethodID()->get_name() != "main")
+                continue;
+
+            main_instrs = &disassembler->disassemble_method(encoded_method);
+
+            assert(main_instrs == &disassembler->disassemble_method(encoded_method) &&
+                   "Disassembled method was not cached");
+            assert(disassembler->get_dex_instructions().size() == 1 &&
+                   "Only the requested method must be disassembled");
+        }
+    }
+
+    assert(main_instrs != nullptr && main_instrs->size() == expected_result.size() &&
+           "Instructions size mismatch with expected result");
+
     disassembler->disassembly_dex();
 
     if (!disassembler->correct_disassembly())
@@ -92,6 +140,232 @@ int main()
                "Instruction doesn't match expected result");
     }
 
+    // the instructions can be created in an arena owned by the caller
+    {
+        KUNAI::DEX::InstructionArena arena;
+
+        auto arena_instructions = disassembler->disassembly_buffer(raw_buffer, arena);
+
+        assert(arena.size() == arena_instructions.size() &&
+               "All the instructions must be owned by the arena");
+
+        for (size_t I = 0, E = arena_instructions.size(); I < E; ++I)
+            assert(arena_instructions[I]->print_instruction() == expected_result[I] &&
+                   "Instruction doesn't match expected result");
+
+        arena.clear();
+
+        assert(arena.size() == 0 && "Arena must be empty after clear");
+
+        arena_instructions = disassembler->disassembly_buffer(raw_buffer, arena);
+
+        assert(arena_instructions.size() == expected_result.size() &&
+               "Arena must be reusable after clear");
+    }
+
+    // the registers of the invoke instructions are stored in
+    // the instruction, and the ranges are computed on demand
+    {
+        auto invoke = reinterpret_cast<KUNAI::DEX::Instruction35c *>(disassembled_instructions[12]);
+        const auto &registers = invoke->get_registers();
+
+        assert(registers.size() == 4 && registers[0] == 1 && registers[1] == 0 &&
+               registers[2] == 2 && registers[3] == 3 && "Incorrect registers of invoke-static");
+
+        std::vector<std::uint8_t> range_buffer = {
+            0x77, 0x03, 0x05, 0x00, 0x04, 0x00}; // invoke-static/range {v4 .. v6}, method@5
+
+        KUNAI::DEX::InstructionArena arena;
+
+        auto range_instructions = disassembler->disassembly_buffer(range_buffer, arena);
+
+        assert(range_instructions.size() == 1 && "Incorrect number of instructions in range buffer");
+
+        auto invoke_range = reinterpret_cast<KUNAI::DEX::Instruction3rc *>(range_instructions[0]);
+        auto range = invoke_range->get_registers();
+
+        assert(range.size() == 3 && range.front() == 4 && range.back() == 6 &&
+               std::vector<std::uint16_t>(range.begin(), range.end()) == std::vector<std::uint16_t>({4, 5, 6}) &&
+               "Incorrect registers of invoke-static/range");
+        assert(invoke_range->get_operand_method() != nullptr &&
+               invoke_range->get_operand_method()->get_name() == "valueOf" &&
+               "Incorrect method of invoke-static/range");
+    }
+
+    // the instructions can be decoded on the fly without
+    // creating a vector with all of them
+    {
+        static_assert(std::ranges::input_range<KUNAI::DEX::InstructionRange>);
+
+        KUNAI::DEX::InstructionRange range(raw_buffer, dex->get_parser());
+
+        size_t I = 0;
+
+        for (auto &instr : range)
+        {
+            assert(I < expected_result.size() &&
+                   "More instructions than expected");
+            assert(instr.print_instruction() == expected_result[I] &&
+                   "Instruction doesn't match expected result");
+            I++;
+        }
+
+        assert(I == expected_result.size() && "Instructions size mismatch with expected result");
+
+        auto invokes = std::ranges::count_if(range, [](KUNAI::DEX::Instruction &instr)
+                                             { return instr.get_instruction_opcode() == KUNAI::DEX::TYPES::opcodes::OP_INVOKE_STATIC; });
+
+        assert(invokes == 2 && "Incorrect number of invoke-static");
+
+        I = 0;
+
+        for (auto &instr : range | std::views::take(3))
+        {
+            assert(instr.print_instruction() == expected_result[I] &&
+                   "Instruction doesn't match expected result");
+            I++;
+        }
+
+        assert(I == 3 && "Range must stop early");
+    }
+
+    // the payloads are skipped and the junk is reported
+    // as incorrect instructions
+    {
+        KUNAI::DEX::InstructionArena arena;
+
+        auto junk_instructions = disassembler->disassembly_buffer(junk_buffer, arena);
+
+        std::vector<std::pair<std::uint64_t, KUNAI::DEX::dexinsttype_t>> expected_junk = {
+            {0, KUNAI::DEX::dexinsttype_t::DEX_INSTRUCTION31T},
+            {6, KUNAI::DEX::dexinsttype_t::DEX_DALVIKINCORRECT},
+            {8, KUNAI::DEX::dexinsttype_t::DEX_INSTRUCTION10X},
+            {10, KUNAI::DEX::dexinsttype_t::DEX_DALVIKINCORRECT},
+            {12, KUNAI::DEX::dexinsttype_t::DEX_PACKEDSWITCH},
+            {24, KUNAI::DEX::dexinsttype_t::DEX_DALVIKINCORRECT}};
+
+        assert(junk_instructions.size() == expected_junk.size() &&
+               "Incorrect number of instructions with junk");
+
+        for (size_t I = 0, E = junk_instructions.size(); I < E; ++I)
+            assert(junk_instructions[I]->get_address() == expected_junk[I].first &&
+                   junk_instructions[I]->get_instruction_type() == expected_junk[I].second &&
+                   "Incorrect instruction with junk");
+
+        auto packed_switch = reinterpret_cast<KUNAI::DEX::Instruction31t *>(junk_instructions[0]);
+
+        assert(packed_switch->get_packed_switch() == junk_instructions[4] &&
+               "Switch not linked with its payload");
+
+        assert(!KUNAI::DEX::Disassembler::is_valid_instruction(junk_buffer, 6, nullptr) &&
+               "Junk accepted as an instruction");
+        assert(KUNAI::DEX::Disassembler::get_instruction_size(junk_buffer, 12) == 12 &&
+               "Incorrect size of the payload");
+    }
+
+    // the pre-scan finds the candidates for each class of opcode
+    {
+        using bytecode_class_t = KUNAI::DEX::BytecodeScan::bytecode_class_t;
+
+        KUNAI::DEX::BytecodeScan scan(payload_buffer);
+
+        assert(scan.get_units() == payload_buffer.size() / 2 && "Incorrect number of code units");
+        assert(scan.is_candidate(bytecode_class_t::SWITCH, 0) && "packed-switch not found");
+        assert(scan.is_candidate(bytecode_class_t::BRANCH, 6) && "if-eq not found");
+        assert(scan.is_candidate(bytecode_class_t::BRANCH, 10) && "goto not found");
+        assert(scan.is_candidate(bytecode_class_t::RETURN, 12) && "return-void not found");
+        assert(scan.is_candidate(bytecode_class_t::FILL_ARRAY_DATA, 16) && "fill-array-data not found");
+        assert(scan.is_candidate(bytecode_class_t::PAYLOAD, 22) && "payload not found");
+        assert(!scan.is_candidate(bytecode_class_t::PAYLOAD, 14) && "nop is not a payload");
+        assert(!scan.is_control_flow_candidate(2) && "operand is not a candidate");
+        assert(!scan.is_candidate(bytecode_class_t::BRANCH, 1000) && "out of range address");
+
+        // the masks with the scalar and the vectorized
+        // paths must be equal for every position
+        for (size_t shift = 0; shift < 8; shift++)
+        {
+            std::vector<std::uint8_t> shifted(shift * 2, 0x01);
+            shifted.insert(shifted.end(), payload_buffer.begin(), payload_buffer.end());
+
+            KUNAI::DEX::BytecodeScan shifted_scan(shifted);
+
+            for (size_t I = 0; I < payload_buffer.size(); I += 2)
+                assert(shifted_scan.is_control_flow_candidate(I + shift * 2) == scan.is_control_flow_candidate(I) &&
+                       shifted_scan.is_candidate(bytecode_class_t::PAYLOAD, I + shift * 2) == scan.is_candidate(bytecode_class_t::PAYLOAD, I) &&
+                       "Scan result depends on the position");
+        }
+
+        assert(!KUNAI::DEX::BytecodeScan(raw_buffer).has_candidates(bytecode_class_t::BRANCH) &&
+               "main method does not have branches");
+    }
+
+    // the text of the whole dex must be the same with any
+    // number of threads, and contain the main method in order
+    {
+        auto write_to_string = [&](unsigned threads)
+        {
+            KUNAI::DEX::DisassemblyWriter writer(dex->get_parser(), threads);
+
+            auto file = std::tmpfile();
+            assert(file != nullptr && "Cannot create a temporary file");
+
+            writer.write(fileno(file));
+
+            std::string text;
+            char chunk[4096];
+
+            std::rewind(file);
+            for (size_t read; (read = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+                text.append(chunk, read);
+
+            std::fclose(file);
+            return text;
+        };
+
+        auto single_thread = write_to_string(1);
+        auto multi_thread = write_to_string(4);
+
+        assert(!single_thread.empty() && "Empty disassembly of the dex");
+        assert(single_thread == multi_thread && "Disassembly depends on the number of threads");
+
+        auto position = single_thread.find("Main->main(");
+        assert(position != std::string::npos && "main method not found");
+
+        for (const auto &expected : expected_result)
+        {
+            position = single_thread.find(expected, position);
+            assert(position != std::string::npos && "Instruction not found in order");
+        }
+    }
+
+    // a method without branches must give the same output
+    // with the recursive traversal algorithm
+    auto recursive_dex = KUNAI::DEX::Dex::parse_dex_file(dex_file_path);
+    auto recursive_disassembler = recursive_dex->get_dex_disassembler();
+
+    recursive_disassembler->set_disassembly_algorithm(
+        KUNAI::DEX::DexDisassembler::disassembly_algorithm::RECURSIVE_TRAVERSAL_ALGORITHM);
+
+    recursive_disassembler->disassembly_dex();
+
+    assert(recursive_disassembler->correct_disassembly() &&
+           "Error in recursive traversal disassembly");
+
+    for (auto &method_instrs : recursive_disassembler->get_dex_instructions())
+    {
+        if (method_instrs.first->getMethodID()->get_name() != "main")
+            continue;
+
+        const auto &instrs = method_instrs.second;
+
+        assert(instrs.size() == expected_result.size() &&
+               "Instructions size mismatch with expected result");
+
+        for (size_t I = 0, E = instrs.size(); I < E; ++I)
+            assert(instrs[I]->print_instruction() == expected_result[I] &&
+                   "Instruction doesn't match expected result");
+    }
+
     logger->info("test-disassembler passed correctly");
 
     return 0;
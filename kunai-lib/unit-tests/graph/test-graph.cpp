@@ -58,6 +58,10 @@ int main()
 
     auto analysis = dex->get_analysis(false);
 
+    // the blocks of all the methods are created by a pool of
+    // threads, the graph checked below must be the same
+    analysis->create_all_basic_blocks(4);
+
     const auto &methods = analysis->get_methods();
 
     for (const auto &method : methods)
@@ -115,6 +119,43 @@ int main()
                 assert(output.str() == expected_edges[i++] && "Expected edge in the graph incorrect");
             }
 
+            assert(blocks.get_edges().size() == expected_edges.size() && "Expected number of edges incorrect");
+
+            auto first_block = method.second->get_block_at(0);
+            auto sucessors = blocks.get_sucessors(first_block);
+
+            assert(sucessors.size() == 2 && sucessors[0]->get_first_address() == 30 &&
+                   sucessors[1]->get_first_address() == 46 && "Expected sucessors of the first block");
+
+            for (auto sucessor : sucessors)
+            {
+                auto predecessor_ids = blocks.get_predecessor_ids(sucessor->get_id());
+                assert(predecessor_ids.size() == 1 && blocks.get_block(predecessor_ids[0]) == first_block &&
+                       "Expected the first block as predecessor");
+            }
+
+            assert(blocks.get_predecessors().at(method.second->get_block_at(92)).size() == 2 &&
+                   "Expected two predecessors of block 92");
+
+            auto division = method.second->get_instruction_at(62);
+
+            assert(division && division->print_instruction() == "div-int/2addr v1, v0" && "Expected division in address 62");
+            assert(method.second->get_instruction_at(63) == nullptr && "No instruction starts in address 63");
+            assert(method.second->get_block_at(62)->get_first_address() == 60 && "Expected address 62 in block 60");
+            assert(method.second->get_block_at(98)->get_first_address() == 92 && "Expected address 98 in block 92");
+            assert(method.second->get_block_at(100) == nullptr && "Address after the method has a block");
+
+            const auto &exception_table = method.second->get_exception_table();
+
+            assert(exception_table.get_exceptions().size() == 1 && "Expected one try block in main");
+
+            auto covering = exception_table.get_exceptions_at(62);
+
+            assert(covering.size() == 1 && covering[0]->handler.size() == 1 && "Expected one handler for the division");
+            assert(covering[0]->handler[0].handler_start_addr == 76 && "Expected handler in the catch block");
+            assert(!exception_table.is_covered(58) && "Address before the try block is covered");
+            assert(!exception_table.is_covered(76) && "Address of the handler is covered");
+
             break;
         }
     }
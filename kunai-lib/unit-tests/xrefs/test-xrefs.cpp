@@ -7,7 +7,9 @@
 #include "test-xrefs.inc"
 #include "Kunai/DEX/dex.hpp"
 #include "Kunai/Utils/logger.hpp"
+#include <algorithm>
 #include <assert.h>
+#include <regex>
 
 std::vector<std::tuple<std::string, std::string, uint64_t>>
     expected_classes = {
@@ -18,9 +20,9 @@ std::vector<std::tuple<std::string, std::string, uint64_t>>
 std::vector<std::tuple<std::string, std::string, std::string, uint64_t>>
     expected_values = {
         /// xref_from
-        {"Ljava/util/Scanner;->closeV", "LMain;", "main", 268},
-        {"Ljava/io/PrintStream;->printlnVL", "LMain;", "main", 136},
-        {"Ljava/io/PrintStream;->printlnVL", "LMain;", "main", 150},
+        {"Ljava/util/Scanner;->close()V", "LMain;", "main", 268},
+        {"Ljava/io/PrintStream;->println(J)V", "LMain;", "main", 180},
+        {"Ljava/io/PrintStream;->println(Ljava/lang/String;)V", "LMain;", "main", 136},
 };
 
 std::vector<std::tuple<std::string, std::string, std::string, uint64_t>>
@@ -30,6 +32,514 @@ std::vector<std::tuple<std::string, std::string, std::string, uint64_t>>
         {"void Main->main(java.lang.String[])", "Ljava/util/Scanner;", "nextInt", 14},
         {"void Main->main(java.lang.String[])", "Ljava/util/Scanner;", "nextInt", 38}};
 
+/// @brief The methods are found by their full descriptor, and the ids
+/// of the symbol table give the same objects than the names
+void test_symbols(KUNAI::DEX::Analysis *analysis)
+{
+    auto &symbols = analysis->get_symbols();
+
+    std::string print_stream = "Ljava/io/PrintStream;", println = "println";
+    std::string int_descriptor = "(I)V", string_descriptor = "(Ljava/lang/String;)V", shorty = "VL";
+
+    auto println_int = analysis->get_method_analysis_by_name(print_stream, println, int_descriptor);
+    auto println_string = analysis->get_method_analysis_by_name(print_stream, println, string_descriptor);
+
+    assert(println_int && println_string && println_int != println_string && "Expected one method for each overload");
+    assert(println_int->external() && println_string->get_full_name() == "Ljava/io/PrintStream;->println(Ljava/lang/String;)V" && "Incorrect external method");
+    assert(analysis->get_method_analysis_by_name(print_stream, println, shorty) == nullptr && "The shorty is not a descriptor");
+
+    auto method_id = symbols.find_method(println_string->get_full_name());
+    assert(method_id != KUNAI::DEX::SymbolTable::no_symbol && analysis->get_method_analysis(method_id) == println_string && "Incorrect id of the method");
+    assert(symbols.get_method_class(method_id) == symbols.find_class(print_stream) && "Incorrect class of the method");
+    assert(analysis->get_class_analysis(symbols.find_class(print_stream)) == analysis->get_class_analysis(print_stream) && "Incorrect id of the class");
+
+    // every string used by a const-string has its id
+    for (auto &name_string : analysis->get_string_analysis())
+    {
+        auto &value = name_string.first;
+        auto string_id = symbols.find_string(value.substr(1, value.size() - 2));
+
+        assert(analysis->get_string_analysis(string_id) == name_string.second.get() && "Incorrect id of the string");
+    }
+}
+
+/// @brief Write all the xrefs of the methods and strings of an analysis
+/// @return one line per xref, in the order these were stored
+std::vector<std::string> dump_xrefs(KUNAI::DEX::Analysis *analysis)
+{
+    std::vector<std::string> lines;
+
+    for (auto &name_method : analysis->get_methods())
+    {
+        auto method = name_method.second.get();
+
+        for (const auto &xref_to : method->get_xrefto())
+            lines.push_back(method->get_full_name() + " to " + std::get<1>(xref_to)->get_full_name() + " " + std::to_string(std::get<2>(xref_to)));
+        for (const auto &xref_from : method->get_xreffrom())
+            lines.push_back(method->get_full_name() + " from " + std::get<1>(xref_from)->get_full_name() + " " + std::to_string(std::get<2>(xref_from)));
+    }
+
+    for (auto &name_string : analysis->get_string_analysis())
+        for (const auto &xref_from : name_string.second->get_xreffrom())
+            lines.push_back(name_string.first + " from " + std::get<1>(xref_from)->get_full_name() + " " + std::to_string(std::get<2>(xref_from)));
+
+    return lines;
+}
+
+/// @brief Every xref of the table must be found from its method
+/// and from the symbol it references, only once
+void test_xref_table(KUNAI::DEX::Analysis *analysis)
+{
+    using KUNAI::DEX::XrefTable;
+
+    auto &table = analysis->get_xref_table();
+    auto xrefs = table.get_xrefs();
+
+    assert(!xrefs.empty() && "The xref table is empty");
+
+    std::size_t from_methods = 0, to_symbols = 0;
+
+    for (std::size_t i = 0; i < analysis->get_symbols().get_number_of_methods(); i++)
+        from_methods += table.get_xrefs_from(static_cast<XrefTable::symbol_id_t>(i)).size();
+
+    assert(from_methods == xrefs.size() && "Xrefs missing from the methods");
+
+    for (std::uint32_t i = 0; i < xrefs.size(); i++)
+    {
+        const auto &xref = xrefs[i];
+
+        assert((i == 0 || !(xrefs[i - 1] == xref)) && "Repeated xref in the table");
+
+        auto to = table.get_xrefs_to(xref.kind, xref.dst);
+        assert(std::count(to.begin(), to.end(), i) == 1 && "Xref missing from the symbol");
+
+        auto same_kind = table.get_xrefs_from(xref.src, xref.kind);
+        assert(std::count(same_kind.begin(), same_kind.end(), xref) == 1 && "Xref missing from the kind of the method");
+
+        if (xref.kind == XrefTable::xref_kind_t::CALL)
+            to_symbols++;
+    }
+
+    std::size_t calls_from = 0;
+
+    for (auto &name_method : analysis->get_methods())
+        calls_from += name_method.second->get_xreffrom().size();
+
+    assert(calls_from == to_symbols && "Calls missing from the called methods");
+
+    // the maps of the classes are built once
+    std::string main_name = "LMain;", print_stream_name = "Ljava/io/PrintStream;";
+    auto main_class = analysis->get_class_analysis(main_name);
+    auto print_stream = analysis->get_class_analysis(print_stream_name);
+
+    const auto &class_xrefto = main_class->get_xrefto();
+
+    assert(&class_xrefto == &main_class->get_xrefto() && "The xrefs of the class are built again");
+    assert(class_xrefto.contains(print_stream) && "Expected the calls to PrintStream");
+    assert(print_stream->get_xreffrom().contains(main_class) && "Expected the calls from Main");
+
+    // the ids out of the table do not have xrefs
+    auto no_symbol = KUNAI::DEX::SymbolTable::no_symbol;
+
+    assert(table.get_xrefs_from(no_symbol).empty() && table.get_xrefs_from(no_symbol, XrefTable::xref_kind_t::CALL).empty() &&
+           "Xrefs from an unknown method");
+    assert(table.get_xrefs_to(XrefTable::xref_kind_t::CALL, no_symbol).empty() &&
+           table.get_xrefs_to(XrefTable::xref_kind_t::STRING, no_symbol).empty() && "Xrefs to an unknown symbol");
+}
+
+/// @brief Queries of the call graph from the main method
+void test_call_graph(KUNAI::DEX::Analysis *analysis)
+{
+    auto &symbols = analysis->get_symbols();
+    auto call_graph = analysis->build_call_graph();
+
+    assert(call_graph.get_number_of_nodes() == symbols.get_number_of_methods() && "One node per method");
+
+    auto main_id = symbols.find_method("LMain;->main([Ljava/lang/String;)V");
+    auto close_id = symbols.find_method("Ljava/util/Scanner;->close()V");
+    auto println_id = symbols.find_method("Ljava/io/PrintStream;->println(J)V");
+
+    assert(main_id != KUNAI::DEX::SymbolTable::no_symbol && close_id != KUNAI::DEX::SymbolTable::no_symbol && "Methods not found");
+
+    assert(call_graph.get_callees(close_id).empty() && "An external method does not call");
+    auto close_callers = call_graph.get_callers(close_id);
+    assert(std::find(close_callers.begin(), close_callers.end(), main_id) != close_callers.end() && "main calls close");
+
+    assert(call_graph.reaches(main_id, close_id) && !call_graph.reaches(close_id, main_id) && "Incorrect reachability");
+
+    auto path = call_graph.get_path(main_id, close_id);
+    assert(path.size() == 2 && path.front() == main_id && path.back() == close_id && "Incorrect path");
+    assert(call_graph.get_path(close_id, main_id).empty() && "There is no path");
+
+    auto reachable = call_graph.reachable_from(std::span(&main_id, 1));
+    auto depth = call_graph.depth_first(main_id);
+    assert(reachable.front() == main_id && depth.front() == main_id && reachable.size() == depth.size() && "Incorrect search");
+    assert(std::find(depth.begin(), depth.end(), close_id) != depth.end() && "close not reached");
+
+    std::size_t callers = 0;
+
+    for (KUNAI::DEX::CallGraph::node_t method = 0; method < call_graph.get_number_of_nodes(); method++)
+    {
+        callers += call_graph.get_callers(method).size();
+
+        for (auto callee : call_graph.get_callees(method))
+            assert(call_graph.get_component(callee) <= call_graph.get_component(method) && "Components not in reverse topological order");
+    }
+
+    assert(callers == call_graph.get_number_of_edges() && "Different number of callers and callees");
+
+    std::vector<KUNAI::DEX::CallGraph::node_t> sinks = {close_id, println_id};
+    auto reachability = call_graph.reach_sinks(sinks);
+
+    assert(reachability.reaches(main_id, 0) && reachability.reaches(main_id, 1) && "main reaches both sinks");
+    assert(reachability.get_sinks(main_id).size() == 2 && "main reaches both sinks");
+    assert(!reachability.reaches(println_id, 0) && reachability.reaches(println_id, 1) && "println only reaches itself");
+}
+
+/// @brief Hierarchy of the classes and targets of the calls, the
+/// dex has only one class so every call has one target
+void test_class_hierarchy(KUNAI::DEX::Analysis *analysis)
+{
+    using KUNAI::DEX::ClassHierarchy;
+
+    auto &symbols = analysis->get_symbols();
+    auto hierarchy = analysis->build_class_hierarchy();
+
+    assert(hierarchy.get_number_of_classes() == symbols.get_number_of_classes() && "One node per class");
+
+    auto main_cls = symbols.find_class("LMain;");
+    auto object = symbols.find_class("Ljava/lang/Object;");
+    auto scanner = symbols.find_class("Ljava/util/Scanner;");
+
+    assert(hierarchy.get_superclass(main_cls) == object && "Main extends Object");
+
+    auto chain = hierarchy.get_superclass_chain(main_cls);
+    assert(chain.size() == 2 && chain[0] == main_cls && chain[1] == object && "Incorrect chain of superclasses");
+
+    assert(hierarchy.is_subclass(main_cls, object) && hierarchy.is_subclass(main_cls, main_cls) && "Incorrect subclass check");
+    assert(!hierarchy.is_subclass(object, main_cls) && !hierarchy.is_subtype(scanner, main_cls) && "Incorrect subtype check");
+    assert(hierarchy.is_instantiated(scanner) && !hierarchy.is_instantiated(main_cls) && "Scanner is instantiated by main");
+
+    auto next_int = symbols.find_method("Ljava/util/Scanner;->nextInt()I");
+    auto println_long = symbols.find_method("Ljava/io/PrintStream;->println(J)V");
+    auto println_string = symbols.find_method("Ljava/io/PrintStream;->println(Ljava/lang/String;)V");
+
+    assert(hierarchy.get_selector(println_long) != hierarchy.get_selector(println_string) && "Overloads have different selectors");
+
+    auto dispatch = hierarchy.get_dispatch_table(hierarchy.get_selector(next_int));
+    assert(dispatch.size() == 1 && dispatch[0].cls == scanner && dispatch[0].method == next_int && "Incorrect dispatch table");
+    assert(hierarchy.resolve(scanner, hierarchy.get_selector(next_int)) == next_int && "Incorrect resolution");
+
+    for (auto mode : {ClassHierarchy::dispatch_t::CHA, ClassHierarchy::dispatch_t::RTA})
+    {
+        auto targets = hierarchy.get_targets(next_int, KUNAI::DEX::TYPES::opcodes::OP_INVOKE_VIRTUAL, mode);
+        assert(targets.size() == 1 && targets[0] == next_int && "Incorrect targets of the virtual call");
+    }
+
+    // without other classes the dispatch does not add calls
+    auto call_graph = analysis->build_call_graph();
+    auto cha_graph = analysis->build_call_graph(&hierarchy);
+    auto rta_graph = analysis->build_call_graph(&hierarchy, ClassHierarchy::dispatch_t::RTA);
+
+    assert(cha_graph.get_number_of_edges() == call_graph.get_number_of_edges() &&
+           rta_graph.get_number_of_edges() == call_graph.get_number_of_edges() && "Incorrect call graph with dispatch");
+}
+
+/// @brief Targets of the calls in a dex with an abstract class, two
+/// subclasses and an interface: Square and Circle extend Base, Base and
+/// Tile implement Shape, Task implements the external Runnable, and main
+/// only instantiates Square, Tile and Task
+void test_class_hierarchy_dispatch(std::string &dex_file_path)
+{
+    using KUNAI::DEX::ClassHierarchy;
+    using namespace KUNAI::DEX::TYPES;
+
+    auto dex = KUNAI::DEX::Dex::parse_dex_file(dex_file_path);
+
+    assert(dex->get_parsing_correct() && "Incorrect parsing of the hierarchy");
+
+    auto analysis = dex->get_analysis(true);
+    analysis->create_xrefs();
+
+    auto &symbols = analysis->get_symbols();
+    auto hierarchy = analysis->build_class_hierarchy();
+
+    auto object = symbols.find_class("Ljava/lang/Object;");
+    auto shape = symbols.find_class("LShape;");
+    auto base = symbols.find_class("LBase;");
+    auto square = symbols.find_class("LSquare;");
+    auto circle = symbols.find_class("LCircle;");
+    auto tile = symbols.find_class("LTile;");
+
+    auto chain = hierarchy.get_superclass_chain(square);
+    assert(chain.size() == 3 && chain[0] == square && chain[1] == base && chain[2] == object && "Incorrect chain of superclasses");
+
+    assert(hierarchy.is_subclass(circle, base) && !hierarchy.is_subclass(tile, base) && "Incorrect subclass check");
+    assert(hierarchy.is_subtype(square, shape) && hierarchy.is_subtype(tile, shape) && !hierarchy.is_subtype(object, shape) && "Incorrect subtype check");
+
+    // the subclasses of an implementor implement the interface too
+    auto implementors = hierarchy.get_implementors(shape);
+    std::vector<ClassHierarchy::class_t> expected_implementors = {base, square, circle, tile};
+    std::sort(expected_implementors.begin(), expected_implementors.end());
+    assert(std::vector<ClassHierarchy::class_t>(implementors.begin(), implementors.end()) == expected_implementors && "Incorrect implementors of Shape");
+
+    assert(hierarchy.is_instantiated(square) && hierarchy.is_instantiated(tile) && "Square and Tile are instantiated by main");
+    assert(!hierarchy.is_instantiated(circle) && !hierarchy.is_instantiated(base) && "Circle and Base are never instantiated");
+
+    auto base_area = symbols.find_method("LBase;->area()I");
+    auto base_name = symbols.find_method("LBase;->name()Ljava/lang/String;");
+    auto shape_area = symbols.find_method("LShape;->area()I");
+    auto square_area = symbols.find_method("LSquare;->area()I");
+    auto circle_area = symbols.find_method("LCircle;->area()I");
+    auto circle_name = symbols.find_method("LCircle;->name()Ljava/lang/String;");
+    auto tile_area = symbols.find_method("LTile;->area()I");
+
+    auto targets = [&](ClassHierarchy::method_t method, std::uint32_t opcode, ClassHierarchy::dispatch_t mode)
+    {
+        return hierarchy.get_targets(method, opcode, mode);
+    };
+
+    auto sorted = [](std::vector<ClassHierarchy::method_t> methods)
+    {
+        std::sort(methods.begin(), methods.end());
+        return methods;
+    };
+
+    // the abstract methods are never a target
+    assert(targets(base_area, opcodes::OP_INVOKE_VIRTUAL, ClassHierarchy::dispatch_t::CHA) == sorted({square_area, circle_area}) &&
+           "CHA: Base->area() is implemented by Square and Circle");
+    assert(targets(base_area, opcodes::OP_INVOKE_VIRTUAL, ClassHierarchy::dispatch_t::RTA) == sorted({square_area}) &&
+           "RTA: only Square is instantiated");
+
+    assert(targets(base_name, opcodes::OP_INVOKE_VIRTUAL, ClassHierarchy::dispatch_t::CHA) == sorted({base_name, circle_name}) &&
+           "CHA: Base->name() is overridden by Circle");
+    assert(targets(base_name, opcodes::OP_INVOKE_VIRTUAL, ClassHierarchy::dispatch_t::RTA) == sorted({base_name}) &&
+           "RTA: Square inherits Base->name()");
+
+    assert(targets(shape_area, opcodes::OP_INVOKE_INTERFACE, ClassHierarchy::dispatch_t::CHA) == sorted({square_area, circle_area, tile_area}) &&
+           "CHA: Shape->area() is implemented by Square, Circle and Tile");
+    assert(targets(shape_area, opcodes::OP_INVOKE_INTERFACE, ClassHierarchy::dispatch_t::RTA) == sorted({square_area, tile_area}) &&
+           "RTA: Circle is never instantiated");
+
+    // Runnable is external, it is an interface because Task implements it,
+    // and its method stays a target as other external classes implement it
+    auto runnable = symbols.find_class("Ljava/lang/Runnable;");
+    auto task = symbols.find_class("LTask;");
+    auto runnable_run = symbols.find_method("Ljava/lang/Runnable;->run()V");
+    auto task_run = symbols.find_method("LTask;->run()V");
+
+    assert(hierarchy.is_interface(runnable) && hierarchy.is_subtype(task, runnable) && "Runnable is an external interface");
+
+    auto runnable_implementors = hierarchy.get_implementors(runnable);
+    assert(runnable_implementors.size() == 1 && runnable_implementors[0] == task && "Incorrect implementors of Runnable");
+
+    for (auto mode : {ClassHierarchy::dispatch_t::CHA, ClassHierarchy::dispatch_t::RTA})
+        assert(targets(runnable_run, opcodes::OP_INVOKE_INTERFACE, mode) == sorted({runnable_run, task_run}) &&
+               "Runnable->run() is implemented by Task");
+
+    // a direct call is never dispatched
+    assert(targets(base_name, opcodes::OP_INVOKE_DIRECT, ClassHierarchy::dispatch_t::CHA) == std::vector<ClassHierarchy::method_t>{base_name} &&
+           "Incorrect targets of a direct call");
+
+    auto main_id = symbols.find_method("LMain;->main([Ljava/lang/String;)V");
+
+    auto call_graph = analysis->build_call_graph();
+    auto cha_graph = analysis->build_call_graph(&hierarchy);
+    auto rta_graph = analysis->build_call_graph(&hierarchy, ClassHierarchy::dispatch_t::RTA);
+
+    auto callees = [&](KUNAI::DEX::CallGraph &graph)
+    {
+        auto span = graph.get_callees(main_id);
+        return std::vector<ClassHierarchy::method_t>(span.begin(), span.end());
+    };
+
+    auto has = [](const std::vector<ClassHierarchy::method_t> &methods, ClassHierarchy::method_t method)
+    {
+        return std::find(methods.begin(), methods.end(), method) != methods.end();
+    };
+
+    auto cha_callees = callees(cha_graph);
+    auto rta_callees = callees(rta_graph);
+
+    assert(has(cha_callees, circle_area) && has(cha_callees, circle_name) && has(cha_callees, tile_area) && "CHA: main calls every implementation");
+    assert(!has(cha_callees, base_area) && !has(cha_callees, shape_area) && "CHA: the abstract methods are not called");
+    assert(has(rta_callees, square_area) && has(rta_callees, tile_area) && has(rta_callees, base_name) && "RTA: main calls the instantiated implementations");
+    assert(!has(rta_callees, circle_area) && !has(rta_callees, circle_name) && "RTA: Circle is never instantiated");
+    assert(has(cha_callees, task_run) && has(rta_callees, task_run) && "main calls Task->run() through Runnable");
+
+    // with RTA the calls through Base and Shape have one target each,
+    // and the call through Runnable adds Task->run()
+    assert(call_graph.get_number_of_edges() + 1 == rta_graph.get_number_of_edges() &&
+           rta_graph.get_number_of_edges() < cha_graph.get_number_of_edges() && "Incorrect number of calls with dispatch");
+}
+
+/// @brief The indexed find_* methods must give the same objects, in the
+/// same order, than checking every name with std::regex_search
+void test_search(KUNAI::DEX::Analysis *analysis)
+{
+    using KUNAI::DEX::SearchPattern;
+
+    assert(SearchPattern("Scanner").get_kind() == SearchPattern::kind_t::LITERAL && "Incorrect literal pattern");
+    assert(SearchPattern("^Ljava").get_kind() == SearchPattern::kind_t::PREFIX && "Incorrect prefix pattern");
+    assert(SearchPattern("^LMain;$").get_kind() == SearchPattern::kind_t::EXACT && "Incorrect exact pattern");
+    assert(SearchPattern(";$").get_kind() == SearchPattern::kind_t::SUFFIX && "Incorrect suffix pattern");
+    assert(SearchPattern(".*").get_kind() == SearchPattern::kind_t::ANY && "Incorrect pattern for any name");
+    assert(SearchPattern("a.b").get_kind() == SearchPattern::kind_t::REGEX && "Incorrect regular expression");
+    assert(SearchPattern("\\d").get_kind() == SearchPattern::kind_t::REGEX && "Incorrect class of characters");
+
+    SearchPattern escaped("\\.\\$$");
+    assert(escaped.get_kind() == SearchPattern::kind_t::SUFFIX && escaped.get_literal() == ".$" && "Incorrect escaped pattern");
+
+    std::vector<std::string> patterns = {"", ".*", "Scanner", "^Ljava", "^LMain;$", ";$", "/lang/", "Scan+er", "^L[a-z]+/", "println|main", "zzz"};
+
+    for (auto &pattern : patterns)
+    {
+        std::regex regex(pattern);
+
+        std::vector<KUNAI::DEX::ClassAnalysis *> expected_classes;
+        for (auto &name_class : analysis->get_classes())
+            if (std::regex_search(name_class.second->name(), regex))
+                expected_classes.push_back(name_class.second.get());
+
+        assert(analysis->find_classes(pattern, false) == expected_classes && "Incorrect classes found");
+
+        std::vector<KUNAI::DEX::MethodAnalysis *> expected_methods;
+        for (auto &name_method : analysis->get_methods())
+            if (std::regex_search(name_method.second->get_class_name(), regex))
+                expected_methods.push_back(name_method.second.get());
+
+        std::string any = "";
+        assert(analysis->find_methods(pattern, any, any, any, false) == expected_methods && "Incorrect methods found by class");
+
+        expected_methods.clear();
+        for (auto &name_method : analysis->get_methods())
+            if (std::regex_search(name_method.second->get_name(), regex))
+                expected_methods.push_back(name_method.second.get());
+
+        assert(analysis->find_methods(any, pattern, any, any, false) == expected_methods && "Incorrect methods found by name");
+
+        std::vector<KUNAI::DEX::StringAnalysis *> expected_strings;
+        for (auto &value_string : analysis->get_string_analysis())
+            if (std::regex_search(value_string.first, regex))
+                expected_strings.push_back(value_string.second.get());
+
+        assert(analysis->find_strings(pattern) == expected_strings && "Incorrect strings found");
+    }
+
+    std::string print_stream = "^Ljava/io/PrintStream;$", println = "^println$", any = "", internal = "^LMain;$";
+
+    auto println_methods = std::count_if(analysis->get_methods().begin(), analysis->get_methods().end(), [](auto &name_method)
+                                         { return name_method.second->get_full_name().starts_with("Ljava/io/PrintStream;->println("); });
+
+    assert(println_methods > 1 && analysis->find_methods(print_stream, println, any, any, false).size() == static_cast<std::size_t>(println_methods) && "Expected all the println methods");
+
+    auto main_methods = std::count_if(analysis->get_methods().begin(), analysis->get_methods().end(), [](auto &name_method)
+                                      { return name_method.second->get_class_name() == "LMain;"; });
+
+    assert(analysis->find_methods(internal, any, any, any, true).size() == static_cast<std::size_t>(main_methods) && "Incorrect internal methods");
+}
+
+/// @brief Every occurrence of a group of patterns in a text, looking
+/// for each pattern at every offset
+std::vector<std::pair<std::uint32_t, std::uint32_t>> find_occurrences(const std::vector<std::string> &patterns, std::string_view text)
+{
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> occurrences;
+
+    for (std::uint32_t pattern = 0; pattern < patterns.size(); pattern++)
+        for (std::size_t offset = 0; !patterns[pattern].empty() && offset + patterns[pattern].size() <= text.size(); offset++)
+            if (text.substr(offset, patterns[pattern].size()) == patterns[pattern])
+                occurrences.emplace_back(pattern, static_cast<std::uint32_t>(offset));
+
+    std::sort(occurrences.begin(), occurrences.end());
+
+    return occurrences;
+}
+
+/// @brief The patterns found in the strings with the automaton must be
+/// the same than looking for every pattern alone
+void test_string_scanner(KUNAI::DEX::Analysis *analysis)
+{
+    using KUNAI::DEX::PatternSet;
+
+    std::vector<std::string> patterns = {"he", "she", "his", "hers", "", "e", "he"};
+    PatternSet set(patterns);
+
+    for (std::string text : {"ushers", "hishershe", "", "xyz", "hehehe"})
+    {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> found;
+
+        set.scan(text, [&](std::uint32_t pattern, std::uint32_t offset)
+                 { found.emplace_back(pattern, offset); });
+
+        std::sort(found.begin(), found.end());
+
+        assert(found == find_occurrences(patterns, text) && "Incorrect occurrences of the patterns");
+        assert(set.contains_any(text) == !found.empty() && "Incorrect check of any pattern");
+    }
+
+    auto &symbols = analysis->get_symbols();
+
+    std::vector<std::string> string_patterns = {"a", "in", "the", "Enter", "ber", "zzz", "Scanner"};
+    PatternSet string_set(string_patterns);
+
+    auto matches = analysis->scan_strings(string_set);
+    auto parallel_matches = analysis->scan_strings(string_set, false, 4);
+
+    assert(!matches.empty() && matches.size() == parallel_matches.size() && "Different matches with several threads");
+
+    std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> found, expected;
+
+    for (std::size_t i = 0; i < matches.size(); i++)
+    {
+        const auto &match = matches[i];
+
+        assert(match.string == parallel_matches[i].string && match.pattern == parallel_matches[i].pattern &&
+               match.offset == parallel_matches[i].offset && "Different matches with several threads");
+
+        found.emplace_back(match.string, match.pattern, match.offset);
+
+        // the sites are the same xrefs of the StringAnalysis
+        auto string_analysis = analysis->get_string_analysis(match.string);
+        auto xrefs = string_analysis ? std::ranges::distance(string_analysis->get_xreffrom()) : 0;
+
+        assert(static_cast<std::size_t>(xrefs) == match.sites.size() && "Incorrect sites of the string");
+    }
+
+    for (std::uint32_t id = 0; id < symbols.get_number_of_strings(); id++)
+        for (auto &occurrence : find_occurrences(string_patterns, symbols.get_string(id)))
+            expected.emplace_back(id, occurrence.first, occurrence.second);
+
+    std::sort(found.begin(), found.end());
+
+    assert(found == expected && "Incorrect matches in the strings");
+
+    for (const auto &match : analysis->scan_strings(string_set, true))
+        assert(!match.sites.empty() && "Only the strings used by const-string expected");
+}
+
+/// @brief The xrefs created with one and with several threads must be the same
+void test_parallel_xrefs(std::string &dex_file_path)
+{
+    auto serial_dex = KUNAI::DEX::Dex::parse_dex_file(dex_file_path);
+    auto parallel_dex = KUNAI::DEX::Dex::parse_dex_file(dex_file_path);
+
+    auto serial = serial_dex->get_analysis(true);
+    auto parallel = parallel_dex->get_analysis(true);
+
+    serial->create_xrefs(1);
+    parallel->create_xrefs(4);
+
+    assert(serial->get_methods().size() == parallel->get_methods().size() && "Different number of methods");
+    assert(serial->get_external_classes().size() == parallel->get_external_classes().size() && "Different number of external classes");
+
+    auto serial_lines = dump_xrefs(serial), parallel_lines = dump_xrefs(parallel);
+
+    std::sort(serial_lines.begin(), serial_lines.end());
+    std::sort(parallel_lines.begin(), parallel_lines.end());
+
+    assert(!serial_lines.empty() && serial_lines == parallel_lines && "Different xrefs with several threads");
+}
+
 int main()
 {
     std::string dex_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-assignment-arith-logic/Main.dex";
@@ -47,6 +557,18 @@ int main()
 
     analysis->create_xrefs();
 
+    test_parallel_xrefs(dex_file_path);
+    test_symbols(analysis);
+    test_xref_table(analysis);
+    test_call_graph(analysis);
+    test_class_hierarchy(analysis);
+
+    std::string hierarchy_file_path = std::string(KUNAI_TEST_FOLDER) + "/test-class-hierarchy/classes.dex";
+    test_class_hierarchy_dispatch(hierarchy_file_path);
+
+    test_search(analysis);
+    test_string_scanner(analysis);
+
     auto &classes = analysis->get_classes();
 
     size_t i = 0;
@@ -55,7 +577,7 @@ int main()
     {
         auto cls = name_class.second.get();
 
-        for (auto &xref : cls->get_xrefnewinstance())
+        for (const auto &xref : cls->get_xrefnewinstance())
         {
             // logger->debug("New Instance of {} in Method: {} and Offset: {}",
             //     cls->name(),
@@ -69,7 +591,7 @@ int main()
             i += 1;
         }
 
-        for (auto &xref : cls->get_xrefconstclass())
+        for (const auto &xref : cls->get_xrefconstclass())
         {
             // logger->debug("New xref const class of {} in Method: {} and offset: {}",
             //     cls->name(),
@@ -86,7 +608,7 @@ int main()
     {
         auto method = name_method.second.get();
 
-        for (auto &xref_from : method->get_xreffrom())
+        for (const auto &xref_from : method->get_xreffrom())
         {
             //logger->debug("New xref_from for method {}, from class {} method {} offset {}",
             //              method->get_full_name(),
@@ -115,7 +637,7 @@ int main()
     {
         auto method = name_method.second.get();
 
-        for (auto &xref_to : method->get_xrefto())
+        for (const auto &xref_to : method->get_xrefto())
         {
             // logger->debug("New xref_to from method {}, to class {} method {} offset {}",
             //     method->get_full_name(),